@@ -128,6 +128,29 @@ QVariantMap QgsExtractByExpressionAlgorithm::processAlgorithm( const QVariantMap
     expressionContext.setFields( source->fields() );
     expression.prepare( &expressionContext );
 
+    // evaluate the expression over blocks of features instead of one feature at a time
+    const int blockSize = 1000;
+    QgsFeatureList block;
+    block.reserve( blockSize );
+    auto flushBlock = [&]
+    {
+      const QVariantList results = expression.evaluateBlock( block, &expressionContext );
+      for ( int i = 0; i < block.count(); ++i )
+      {
+        if ( results.at( i ).toBool() )
+        {
+          matchingSink->addFeature( block[i], QgsFeatureSink::FastInsert );
+        }
+        else
+        {
+          nonMatchingSink->addFeature( block[i], QgsFeatureSink::FastInsert );
+        }
+      }
+      current += block.count();
+      feedback->setProgress( current * step );
+      block.clear();
+    };
+
     QgsFeatureIterator it = source->getFeatures();
     QgsFeature f;
     while ( it.nextFeature( f ) )
@@ -137,19 +160,12 @@ QVariantMap QgsExtractByExpressionAlgorithm::processAlgorithm( const QVariantMap
         break;
       }
 
-      expressionContext.setFeature( f );
-      if ( expression.evaluate( &expressionContext ).toBool() )
-      {
-        matchingSink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
-      else
-      {
-        nonMatchingSink->addFeature( f, QgsFeatureSink::FastInsert );
-      }
-
-      feedback->setProgress( current * step );
-      current++;
+      block << f;
+      if ( block.count() == blockSize )
+        flushBlock();
     }
+    if ( !block.isEmpty() && !feedback->isCanceled() )
+      flushBlock();
   }
 
 
@@ -99,6 +99,7 @@ bool QgsExpression::checkExpression( const QString &text, const QgsExpressionCon
 void QgsExpression::setExpression( const QString &expression )
 {
   detach();
+  d->mBytecode.reset();
   d->mRootNode = ::parseExpression( expression, d->mParserErrorString, d->mParserErrors );
   d->mEvalErrorString = QString();
   d->mExp = expression;
@@ -346,6 +347,7 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
 {
   detach();
   d->mEvalErrorString = QString();
+  d->mBytecode.reset();
   if ( !d->mRootNode )
   {
     //re-parse expression. Creation of QgsExpressionContexts may have added extra
@@ -360,7 +362,13 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
     return false;
   }
 
-  return d->mRootNode->prepare( this, context );
+  if ( !d->mRootNode->prepare( this, context ) )
+    return false;
+
+  if ( d->mBytecodeEnabled )
+    d->mBytecode = QgsExpressionBytecode::compile( d->mRootNode, context );
+
+  return true;
 }
 
 QVariant QgsExpression::evaluate()
@@ -384,9 +392,73 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
     return QVariant();
   }
 
+  if ( d->mBytecode )
+  {
+    QVariant result;
+    if ( d->mBytecode->execute( this, context, result ) )
+      return result;
+  }
+
   return d->mRootNode->eval( this, context );
 }
 
+QVariantList QgsExpression::evaluateBlock( const QList< QgsFeature > &features, QgsExpressionContext *context )
+{
+  d->mEvalErrorString = QString();
+  QVariantList results;
+  if ( !d->mRootNode )
+  {
+    d->mEvalErrorString = tr( "No root node! Parsing failed?" );
+    for ( int i = 0; i < features.count(); ++i )
+      results << QVariant();
+    return results;
+  }
+
+  if ( d->mBytecode )
+  {
+    d->mBytecode->executeBlock( this, context, features, results );
+    return results;
+  }
+
+  results.reserve( features.count() );
+  QString firstError;
+  for ( const QgsFeature &feature : features )
+  {
+    if ( context )
+      context->setFeature( feature );
+    results << d->mRootNode->eval( this, context );
+    if ( hasEvalError() )
+    {
+      if ( firstError.isNull() )
+        firstError = d->mEvalErrorString;
+      d->mEvalErrorString = QString();
+    }
+  }
+  d->mEvalErrorString = firstError;
+  return results;
+}
+
+void QgsExpression::setBytecodeEnabled( bool enabled )
+{
+  if ( d->mBytecodeEnabled == enabled )
+    return;
+
+  detach();
+  d->mBytecodeEnabled = enabled;
+  if ( !enabled )
+    d->mBytecode.reset();
+}
+
+bool QgsExpression::isBytecodeEnabled() const
+{
+  return d->mBytecodeEnabled;
+}
+
+bool QgsExpression::hasBytecode() const
+{
+  return static_cast< bool >( d->mBytecode );
+}
+
 bool QgsExpression::hasEvalError() const
 {
   return !d->mEvalErrorString.isNull();
@@ -323,6 +323,55 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext *context );
 
+    /**
+     * Evaluates the expression for each feature in a block of \a features and returns
+     * one result per feature, in the same order.
+     *
+     * This is equivalent to calling QgsExpressionContext::setFeature() and evaluate() for each
+     * feature in turn, but avoids most of the per feature overhead when the expression has been
+     * compiled into bytecode by prepare(). Expressions consisting solely of operators on fields
+     * and literals are then evaluated one operation at a time over the whole block.
+     *
+     * If the evaluation fails for a feature its result will be a null variant, and hasEvalError()
+     * will return true after the call with evalErrorString() describing the first error encountered.
+     *
+     * \note The feature set on \a context may be changed by this call.
+     * \note prepare() should be called before calling this method.
+     * \since QGIS 3.4
+     */
+    QVariantList evaluateBlock( const QList< QgsFeature > &features, QgsExpressionContext *context );
+
+    /**
+     * Sets whether prepare() should compile the expression into a flat bytecode
+     * program, which evaluate() then executes instead of walking the node tree.
+     * Parts of the expression which cannot be compiled are still evaluated by
+     * the node tree, so results are identical in both modes.
+     *
+     * Compilation is enabled by default.
+     *
+     * \see isBytecodeEnabled()
+     * \see hasBytecode()
+     * \since QGIS 3.4
+     */
+    void setBytecodeEnabled( bool enabled );
+
+    /**
+     * Returns true if prepare() compiles the expression into a bytecode program.
+     *
+     * \see setBytecodeEnabled()
+     * \since QGIS 3.4
+     */
+    bool isBytecodeEnabled() const;
+
+    /**
+     * Returns true if the last call to prepare() compiled the expression into
+     * a bytecode program which will be used by evaluate().
+     *
+     * \see setBytecodeEnabled()
+     * \since QGIS 3.4
+     */
+    bool hasBytecode() const;
+
     //! Returns true if an error occurred when evaluating last input
     bool hasEvalError() const;
     //! Returns evaluation error
@@ -0,0 +1,840 @@
+/***************************************************************************
+                               qgsexpressionbytecode.cpp
+                             -------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionbytecode_p.h"
+#include "qgsexpressionutils.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+
+#include <QVarLengthArray>
+
+#include <cmath>
+#include <limits>
+
+///@cond PRIVATE
+
+static bool compareDiff( QgsExpressionNodeBinaryOperator::BinaryOperator op, double diff )
+{
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boEQ:
+      return qgsDoubleNear( diff, 0.0 );
+    case QgsExpressionNodeBinaryOperator::boNE:
+      return !qgsDoubleNear( diff, 0.0 );
+    case QgsExpressionNodeBinaryOperator::boLT:
+      return diff < 0;
+    case QgsExpressionNodeBinaryOperator::boGT:
+      return diff > 0;
+    case QgsExpressionNodeBinaryOperator::boLE:
+      return diff <= 0;
+    case QgsExpressionNodeBinaryOperator::boGE:
+      return diff >= 0;
+    default:
+      Q_ASSERT( false );
+      return false;
+  }
+}
+
+static qlonglong computeInt( QgsExpressionNodeBinaryOperator::BinaryOperator op, qlonglong x, qlonglong y )
+{
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boPlus:
+      return x + y;
+    case QgsExpressionNodeBinaryOperator::boMinus:
+      return x - y;
+    case QgsExpressionNodeBinaryOperator::boMul:
+      return x * y;
+    case QgsExpressionNodeBinaryOperator::boMod:
+      return x % y;
+    default:
+      Q_ASSERT( false );
+      return 0;
+  }
+}
+
+static double computeDouble( QgsExpressionNodeBinaryOperator::BinaryOperator op, double x, double y )
+{
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boPlus:
+      return x + y;
+    case QgsExpressionNodeBinaryOperator::boMinus:
+      return x - y;
+    case QgsExpressionNodeBinaryOperator::boMul:
+      return x * y;
+    case QgsExpressionNodeBinaryOperator::boDiv:
+      return x / y;
+    case QgsExpressionNodeBinaryOperator::boMod:
+      return std::fmod( x, y );
+    default:
+      Q_ASSERT( false );
+      return 0;
+  }
+}
+
+void QgsExpressionBytecode::Value::setVariant( const QVariant &value )
+{
+  variant = value;
+  boxed = true;
+
+  if ( value.isNull() )
+  {
+    kind = Null;
+    return;
+  }
+
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+      kind = Int;
+      i = value.toLongLong();
+      intType = value.type();
+      break;
+
+    case QVariant::Double:
+      kind = Double;
+      d = value.toDouble();
+      break;
+
+    case QVariant::String:
+      kind = String;
+      break;
+
+    default:
+      kind = Other;
+      break;
+  }
+}
+
+QVariant QgsExpressionBytecode::Value::toVariant() const
+{
+  if ( boxed )
+    return variant;
+
+  switch ( kind )
+  {
+    case Int:
+      return intType == QVariant::Int ? QVariant( static_cast< int >( i ) ) : QVariant( i );
+    case Double:
+      return QVariant( d );
+    case Null:
+    case String:
+    case Other:
+      break;
+  }
+  return QVariant();
+}
+
+std::unique_ptr<QgsExpressionBytecode> QgsExpressionBytecode::compile( QgsExpressionNode *root, const QgsExpressionContext *context )
+{
+  if ( !root || root->hasCachedStaticValue() )
+    return nullptr;
+
+  switch ( root->nodeType() )
+  {
+    case QgsExpressionNode::ntUnaryOperator:
+    case QgsExpressionNode::ntBinaryOperator:
+    case QgsExpressionNode::ntCondition:
+      break;
+
+    default:
+      // a single literal, column or function call has nothing to gain from compilation
+      return nullptr;
+  }
+
+  QgsFields fields;
+  if ( context && context->hasVariable( QgsExpressionContext::EXPR_FIELDS ) )
+    fields = qvariant_cast<QgsFields>( context->variable( QgsExpressionContext::EXPR_FIELDS ) );
+
+  std::unique_ptr< QgsExpressionBytecode > program( new QgsExpressionBytecode() );
+  program->mResultRegister = program->compileNode( root, fields );
+
+  if ( program->mInstructions.count() == 1 && program->mInstructions.at( 0 ).code == OpEvalNode )
+    return nullptr;
+
+  return program;
+}
+
+std::unique_ptr<QgsExpressionBytecode> QgsExpressionBytecode::cloneForTree( const QgsExpressionNode *oldRoot, QgsExpressionNode *newRoot ) const
+{
+  std::unique_ptr< QgsExpressionBytecode > program( new QgsExpressionBytecode( *this ) );
+  if ( mNodes.isEmpty() )
+    return program;
+
+  // clone() preserves the tree structure, so nodes are matched by their position in the node list
+  const QList<const QgsExpressionNode *> oldNodes = oldRoot->nodes();
+  const QList<const QgsExpressionNode *> newNodes = newRoot->nodes();
+  if ( oldNodes.count() != newNodes.count() )
+    return nullptr;
+
+  for ( QgsExpressionNode *&node : program->mNodes )
+  {
+    const int index = oldNodes.indexOf( node );
+    if ( index < 0 )
+      return nullptr;
+    node = const_cast< QgsExpressionNode * >( newNodes.at( index ) );
+  }
+  return program;
+}
+
+int QgsExpressionBytecode::addInstruction( OpCode code, int a, int b, QgsExpressionNodeBinaryOperator::BinaryOperator binaryOp )
+{
+  const int dest = mRegisterCount++;
+  mInstructions.append( Instruction{ code, binaryOp, dest, a, b } );
+  return dest;
+}
+
+int QgsExpressionBytecode::addConstant( const QVariant &value )
+{
+  Value constant;
+  constant.setVariant( value );
+  mConstants.append( constant );
+  return mConstants.count() - 1;
+}
+
+int QgsExpressionBytecode::addFallback( QgsExpressionNode *node )
+{
+  mNodes.append( node );
+  return mNodes.count() - 1;
+}
+
+int QgsExpressionBytecode::compileNode( QgsExpressionNode *node, const QgsFields &fields )
+{
+  if ( node->hasCachedStaticValue() )
+    return addInstruction( OpLoadConst, addConstant( node->cachedStaticValue() ) );
+
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntLiteral:
+      return addInstruction( OpLoadConst, addConstant( static_cast< QgsExpressionNodeLiteral * >( node )->value() ) );
+
+    case QgsExpressionNode::ntColumnRef:
+    {
+      const int index = fields.lookupField( static_cast< QgsExpressionNodeColumnRef * >( node )->name() );
+      if ( index < 0 )
+        break;
+
+      mNeedsFeature = true;
+      return addInstruction( OpLoadAttribute, index );
+    }
+
+    case QgsExpressionNode::ntUnaryOperator:
+    {
+      QgsExpressionNodeUnaryOperator *unary = static_cast< QgsExpressionNodeUnaryOperator * >( node );
+      const int operand = compileNode( unary->operand(), fields );
+      return addInstruction( unary->op() == QgsExpressionNodeUnaryOperator::uoNot ? OpNot : OpNegate, operand );
+    }
+
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      QgsExpressionNodeBinaryOperator *binary = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+      switch ( binary->op() )
+      {
+        case QgsExpressionNodeBinaryOperator::boRegexp:
+        case QgsExpressionNodeBinaryOperator::boLike:
+        case QgsExpressionNodeBinaryOperator::boNotLike:
+        case QgsExpressionNodeBinaryOperator::boILike:
+        case QgsExpressionNodeBinaryOperator::boNotILike:
+          // pattern matching is left to the tree walker
+          return addInstruction( OpEvalNode, addFallback( node ) );
+
+        default:
+          break;
+      }
+
+      const int left = compileNode( binary->opLeft(), fields );
+      const int right = compileNode( binary->opRight(), fields );
+      return addInstruction( OpBinary, left, right, binary->op() );
+    }
+
+    case QgsExpressionNode::ntCondition:
+    {
+      QgsExpressionNodeCondition *condition = static_cast< QgsExpressionNodeCondition * >( node );
+      const int result = mRegisterCount++;
+
+      QVector< int > jumpsToEnd;
+      const QgsExpressionNodeCondition::WhenThenList conditions = condition->conditions();
+      for ( QgsExpressionNodeCondition::WhenThen *whenThen : conditions )
+      {
+        const int when = compileNode( whenThen->whenExp(), fields );
+        const int jumpToNext = mInstructions.count();
+        mInstructions.append( Instruction{ OpJumpIfNotTrue, QgsExpressionNodeBinaryOperator::boOr, -1, when, -1 } );
+        mHasJumps = true;
+
+        const int then = compileNode( whenThen->thenExp(), fields );
+        mInstructions.append( Instruction{ OpMove, QgsExpressionNodeBinaryOperator::boOr, result, then, -1 } );
+        jumpsToEnd << mInstructions.count();
+        mInstructions.append( Instruction{ OpJump, QgsExpressionNodeBinaryOperator::boOr, -1, -1, -1 } );
+
+        mInstructions[ jumpToNext ].dest = mInstructions.count();
+      }
+
+      if ( condition->elseExp() )
+      {
+        const int elseValue = compileNode( condition->elseExp(), fields );
+        mInstructions.append( Instruction{ OpMove, QgsExpressionNodeBinaryOperator::boOr, result, elseValue, -1 } );
+      }
+      else
+      {
+        mInstructions.append( Instruction{ OpLoadConst, QgsExpressionNodeBinaryOperator::boOr, result, addConstant( QVariant() ), -1 } );
+      }
+
+      for ( int jump : qgis::as_const( jumpsToEnd ) )
+        mInstructions[ jump ].dest = mInstructions.count();
+
+      return result;
+    }
+
+    case QgsExpressionNode::ntInOperator:
+    case QgsExpressionNode::ntFunction:
+      break;
+  }
+
+  return addInstruction( OpEvalNode, addFallback( node ) );
+}
+
+bool QgsExpressionBytecode::tvlValue( const Value &value, int &tvl, QgsExpression *parent )
+{
+  switch ( value.kind )
+  {
+    case Value::Null:
+      tvl = QgsExpressionUtils::Unknown;
+      return true;
+
+    case Value::Int:
+      tvl = value.i != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      return true;
+
+    case Value::Double:
+      tvl = !qgsDoubleNear( value.d, 0.0 ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      return true;
+
+    case Value::String:
+    case Value::Other:
+      break;
+  }
+
+  if ( !parent )
+    return false;
+
+  tvl = QgsExpressionUtils::getTVLValue( value.toVariant(), parent );
+  return true;
+}
+
+void QgsExpressionBytecode::evalNegate( Value &dest, const Value &operand, QgsExpression *parent, const QgsExpressionContext *context )
+{
+  if ( operand.kind == Value::Int )
+  {
+    dest.setInt( -operand.i );
+    return;
+  }
+  else if ( operand.kind == Value::Double && std::isfinite( operand.d ) )
+  {
+    dest.setDouble( -operand.d );
+    return;
+  }
+
+  QgsExpressionNodeUnaryOperator node( QgsExpressionNodeUnaryOperator::uoMinus, new QgsExpressionNodeLiteral( operand.toVariant() ) );
+  dest.setVariant( node.eval( parent, context ) );
+}
+
+void QgsExpressionBytecode::evalNot( Value &dest, const Value &operand, QgsExpression *parent )
+{
+  int tvl = QgsExpressionUtils::Unknown;
+  tvlValue( operand, tvl, parent );
+  const QgsExpressionUtils::TVL res = QgsExpressionUtils::NOT[tvl];
+  if ( res == QgsExpressionUtils::Unknown )
+    dest.setNull();
+  else
+    dest.setInt( res == QgsExpressionUtils::True ? 1 : 0, QVariant::Int );
+}
+
+void QgsExpressionBytecode::evalBinary( QgsExpressionNodeBinaryOperator::BinaryOperator op, const Value &l, const Value &r, Value &dest, QgsExpression *parent, const QgsExpressionContext *context )
+{
+  const bool hasNull = l.kind == Value::Null || r.kind == Value::Null;
+  const bool bothNumeric = ( l.kind == Value::Int || l.kind == Value::Double ) && ( r.kind == Value::Int || r.kind == Value::Double );
+  const bool bothInt = l.kind == Value::Int && r.kind == Value::Int;
+  const bool bothString = l.kind == Value::String && r.kind == Value::String;
+  const double fL = l.kind == Value::Int ? static_cast< double >( l.i ) : l.d;
+  const double fR = r.kind == Value::Int ? static_cast< double >( r.i ) : r.d;
+  // the tree walker raises an error for non finite operands, so leave these to it
+  const bool finite = bothNumeric && std::isfinite( fL ) && std::isfinite( fR );
+
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boPlus:
+      // NULL strings are concatenated as empty strings
+      if ( ( l.boxed && l.variant.type() == QVariant::String ) || ( r.boxed && r.variant.type() == QVariant::String ) )
+        break;
+      FALLTHROUGH
+    case QgsExpressionNodeBinaryOperator::boMinus:
+    case QgsExpressionNodeBinaryOperator::boMul:
+    case QgsExpressionNodeBinaryOperator::boDiv:
+    case QgsExpressionNodeBinaryOperator::boMod:
+      if ( hasNull )
+      {
+        dest.setNull();
+        return;
+      }
+      else if ( op != QgsExpressionNodeBinaryOperator::boDiv && bothInt )
+      {
+        if ( op == QgsExpressionNodeBinaryOperator::boMod && r.i == 0 )
+          dest.setNull();
+        else
+          dest.setInt( computeInt( op, l.i, r.i ) );
+        return;
+      }
+      else if ( finite )
+      {
+        if ( ( op == QgsExpressionNodeBinaryOperator::boDiv || op == QgsExpressionNodeBinaryOperator::boMod ) && fR == 0. )
+          dest.setNull();
+        else
+          dest.setDouble( computeDouble( op, fL, fR ) );
+        return;
+      }
+      break;
+
+    case QgsExpressionNodeBinaryOperator::boIntDiv:
+      if ( finite )
+      {
+        if ( fR == 0. )
+          dest.setNull();
+        else
+          dest.setInt( qlonglong( std::floor( fL / fR ) ) );
+        return;
+      }
+      break;
+
+    case QgsExpressionNodeBinaryOperator::boPow:
+      if ( hasNull )
+      {
+        dest.setNull();
+        return;
+      }
+      else if ( finite )
+      {
+        dest.setDouble( std::pow( fL, fR ) );
+        return;
+      }
+      break;
+
+    case QgsExpressionNodeBinaryOperator::boAnd:
+    case QgsExpressionNodeBinaryOperator::boOr:
+    {
+      int tvlL = QgsExpressionUtils::Unknown;
+      int tvlR = QgsExpressionUtils::Unknown;
+      if ( tvlValue( l, tvlL, nullptr ) && tvlValue( r, tvlR, nullptr ) )
+      {
+        const QgsExpressionUtils::TVL res = op == QgsExpressionNodeBinaryOperator::boAnd ? QgsExpressionUtils::AND[tvlL][tvlR] : QgsExpressionUtils::OR[tvlL][tvlR];
+        if ( res == QgsExpressionUtils::Unknown )
+          dest.setNull();
+        else
+          dest.setInt( res == QgsExpressionUtils::True ? 1 : 0, QVariant::Int );
+        return;
+      }
+      break;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boEQ:
+    case QgsExpressionNodeBinaryOperator::boNE:
+    case QgsExpressionNodeBinaryOperator::boLT:
+    case QgsExpressionNodeBinaryOperator::boGT:
+    case QgsExpressionNodeBinaryOperator::boLE:
+    case QgsExpressionNodeBinaryOperator::boGE:
+      if ( hasNull )
+      {
+        dest.setNull();
+        return;
+      }
+      else if ( finite )
+      {
+        dest.setInt( compareDiff( op, fL - fR ) ? 1 : 0, QVariant::Int );
+        return;
+      }
+      else if ( bothString )
+      {
+        const int diff = QString::compare( l.variant.toString(), r.variant.toString() );
+        dest.setInt( compareDiff( op, diff ) ? 1 : 0, QVariant::Int );
+        return;
+      }
+      break;
+
+    case QgsExpressionNodeBinaryOperator::boIs:
+    case QgsExpressionNodeBinaryOperator::boIsNot:
+    {
+      bool equal = false;
+      if ( l.kind == Value::Null && r.kind == Value::Null )
+        equal = true;
+      else if ( hasNull )
+        equal = false;
+      else if ( finite )
+        equal = qgsDoubleNear( fL, fR );
+      else if ( bothString )
+        equal = QString::compare( l.variant.toString(), r.variant.toString() ) == 0;
+      else
+        break;
+
+      dest.setInt( equal == ( op == QgsExpressionNodeBinaryOperator::boIs ) ? 1 : 0, QVariant::Int );
+      return;
+    }
+
+    case QgsExpressionNodeBinaryOperator::boConcat:
+      if ( hasNull )
+      {
+        dest.setNull();
+        return;
+      }
+      else if ( bothString )
+      {
+        dest.setVariant( QVariant( l.variant.toString() + r.variant.toString() ) );
+        return;
+      }
+      break;
+
+    case QgsExpressionNodeBinaryOperator::boRegexp:
+    case QgsExpressionNodeBinaryOperator::boLike:
+    case QgsExpressionNodeBinaryOperator::boNotLike:
+    case QgsExpressionNodeBinaryOperator::boILike:
+    case QgsExpressionNodeBinaryOperator::boNotILike:
+      break;
+  }
+
+  // no typed fast path for this combination of values, so let the tree walker handle it
+  QgsExpressionNodeBinaryOperator node( op, new QgsExpressionNodeLiteral( l.toVariant() ), new QgsExpressionNodeLiteral( r.toVariant() ) );
+  dest.setVariant( node.eval( parent, context ) );
+}
+
+bool QgsExpressionBytecode::evalBinaryColumns( QgsExpressionNodeBinaryOperator::BinaryOperator op, const Value *l, const Value *r, Value *dest, int count, const std::vector< char > &failed )
+{
+  bool isComparison = false;
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boPlus:
+    case QgsExpressionNodeBinaryOperator::boMinus:
+    case QgsExpressionNodeBinaryOperator::boMul:
+      break;
+
+    case QgsExpressionNodeBinaryOperator::boEQ:
+    case QgsExpressionNodeBinaryOperator::boNE:
+    case QgsExpressionNodeBinaryOperator::boLT:
+    case QgsExpressionNodeBinaryOperator::boGT:
+    case QgsExpressionNodeBinaryOperator::boLE:
+    case QgsExpressionNodeBinaryOperator::boGE:
+      isComparison = true;
+      break;
+
+    default:
+      return false;
+  }
+
+  // gather both operands into plain double arrays, giving up on anything which needs
+  // the per value semantics (NULLs, strings, integer arithmetic, non finite values)
+  std::vector< double > lhs( count );
+  std::vector< double > rhs( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( failed[i] )
+    {
+      lhs[i] = rhs[i] = 0;
+      continue;
+    }
+
+    const Value &left = l[i];
+    const Value &right = r[i];
+    if ( ( left.kind != Value::Int && left.kind != Value::Double ) || ( right.kind != Value::Int && right.kind != Value::Double ) )
+      return false;
+    if ( !isComparison && left.kind == Value::Int && right.kind == Value::Int )
+      return false;
+
+    lhs[i] = left.kind == Value::Int ? static_cast< double >( left.i ) : left.d;
+    rhs[i] = right.kind == Value::Int ? static_cast< double >( right.i ) : right.d;
+    if ( !std::isfinite( lhs[i] ) || !std::isfinite( rhs[i] ) )
+      return false;
+  }
+
+  // branch free loops over contiguous arrays, which the compiler can vectorize
+  std::vector< double > out( count );
+  const double *x = lhs.data();
+  const double *y = rhs.data();
+  double *res = out.data();
+  const double epsilon = 4 * std::numeric_limits<double>::epsilon();
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boPlus:
+      for ( int i = 0; i < count; ++i )
+        res[i] = x[i] + y[i];
+      break;
+    case QgsExpressionNodeBinaryOperator::boMinus:
+      for ( int i = 0; i < count; ++i )
+        res[i] = x[i] - y[i];
+      break;
+    case QgsExpressionNodeBinaryOperator::boMul:
+      for ( int i = 0; i < count; ++i )
+        res[i] = x[i] * y[i];
+      break;
+    case QgsExpressionNodeBinaryOperator::boEQ:
+      // same as qgsDoubleNear( x - y, 0 )
+      for ( int i = 0; i < count; ++i )
+        res[i] = ( x[i] - y[i] > -epsilon ) & ( x[i] - y[i] <= epsilon );
+      break;
+    case QgsExpressionNodeBinaryOperator::boNE:
+      for ( int i = 0; i < count; ++i )
+        res[i] = !( ( x[i] - y[i] > -epsilon ) & ( x[i] - y[i] <= epsilon ) );
+      break;
+    case QgsExpressionNodeBinaryOperator::boLT:
+      for ( int i = 0; i < count; ++i )
+        res[i] = x[i] - y[i] < 0;
+      break;
+    case QgsExpressionNodeBinaryOperator::boGT:
+      for ( int i = 0; i < count; ++i )
+        res[i] = x[i] - y[i] > 0;
+      break;
+    case QgsExpressionNodeBinaryOperator::boLE:
+      for ( int i = 0; i < count; ++i )
+        res[i] = x[i] - y[i] <= 0;
+      break;
+    case QgsExpressionNodeBinaryOperator::boGE:
+      for ( int i = 0; i < count; ++i )
+        res[i] = x[i] - y[i] >= 0;
+      break;
+    default:
+      return false;
+  }
+
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( failed[i] )
+      continue;
+
+    if ( isComparison )
+      dest[i].setInt( res[i] != 0 ? 1 : 0, QVariant::Int );
+    else
+      dest[i].setDouble( res[i] );
+  }
+  return true;
+}
+
+bool QgsExpressionBytecode::execute( QgsExpression *parent, const QgsExpressionContext *context, QVariant &result )
+{
+  QgsAttributes attributes;
+  if ( mNeedsFeature )
+  {
+    // without a feature column references evaluate to their name, leave that to the tree walker
+    if ( !context || !context->hasFeature() )
+      return false;
+
+    attributes = context->feature().attributes();
+  }
+
+  result = run( parent, context, attributes );
+  return true;
+}
+
+QVariant QgsExpressionBytecode::run( QgsExpression *parent, const QgsExpressionContext *context, const QgsAttributes &attributes )
+{
+  const Instruction *instructions = mInstructions.constData();
+  const int instructionCount = mInstructions.count();
+  QVarLengthArray< Value, 32 > registerStorage( mRegisterCount );
+  Value *registers = registerStorage.data();
+
+  int pc = 0;
+  while ( pc < instructionCount )
+  {
+    const Instruction &instruction = instructions[ pc++ ];
+    switch ( instruction.code )
+    {
+      case OpLoadConst:
+        registers[ instruction.dest ] = mConstants.at( instruction.a );
+        break;
+
+      case OpLoadAttribute:
+        registers[ instruction.dest ].setVariant( instruction.a < attributes.count() ? attributes.at( instruction.a ) : QVariant() );
+        break;
+
+      case OpEvalNode:
+        registers[ instruction.dest ].setVariant( mNodes.at( instruction.a )->eval( parent, context ) );
+        break;
+
+      case OpMove:
+        registers[ instruction.dest ] = registers[ instruction.a ];
+        break;
+
+      case OpNot:
+        evalNot( registers[ instruction.dest ], registers[ instruction.a ], parent );
+        break;
+
+      case OpNegate:
+        evalNegate( registers[ instruction.dest ], registers[ instruction.a ], parent, context );
+        break;
+
+      case OpBinary:
+        evalBinary( instruction.binaryOp, registers[ instruction.a ], registers[ instruction.b ], registers[ instruction.dest ], parent, context );
+        break;
+
+      case OpJumpIfNotTrue:
+      {
+        int tvl = QgsExpressionUtils::Unknown;
+        tvlValue( registers[ instruction.a ], tvl, parent );
+        if ( tvl != QgsExpressionUtils::True )
+          pc = instruction.dest;
+        break;
+      }
+
+      case OpJump:
+        pc = instruction.dest;
+        break;
+    }
+
+    // same as ENSURE_NO_EVAL_ERROR, the first error aborts the whole evaluation
+    if ( parent->hasEvalError() )
+      return QVariant();
+  }
+
+  return registers[ mResultRegister ].toVariant();
+}
+
+void QgsExpressionBytecode::executeBlock( QgsExpression *parent, QgsExpressionContext *context, const QgsFeatureList &features, QVariantList &results )
+{
+  results.clear();
+  results.reserve( features.count() );
+
+  QString firstError;
+  if ( !mHasJumps && mNodes.isEmpty() )
+  {
+    runColumns( parent, context, features, results, firstError );
+  }
+  else
+  {
+    for ( const QgsFeature &feature : features )
+    {
+      if ( context && !mNodes.isEmpty() )
+        context->setFeature( feature );
+
+      results << run( parent, context, feature.attributes() );
+      if ( parent->hasEvalError() )
+      {
+        if ( firstError.isNull() )
+          firstError = parent->evalErrorString();
+        parent->setEvalErrorString( QString() );
+      }
+    }
+  }
+
+  parent->setEvalErrorString( firstError );
+}
+
+void QgsExpressionBytecode::runColumns( QgsExpression *parent, const QgsExpressionContext *context, const QgsFeatureList &features, QVariantList &results, QString &firstError )
+{
+  const int count = features.count();
+
+  QVector< QgsAttributes > attributes;
+  attributes.reserve( count );
+  for ( const QgsFeature &feature : features )
+    attributes << feature.attributes();
+
+  // register r of feature i lives at r * count + i
+  std::vector< Value > registers( static_cast< std::size_t >( mRegisterCount ) * count );
+  std::vector< char > failed( count, 0 );
+
+  auto checkError = [parent, &failed, &firstError]( int i )
+  {
+    if ( !parent->hasEvalError() )
+      return;
+
+    if ( firstError.isNull() )
+      firstError = parent->evalErrorString();
+    parent->setEvalErrorString( QString() );
+    failed[i] = 1;
+  };
+
+  for ( const Instruction &instruction : qgis::as_const( mInstructions ) )
+  {
+    Value *dest = registers.data() + static_cast< std::size_t >( instruction.dest ) * count;
+    switch ( instruction.code )
+    {
+      case OpLoadConst:
+      {
+        const Value &constant = mConstants.at( instruction.a );
+        for ( int i = 0; i < count; ++i )
+          dest[i] = constant;
+        break;
+      }
+
+      case OpLoadAttribute:
+        for ( int i = 0; i < count; ++i )
+          dest[i].setVariant( instruction.a < attributes.at( i ).count() ? attributes.at( i ).at( instruction.a ) : QVariant() );
+        break;
+
+      case OpNot:
+      {
+        const Value *operand = registers.data() + static_cast< std::size_t >( instruction.a ) * count;
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( failed[i] )
+            continue;
+          evalNot( dest[i], operand[i], parent );
+          checkError( i );
+        }
+        break;
+      }
+
+      case OpNegate:
+      {
+        const Value *operand = registers.data() + static_cast< std::size_t >( instruction.a ) * count;
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( failed[i] )
+            continue;
+          evalNegate( dest[i], operand[i], parent, context );
+          checkError( i );
+        }
+        break;
+      }
+
+      case OpBinary:
+      {
+        const Value *l = registers.data() + static_cast< std::size_t >( instruction.a ) * count;
+        const Value *r = registers.data() + static_cast< std::size_t >( instruction.b ) * count;
+        if ( evalBinaryColumns( instruction.binaryOp, l, r, dest, count, failed ) )
+          break;
+
+        for ( int i = 0; i < count; ++i )
+        {
+          if ( failed[i] )
+            continue;
+          evalBinary( instruction.binaryOp, l[i], r[i], dest[i], parent, context );
+          checkError( i );
+        }
+        break;
+      }
+
+      case OpMove:
+      case OpEvalNode:
+      case OpJumpIfNotTrue:
+      case OpJump:
+        // never part of a straight line program
+        Q_ASSERT( false );
+        break;
+    }
+  }
+
+  const Value *result = registers.data() + static_cast< std::size_t >( mResultRegister ) * count;
+  for ( int i = 0; i < count; ++i )
+    results << ( failed[i] ? QVariant() : result[i].toVariant() );
+}
+
+///@endcond
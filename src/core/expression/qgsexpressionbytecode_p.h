@@ -0,0 +1,177 @@
+/***************************************************************************
+                               qgsexpressionbytecode_p.h
+                             -------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONBYTECODE_P_H
+#define QGSEXPRESSIONBYTECODE_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include <QVariant>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+#include "qgsexpressionnodeimpl.h"
+#include "qgsfeature.h"
+
+class QgsExpression;
+class QgsExpressionContext;
+class QgsFields;
+
+/**
+ * A flat register based program compiled from a prepared QgsExpressionNode tree.
+ *
+ * Operators, literals, column references and CASE conditions are lowered into
+ * typed instructions which operate on unboxed integer, double and string registers.
+ * Any other node (functions, IN, LIKE, ...) is embedded as a single instruction which
+ * evaluates the original subtree with the tree walker, so compiled programs always
+ * produce the same results as QgsExpressionNode::eval().
+ */
+class QgsExpressionBytecode
+{
+  public:
+
+    /**
+     * Compiles the prepared tree starting at \a root. Column references are resolved
+     * against the fields of \a context.
+     * Returns nullptr if the tree would not benefit from compilation.
+     */
+    static std::unique_ptr< QgsExpressionBytecode > compile( QgsExpressionNode *root, const QgsExpressionContext *context );
+
+    /**
+     * Returns a copy of this program which evaluates its fallback instructions using
+     * the nodes of \a newRoot, a clone of the tree the program was compiled from (\a oldRoot).
+     */
+    std::unique_ptr< QgsExpressionBytecode > cloneForTree( const QgsExpressionNode *oldRoot, QgsExpressionNode *newRoot ) const;
+
+    /**
+     * Executes the program. Returns false if the program cannot handle the given \a context,
+     * in which case the caller must evaluate the tree instead.
+     * Evaluation errors are reported to \a parent exactly like the tree walker does.
+     */
+    bool execute( QgsExpression *parent, const QgsExpressionContext *context, QVariant &result );
+
+    /**
+     * Executes the program once for each of the \a features, storing one value per feature in \a results.
+     *
+     * Programs without branches or tree walker fallbacks are run one instruction at a time over the
+     * whole block, with registers stored as contiguous columns. Other programs are run feature by feature,
+     * setting the feature on \a context only when a fallback instruction needs it.
+     *
+     * Evaluation errors only affect the result of the feature which raised them. The first error
+     * message is reported to \a parent once the whole block has been evaluated.
+     */
+    void executeBlock( QgsExpression *parent, QgsExpressionContext *context, const QgsFeatureList &features, QVariantList &results );
+
+    //! Returns the number of instructions in the program
+    int instructionCount() const { return mInstructions.count(); }
+
+    //! Returns the number of instructions which fall back to the tree walker
+    int fallbackCount() const { return mNodes.count(); }
+
+  private:
+
+    enum OpCode
+    {
+      OpLoadConst, //!< r[dest] = constants[a]
+      OpLoadAttribute, //!< r[dest] = feature attribute a
+      OpEvalNode, //!< r[dest] = nodes[a]->eval()
+      OpMove, //!< r[dest] = r[a]
+      OpNot, //!< r[dest] = NOT r[a]
+      OpNegate, //!< r[dest] = -r[a]
+      OpBinary, //!< r[dest] = r[a] binaryOp r[b]
+      OpJumpIfNotTrue, //!< if r[a] is not TRUE jump to dest
+      OpJump, //!< jump to dest
+    };
+
+    struct Instruction
+    {
+      OpCode code;
+      QgsExpressionNodeBinaryOperator::BinaryOperator binaryOp;
+      int dest;
+      int a;
+      int b;
+    };
+
+    //! A single unboxed register value
+    struct Value
+    {
+      enum Kind
+      {
+        Null,
+        Int,
+        Double,
+        String,
+        Other,
+      };
+
+      Kind kind = Null;
+      qlonglong i = 0;
+      double d = 0;
+
+      //! For Int values, the type to use when boxing the value
+      QVariant::Type intType = QVariant::LongLong;
+
+      //! True if the value was loaded from a QVariant which is kept in variant
+      bool boxed = false;
+      QVariant variant;
+
+      void setNull() { kind = Null; boxed = false; }
+      void setInt( qlonglong value, QVariant::Type type = QVariant::LongLong ) { kind = Int; i = value; intType = type; boxed = false; }
+      void setDouble( double value ) { kind = Double; d = value; boxed = false; }
+      void setVariant( const QVariant &value );
+      QVariant toVariant() const;
+    };
+
+    QgsExpressionBytecode() = default;
+
+    int compileNode( QgsExpressionNode *node, const QgsFields &fields );
+    int addInstruction( OpCode code, int a, int b = -1, QgsExpressionNodeBinaryOperator::BinaryOperator binaryOp = QgsExpressionNodeBinaryOperator::boOr );
+    int addConstant( const QVariant &value );
+    int addFallback( QgsExpressionNode *node );
+
+    QVariant run( QgsExpression *parent, const QgsExpressionContext *context, const QgsAttributes &attributes );
+    void runColumns( QgsExpression *parent, const QgsExpressionContext *context, const QgsFeatureList &features, QVariantList &results, QString &firstError );
+
+    static void evalBinary( QgsExpressionNodeBinaryOperator::BinaryOperator op, const Value &l, const Value &r, Value &dest, QgsExpression *parent, const QgsExpressionContext *context );
+    static bool evalBinaryColumns( QgsExpressionNodeBinaryOperator::BinaryOperator op, const Value *l, const Value *r, Value *dest, int count, const std::vector< char > &failed );
+    static void evalNegate( Value &dest, const Value &operand, QgsExpression *parent, const QgsExpressionContext *context );
+    static void evalNot( Value &dest, const Value &operand, QgsExpression *parent );
+    static bool tvlValue( const Value &value, int &tvl, QgsExpression *parent );
+
+    QVector< Instruction > mInstructions;
+    QVector< Value > mConstants;
+    QVector< QgsExpressionNode * > mNodes;
+
+    //! Registers are allocated for each run, as copies of a prepared expression share the program
+    int mRegisterCount = 0;
+    int mResultRegister = -1;
+    bool mNeedsFeature = false;
+    bool mHasJumps = false;
+};
+
+/// @endcond
+
+#endif // QGSEXPRESSIONBYTECODE_P_H
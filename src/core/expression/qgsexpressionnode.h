@@ -265,6 +265,22 @@ class CORE_EXPORT QgsExpressionNode SIP_ABSTRACT
      */
     bool prepare( QgsExpression *parent, const QgsExpressionContext *context );
 
+    /**
+     * Returns true if the node can be replaced by a static cached value.
+     *
+     * \see cachedStaticValue()
+     * \since QGIS 3.4
+     */
+    bool hasCachedStaticValue() const { return mHasCachedValue; }
+
+    /**
+     * Returns the node's static cached value. Only valid if hasCachedStaticValue() returns true.
+     *
+     * \see hasCachedStaticValue()
+     * \since QGIS 3.4
+     */
+    QVariant cachedStaticValue() const { return mCachedStaticValue; }
+
     /**
      * First line in the parser this node was found.
      * \note This might not be complete for all nodes. Currently
@@ -0,0 +1,483 @@
+/***************************************************************************
+                         qgscoordinatekernels.cpp
+                         ------------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgscoordinatekernels_p.h"
+#include "qgis.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define QGS_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are compiled with a per function target attribute, so the rest of
+// the library does not require AVX2 capable hardware
+#if defined(QGS_KERNELS_SSE2) && ( defined(__GNUC__) || defined(__clang__) ) && ( defined(__x86_64__) || defined(__i386__) )
+#define QGS_KERNELS_AVX2
+#define QGS_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+///@cond PRIVATE
+
+namespace
+{
+
+  //
+  // Scalar
+  //
+
+  void boundingBoxScalar( const double *x, const double *y, int count, double &xMin, double &yMin, double &xMax, double &yMax )
+  {
+    xMin = yMin = std::numeric_limits<double>::max();
+    xMax = yMax = -std::numeric_limits<double>::max();
+    for ( int i = 0; i < count; ++i )
+    {
+      if ( x[i] < xMin )
+        xMin = x[i];
+      if ( x[i] > xMax )
+        xMax = x[i];
+      if ( y[i] < yMin )
+        yMin = y[i];
+      if ( y[i] > yMax )
+        yMax = y[i];
+    }
+  }
+
+  double lengthScalar( const double *x, const double *y, int count )
+  {
+    double length = 0;
+    for ( int i = 1; i < count; ++i )
+    {
+      const double dx = x[i] - x[i - 1];
+      const double dy = y[i] - y[i - 1];
+      length += std::sqrt( dx * dx + dy * dy );
+    }
+    return length;
+  }
+
+  double shoelaceScalar( const double *x, const double *y, int count )
+  {
+    double sum = 0;
+    for ( int i = 0; i < count - 1; ++i )
+    {
+      sum += x[i] * y[i + 1] - y[i] * x[i + 1];
+    }
+    return sum;
+  }
+
+  void affineTransformScalar( double *x, double *y, int count, double m11, double m12, double m21, double m22, double dx, double dy )
+  {
+    for ( int i = 0; i < count; ++i )
+    {
+      const double px = x[i];
+      const double py = y[i];
+      x[i] = m11 * px + m21 * py + dx;
+      y[i] = m12 * px + m22 * py + dy;
+    }
+  }
+
+  void scaleTranslateScalar( double *values, int count, double scale, double translate )
+  {
+    for ( int i = 0; i < count; ++i )
+    {
+      values[i] = values[i] * scale + translate;
+    }
+  }
+
+#ifdef QGS_KERNELS_SSE2
+
+  //
+  // SSE2
+  //
+
+  double horizontalSum( __m128d v )
+  {
+    double lanes[2];
+    _mm_storeu_pd( lanes, v );
+    return lanes[0] + lanes[1];
+  }
+
+  void boundingBoxSse2( const double *x, const double *y, int count, double &xMin, double &yMin, double &xMax, double &yMax )
+  {
+    // _mm_min_pd( a, b ) returns b if a is NaN, so NaN coordinates are skipped like the scalar code does
+    __m128d vxMin = _mm_set1_pd( std::numeric_limits<double>::max() );
+    __m128d vyMin = vxMin;
+    __m128d vxMax = _mm_set1_pd( -std::numeric_limits<double>::max() );
+    __m128d vyMax = vxMax;
+
+    int i = 0;
+    for ( ; i + 2 <= count; i += 2 )
+    {
+      const __m128d vx = _mm_loadu_pd( x + i );
+      const __m128d vy = _mm_loadu_pd( y + i );
+      vxMin = _mm_min_pd( vx, vxMin );
+      vxMax = _mm_max_pd( vx, vxMax );
+      vyMin = _mm_min_pd( vy, vyMin );
+      vyMax = _mm_max_pd( vy, vyMax );
+    }
+
+    double lanes[2];
+    _mm_storeu_pd( lanes, vxMin );
+    xMin = std::min( lanes[0], lanes[1] );
+    _mm_storeu_pd( lanes, vxMax );
+    xMax = std::max( lanes[0], lanes[1] );
+    _mm_storeu_pd( lanes, vyMin );
+    yMin = std::min( lanes[0], lanes[1] );
+    _mm_storeu_pd( lanes, vyMax );
+    yMax = std::max( lanes[0], lanes[1] );
+
+    for ( ; i < count; ++i )
+    {
+      if ( x[i] < xMin )
+        xMin = x[i];
+      if ( x[i] > xMax )
+        xMax = x[i];
+      if ( y[i] < yMin )
+        yMin = y[i];
+      if ( y[i] > yMax )
+        yMax = y[i];
+    }
+  }
+
+  double lengthSse2( const double *x, const double *y, int count )
+  {
+    __m128d sum = _mm_setzero_pd();
+    int i = 1;
+    for ( ; i + 2 <= count; i += 2 )
+    {
+      const __m128d dx = _mm_sub_pd( _mm_loadu_pd( x + i ), _mm_loadu_pd( x + i - 1 ) );
+      const __m128d dy = _mm_sub_pd( _mm_loadu_pd( y + i ), _mm_loadu_pd( y + i - 1 ) );
+      sum = _mm_add_pd( sum, _mm_sqrt_pd( _mm_add_pd( _mm_mul_pd( dx, dx ), _mm_mul_pd( dy, dy ) ) ) );
+    }
+
+    double length = horizontalSum( sum );
+    for ( ; i < count; ++i )
+    {
+      const double dx = x[i] - x[i - 1];
+      const double dy = y[i] - y[i - 1];
+      length += std::sqrt( dx * dx + dy * dy );
+    }
+    return length;
+  }
+
+  double shoelaceSse2( const double *x, const double *y, int count )
+  {
+    __m128d sum = _mm_setzero_pd();
+    int i = 0;
+    for ( ; i + 3 <= count; i += 2 )
+    {
+      const __m128d a = _mm_mul_pd( _mm_loadu_pd( x + i ), _mm_loadu_pd( y + i + 1 ) );
+      const __m128d b = _mm_mul_pd( _mm_loadu_pd( y + i ), _mm_loadu_pd( x + i + 1 ) );
+      sum = _mm_add_pd( sum, _mm_sub_pd( a, b ) );
+    }
+
+    double result = horizontalSum( sum );
+    for ( ; i < count - 1; ++i )
+    {
+      result += x[i] * y[i + 1] - y[i] * x[i + 1];
+    }
+    return result;
+  }
+
+  void affineTransformSse2( double *x, double *y, int count, double m11, double m12, double m21, double m22, double dx, double dy )
+  {
+    const __m128d vm11 = _mm_set1_pd( m11 );
+    const __m128d vm12 = _mm_set1_pd( m12 );
+    const __m128d vm21 = _mm_set1_pd( m21 );
+    const __m128d vm22 = _mm_set1_pd( m22 );
+    const __m128d vdx = _mm_set1_pd( dx );
+    const __m128d vdy = _mm_set1_pd( dy );
+
+    int i = 0;
+    for ( ; i + 2 <= count; i += 2 )
+    {
+      const __m128d px = _mm_loadu_pd( x + i );
+      const __m128d py = _mm_loadu_pd( y + i );
+      _mm_storeu_pd( x + i, _mm_add_pd( _mm_add_pd( _mm_mul_pd( vm11, px ), _mm_mul_pd( vm21, py ) ), vdx ) );
+      _mm_storeu_pd( y + i, _mm_add_pd( _mm_add_pd( _mm_mul_pd( vm12, px ), _mm_mul_pd( vm22, py ) ), vdy ) );
+    }
+    affineTransformScalar( x + i, y + i, count - i, m11, m12, m21, m22, dx, dy );
+  }
+
+  void scaleTranslateSse2( double *values, int count, double scale, double translate )
+  {
+    const __m128d vScale = _mm_set1_pd( scale );
+    const __m128d vTranslate = _mm_set1_pd( translate );
+    int i = 0;
+    for ( ; i + 2 <= count; i += 2 )
+    {
+      _mm_storeu_pd( values + i, _mm_add_pd( _mm_mul_pd( _mm_loadu_pd( values + i ), vScale ), vTranslate ) );
+    }
+    scaleTranslateScalar( values + i, count - i, scale, translate );
+  }
+
+#endif
+
+#ifdef QGS_KERNELS_AVX2
+
+  //
+  // AVX2
+  //
+
+  QGS_AVX2_TARGET double horizontalSum256( __m256d v )
+  {
+    double lanes[4];
+    _mm256_storeu_pd( lanes, v );
+    return ( lanes[0] + lanes[1] ) + ( lanes[2] + lanes[3] );
+  }
+
+  QGS_AVX2_TARGET void boundingBoxAvx2( const double *x, const double *y, int count, double &xMin, double &yMin, double &xMax, double &yMax )
+  {
+    __m256d vxMin = _mm256_set1_pd( std::numeric_limits<double>::max() );
+    __m256d vyMin = vxMin;
+    __m256d vxMax = _mm256_set1_pd( -std::numeric_limits<double>::max() );
+    __m256d vyMax = vxMax;
+
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+      const __m256d vx = _mm256_loadu_pd( x + i );
+      const __m256d vy = _mm256_loadu_pd( y + i );
+      vxMin = _mm256_min_pd( vx, vxMin );
+      vxMax = _mm256_max_pd( vx, vxMax );
+      vyMin = _mm256_min_pd( vy, vyMin );
+      vyMax = _mm256_max_pd( vy, vyMax );
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd( lanes, vxMin );
+    xMin = std::min( std::min( lanes[0], lanes[1] ), std::min( lanes[2], lanes[3] ) );
+    _mm256_storeu_pd( lanes, vxMax );
+    xMax = std::max( std::max( lanes[0], lanes[1] ), std::max( lanes[2], lanes[3] ) );
+    _mm256_storeu_pd( lanes, vyMin );
+    yMin = std::min( std::min( lanes[0], lanes[1] ), std::min( lanes[2], lanes[3] ) );
+    _mm256_storeu_pd( lanes, vyMax );
+    yMax = std::max( std::max( lanes[0], lanes[1] ), std::max( lanes[2], lanes[3] ) );
+
+    for ( ; i < count; ++i )
+    {
+      if ( x[i] < xMin )
+        xMin = x[i];
+      if ( x[i] > xMax )
+        xMax = x[i];
+      if ( y[i] < yMin )
+        yMin = y[i];
+      if ( y[i] > yMax )
+        yMax = y[i];
+    }
+  }
+
+  QGS_AVX2_TARGET double lengthAvx2( const double *x, const double *y, int count )
+  {
+    __m256d sum = _mm256_setzero_pd();
+    int i = 1;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+      const __m256d dx = _mm256_sub_pd( _mm256_loadu_pd( x + i ), _mm256_loadu_pd( x + i - 1 ) );
+      const __m256d dy = _mm256_sub_pd( _mm256_loadu_pd( y + i ), _mm256_loadu_pd( y + i - 1 ) );
+      sum = _mm256_add_pd( sum, _mm256_sqrt_pd( _mm256_add_pd( _mm256_mul_pd( dx, dx ), _mm256_mul_pd( dy, dy ) ) ) );
+    }
+
+    double length = horizontalSum256( sum );
+    for ( ; i < count; ++i )
+    {
+      const double dx = x[i] - x[i - 1];
+      const double dy = y[i] - y[i - 1];
+      length += std::sqrt( dx * dx + dy * dy );
+    }
+    return length;
+  }
+
+  QGS_AVX2_TARGET double shoelaceAvx2( const double *x, const double *y, int count )
+  {
+    __m256d sum = _mm256_setzero_pd();
+    int i = 0;
+    for ( ; i + 5 <= count; i += 4 )
+    {
+      const __m256d a = _mm256_mul_pd( _mm256_loadu_pd( x + i ), _mm256_loadu_pd( y + i + 1 ) );
+      const __m256d b = _mm256_mul_pd( _mm256_loadu_pd( y + i ), _mm256_loadu_pd( x + i + 1 ) );
+      sum = _mm256_add_pd( sum, _mm256_sub_pd( a, b ) );
+    }
+
+    double result = horizontalSum256( sum );
+    for ( ; i < count - 1; ++i )
+    {
+      result += x[i] * y[i + 1] - y[i] * x[i + 1];
+    }
+    return result;
+  }
+
+  QGS_AVX2_TARGET void affineTransformAvx2( double *x, double *y, int count, double m11, double m12, double m21, double m22, double dx, double dy )
+  {
+    const __m256d vm11 = _mm256_set1_pd( m11 );
+    const __m256d vm12 = _mm256_set1_pd( m12 );
+    const __m256d vm21 = _mm256_set1_pd( m21 );
+    const __m256d vm22 = _mm256_set1_pd( m22 );
+    const __m256d vdx = _mm256_set1_pd( dx );
+    const __m256d vdy = _mm256_set1_pd( dy );
+
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+      const __m256d px = _mm256_loadu_pd( x + i );
+      const __m256d py = _mm256_loadu_pd( y + i );
+      _mm256_storeu_pd( x + i, _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( vm11, px ), _mm256_mul_pd( vm21, py ) ), vdx ) );
+      _mm256_storeu_pd( y + i, _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( vm12, px ), _mm256_mul_pd( vm22, py ) ), vdy ) );
+    }
+    affineTransformScalar( x + i, y + i, count - i, m11, m12, m21, m22, dx, dy );
+  }
+
+  QGS_AVX2_TARGET void scaleTranslateAvx2( double *values, int count, double scale, double translate )
+  {
+    const __m256d vScale = _mm256_set1_pd( scale );
+    const __m256d vTranslate = _mm256_set1_pd( translate );
+    int i = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+      _mm256_storeu_pd( values + i, _mm256_add_pd( _mm256_mul_pd( _mm256_loadu_pd( values + i ), vScale ), vTranslate ) );
+    }
+    scaleTranslateScalar( values + i, count - i, scale, translate );
+  }
+
+#endif
+
+  //
+  // Dispatch
+  //
+
+  struct KernelTable
+  {
+    void ( *boundingBox )( const double *, const double *, int, double &, double &, double &, double & );
+    double ( *length )( const double *, const double *, int );
+    double ( *shoelace )( const double *, const double *, int );
+    void ( *affineTransform )( double *, double *, int, double, double, double, double, double, double );
+    void ( *scaleTranslate )( double *, int, double, double );
+  };
+
+  const KernelTable SCALAR_KERNELS = { boundingBoxScalar, lengthScalar, shoelaceScalar, affineTransformScalar, scaleTranslateScalar };
+#ifdef QGS_KERNELS_SSE2
+  const KernelTable SSE2_KERNELS = { boundingBoxSse2, lengthSse2, shoelaceSse2, affineTransformSse2, scaleTranslateSse2 };
+#endif
+#ifdef QGS_KERNELS_AVX2
+  const KernelTable AVX2_KERNELS = { boundingBoxAvx2, lengthAvx2, shoelaceAvx2, affineTransformAvx2, scaleTranslateAvx2 };
+#endif
+
+  QgsCoordinateKernels::Implementation detectImplementation()
+  {
+#ifdef QGS_KERNELS_AVX2
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) )
+      return QgsCoordinateKernels::Avx2;
+#endif
+#ifdef QGS_KERNELS_SSE2
+    return QgsCoordinateKernels::Sse2;
+#else
+    return QgsCoordinateKernels::Scalar;
+#endif
+  }
+
+  const KernelTable *tableForImplementation( QgsCoordinateKernels::Implementation implementation )
+  {
+    switch ( implementation )
+    {
+      case QgsCoordinateKernels::Avx2:
+#ifdef QGS_KERNELS_AVX2
+        return &AVX2_KERNELS;
+#endif
+        FALLTHROUGH
+      case QgsCoordinateKernels::Sse2:
+#ifdef QGS_KERNELS_SSE2
+        return &SSE2_KERNELS;
+#endif
+        FALLTHROUGH
+      case QgsCoordinateKernels::Scalar:
+        break;
+    }
+    return &SCALAR_KERNELS;
+  }
+
+  std::atomic< const KernelTable * > sForcedKernels( nullptr );
+
+  const KernelTable *kernels()
+  {
+    if ( const KernelTable *forced = sForcedKernels.load( std::memory_order_relaxed ) )
+      return forced;
+
+    static const KernelTable *sBestKernels = tableForImplementation( detectImplementation() );
+    return sBestKernels;
+  }
+
+}
+
+QgsCoordinateKernels::Implementation QgsCoordinateKernels::bestImplementation()
+{
+  static const Implementation sBest = detectImplementation();
+  return sBest;
+}
+
+QgsCoordinateKernels::Implementation QgsCoordinateKernels::implementation()
+{
+  const KernelTable *table = kernels();
+#ifdef QGS_KERNELS_AVX2
+  if ( table == &AVX2_KERNELS )
+    return Avx2;
+#endif
+#ifdef QGS_KERNELS_SSE2
+  if ( table == &SSE2_KERNELS )
+    return Sse2;
+#endif
+  Q_UNUSED( table );
+  return Scalar;
+}
+
+void QgsCoordinateKernels::setImplementation( QgsCoordinateKernels::Implementation implementation )
+{
+  if ( implementation > bestImplementation() )
+    implementation = bestImplementation();
+  sForcedKernels.store( tableForImplementation( implementation ), std::memory_order_relaxed );
+}
+
+void QgsCoordinateKernels::boundingBox( const double *x, const double *y, int count, double &xMin, double &yMin, double &xMax, double &yMax )
+{
+  kernels()->boundingBox( x, y, count, xMin, yMin, xMax, yMax );
+}
+
+double QgsCoordinateKernels::length( const double *x, const double *y, int count )
+{
+  return kernels()->length( x, y, count );
+}
+
+double QgsCoordinateKernels::shoelace( const double *x, const double *y, int count )
+{
+  return kernels()->shoelace( x, y, count );
+}
+
+void QgsCoordinateKernels::affineTransform( double *x, double *y, int count, double m11, double m12, double m21, double m22, double dx, double dy )
+{
+  kernels()->affineTransform( x, y, count, m11, m12, m21, m22, dx, dy );
+}
+
+void QgsCoordinateKernels::scaleTranslate( double *values, int count, double scale, double translate )
+{
+  kernels()->scaleTranslate( values, count, scale, translate );
+}
+
+///@endcond
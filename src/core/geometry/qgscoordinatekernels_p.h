@@ -0,0 +1,104 @@
+/***************************************************************************
+                         qgscoordinatekernels_p.h
+                         ------------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSCOORDINATEKERNELS_P_H
+#define QGSCOORDINATEKERNELS_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+
+/**
+ * \ingroup core
+ * Vectorized loops over separate x and y coordinate arrays, as stored by QgsLineString.
+ *
+ * The best implementation supported by the CPU (AVX2, SSE2 or plain scalar code)
+ * is selected at runtime the first time a kernel is called.
+ *
+ * \since QGIS 3.4
+ */
+class CORE_EXPORT QgsCoordinateKernels
+{
+  public:
+
+    //! Available kernel implementations
+    enum Implementation
+    {
+      Scalar, //!< Portable scalar loops
+      Sse2, //!< 128 bit SSE2 kernels
+      Avx2, //!< 256 bit AVX2 kernels
+    };
+
+    /**
+     * Returns the implementation used by the kernels.
+     */
+    static Implementation implementation();
+
+    /**
+     * Returns the best implementation supported by the current CPU.
+     */
+    static Implementation bestImplementation();
+
+    /**
+     * Forces the kernels to use a specific \a implementation. If the implementation
+     * is not supported by the CPU the best supported one is used instead.
+     * This is intended for tests and benchmarks only.
+     */
+    static void setImplementation( Implementation implementation );
+
+    /**
+     * Calculates the bounding box of \a count points. NaN coordinates are ignored.
+     * If \a count is 0 the min values are set to the largest double and the max values to the lowest double.
+     */
+    static void boundingBox( const double *x, const double *y, int count, double &xMin, double &yMin, double &xMax, double &yMax );
+
+    /**
+     * Returns the sum of the 2D lengths of the \a count - 1 segments joining consecutive points.
+     */
+    static double length( const double *x, const double *y, int count );
+
+    /**
+     * Returns the sum of the cross products x[i] * y[i+1] - y[i] * x[i+1] over
+     * consecutive points, i.e. twice the signed area of a closed ring (shoelace formula).
+     */
+    static double shoelace( const double *x, const double *y, int count );
+
+    /**
+     * Applies the affine transform x' = m11 * x + m21 * y + dx, y' = m12 * x + m22 * y + dy
+     * to \a count points, in place.
+     */
+    static void affineTransform( double *x, double *y, int count, double m11, double m12, double m21, double m22, double dx, double dy );
+
+    /**
+     * Replaces each of the \a count \a values with value * scale + translate.
+     */
+    static void scaleTranslate( double *values, int count, double scale, double translate );
+};
+
+/// @endcond
+
+#endif // QGSCOORDINATEKERNELS_P_H
@@ -46,14 +46,137 @@ email                : morb at ozemail dot com dot au
 #include "qgslinestring.h"
 #include "qgscircle.h"
 #include "qgscurve.h"
+#include "qgswkbview_p.h"
+
+#include <QMutex>
+#include <atomic>
+
+///@cond PRIVATE
+
+/**
+ * Owns the abstract geometry of a QgsGeometry.
+ *
+ * Geometries created from WKB keep the WKB buffer and only parse it into a QgsAbstractGeometry
+ * the first time the abstract geometry is accessed. Until then the read-only fast paths of
+ * QgsGeometry use wkbView() instead.
+ *
+ * The interface mimics std::unique_ptr. Parsing happens on const access, possibly from
+ * several threads sharing the same private data, so it is guarded by a mutex.
+ *
+ * The WKB is released as soon as the geometry is parsed and the private data is not shared,
+ * so that parsed geometries do not keep both representations in memory. While copies share
+ * the private data, one of them may still be reading its wkbView() from another thread, so
+ * the WKB is kept until the last but one copy is gone.
+ */
+class QgsGeometryHolder
+{
+  public:
+
+    //! Constructor for QgsGeometryHolder, \a ownerRef is the reference count of the private data
+    explicit QgsGeometryHolder( const QAtomicInt &ownerRef )
+      : mOwnerRef( ownerRef )
+    {}
+    QgsGeometryHolder( const QgsGeometryHolder &other ) = delete;
+    QgsGeometryHolder &operator=( const QgsGeometryHolder &other ) = delete;
+
+    /**
+     * Defers parsing of \a wkb until the geometry is accessed. Returns false if the
+     * WKB is not supported by QgsWkbView, in which case the holder is left untouched.
+     */
+    bool setWkb( const QByteArray &wkb )
+    {
+      QgsWkbView view( wkb );
+      if ( !view.isValid() )
+        return false;
+
+      mGeometry.reset();
+      mView = view;
+      mParsed.store( false, std::memory_order_release );
+      return true;
+    }
+
+    //! Returns the WKB view if the WKB has not been parsed yet, or nullptr
+    const QgsWkbView *wkbView() const
+    {
+      return mParsed.load( std::memory_order_acquire ) ? nullptr : &mView;
+    }
+
+    //! Parses the WKB if needed and drops it, ready for the geometry to be modified
+    void dropWkb()
+    {
+      parse();
+      mView = QgsWkbView();
+    }
+
+    QgsAbstractGeometry *get() const
+    {
+      parse();
+      return mGeometry.get();
+    }
+
+    QgsAbstractGeometry *operator->() const { return get(); }
+    QgsAbstractGeometry &operator*() const { return *get(); }
+
+    explicit operator bool() const
+    {
+      // a valid view always parses to a geometry
+      return !mParsed.load( std::memory_order_acquire ) || mGeometry;
+    }
+
+    void reset( QgsAbstractGeometry *geometry = nullptr )
+    {
+      mGeometry.reset( geometry );
+      mView = QgsWkbView();
+      mParsed.store( true, std::memory_order_release );
+    }
+
+    QgsGeometryHolder &operator=( std::unique_ptr< QgsAbstractGeometry > &&geometry )
+    {
+      reset( geometry.release() );
+      return *this;
+    }
+
+    QgsAbstractGeometry *release()
+    {
+      dropWkb();
+      return mGeometry.release();
+    }
+
+  private:
+
+    void parse() const
+    {
+      if ( !mParsed.load( std::memory_order_acquire ) )
+      {
+        QMutexLocker locker( &mMutex );
+        if ( !mParsed.load( std::memory_order_relaxed ) )
+        {
+          mGeometry = mView.materialize();
+          mParsed.store( true, std::memory_order_release );
+        }
+      }
+
+      // no other copy can be holding a pointer to the view
+      if ( mView.isValid() && mOwnerRef.load() <= 1 )
+        mView = QgsWkbView();
+    }
+
+    const QAtomicInt &mOwnerRef;
+    mutable std::unique_ptr< QgsAbstractGeometry > mGeometry;
+    mutable QgsWkbView mView;
+    mutable std::atomic< bool > mParsed{ true };
+    mutable QMutex mMutex;
+};
 
 struct QgsGeometryPrivate
 {
-  QgsGeometryPrivate(): ref( 1 ) {}
+  QgsGeometryPrivate(): ref( 1 ), geometry( ref ) {}
   QAtomicInt ref;
-  std::unique_ptr< QgsAbstractGeometry > geometry;
+  QgsGeometryHolder geometry;
 };
 
+///@endcond
+
 QgsGeometry::QgsGeometry()
   : d( new QgsGeometryPrivate() )
 {
@@ -102,10 +225,16 @@ QgsGeometry &QgsGeometry::operator=( QgsGeometry const &other )
 void QgsGeometry::detach()
 {
   if ( d->ref <= 1 )
+  {
+    // the geometry is about to be modified, so the WKB it may have been created from becomes stale
+    d->geometry.dropWkb();
     return;
+  }
 
   std::unique_ptr< QgsAbstractGeometry > cGeom;
-  if ( d->geometry )
+  if ( const QgsWkbView *view = d->geometry.wkbView() )
+    cGeom = view->materialize();
+  else if ( d->geometry )
     cGeom.reset( d->geometry->clone() );
 
   reset( std::move( cGeom ) );
@@ -317,20 +446,35 @@ QgsGeometry QgsGeometry::createWedgeBuffer( const QgsPoint &center, const double
 
 void QgsGeometry::fromWkb( unsigned char *wkb, int length )
 {
-  QgsConstWkbPtr ptr( wkb, length );
-  reset( QgsGeometryFactory::geomFromWkb( ptr ) );
+  fromWkb( QByteArray( reinterpret_cast< const char * >( wkb ), length ) );
   delete [] wkb;
 }
 
 void QgsGeometry::fromWkb( const QByteArray &wkb )
 {
+  reset( nullptr );
+
+  // parsing is deferred until the abstract geometry is needed, the read-only
+  // fast paths (bounding box, type...) work directly on the WKB
+  if ( d->geometry.setWkb( wkb ) )
+    return;
+
   QgsConstWkbPtr ptr( wkb );
-  reset( QgsGeometryFactory::geomFromWkb( ptr ) );
+  d->geometry = QgsGeometryFactory::geomFromWkb( ptr );
+}
+
+const QgsWkbView *QgsGeometry::wkbView() const
+{
+  return d->geometry.wkbView();
 }
 
 QgsWkbTypes::Type QgsGeometry::wkbType() const
 {
-  if ( !d->geometry )
+  if ( const QgsWkbView *view = d->geometry.wkbView() )
+  {
+    return view->wkbType();
+  }
+  else if ( !d->geometry )
   {
     return QgsWkbTypes::Unknown;
   }
@@ -347,12 +491,16 @@ QgsWkbTypes::GeometryType QgsGeometry::type() const
   {
     return QgsWkbTypes::UnknownGeometry;
   }
-  return static_cast< QgsWkbTypes::GeometryType >( QgsWkbTypes::geometryType( d->geometry->wkbType() ) );
+  return static_cast< QgsWkbTypes::GeometryType >( QgsWkbTypes::geometryType( wkbType() ) );
 }
 
 bool QgsGeometry::isEmpty() const
 {
-  if ( !d->geometry )
+  if ( const QgsWkbView *view = d->geometry.wkbView() )
+  {
+    return view->isEmpty();
+  }
+  else if ( !d->geometry )
   {
     return true;
   }
@@ -366,7 +514,7 @@ bool QgsGeometry::isMultipart() const
   {
     return false;
   }
-  return QgsWkbTypes::isMultiType( d->geometry->wkbType() );
+  return QgsWkbTypes::isMultiType( wkbType() );
 }
 
 QgsPointXY QgsGeometry::closestVertex( const QgsPointXY &point, int &atVertex, int &beforeVertex, int &afterVertex, double &sqrDist ) const
@@ -931,7 +1079,11 @@ QgsGeometry QgsGeometry::makeDifference( const QgsGeometry &other ) const
 
 QgsRectangle QgsGeometry::boundingBox() const
 {
-  if ( d->geometry )
+  if ( const QgsWkbView *view = d->geometry.wkbView() )
+  {
+    return view->boundingBox();
+  }
+  else if ( d->geometry )
   {
     return d->geometry->boundingBox();
   }
@@ -1136,7 +1288,7 @@ bool QgsGeometry::boundingBoxIntersects( const QgsRectangle &rectangle ) const
     return false;
   }
 
-  return d->geometry->boundingBox().intersects( rectangle );
+  return boundingBox().intersects( rectangle );
 }
 
 bool QgsGeometry::boundingBoxIntersects( const QgsGeometry &geometry ) const
@@ -1146,7 +1298,7 @@ bool QgsGeometry::boundingBoxIntersects( const QgsGeometry &geometry ) const
     return false;
   }
 
-  return d->geometry->boundingBox().intersects( geometry.constGet()->boundingBox() );
+  return boundingBox().intersects( geometry.boundingBox() );
 }
 
 bool QgsGeometry::contains( const QgsPointXY *p ) const
@@ -2229,6 +2381,9 @@ QgsGeometry QgsGeometry::extrude( double x, double y )
 
 QByteArray QgsGeometry::asWkb() const
 {
+  if ( const QgsWkbView *view = d->geometry.wkbView() )
+    return view->asWkb();
+
   return d->geometry ? d->geometry->asWkb() : QByteArray();
 }
 
@@ -88,6 +88,7 @@ typedef QVector<QVector<QVector<QgsPointXY>>> QgsMultiPolygonXY;
 class QgsRectangle;
 
 class QgsConstWkbPtr;
+class QgsWkbView;
 
 struct QgsGeometryPrivate;
 
@@ -276,6 +277,10 @@ class CORE_EXPORT QgsGeometry
 
     /**
      * Set the geometry, feeding in the buffer containing OGC Well-Known Binary
+     *
+     * Points, line strings, polygons and their multi types are not parsed straight away:
+     * read-only methods such as boundingBox(), wkbType(), isEmpty() and asWkb() work
+     * directly on the WKB, which is only parsed when the geometry is accessed in any other way.
      * \since QGIS 3.0
      */
     void fromWkb( const QByteArray &wkb );
@@ -1839,6 +1844,13 @@ class CORE_EXPORT QgsGeometry
      */
     void reset( std::unique_ptr< QgsAbstractGeometry > newGeometry );
 
+    /**
+     * Returns a view over the WKB the geometry was created from, or nullptr if the
+     * WKB has already been parsed into an abstract geometry (or the geometry was not created from WKB).
+     * The view is only valid until the geometry is parsed, e.g. by constGet().
+     */
+    const QgsWkbView *wkbView() const;
+
     static void convertToPolyline( const QgsPointSequence &input, QgsPolylineXY &output );
     static void convertPolygon( const QgsPolygon &input, QgsPolygonXY &output );
 
@@ -1879,6 +1891,7 @@ class CORE_EXPORT QgsGeometry
 
 
     friend class QgsInternalGeometryEngine;
+    friend class QgsMapToPixelSimplifier;
 
 }; // class QgsGeometry
 
@@ -23,6 +23,7 @@
 #include "qgsmaptopixel.h"
 #include "qgswkbptr.h"
 #include "qgslinesegment.h"
+#include "qgscoordinatekernels_p.h"
 
 #include <cmath>
 #include <memory>
@@ -308,25 +309,8 @@ bool QgsLineString::fromWkb( QgsConstWkbPtr &wkbPtr )
 
 QgsRectangle QgsLineString::calculateBoundingBox() const
 {
-  double xmin = std::numeric_limits<double>::max();
-  double ymin = std::numeric_limits<double>::max();
-  double xmax = -std::numeric_limits<double>::max();
-  double ymax = -std::numeric_limits<double>::max();
-
-  for ( double x : mX )
-  {
-    if ( x < xmin )
-      xmin = x;
-    if ( x > xmax )
-      xmax = x;
-  }
-  for ( double y : mY )
-  {
-    if ( y < ymin )
-      ymin = y;
-    if ( y > ymax )
-      ymax = y;
-  }
+  double xmin, ymin, xmax, ymax;
+  QgsCoordinateKernels::boundingBox( mX.constData(), mY.constData(), mX.size(), xmin, ymin, xmax, ymax );
   return QgsRectangle( xmin, ymin, xmax, ymax );
 }
 
@@ -426,16 +410,7 @@ QString QgsLineString::asJson( int precision ) const
 
 double QgsLineString::length() const
 {
-  double length = 0;
-  int size = mX.size();
-  double dx, dy;
-  for ( int i = 1; i < size; ++i )
-  {
-    dx = mX.at( i ) - mX.at( i - 1 );
-    dy = mY.at( i ) - mY.at( i - 1 );
-    length += std::sqrt( dx * dx + dy * dy );
-  }
-  return length;
+  return QgsCoordinateKernels::length( mX.constData(), mY.constData(), mX.size() );
 }
 
 QgsPoint QgsLineString::startPoint() const
@@ -979,23 +954,31 @@ void QgsLineString::transform( const QgsCoordinateTransform &ct, QgsCoordinateTr
 void QgsLineString::transform( const QTransform &t, double zTranslate, double zScale, double mTranslate, double mScale )
 {
   int nPoints = numPoints();
-  bool hasZ = is3D();
-  bool hasM = isMeasure();
-  for ( int i = 0; i < nPoints; ++i )
+  double *x = mX.data();
+  double *y = mY.data();
+  if ( t.type() == QTransform::TxProject )
   {
-    qreal x, y;
-    t.map( mX.at( i ), mY.at( i ), &x, &y );
-    mX[i] = x;
-    mY[i] = y;
-    if ( hasZ )
+    for ( int i = 0; i < nPoints; ++i )
     {
-      mZ[i] = mZ.at( i ) * zScale + zTranslate;
-    }
-    if ( hasM )
-    {
-      mM[i] = mM.at( i ) * mScale + mTranslate;
+      qreal tx, ty;
+      t.map( x[i], y[i], &tx, &ty );
+      x[i] = tx;
+      y[i] = ty;
     }
   }
+  else
+  {
+    QgsCoordinateKernels::affineTransform( x, y, nPoints, t.m11(), t.m12(), t.m21(), t.m22(), t.dx(), t.dy() );
+  }
+
+  if ( is3D() )
+  {
+    QgsCoordinateKernels::scaleTranslate( mZ.data(), nPoints, zScale, zTranslate );
+  }
+  if ( isMeasure() )
+  {
+    QgsCoordinateKernels::scaleTranslate( mM.data(), nPoints, mScale, mTranslate );
+  }
   clearCache();
 }
 
@@ -1238,12 +1221,7 @@ QgsPoint QgsLineString::centroid() const
 
 void QgsLineString::sumUpArea( double &sum ) const
 {
-  int maxIndex = numPoints() - 1;
-
-  for ( int i = 0; i < maxIndex; ++i )
-  {
-    sum += 0.5 * ( mX.at( i ) * mY.at( i + 1 ) - mY.at( i ) * mX.at( i + 1 ) );
-  }
+  sum += 0.5 * QgsCoordinateKernels::shoelace( mX.constData(), mY.constData(), numPoints() );
 }
 
 void QgsLineString::importVerticesFromWkb( const QgsConstWkbPtr &wkb )
@@ -0,0 +1,430 @@
+/***************************************************************************
+                         qgswkbview.cpp
+                         --------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswkbview_p.h"
+#include "qgsgeometryfactory.h"
+#include "qgslinestring.h"
+#include "qgswkbptr.h"
+
+#include <limits>
+
+///@cond PRIVATE
+
+QgsWkbView::QgsWkbView( const QByteArray &wkb )
+  : mWkb( wkb )
+  , mSize( wkb.size() )
+{
+  init();
+}
+
+QgsWkbView::QgsWkbView( const QByteArray &wkb, int offset, int size )
+  : mWkb( wkb )
+  , mOffset( offset )
+  , mSize( size )
+{
+  init();
+}
+
+void QgsWkbView::init()
+{
+  if ( mSize <= 0 )
+    return;
+
+  QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( mWkb.constData() ) + mOffset, mSize );
+  const unsigned char *start = wkbPtr;
+  Info info;
+  try
+  {
+    if ( !scan( wkbPtr, false, info ) )
+      return;
+  }
+  catch ( const QgsWkbException & )
+  {
+    return;
+  }
+
+  mType = info.type;
+  mCoordinateCount = info.coordinateCount;
+  mIsEmpty = info.isEmpty;
+  mNativeEndian = info.nativeEndian;
+  mCanonical = info.canonical && info.nativeEndian;
+  mSize = static_cast< int >( static_cast< const unsigned char * >( wkbPtr ) - start );
+}
+
+bool QgsWkbView::scan( QgsConstWkbPtr &wkbPtr, bool isPart, QgsWkbView::Info &info )
+{
+  if ( wkbPtr.remaining() < 1 )
+    return false;
+
+  const bool nativeEndian = *static_cast< const unsigned char * >( wkbPtr ) == QgsApplication::endian();
+  const QgsWkbTypes::Type type = wkbPtr.readHeader();
+  info.type = type;
+  info.nativeEndian = nativeEndian;
+  info.canonical = true;
+
+  const int pointSize = static_cast< int >( sizeof( double ) ) * ( 2 + QgsWkbTypes::hasZ( type ) + QgsWkbTypes::hasM( type ) );
+  auto skipPoints = [&wkbPtr, pointSize]( int count ) -> bool
+  {
+    if ( count < 0 || count > wkbPtr.remaining() / pointSize )
+      return false;
+    wkbPtr += count * pointSize;
+    return true;
+  };
+
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    {
+      info.coordinateCount = 1;
+      info.isEmpty = false;
+      return skipPoints( 1 );
+    }
+
+    case QgsWkbTypes::LineString:
+    {
+      int count = 0;
+      wkbPtr >> count;
+      info.coordinateCount = count;
+      info.isEmpty = count == 0;
+      return skipPoints( count );
+    }
+
+    case QgsWkbTypes::Polygon:
+    {
+      int ringCount = 0;
+      wkbPtr >> ringCount;
+      if ( ringCount < 0 )
+        return false;
+
+      info.coordinateCount = 0;
+      info.isEmpty = true;
+      for ( int i = 0; i < ringCount; ++i )
+      {
+        int count = 0;
+        wkbPtr >> count;
+        if ( i == 0 )
+          info.isEmpty = count == 0;
+        info.coordinateCount += count;
+        if ( !skipPoints( count ) )
+          return false;
+      }
+      return true;
+    }
+
+    case QgsWkbTypes::MultiPoint:
+    case QgsWkbTypes::MultiLineString:
+    case QgsWkbTypes::MultiPolygon:
+    case QgsWkbTypes::GeometryCollection:
+    {
+      if ( isPart )
+        return false;
+
+      const bool isCollection = QgsWkbTypes::flatType( type ) == QgsWkbTypes::GeometryCollection;
+      const QgsWkbTypes::Type partFlatType = QgsWkbTypes::flatType( QgsWkbTypes::singleType( type ) );
+
+      int partCount = 0;
+      wkbPtr >> partCount;
+      if ( partCount < 0 )
+        return false;
+
+      info.coordinateCount = 0;
+      info.isEmpty = true;
+      bool hasZ = false;
+      bool hasM = false;
+      for ( int i = 0; i < partCount; ++i )
+      {
+        Info partInfo;
+        if ( !scan( wkbPtr, true, partInfo ) )
+          return false;
+
+        if ( !isCollection )
+        {
+          // multi geometries force the z/m dimensions of their parts to match the first
+          // part, so only accept the ones which would be parsed without any conversion
+          if ( QgsWkbTypes::flatType( partInfo.type ) != partFlatType )
+            return false;
+          if ( i == 0 )
+          {
+            hasZ = QgsWkbTypes::hasZ( partInfo.type );
+            hasM = QgsWkbTypes::hasM( partInfo.type );
+            info.type = QgsWkbTypes::zmType( QgsWkbTypes::flatType( type ), hasZ, hasM );
+          }
+          else if ( QgsWkbTypes::hasZ( partInfo.type ) != hasZ || QgsWkbTypes::hasM( partInfo.type ) != hasM )
+          {
+            return false;
+          }
+        }
+
+        info.coordinateCount += partInfo.coordinateCount;
+        info.isEmpty = info.isEmpty && partInfo.isEmpty;
+        info.nativeEndian = info.nativeEndian && partInfo.nativeEndian;
+        info.canonical = info.canonical && partInfo.canonical;
+      }
+      info.canonical = info.canonical && info.type == type;
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+QgsRectangle QgsWkbView::boundingBox() const
+{
+  if ( !isValid() )
+    return QgsRectangle();
+
+  QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( mWkb.constData() ) + mOffset, mSize );
+  return boundingBox( wkbPtr );
+}
+
+QgsRectangle QgsWkbView::boundingBox( QgsConstWkbPtr &wkbPtr )
+{
+  const bool swap = *static_cast< const unsigned char * >( wkbPtr ) != QgsApplication::endian();
+  const QgsWkbTypes::Type type = wkbPtr.readHeader();
+
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    {
+      const CoordinateSequence point = readSequence( wkbPtr, type, swap );
+      return QgsRectangle( point.x( 0 ), point.y( 0 ), point.x( 0 ), point.y( 0 ) );
+    }
+
+    case QgsWkbTypes::LineString:
+      return readSequence( wkbPtr, type, swap ).boundingBox();
+
+    case QgsWkbTypes::Polygon:
+    {
+      int ringCount = 0;
+      wkbPtr >> ringCount;
+      if ( ringCount == 0 )
+        return QgsRectangle();
+
+      // only the exterior ring contributes to the bounding box, interior rings are skipped
+      const QgsRectangle bbox = readSequence( wkbPtr, type, swap ).boundingBox();
+      for ( int i = 1; i < ringCount; ++i )
+      {
+        readSequence( wkbPtr, type, swap );
+      }
+      return bbox;
+    }
+
+    default:
+    {
+      int partCount = 0;
+      wkbPtr >> partCount;
+      if ( partCount == 0 )
+        return QgsRectangle();
+
+      QgsRectangle bbox = boundingBox( wkbPtr );
+      for ( int i = 1; i < partCount; ++i )
+      {
+        bbox.combineExtentWith( boundingBox( wkbPtr ) );
+      }
+      return bbox;
+    }
+  }
+}
+
+QgsWkbView::CoordinateSequence QgsWkbView::readSequence( QgsConstWkbPtr &wkbPtr, QgsWkbTypes::Type type, bool swap )
+{
+  CoordinateSequence sequence;
+  const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( type );
+  if ( flatType == QgsWkbTypes::Polygon )
+  {
+    switch ( type )
+    {
+      case QgsWkbTypes::PolygonZ:
+        sequence.mType = QgsWkbTypes::LineStringZ;
+        break;
+      case QgsWkbTypes::PolygonM:
+        sequence.mType = QgsWkbTypes::LineStringM;
+        break;
+      case QgsWkbTypes::PolygonZM:
+        sequence.mType = QgsWkbTypes::LineStringZM;
+        break;
+      case QgsWkbTypes::Polygon25D:
+        sequence.mType = QgsWkbTypes::LineString25D;
+        break;
+      default:
+        sequence.mType = QgsWkbTypes::LineString;
+        break;
+    }
+  }
+  else
+  {
+    sequence.mType = type;
+  }
+
+  if ( flatType == QgsWkbTypes::Point )
+  {
+    sequence.mCount = 1;
+  }
+  else
+  {
+    wkbPtr >> sequence.mCount;
+  }
+  sequence.mStride = static_cast< int >( sizeof( double ) ) * ( 2 + QgsWkbTypes::hasZ( type ) + QgsWkbTypes::hasM( type ) );
+  sequence.mSwap = swap;
+  sequence.mData = wkbPtr;
+  wkbPtr += sequence.mCount * sequence.mStride;
+  return sequence;
+}
+
+QgsRectangle QgsWkbView::CoordinateSequence::boundingBox() const
+{
+  double xmin = std::numeric_limits<double>::max();
+  double ymin = std::numeric_limits<double>::max();
+  double xmax = -std::numeric_limits<double>::max();
+  double ymax = -std::numeric_limits<double>::max();
+
+  for ( int i = 0; i < mCount; ++i )
+  {
+    const double px = x( i );
+    const double py = y( i );
+    if ( px < xmin )
+      xmin = px;
+    if ( px > xmax )
+      xmax = px;
+    if ( py < ymin )
+      ymin = py;
+    if ( py > ymax )
+      ymax = py;
+  }
+  return QgsRectangle( xmin, ymin, xmax, ymax );
+}
+
+std::unique_ptr< QgsLineString > QgsWkbView::CoordinateSequence::toLineString() const
+{
+  std::unique_ptr< QgsLineString > line = qgis::make_unique< QgsLineString >();
+  line->mWkbType = mType;
+
+  const bool hasZ = QgsWkbTypes::hasZ( mType );
+  const bool hasM = QgsWkbTypes::hasM( mType );
+  line->mX.resize( mCount );
+  line->mY.resize( mCount );
+  if ( hasZ )
+    line->mZ.resize( mCount );
+  if ( hasM )
+    line->mM.resize( mCount );
+
+  const unsigned char *p = mData;
+  for ( int i = 0; i < mCount; ++i, p += mStride )
+  {
+    const unsigned char *value = p;
+    line->mX[i] = read( value );
+    value += sizeof( double );
+    line->mY[i] = read( value );
+    value += sizeof( double );
+    if ( hasZ )
+    {
+      line->mZ[i] = read( value );
+      value += sizeof( double );
+    }
+    if ( hasM )
+    {
+      line->mM[i] = read( value );
+    }
+  }
+  return line;
+}
+
+QByteArray QgsWkbView::asWkb() const
+{
+  if ( !isValid() )
+    return QByteArray();
+
+  if ( !mCanonical )
+    return materialize()->asWkb();
+
+  if ( mOffset == 0 && mSize == mWkb.size() )
+    return mWkb;
+  return mWkb.mid( mOffset, mSize );
+}
+
+std::unique_ptr< QgsAbstractGeometry > QgsWkbView::materialize() const
+{
+  if ( !isValid() )
+    return nullptr;
+
+  QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( mWkb.constData() ) + mOffset, mSize );
+  return QgsGeometryFactory::geomFromWkb( wkbPtr );
+}
+
+QVector< QgsWkbView > QgsWkbView::parts() const
+{
+  QVector< QgsWkbView > parts;
+  if ( !isValid() )
+    return parts;
+
+  if ( !QgsWkbTypes::isMultiType( mType ) )
+  {
+    parts << *this;
+    return parts;
+  }
+
+  const unsigned char *start = reinterpret_cast< const unsigned char * >( mWkb.constData() );
+  QgsConstWkbPtr wkbPtr( start + mOffset, mSize );
+  wkbPtr.readHeader();
+  int partCount = 0;
+  wkbPtr >> partCount;
+  parts.reserve( partCount );
+  for ( int i = 0; i < partCount; ++i )
+  {
+    const int offset = static_cast< int >( static_cast< const unsigned char * >( wkbPtr ) - start );
+    QgsWkbView part( mWkb, offset, wkbPtr.remaining() );
+    wkbPtr += part.mSize;
+    parts << part;
+  }
+  return parts;
+}
+
+QVector< QgsWkbView::CoordinateSequence > QgsWkbView::sequences() const
+{
+  QVector< CoordinateSequence > sequences;
+  if ( !isValid() || QgsWkbTypes::isMultiType( mType ) )
+    return sequences;
+
+  QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( mWkb.constData() ) + mOffset, mSize );
+  const bool swap = !mNativeEndian;
+  const QgsWkbTypes::Type type = wkbPtr.readHeader();
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    case QgsWkbTypes::LineString:
+      sequences << readSequence( wkbPtr, type, swap );
+      break;
+
+    case QgsWkbTypes::Polygon:
+    {
+      int ringCount = 0;
+      wkbPtr >> ringCount;
+      sequences.reserve( ringCount );
+      for ( int i = 0; i < ringCount; ++i )
+      {
+        sequences << readSequence( wkbPtr, type, swap );
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+  return sequences;
+}
+
+///@endcond
@@ -0,0 +1,203 @@
+/***************************************************************************
+                         qgswkbview_p.h
+                         --------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWKBVIEW_P_H
+#define QGSWKBVIEW_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+#include "qgsapplication.h"
+#include "qgsrectangle.h"
+#include "qgswkbtypes.h"
+
+#include <QByteArray>
+#include <QVector>
+#include <cstring>
+#include <memory>
+
+class QgsAbstractGeometry;
+class QgsConstWkbPtr;
+class QgsLineString;
+
+/**
+ * \ingroup core
+ * A read-only view over a WKB geometry, which answers the cheap questions (type, bounding box,
+ * coordinates) straight from the WKB buffer without creating a QgsAbstractGeometry.
+ *
+ * Only points, line strings, polygons and their multi and collection types are supported.
+ * The WKB is checked when the view is created, and isValid() returns false for anything
+ * else (curves, triangles, nested collections, truncated buffers...). In that case the WKB
+ * must be parsed with QgsGeometryFactory instead.
+ *
+ * All results match the ones of the geometry created by QgsGeometryFactory::geomFromWkb().
+ *
+ * \since QGIS 3.4
+ */
+class CORE_EXPORT QgsWkbView
+{
+  public:
+
+    /**
+     * The coordinates of a point, of a line string or of a polygon ring, as stored in the WKB.
+     */
+    class CoordinateSequence
+    {
+      public:
+
+        //! Returns the number of points in the sequence
+        int count() const { return mCount; }
+
+        /**
+         * Returns the WKB type of the sequence, i.e. the type of the point or line string,
+         * or the line string type matching the polygon for rings.
+         */
+        QgsWkbTypes::Type wkbType() const { return mType; }
+
+        //! Returns the x coordinate of the point at \a index
+        double x( int index ) const { return read( mData + index * mStride ); }
+
+        //! Returns the y coordinate of the point at \a index
+        double y( int index ) const { return read( mData + index * mStride + sizeof( double ) ); }
+
+        //! Returns true if the coordinates are stored using the byte order of the current platform
+        bool isNativeEndian() const { return !mSwap; }
+
+        /**
+         * Returns a pointer to the first x coordinate. Consecutive coordinates are stride() bytes apart,
+         * and the y coordinate follows the x coordinate. The data is not necessarily aligned.
+         */
+        const unsigned char *data() const { return mData; }
+
+        //! Returns the distance in bytes between two consecutive points
+        int stride() const { return mStride; }
+
+        //! Returns the bounding box of the points, as calculated by QgsLineString
+        QgsRectangle boundingBox() const;
+
+        //! Creates a line string (including z and m values) from the sequence
+        std::unique_ptr< QgsLineString > toLineString() const;
+
+      private:
+
+        double read( const unsigned char *p ) const
+        {
+          double value;
+          std::memcpy( &value, p, sizeof( double ) );
+          if ( mSwap )
+            QgsApplication::endian_swap( value );
+          return value;
+        }
+
+        QgsWkbTypes::Type mType = QgsWkbTypes::Unknown;
+        const unsigned char *mData = nullptr;
+        int mCount = 0;
+        int mStride = 0;
+        bool mSwap = false;
+
+        friend class QgsWkbView;
+    };
+
+    //! Constructs an invalid view
+    QgsWkbView() = default;
+
+    /**
+     * Constructs a view over \a wkb. The WKB is validated but not parsed.
+     */
+    explicit QgsWkbView( const QByteArray &wkb );
+
+    //! Returns true if the WKB is well formed and supported by the view
+    bool isValid() const { return mType != QgsWkbTypes::Unknown; }
+
+    //! Returns the WKB type of the geometry, see QgsAbstractGeometry::wkbType()
+    QgsWkbTypes::Type wkbType() const { return mType; }
+
+    //! Returns true if the geometry is empty, see QgsAbstractGeometry::isEmpty()
+    bool isEmpty() const { return mIsEmpty; }
+
+    //! Returns the number of coordinates, see QgsAbstractGeometry::nCoordinates()
+    int nCoordinates() const { return mCoordinateCount; }
+
+    //! Returns true if the whole WKB uses the byte order of the current platform
+    bool isNativeEndian() const { return mNativeEndian; }
+
+    //! Returns the bounding box of the geometry, see QgsAbstractGeometry::boundingBox()
+    QgsRectangle boundingBox() const;
+
+    /**
+     * Returns the WKB representation of the geometry, see QgsAbstractGeometry::asWkb().
+     * The original buffer is returned whenever it matches what the parsed geometry would write.
+     */
+    QByteArray asWkb() const;
+
+    //! Parses the WKB into a geometry
+    std::unique_ptr< QgsAbstractGeometry > materialize() const;
+
+    /**
+     * Returns the parts of a multi geometry or geometry collection. Single geometries
+     * return a list containing a copy of the view itself.
+     */
+    QVector< QgsWkbView > parts() const;
+
+    /**
+     * Returns the coordinate sequences of a single geometry: the point, the line string or
+     * the polygon rings (exterior ring first). Returns an empty list for collections.
+     */
+    QVector< CoordinateSequence > sequences() const;
+
+  private:
+
+    struct Info
+    {
+      QgsWkbTypes::Type type = QgsWkbTypes::Unknown;
+      int coordinateCount = 0;
+      bool isEmpty = true;
+      bool nativeEndian = true;
+      bool canonical = true;
+    };
+
+    QgsWkbView( const QByteArray &wkb, int offset, int size );
+
+    void init();
+    static bool scan( QgsConstWkbPtr &wkbPtr, bool isPart, Info &info );
+    static QgsRectangle boundingBox( QgsConstWkbPtr &wkbPtr );
+    static CoordinateSequence readSequence( QgsConstWkbPtr &wkbPtr, QgsWkbTypes::Type type, bool swap );
+
+    QByteArray mWkb;
+    int mOffset = 0;
+    int mSize = 0;
+
+    QgsWkbTypes::Type mType = QgsWkbTypes::Unknown;
+    int mCoordinateCount = 0;
+    bool mIsEmpty = true;
+    bool mNativeEndian = true;
+    bool mCanonical = true;
+};
+
+/// @endcond
+
+#endif // QGSWKBVIEW_P_H
@@ -80,6 +80,8 @@ FeaturePart::~FeaturePart()
 
   qDeleteAll( mHoles );
   mHoles.clear();
+
+  qDeleteAll( mPreparedCandidates );
 }
 
 void FeaturePart::extractCoords( const GEOSGeometry *geom )
@@ -1519,6 +1521,35 @@ int FeaturePart::createCandidatesForPolygon( QList< LabelPosition *> &lPos, Poin
 int FeaturePart::createCandidates( QList< LabelPosition *> &lPos,
                                    const GEOSPreparedGeometry *mapBoundary,
                                    PointSet *mapShape, RTree<LabelPosition *, double, 2, double> *candidates )
+{
+  if ( mHasPreparedCandidates && mapShape == this )
+  {
+    lPos << mPreparedCandidates;
+    mPreparedCandidates.clear();
+    mHasPreparedCandidates = false;
+  }
+  else
+  {
+    generateCandidates( lPos, mapBoundary, mapShape );
+  }
+
+  for ( LabelPosition *pos : qgis::as_const( lPos ) )
+    pos->insertIntoIndex( candidates );
+
+  std::sort( lPos.begin(), lPos.end(), CostCalculator::candidateSortGrow );
+  return lPos.count();
+}
+
+void FeaturePart::prepareCandidates( const GEOSPreparedGeometry *mapBoundary )
+{
+  qDeleteAll( mPreparedCandidates );
+  mPreparedCandidates.clear();
+  generateCandidates( mPreparedCandidates, mapBoundary, this );
+  mHasPreparedCandidates = true;
+}
+
+void FeaturePart::generateCandidates( QList< LabelPosition *> &lPos,
+                                      const GEOSPreparedGeometry *mapBoundary, PointSet *mapShape )
 {
   double angle = mLF->hasFixedAngle() ? mLF->fixedAngle() : 0.0;
 
@@ -1587,14 +1618,7 @@ int FeaturePart::createCandidates( QList< LabelPosition *> &lPos,
       i.remove();
       delete pos;
     }
-    else   // this one is OK
-    {
-      pos->insertIntoIndex( candidates );
-    }
   }
-
-  std::sort( lPos.begin(), lPos.end(), CostCalculator::candidateSortGrow );
-  return lPos.count();
 }
 
 void FeaturePart::addSizePenalty( int nbp, QList< LabelPosition * > &lPos, double bbx[4], double bby[4] )
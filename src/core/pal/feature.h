@@ -137,6 +137,14 @@ namespace pal
        */
       int createCandidates( QList<LabelPosition *> &lPos, const GEOSPreparedGeometry *mapBoundary, PointSet *mapShape, RTree<LabelPosition *, double, 2, double> *candidates );
 
+      /**
+       * Generates the candidates of the part ahead of the problem extraction, while
+       * other features are still being registered. They are returned by the next call
+       * to createCandidates() for the part itself, which must use the same \a mapBoundary.
+       * \since QGIS 3.4
+       */
+      void prepareCandidates( const GEOSPreparedGeometry *mapBoundary );
+
       /**
        * Generate candidates for point feature, located around a specified point.
        * \param x x coordinate of the point
@@ -312,6 +320,13 @@ namespace pal
     private:
 
       LabelPosition::Quadrant quadrantFromOffset() const;
+
+      //! Generates the candidates which are within \a mapBoundary, without indexing nor sorting them
+      void generateCandidates( QList<LabelPosition *> &lPos, const GEOSPreparedGeometry *mapBoundary, PointSet *mapShape );
+
+      //! Candidates generated by prepareCandidates()
+      QList<LabelPosition *> mPreparedCandidates;
+      bool mHasPreparedCandidates = false;
   };
 
 } // end namespace pal
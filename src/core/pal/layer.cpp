@@ -287,6 +287,26 @@ bool Layer::registerFeature( QgsLabelFeature *lf )
 }
 
 
+void Layer::prepareCandidates( const GEOSPreparedGeometry *mapBoundary )
+{
+  mMutex.lock();
+  const QList<FeaturePart *> parts = mUnpreparedParts;
+  mUnpreparedParts.clear();
+  mMutex.unlock();
+
+  // merged and chopped parts are replaced during the extraction
+  if ( mMergeLines )
+    return;
+
+  for ( FeaturePart *fpart : parts )
+  {
+    if ( fpart->repeatDistance() != 0. && fpart->getGeosType() == GEOS_LINESTRING )
+      continue;
+
+    fpart->prepareCandidates( mapBoundary );
+  }
+}
+
 void Layer::addFeaturePart( FeaturePart *fpart, const QString &labelText )
 {
   double bmin[2];
@@ -295,6 +315,8 @@ void Layer::addFeaturePart( FeaturePart *fpart, const QString &labelText )
 
   // add to list of layer's feature parts
   mFeatureParts << fpart;
+  if ( mPrepareCandidates )
+    mUnpreparedParts << fpart;
 
   // add to r-tree for fast spatial access
   mFeatureIndex->Insert( bmin, bmax, fpart );
@@ -228,6 +228,22 @@ namespace pal
        */
       UpsideDownLabels upsidedownLabels() const { return mUpsidedownLabels; }
 
+      /**
+       * Sets whether the feature parts registered from now on should be kept
+       * for prepareCandidates().
+       * \since QGIS 3.4
+       */
+      void setPrepareCandidates( bool prepare ) { mPrepareCandidates = prepare; }
+
+      /**
+       * Generates the candidates of the feature parts registered since the last call, so
+       * that they are ready when the problem is extracted. Parts which are modified before
+       * the extraction (merged lines and lines chopped at a repeat distance) are skipped.
+       * \see setPrepareCandidates()
+       * \since QGIS 3.4
+       */
+      void prepareCandidates( const GEOSPreparedGeometry *mapBoundary );
+
       /**
        * Sets whether labels placed at the centroid of features within the layer
        * are forced to be placed inside the feature's geometry.
@@ -310,6 +326,10 @@ namespace pal
 
       QMutex mMutex;
 
+      bool mPrepareCandidates = false;
+      //! Parts registered since the last call to prepareCandidates()
+      QList<FeaturePart *> mUnpreparedParts;
+
       /**
        * \brief Create a new layer
        *
@@ -42,6 +42,7 @@
 #include "internalexception.h"
 #include "util.h"
 #include <cfloat>
+#include <QtConcurrentMap>
 
 using namespace pal;
 
@@ -461,12 +462,29 @@ QList<LabelPosition *> Pal::solveProblem( Problem *prob, bool displayAll )
 
   try
   {
-    if ( searchMethod == FALP )
-      prob->init_sol_falp();
-    else if ( searchMethod == CHAIN )
-      prob->chain_search();
+    // POPMUSIC searches build their sub problems from the neighborhood of each feature,
+    // which is only the same in a group of labels for the FALP and chain searches
+    if ( mParallelSolving && ( searchMethod == FALP || searchMethod == CHAIN ) )
+    {
+      // groups of labels which cannot collide with each other are solved concurrently,
+      // then merged back in the order of their features
+      std::vector< std::unique_ptr< Problem > > components = prob->splitIntoComponents();
+      QtConcurrent::blockingMap( components, [this]( std::unique_ptr< Problem > &component )
+      {
+        try
+        {
+          solve( component.get() );
+        }
+        catch ( InternalException::Empty & )
+        {
+        }
+      } );
+      prob->mergeComponents( components );
+    }
     else
-      prob->popmusic();
+    {
+      solve( prob );
+    }
   }
   catch ( InternalException::Empty & )
   {
@@ -476,6 +494,16 @@ QList<LabelPosition *> Pal::solveProblem( Problem *prob, bool displayAll )
   return prob->getSolution( displayAll );
 }
 
+void Pal::solve( Problem *prob )
+{
+  if ( searchMethod == FALP )
+    prob->init_sol_falp();
+  else if ( searchMethod == CHAIN )
+    prob->chain_search();
+  else
+    prob->popmusic();
+}
+
 
 void Pal::setPointP( int point_p )
 {
@@ -143,6 +143,10 @@ namespace pal
        */
       std::unique_ptr< Problem > extractProblem( const QgsRectangle &extent, const QgsGeometry &mapBoundary );
 
+      /**
+       * Solves the problem \a prob, using the search method in use and
+       * splitting it into independent problems if parallelSolving() is enabled.
+       */
       QList<LabelPosition *> solveProblem( Problem *prob, bool displayAll );
 
       /**
@@ -211,6 +215,22 @@ namespace pal
        */
       SearchMethod getSearch();
 
+      /**
+       * Sets whether independent groups of conflicting labels are solved in parallel
+       * by solveProblem(). The solution is the same as when solving the whole problem
+       * at once. Only the FALP and chain searches are run in parallel.
+       * \see parallelSolving()
+       * \since QGIS 3.4
+       */
+      void setParallelSolving( bool parallel ) { mParallelSolving = parallel; }
+
+      /**
+       * Returns whether independent groups of conflicting labels are solved in parallel.
+       * \see setParallelSolving()
+       * \since QGIS 3.4
+       */
+      bool parallelSolving() const { return mParallelSolving; }
+
     private:
 
       QHash< QgsAbstractLabelProvider *, Layer * > mLayers;
@@ -251,6 +271,9 @@ namespace pal
        */
       bool showPartial;
 
+      //! Solve independent groups of labels in parallel
+      bool mParallelSolving = false;
+
       //! Callback that may be called from PAL to check whether the job has not been canceled in meanwhile
       FnIsCanceled fnIsCanceled;
       //! Application-specific context for the cancelation check function
@@ -263,6 +286,9 @@ namespace pal
        */
       std::unique_ptr< Problem > extract( const QgsRectangle &extent, const QgsGeometry &mapBoundary );
 
+      //! Runs the search method in use on the reduced problem \a prob
+      void solve( Problem *prob );
+
       /**
        * \brief Choose the size of popmusic subpart's
        * \param r subpart size
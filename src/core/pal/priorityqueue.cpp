@@ -165,6 +165,14 @@ void PriorityQueue::sort()
 }
 
 
+bool PriorityQueue::lowerPriority( int i, int j ) const
+{
+  // ties are broken by key, so that the best element does not depend on the heap layout
+  if ( p[i] == p[j] )
+    return heap[i] > heap[j];
+  return greater( p[i], p[j] );
+}
+
 void PriorityQueue::upheap( int key )
 {
   int i;
@@ -183,7 +191,7 @@ void PriorityQueue::upheap( int key )
   {
     while ( i > 0 )
     {
-      if ( greater( p[PARENT( i )], p[i] ) )
+      if ( lowerPriority( PARENT( i ), i ) )
       {
         i2 = PARENT( i );
 
@@ -220,7 +228,7 @@ void PriorityQueue::downheap( int id )
     {
       if ( RIGHT( id ) < size )
       {
-        min_child = greater( p[RIGHT( id )], p[LEFT( id )] ) ? LEFT( id ) : RIGHT( id );
+        min_child = lowerPriority( RIGHT( id ), LEFT( id ) ) ? LEFT( id ) : RIGHT( id );
       }
       else
         min_child = LEFT( id );
@@ -228,7 +236,7 @@ void PriorityQueue::downheap( int id )
     else // leaf
       break;
 
-    if ( greater( p[id], p[min_child] ) )
+    if ( lowerPriority( id, min_child ) )
     {
       pos[heap[id]] = min_child;
       pos[heap[min_child]] = id;
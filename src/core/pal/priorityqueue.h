@@ -99,6 +99,12 @@ namespace pal
       int *pos = nullptr;
 
       bool ( *greater )( double l, double r );
+
+      /**
+       * Returns true if the element at heap index \a i comes after the element
+       * at heap index \a j. Elements with the same priority are ordered by key.
+       */
+      bool lowerPriority( int i, int j ) const;
   };
 
 } // namespace
@@ -40,6 +40,7 @@
 #include "internalexception.h"
 #include <cfloat>
 #include <limits> //for std::numeric_limits<int>::max()
+#include <algorithm>
 
 #include "qgslabelingengine.h"
 
@@ -79,7 +80,8 @@ Problem::~Problem()
   delete[] featStartId;
   delete[] featNbLp;
 
-  qDeleteAll( mLabelPositions );
+  if ( mOwnsLabelPositions )
+    qDeleteAll( mLabelPositions );
   mLabelPositions.clear();
 
   delete[] inactiveCost;
@@ -1583,10 +1585,15 @@ inline Chain *Problem::chain( int seed )
               newChain->delta = delta + mLabelPositions.at( newChain->label[j] )->cost();
               j++;
 
-              // hide all conflictual candidates
+              // hide all conflictual candidates, in feature order so that the costs
+              // are summed up in the same order whatever the layout of the index
+              QVector< int > conflictFeatures;
               while ( !conflicts->isEmpty() )
+                conflictFeatures.append( conflicts->takeFirst() );
+              std::sort( conflictFeatures.begin(), conflictFeatures.end() );
+
+              for ( int ftid : qgis::as_const( conflictFeatures ) )
               {
-                int ftid = conflicts->takeFirst();
                 newChain->feat[j] = ftid;
                 newChain->label[j] = -1;
                 newChain->delta += inactiveCost[ftid];
@@ -2149,25 +2156,34 @@ void Problem::chain_search()
   //check_solution();
   solution_cost();
 
-  int iter = 0;
+  // seeds are visited in feature order, cycling from the previous seed. Independent
+  // groups of features are then visited in the same order whether they are solved
+  // together or separately (see splitIntoComponents())
+  seed = -1;
 
   while ( true )
   {
 
     //check_solution();
 
-    for ( seed = ( iter + 1 ) % nbft;
-          ok[seed] && seed != iter;
-          seed = ( seed + 1 ) % nbft )
-      ;
+    int next = -1;
+    for ( int k = 1; k <= nbft; k++ )
+    {
+      const int feat = ( seed + k ) % nbft;
+      if ( !ok[feat] )
+      {
+        next = feat;
+        break;
+      }
+    }
 
     // All seeds are OK
-    if ( seed == iter )
+    if ( next == -1 )
     {
       break;
     }
 
-    iter = ( iter + 1 ) % nbft;
+    seed = next;
     retainedChain = chain( seed );
 
     if ( retainedChain && retainedChain->delta < - EPSILON )
@@ -2252,6 +2268,155 @@ QList<LabelPosition *> Problem::getSolution( bool returnInactive )
   return solList;
 }
 
+typedef struct
+{
+  LabelPosition *lp = nullptr;
+  std::vector< int > *groups = nullptr;
+} ComponentContext;
+
+static int componentRoot( std::vector< int > &groups, int feature )
+{
+  while ( groups[feature] != feature )
+  {
+    groups[feature] = groups[groups[feature]];
+    feature = groups[feature];
+  }
+  return feature;
+}
+
+bool componentCallback( LabelPosition *lp, void *ctx )
+{
+  ComponentContext *context = reinterpret_cast< ComponentContext * >( ctx );
+
+  if ( context->lp->isInConflict( lp ) )
+  {
+    int root1 = componentRoot( *context->groups, context->lp->getProblemFeatureId() );
+    int root2 = componentRoot( *context->groups, lp->getProblemFeatureId() );
+    // the smallest feature id is the root, which keeps the split independent of the search order
+    if ( root1 < root2 )
+      ( *context->groups )[root2] = root1;
+    else if ( root2 < root1 )
+      ( *context->groups )[root1] = root2;
+  }
+
+  return true;
+}
+
+std::vector< std::unique_ptr< Problem > > Problem::splitIntoComponents()
+{
+  std::vector< std::unique_ptr< Problem > > components;
+
+  init_sol_empty();
+
+  std::vector< int > groups( nbft );
+  for ( int i = 0; i < nbft; i++ )
+    groups[i] = i;
+
+  ComponentContext context;
+  context.groups = &groups;
+  double amin[2];
+  double amax[2];
+
+  for ( int i = 0; i < nbft; i++ )
+  {
+    for ( int j = 0; j < featNbLp[i]; j++ )
+    {
+      context.lp = mLabelPositions.at( featStartId[i] + j );
+      context.lp->getBoundingBox( amin, amax );
+      candidates->Search( amin, amax, componentCallback, reinterpret_cast< void * >( &context ) );
+    }
+  }
+
+  std::vector< QVector< int > > members( nbft );
+  for ( int i = 0; i < nbft; i++ )
+    members[componentRoot( groups, i )].append( i );
+
+  // features without conflicts are solved together, as a single problem
+  QVector< int > isolated;
+  for ( int root = 0; root < nbft; root++ )
+  {
+    if ( members[root].size() == 1 )
+      isolated.append( root );
+  }
+
+  auto addComponent = [this, &components]( const QVector< int > &features )
+  {
+    std::unique_ptr< Problem > component = qgis::make_unique< Problem >();
+    component->pal = pal;
+    component->displayAll = displayAll;
+    for ( int k = 0; k < 4; k++ )
+      component->bbox[k] = bbox[k];
+
+    component->mOwnsLabelPositions = false;
+    component->mComponentFeatureIds = features;
+    component->nbft = features.size();
+    component->featStartId = new int[component->nbft];
+    component->featNbLp = new int[component->nbft];
+    component->inactiveCost = new double[component->nbft];
+
+    // features and candidates keep the order they have in this problem, so that the
+    // solvers visit them and break ties between them in the same order
+    int nbOverlaps = 0;
+    for ( int k = 0; k < component->nbft; k++ )
+    {
+      const int feature = features.at( k );
+      component->featStartId[k] = component->mLabelPositions.size();
+      component->featNbLp[k] = featNbLp[feature];
+      component->inactiveCost[k] = inactiveCost[feature];
+
+      for ( int j = 0; j < featNbLp[feature]; j++ )
+      {
+        LabelPosition *lp = mLabelPositions.at( featStartId[feature] + j );
+        lp->setProblemIds( k, component->mLabelPositions.size() );
+        lp->insertIntoIndex( component->candidates );
+        nbOverlaps += lp->getNumOverlaps();
+        component->mLabelPositions.append( lp );
+      }
+    }
+
+    component->nblp = component->mLabelPositions.size();
+    component->all_nblp = component->nblp;
+    component->nbOverlap = nbOverlaps / 2;
+    components.push_back( std::move( component ) );
+  };
+
+  if ( !isolated.isEmpty() )
+    addComponent( isolated );
+
+  for ( int root = 0; root < nbft; root++ )
+  {
+    if ( members[root].size() > 1 )
+      addComponent( members[root] );
+  }
+
+  return components;
+}
+
+void Problem::mergeComponents( const std::vector< std::unique_ptr< Problem > > &components )
+{
+  for ( const std::unique_ptr< Problem > &component : components )
+  {
+    for ( int k = 0; k < component->nbft; k++ )
+    {
+      const int feature = component->mComponentFeatureIds.at( k );
+      const int local = component->sol ? component->sol->s[k] : -1;
+      sol->s[feature] = local >= 0 ? featStartId[feature] + local - component->featStartId[k] : -1;
+
+      // give the candidates back their ids in this problem
+      for ( int j = 0; j < featNbLp[feature]; j++ )
+        mLabelPositions.at( featStartId[feature] + j )->setProblemIds( feature, featStartId[feature] + j );
+    }
+  }
+
+  for ( int i = 0; i < nbft; i++ )
+  {
+    if ( sol->s[i] != -1 )
+      mLabelPositions.at( sol->s[i] )->insertIntoIndex( candidates_sol );
+  }
+
+  solution_cost();
+}
+
 PalStat *Problem::getStats()
 {
   int i, j;
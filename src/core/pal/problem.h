@@ -35,7 +35,10 @@
 
 #include "qgis_core.h"
 #include <list>
+#include <memory>
+#include <vector>
 #include <QList>
+#include <QVector>
 #include "rtree.hpp"
 
 namespace pal
@@ -152,6 +155,30 @@ namespace pal
 
       QList<LabelPosition *> getSolution( bool returnInactive );
 
+      /**
+       * Splits the problem into independent problems, one for each group of features
+       * whose candidates conflict with each other, so that the groups can be solved
+       * concurrently. Features without any conflicting candidate are gathered in a
+       * single problem.
+       *
+       * Features and candidates keep their relative order, so the FALP and chain
+       * searches give the same solution as when solving the whole problem.
+       *
+       * Must be called after reduce(). The candidates stay owned by this problem, and
+       * mergeComponents() must be called once the returned problems have been solved.
+       *
+       * \since QGIS 3.4
+       */
+      std::vector< std::unique_ptr< Problem > > splitIntoComponents();
+
+      /**
+       * Builds the solution of this problem from the solved \a components returned
+       * by splitIntoComponents().
+       *
+       * \since QGIS 3.4
+       */
+      void mergeComponents( const std::vector< std::unique_ptr< Problem > > &components );
+
       PalStat *getStats();
 
       /* useful only for postscript post-conversion*/
@@ -229,6 +256,12 @@ namespace pal
 
       QList< LabelPosition * > mLabelPositions;
 
+      //! False for the components created by splitIntoComponents(), which share the candidates of their parent
+      bool mOwnsLabelPositions = true;
+
+      //! Feature ids in the parent problem, for the components created by splitIntoComponents()
+      QVector< int > mComponentFeatureIds;
+
       RTree<LabelPosition *, double, 2, double> *candidates = nullptr; // index all candidates
       RTree<LabelPosition *, double, 2, double> *candidates_sol = nullptr; // index active candidates
       RTree<LabelPosition *, double, 2, double> *candidates_subsol = nullptr; // idem for subparts
@@ -18,11 +18,13 @@
 #include "qgsgeometry.h"
 #include "qgsgeometryengine.h"
 #include "qgslogger.h"
-#include "qgsspatialindex.h"
+#include "qgsfeaturebatch.h"
 #include "qgsmessagelog.h"
 #include "qgsproject.h"
 #include "qgsexception.h"
 
+#include <algorithm>
+
 ///@cond PRIVATE
 
 QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
@@ -58,22 +60,31 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource *sour
 
   // if there's spatial index, use it!
   // (but don't use it when selection rect is not specified)
-  if ( !mFilterRect.isNull() && mSource->mSpatialIndex )
+  if ( !mFilterRect.isNull() && mSource->mStore.hasSpatialIndex() )
   {
-    mUsingFeatureIdList = true;
-    mFeatureIdList = mSource->mSpatialIndex->intersects( mFilterRect );
-    QgsDebugMsg( "Features returned by spatial index: " + QString::number( mFeatureIdList.count() ) );
+    mUsingRowList = true;
+    mRowList = mSource->mStore.intersects( mFilterRect );
+    QgsDebugMsg( "Features returned by spatial index: " + QString::number( mRowList.count() ) );
   }
   else if ( mRequest.filterType() == QgsFeatureRequest::FilterFid )
   {
-    mUsingFeatureIdList = true;
-    QgsFeatureMap::const_iterator it = mSource->mFeatures.constFind( mRequest.filterFid() );
-    if ( it != mSource->mFeatures.constEnd() )
-      mFeatureIdList.append( mRequest.filterFid() );
+    mUsingRowList = true;
+    const int row = mSource->mStore.rowForId( mRequest.filterFid() );
+    if ( row >= 0 )
+      mRowList.append( row );
   }
   else
   {
-    mUsingFeatureIdList = false;
+    mUsingRowList = false;
+  }
+
+  // the subset string, filter expressions and order by clauses are evaluated on the
+  // returned features, so they get everything
+  if ( !mSubsetExpression && mRequest.filterType() != QgsFeatureRequest::FilterExpression && mRequest.orderBy().isEmpty() )
+  {
+    if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
+      mAttributes = qgis::make_unique< QgsAttributeList >( mRequest.subsetOfAttributes() );
+    mFetchGeometry = !( mRequest.flags() & QgsFeatureRequest::NoGeometry );
   }
 
   rewind();
@@ -91,115 +102,122 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature &feature )
   if ( mClosed )
     return false;
 
-  if ( mUsingFeatureIdList )
-    return nextFeatureUsingList( feature );
-  else
-    return nextFeatureTraverseAll( feature );
-}
+  const int row = nextRow();
+  if ( row < 0 )
+  {
+    close();
+    return false;
+  }
 
+  feature = mSource->mStore.feature( row, mSource->mFields, mAttributes.get(), mFetchGeometry ); // allow name-based attribute lookups
+  geometryToDestinationCrs( feature, mTransform );
+  return true;
+}
 
-bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
+int QgsMemoryFeatureIterator::nextRow()
 {
-  bool hasFeature = false;
-
-  // option 1: we have a list of features to traverse
-  while ( mFeatureIdListIterator != mFeatureIdList.constEnd() )
+  const QgsMemoryFeatureStore &store = mSource->mStore;
+  for ( ;; )
   {
-    if ( !mFilterRect.isNull() && mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+    int row;
+    if ( mUsingRowList )
     {
+      // option 1: we have a list of features to traverse
+      if ( mRowListIndex >= mRowList.size() )
+        return -1;
+      row = mRowList.at( mRowListIndex++ );
+
       // do exact check in case we're doing intersection
-      if ( mSource->mFeatures.value( *mFeatureIdListIterator ).hasGeometry() && mSelectRectEngine->intersects( mSource->mFeatures.value( *mFeatureIdListIterator ).geometry().constGet() ) )
-        hasFeature = true;
+      if ( !mFilterRect.isNull() && mRequest.flags() & QgsFeatureRequest::ExactIntersect && !rowIntersectsFilterRect( row ) )
+        continue;
     }
     else
-      hasFeature = true;
+    {
+      // option 2: traversing the whole layer
+      if ( mNextRow >= store.rowCount() )
+        return -1;
+      row = mNextRow++;
+
+      if ( store.isDeleted( row ) )
+        continue;
+
+      // selection rect empty => using all features
+      if ( !mFilterRect.isNull() && !rowIntersectsFilterRect( row ) )
+        continue;
+    }
 
     if ( mSubsetExpression )
     {
-      mSource->mExpressionContext.setFeature( mSource->mFeatures.value( *mFeatureIdListIterator ) );
+      mSource->mExpressionContext.setFeature( store.feature( row, mSource->mFields ) );
       if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
-        hasFeature = false;
+        continue;
     }
 
-    if ( hasFeature )
-      break;
-
-    ++mFeatureIdListIterator;
+    return row;
   }
+}
+
+bool QgsMemoryFeatureIterator::rowIntersectsFilterRect( int row ) const
+{
+  const QgsMemoryFeatureStore &store = mSource->mStore;
+  if ( !store.hasGeometry( row ) )
+    return false;
 
-  // copy feature
-  if ( hasFeature )
+  if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
   {
-    feature = mSource->mFeatures.value( *mFeatureIdListIterator );
-    ++mFeatureIdListIterator;
+    // using exact test when checking for intersection
+    const QgsGeometry geometry = store.geometry( row );
+    return mSelectRectEngine->intersects( geometry.constGet() );
   }
-  else
-    close();
 
-  if ( hasFeature )
+  // check just bounding box against rect when not using intersection
+  return store.boundingBox( row ).intersects( mFilterRect );
+}
+
+bool QgsMemoryFeatureIterator::canReadBatch() const
+{
+  switch ( mRequest.filterType() )
   {
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
+    case QgsFeatureRequest::FilterNone:
+      break;
+    case QgsFeatureRequest::FilterFid:
+    case QgsFeatureRequest::FilterFids:
+    case QgsFeatureRequest::FilterExpression:
+      return false;
   }
 
-  return hasFeature;
+  // everything fetchFeature() and the base class do on top of copying the values
+  return mRequest.orderBy().isEmpty() && !mTransform.isValid();
 }
 
-
-bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
+bool QgsMemoryFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
 {
-  bool hasFeature = false;
+  if ( !canReadBatch() )
+    return QgsAbstractFeatureIterator::nextBatch( batch, maxFeatures );
 
-  // option 2: traversing the whole layer
-  while ( mSelectIterator != mSource->mFeatures.constEnd() )
-  {
-    if ( mFilterRect.isNull() )
-    {
-      // selection rect empty => using all features
-      hasFeature = true;
-    }
-    else
-    {
-      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
-      {
-        // using exact test when checking for intersection
-        if ( mSelectIterator->hasGeometry() && mSelectRectEngine->intersects( mSelectIterator->geometry().constGet() ) )
-          hasFeature = true;
-      }
-      else
-      {
-        // check just bounding box against rect when not using intersection
-        if ( mSelectIterator->hasGeometry() && mSelectIterator->geometry().boundingBox().intersects( mFilterRect ) )
-          hasFeature = true;
-      }
-    }
+  batch.clear();
 
-    if ( mSubsetExpression )
-    {
-      mSource->mExpressionContext.setFeature( *mSelectIterator );
-      if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
-        hasFeature = false;
-    }
+  if ( mClosed )
+    return false;
 
-    if ( hasFeature )
-      break;
+  batch.setFields( mSource->mFields, ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList() );
 
-    ++mSelectIterator;
-  }
+  if ( mRequest.limit() >= 0 )
+    maxFeatures = static_cast< int >( std::min( static_cast< long >( maxFeatures ), mRequest.limit() - mFetchedCount ) );
 
-  // copy feature
-  if ( hasFeature )
+  while ( batch.size() < maxFeatures )
   {
-    feature = mSelectIterator.value();
-    ++mSelectIterator;
-    feature.setValid( true );
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
+    const int row = nextRow();
+    if ( row < 0 )
+    {
+      close();
+      break;
+    }
+    mSource->mStore.addToBatch( row, batch, mFetchGeometry );
   }
-  else
-    close();
 
-  return hasFeature;
+  mFetchedCount += batch.size();
+  return !batch.isEmpty();
 }
 
 bool QgsMemoryFeatureIterator::rewind()
@@ -207,10 +225,8 @@ bool QgsMemoryFeatureIterator::rewind()
   if ( mClosed )
     return false;
 
-  if ( mUsingFeatureIdList )
-    mFeatureIdListIterator = mFeatureIdList.constBegin();
-  else
-    mSelectIterator = mSource->mFeatures.constBegin();
+  mRowListIndex = 0;
+  mNextRow = 0;
 
   return true;
 }
@@ -230,8 +246,7 @@ bool QgsMemoryFeatureIterator::close()
 
 QgsMemoryFeatureSource::QgsMemoryFeatureSource( const QgsMemoryProvider *p )
   : mFields( p->mFields )
-  , mFeatures( p->mFeatures )
-  , mSpatialIndex( p->mSpatialIndex ? qgis::make_unique< QgsSpatialIndex >( *p->mSpatialIndex ) : nullptr ) // just shallow copy
+  , mStore( p->mStore ) // just shallow copy
   , mSubsetString( p->mSubsetString )
   , mCrs( p->mCrs )
 {
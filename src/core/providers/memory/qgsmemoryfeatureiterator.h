@@ -21,15 +21,12 @@
 #include "qgsexpressioncontext.h"
 #include "qgsfields.h"
 #include "qgsgeometry.h"
+#include "qgsmemoryfeaturestore.h"
 
 ///@cond PRIVATE
 
 class QgsMemoryProvider;
 
-typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap;
-
-class QgsSpatialIndex;
-
 
 class QgsMemoryFeatureSource : public QgsAbstractFeatureSource
 {
@@ -40,8 +37,7 @@ class QgsMemoryFeatureSource : public QgsAbstractFeatureSource
 
   private:
     QgsFields mFields;
-    QgsFeatureMap mFeatures;
-    std::unique_ptr< QgsSpatialIndex > mSpatialIndex;
+    QgsMemoryFeatureStore mStore;
     QString mSubsetString;
     QgsExpressionContext mExpressionContext;
     QgsCoordinateReferenceSystem mCrs;
@@ -57,6 +53,7 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
 
     ~QgsMemoryFeatureIterator() override;
 
+    bool nextBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
     bool rewind() override;
     bool close() override;
 
@@ -65,18 +62,25 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
     bool fetchFeature( QgsFeature &feature ) override;
 
   private:
-    bool nextFeatureUsingList( QgsFeature &feature );
-    bool nextFeatureTraverseAll( QgsFeature &feature );
+    //! Returns the next row matching the filter rectangle and the subset string, or -1
+    int nextRow();
+    //! Returns true if the geometry of the feature at \a row matches the filter rectangle
+    bool rowIntersectsFilterRect( int row ) const;
+    //! Returns true if the features can be copied to batches straight from the columns
+    bool canReadBatch() const;
 
     QgsGeometry mSelectRectGeom;
     std::unique_ptr< QgsGeometryEngine > mSelectRectEngine;
     QgsRectangle mFilterRect;
-    QgsFeatureMap::const_iterator mSelectIterator;
-    bool mUsingFeatureIdList = false;
-    QList<QgsFeatureId> mFeatureIdList;
-    QList<QgsFeatureId>::const_iterator mFeatureIdListIterator;
+    int mNextRow = 0;
+    bool mUsingRowList = false;
+    QVector<int> mRowList;
+    int mRowListIndex = 0;
     std::unique_ptr< QgsExpression > mSubsetExpression;
     QgsCoordinateTransform mTransform;
+    //! Attributes to fetch, or null to fetch all of them
+    std::unique_ptr< QgsAttributeList > mAttributes;
+    bool mFetchGeometry = true;
 
 };
 
@@ -0,0 +1,790 @@
+/***************************************************************************
+    qgsmemoryfeaturestore.cpp
+    ---------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsmemoryfeaturestore.h"
+#include "qgsfeaturebatch.h"
+#include "qgsgeometry.h"
+#include "qgswkbview_p.h"
+
+#include <QBitArray>
+#include <QSharedData>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+///@cond PRIVATE
+
+//! Geometries are appended to a new block once the current one reaches this size
+static const int GEOMETRY_BLOCK_SIZE = 16 * 1024 * 1024;
+
+//! Number of children of the nodes of the packed R-tree
+static const int RTREE_NODE_SIZE = 16;
+
+//! Minimum number of rows outside of the packed R-tree before it is built again
+static const int MIN_PENDING_ROWS = 1024;
+
+/**
+ * A static R-tree, bulk loaded with the STR algorithm. Nodes are stored level by level
+ * in flat arrays, starting with the leaves, and each parent covers up to RTREE_NODE_SIZE
+ * consecutive nodes of the level below.
+ */
+class QgsMemoryPackedRTree
+{
+  public:
+
+    struct Item
+    {
+      QgsRectangle rect;
+      int row;
+    };
+
+    //! Builds the tree. The \a items are sorted in place.
+    explicit QgsMemoryPackedRTree( QVector<Item> &items );
+
+    //! Appends the rows of the items intersecting \a rect to \a rows
+    void intersects( const QgsRectangle &rect, QVector<int> &rows ) const;
+
+    //! Returns the memory used by the tree, in bytes
+    qint64 memoryUsage() const;
+
+  private:
+
+    //! Bounding box of each node, as xmin, ymin, xmax, ymax
+    QVector<double> mBoxes;
+    //! Row of the leaves, first child of the other nodes
+    QVector<int> mIndices;
+    //! End of each level in the node arrays
+    QVector<int> mLevelEnds;
+};
+
+QgsMemoryPackedRTree::QgsMemoryPackedRTree( QVector<Item> &items )
+{
+  const int count = items.size();
+  if ( count == 0 )
+    return;
+
+  // sort by x into vertical slices, then each slice by y, so that consecutive
+  // items are close to each other
+  std::sort( items.begin(), items.end(), []( const Item & a, const Item & b )
+  {
+    return a.rect.xMinimum() + a.rect.xMaximum() < b.rect.xMinimum() + b.rect.xMaximum();
+  } );
+  const int leafCount = ( count + RTREE_NODE_SIZE - 1 ) / RTREE_NODE_SIZE;
+  const int sliceCount = static_cast< int >( std::ceil( std::sqrt( static_cast< double >( leafCount ) ) ) );
+  const int sliceSize = RTREE_NODE_SIZE * ( ( leafCount + sliceCount - 1 ) / sliceCount );
+  for ( int start = 0; start < count; start += sliceSize )
+  {
+    std::sort( items.begin() + start, items.begin() + std::min( start + sliceSize, count ), []( const Item & a, const Item & b )
+    {
+      return a.rect.yMinimum() + a.rect.yMaximum() < b.rect.yMinimum() + b.rect.yMaximum();
+    } );
+  }
+
+  int nodeCount = count;
+  for ( int levelSize = count; levelSize > 1; )
+  {
+    levelSize = ( levelSize + RTREE_NODE_SIZE - 1 ) / RTREE_NODE_SIZE;
+    nodeCount += levelSize;
+  }
+  mBoxes.reserve( 4 * nodeCount );
+  mIndices.reserve( nodeCount );
+
+  for ( const Item &item : qgis::as_const( items ) )
+  {
+    mBoxes << item.rect.xMinimum() << item.rect.yMinimum() << item.rect.xMaximum() << item.rect.yMaximum();
+    mIndices << item.row;
+  }
+  mLevelEnds << count;
+
+  int levelStart = 0;
+  while ( mLevelEnds.last() - levelStart > 1 )
+  {
+    const int levelEnd = mLevelEnds.last();
+    for ( int child = levelStart; child < levelEnd; child += RTREE_NODE_SIZE )
+    {
+      const int childEnd = std::min( child + RTREE_NODE_SIZE, levelEnd );
+      double xMin = mBoxes.at( 4 * child );
+      double yMin = mBoxes.at( 4 * child + 1 );
+      double xMax = mBoxes.at( 4 * child + 2 );
+      double yMax = mBoxes.at( 4 * child + 3 );
+      for ( int node = child + 1; node < childEnd; ++node )
+      {
+        xMin = std::min( xMin, mBoxes.at( 4 * node ) );
+        yMin = std::min( yMin, mBoxes.at( 4 * node + 1 ) );
+        xMax = std::max( xMax, mBoxes.at( 4 * node + 2 ) );
+        yMax = std::max( yMax, mBoxes.at( 4 * node + 3 ) );
+      }
+      mBoxes << xMin << yMin << xMax << yMax;
+      mIndices << child;
+    }
+    levelStart = levelEnd;
+    mLevelEnds << mIndices.size();
+  }
+}
+
+void QgsMemoryPackedRTree::intersects( const QgsRectangle &rect, QVector<int> &rows ) const
+{
+  if ( mIndices.isEmpty() )
+    return;
+
+  // groups of sibling nodes still to visit, as first node and level
+  QVector< QPair< int, int > > stack;
+  int first = mIndices.size() - 1;
+  int level = mLevelEnds.size() - 1;
+  for ( ;; )
+  {
+    const int end = std::min( first + RTREE_NODE_SIZE, mLevelEnds.at( level ) );
+    for ( int node = first; node < end; ++node )
+    {
+      // same test as QgsRectangle::intersects()
+      const double *box = mBoxes.constData() + 4 * node;
+      if ( box[0] > rect.xMaximum() || box[2] < rect.xMinimum() || box[1] > rect.yMaximum() || box[3] < rect.yMinimum() )
+        continue;
+
+      if ( level == 0 )
+        rows << mIndices.at( node );
+      else
+        stack << qMakePair( mIndices.at( node ), level - 1 );
+    }
+
+    if ( stack.isEmpty() )
+      break;
+    first = stack.last().first;
+    level = stack.last().second;
+    stack.removeLast();
+  }
+}
+
+qint64 QgsMemoryPackedRTree::memoryUsage() const
+{
+  return sizeof( QgsMemoryPackedRTree ) + mBoxes.capacity() * sizeof( double ) + mIndices.capacity() * sizeof( int ) + mLevelEnds.capacity() * sizeof( int );
+}
+
+
+class QgsMemoryFeatureStoreData : public QSharedData
+{
+  public:
+
+    //! State of the values of typed columns
+    enum ValueState : quint8
+    {
+      Value, //!< The value is stored in the typed vector
+      NullValue, //!< Null value of the field type
+      InvalidValue, //!< Invalid QVariant
+    };
+
+    struct Column
+    {
+      QgsFeatureBatch::ColumnType type = QgsFeatureBatch::VariantColumn;
+      QVariant::Type variantType = QVariant::Invalid;
+      //! ValueState of each row, unused for variant columns
+      QVector<quint8> states;
+      QVector<qint64> int64Values;
+      QVector<double> doubleValues;
+      QVector<QString> stringValues;
+      QVector<QVariant> variantValues;
+    };
+
+    //! Feature ID of each row, in ascending order
+    QVector<QgsFeatureId> ids;
+    QBitArray deleted;
+    int deletedCount = 0;
+
+    QVector<Column> columns;
+
+    QVector<QByteArray> geometryBlocks;
+    //! Block (high 32 bits) and offset in the block (low 32 bits) of the WKB of each row
+    QVector<qint64> geometryLocations;
+    //! WKB size of each row, 0 for rows without geometry
+    QVector<int> geometrySizes;
+    //! Bytes of the blocks which are not used by any row anymore
+    qint64 unusedGeometryBytes = 0;
+
+    bool spatialIndex = false;
+    std::shared_ptr< const QgsMemoryPackedRTree > tree;
+    //! Rows which existed when the tree was built
+    int treeRowCount = 0;
+    //! Rows in the tree whose geometry changed since it was built, in ascending order
+    QVector<int> changedRows;
+};
+
+typedef QgsMemoryFeatureStoreData::Column Column;
+
+static const char *geometryData( const QgsMemoryFeatureStoreData &data, int row )
+{
+  const qint64 location = data.geometryLocations.at( row );
+  return data.geometryBlocks.at( static_cast< int >( location >> 32 ) ).constData() + ( location & 0xffffffff );
+}
+
+static QgsGeometry rowGeometry( const QgsMemoryFeatureStoreData &data, int row )
+{
+  const int size = data.geometrySizes.at( row );
+  if ( size == 0 )
+    return QgsGeometry();
+
+  QgsGeometry geometry;
+  geometry.fromWkb( QByteArray( geometryData( data, row ), size ) );
+  return geometry;
+}
+
+static QgsRectangle rowBoundingBox( const QgsMemoryFeatureStoreData &data, int row )
+{
+  const int size = data.geometrySizes.at( row );
+  if ( size == 0 )
+    return QgsRectangle();
+
+  // no copy of the WKB for the geometry types supported by the view
+  const QgsWkbView view( QByteArray::fromRawData( geometryData( data, row ), size ) );
+  if ( view.isValid() )
+    return view.boundingBox();
+  return rowGeometry( data, row ).boundingBox();
+}
+
+static unsigned char *allocateGeometry( QgsMemoryFeatureStoreData &data, int row, int size )
+{
+  if ( data.geometryBlocks.isEmpty() || ( !data.geometryBlocks.last().isEmpty() && static_cast< qint64 >( data.geometryBlocks.last().size() ) + size > GEOMETRY_BLOCK_SIZE ) )
+    data.geometryBlocks << QByteArray();
+
+  QByteArray &block = data.geometryBlocks.last();
+  const int offset = block.size();
+  block.resize( offset + size );
+  data.geometryLocations[ row ] = ( static_cast< qint64 >( data.geometryBlocks.size() - 1 ) << 32 ) | offset;
+  data.geometrySizes[ row ] = size;
+  return reinterpret_cast< unsigned char * >( block.data() ) + offset;
+}
+
+static QVariant columnValue( const Column &column, int row )
+{
+  if ( column.type == QgsFeatureBatch::VariantColumn )
+    return column.variantValues.at( row );
+
+  switch ( column.states.at( row ) )
+  {
+    case QgsMemoryFeatureStoreData::InvalidValue:
+      return QVariant();
+    case QgsMemoryFeatureStoreData::NullValue:
+      return QVariant( column.variantType );
+    default:
+      break;
+  }
+
+  switch ( column.type )
+  {
+    case QgsFeatureBatch::Int64Column:
+    {
+      const qint64 value = column.int64Values.at( row );
+      switch ( column.variantType )
+      {
+        case QVariant::Bool:
+          return QVariant( value != 0 );
+        case QVariant::Int:
+          return QVariant( static_cast< int >( value ) );
+        case QVariant::UInt:
+          return QVariant( static_cast< uint >( value ) );
+        default:
+          return QVariant( static_cast< qlonglong >( value ) );
+      }
+    }
+
+    case QgsFeatureBatch::DoubleColumn:
+      return QVariant( column.doubleValues.at( row ) );
+
+    case QgsFeatureBatch::StringColumn:
+      return QVariant( column.stringValues.at( row ) );
+
+    case QgsFeatureBatch::VariantColumn:
+      break;
+  }
+  return QVariant();
+}
+
+static void appendInvalidValue( Column &column )
+{
+  switch ( column.type )
+  {
+    case QgsFeatureBatch::Int64Column:
+      column.int64Values << 0;
+      break;
+    case QgsFeatureBatch::DoubleColumn:
+      column.doubleValues << 0.0;
+      break;
+    case QgsFeatureBatch::StringColumn:
+      column.stringValues << QString();
+      break;
+    case QgsFeatureBatch::VariantColumn:
+      column.variantValues << QVariant();
+      return;
+  }
+  column.states << QgsMemoryFeatureStoreData::InvalidValue;
+}
+
+//! Stores all values of \a column as variants, to keep values of different types
+static void convertToVariantColumn( Column &column )
+{
+  QVector<QVariant> values;
+  values.reserve( column.states.size() );
+  for ( int row = 0; row < column.states.size(); ++row )
+    values << columnValue( column, row );
+
+  Column variantColumn;
+  variantColumn.type = QgsFeatureBatch::VariantColumn;
+  variantColumn.variantType = column.variantType;
+  variantColumn.variantValues = values;
+  column = variantColumn;
+}
+
+static void setColumnValue( Column &column, int row, const QVariant &value )
+{
+  if ( column.type != QgsFeatureBatch::VariantColumn )
+  {
+    if ( column.type == QgsFeatureBatch::StringColumn )
+      column.stringValues[ row ] = QString();
+
+    if ( !value.isValid() )
+    {
+      column.states[ row ] = QgsMemoryFeatureStoreData::InvalidValue;
+      return;
+    }
+
+    // values are returned exactly as they were set, so only values of the field
+    // type can be stored in a typed column
+    if ( value.type() == column.variantType )
+    {
+      if ( value.isNull() )
+      {
+        column.states[ row ] = QgsMemoryFeatureStoreData::NullValue;
+        return;
+      }
+
+      column.states[ row ] = QgsMemoryFeatureStoreData::Value;
+      switch ( column.type )
+      {
+        case QgsFeatureBatch::Int64Column:
+          column.int64Values[ row ] = value.toLongLong();
+          break;
+        case QgsFeatureBatch::DoubleColumn:
+          column.doubleValues[ row ] = value.toDouble();
+          break;
+        case QgsFeatureBatch::StringColumn:
+          column.stringValues[ row ] = value.toString();
+          break;
+        case QgsFeatureBatch::VariantColumn:
+          break;
+      }
+      return;
+    }
+
+    convertToVariantColumn( column );
+  }
+
+  column.variantValues[ row ] = value;
+}
+
+template <typename T>
+static QVector<T> keepRows( const QVector<T> &values, const QVector<int> &rows )
+{
+  QVector<T> kept;
+  if ( values.isEmpty() )
+    return kept;
+
+  kept.reserve( rows.size() );
+  for ( int row : rows )
+    kept << values.at( row );
+  return kept;
+}
+
+static void buildSpatialIndex( QgsMemoryFeatureStoreData &data )
+{
+  QVector<QgsMemoryPackedRTree::Item> items;
+  items.reserve( data.ids.size() - data.deletedCount );
+  for ( int row = 0; row < data.ids.size(); ++row )
+  {
+    if ( data.geometrySizes.at( row ) > 0 && !data.deleted.testBit( row ) )
+      items << QgsMemoryPackedRTree::Item { rowBoundingBox( data, row ), row };
+  }
+
+  data.tree = std::make_shared< const QgsMemoryPackedRTree >( items );
+  data.treeRowCount = data.ids.size();
+  data.changedRows.clear();
+}
+
+
+QgsMemoryFeatureStore::QgsMemoryFeatureStore()
+  : d( new QgsMemoryFeatureStoreData() )
+{
+}
+
+QgsMemoryFeatureStore::QgsMemoryFeatureStore( const QgsMemoryFeatureStore &other ) = default;
+
+QgsMemoryFeatureStore &QgsMemoryFeatureStore::operator=( const QgsMemoryFeatureStore &other ) = default;
+
+QgsMemoryFeatureStore::~QgsMemoryFeatureStore() = default;
+
+int QgsMemoryFeatureStore::rowCount() const
+{
+  return d->ids.size();
+}
+
+long QgsMemoryFeatureStore::featureCount() const
+{
+  return d->ids.size() - d->deletedCount;
+}
+
+int QgsMemoryFeatureStore::rowForId( QgsFeatureId id ) const
+{
+  const auto it = std::lower_bound( d->ids.constBegin(), d->ids.constEnd(), id );
+  if ( it == d->ids.constEnd() || *it != id )
+    return -1;
+
+  const int row = static_cast< int >( it - d->ids.constBegin() );
+  return d->deleted.testBit( row ) ? -1 : row;
+}
+
+bool QgsMemoryFeatureStore::isDeleted( int row ) const
+{
+  return d->deleted.testBit( row );
+}
+
+QgsFeatureId QgsMemoryFeatureStore::id( int row ) const
+{
+  return d->ids.at( row );
+}
+
+bool QgsMemoryFeatureStore::hasGeometry( int row ) const
+{
+  return d->geometrySizes.at( row ) > 0;
+}
+
+QgsGeometry QgsMemoryFeatureStore::geometry( int row ) const
+{
+  return rowGeometry( *d, row );
+}
+
+QgsRectangle QgsMemoryFeatureStore::boundingBox( int row ) const
+{
+  return rowBoundingBox( *d, row );
+}
+
+QVariant QgsMemoryFeatureStore::value( int row, int field ) const
+{
+  return columnValue( d->columns.at( field ), row );
+}
+
+QgsFeature QgsMemoryFeatureStore::feature( int row, const QgsFields &fields, const QgsAttributeList *attributes, bool fetchGeometry ) const
+{
+  QgsFeature feature( fields, d->ids.at( row ) );
+  if ( attributes )
+  {
+    for ( int field : *attributes )
+    {
+      if ( field >= 0 && field < d->columns.size() )
+        feature.setAttribute( field, columnValue( d->columns.at( field ), row ) );
+    }
+  }
+  else
+  {
+    QgsAttributes values( d->columns.size() );
+    for ( int field = 0; field < d->columns.size(); ++field )
+      values[ field ] = columnValue( d->columns.at( field ), row );
+    feature.setAttributes( values );
+  }
+
+  if ( fetchGeometry && hasGeometry( row ) )
+    feature.setGeometry( rowGeometry( *d, row ) );
+
+  feature.setValid( true );
+  return feature;
+}
+
+void QgsMemoryFeatureStore::appendFeature( QgsFeatureId id, const QgsFeature &feature )
+{
+  Q_ASSERT( d->ids.isEmpty() || id > d->ids.last() );
+
+  QgsMemoryFeatureStoreData *data = d.data();
+  const int row = data->ids.size();
+  data->ids << id;
+  data->deleted.resize( row + 1 );
+  data->geometryLocations << 0;
+  data->geometrySizes << 0;
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( int field = 0; field < data->columns.size(); ++field )
+  {
+    Column &column = data->columns[ field ];
+    appendInvalidValue( column );
+    setColumnValue( column, row, attributes.value( field ) );
+  }
+
+  if ( feature.hasGeometry() )
+  {
+    const QByteArray wkb = feature.geometry().asWkb();
+    memcpy( allocateGeometry( *data, row, wkb.size() ), wkb.constData(), wkb.size() );
+  }
+}
+
+void QgsMemoryFeatureStore::deleteRow( int row )
+{
+  if ( d->deleted.testBit( row ) )
+    return;
+
+  QgsMemoryFeatureStoreData *data = d.data();
+  data->deleted.setBit( row );
+  data->deletedCount++;
+  data->unusedGeometryBytes += data->geometrySizes.at( row );
+  data->geometrySizes[ row ] = 0;
+}
+
+void QgsMemoryFeatureStore::setValue( int row, int field, const QVariant &value )
+{
+  setColumnValue( d->columns[ field ], row, value );
+}
+
+void QgsMemoryFeatureStore::setGeometry( int row, const QgsGeometry &geometry )
+{
+  QgsMemoryFeatureStoreData *data = d.data();
+  data->unusedGeometryBytes += data->geometrySizes.at( row );
+  data->geometrySizes[ row ] = 0;
+
+  if ( row < data->treeRowCount )
+  {
+    // the tree still has the old bounding box
+    const auto it = std::lower_bound( data->changedRows.begin(), data->changedRows.end(), row );
+    if ( it == data->changedRows.end() || *it != row )
+      data->changedRows.insert( it, row );
+  }
+
+  if ( geometry.isNull() )
+    return;
+
+  const QByteArray wkb = geometry.asWkb();
+  memcpy( allocateGeometry( *data, row, wkb.size() ), wkb.constData(), wkb.size() );
+}
+
+void QgsMemoryFeatureStore::addColumn( const QgsField &field )
+{
+  Column column;
+  column.type = QgsFeatureBatch::columnTypeForField( field );
+  column.variantType = field.type();
+
+  const int rowCount = d->ids.size();
+  switch ( column.type )
+  {
+    case QgsFeatureBatch::Int64Column:
+      column.int64Values.fill( 0, rowCount );
+      break;
+    case QgsFeatureBatch::DoubleColumn:
+      column.doubleValues.fill( 0.0, rowCount );
+      break;
+    case QgsFeatureBatch::StringColumn:
+      column.stringValues.resize( rowCount );
+      break;
+    case QgsFeatureBatch::VariantColumn:
+      column.variantValues.resize( rowCount );
+      break;
+  }
+  if ( column.type != QgsFeatureBatch::VariantColumn )
+    column.states.fill( QgsMemoryFeatureStoreData::InvalidValue, rowCount );
+
+  d->columns << column;
+}
+
+void QgsMemoryFeatureStore::removeColumn( int field )
+{
+  d->columns.remove( field );
+}
+
+void QgsMemoryFeatureStore::createSpatialIndex()
+{
+  if ( d->spatialIndex )
+    return;
+
+  QgsMemoryFeatureStoreData *data = d.data();
+  data->spatialIndex = true;
+  buildSpatialIndex( *data );
+}
+
+bool QgsMemoryFeatureStore::hasSpatialIndex() const
+{
+  return d->spatialIndex;
+}
+
+QVector<int> QgsMemoryFeatureStore::intersects( const QgsRectangle &rect ) const
+{
+  const QgsMemoryFeatureStoreData &data = *d;
+
+  QVector<int> rows;
+  if ( data.tree )
+  {
+    data.tree->intersects( rect, rows );
+    rows.erase( std::remove_if( rows.begin(), rows.end(), [&data]( int row )
+    {
+      return data.deleted.testBit( row ) || std::binary_search( data.changedRows.constBegin(), data.changedRows.constEnd(), row );
+    } ), rows.end() );
+  }
+
+  // rows which are not in the tree, or with an outdated bounding box
+  auto testRow = [&data, &rect, &rows]( int row )
+  {
+    if ( data.geometrySizes.at( row ) > 0 && !data.deleted.testBit( row ) && rowBoundingBox( data, row ).intersects( rect ) )
+      rows << row;
+  };
+  for ( int row : data.changedRows )
+    testRow( row );
+  for ( int row = data.treeRowCount; row < data.ids.size(); ++row )
+    testRow( row );
+
+  std::sort( rows.begin(), rows.end() );
+  return rows;
+}
+
+void QgsMemoryFeatureStore::optimize()
+{
+  const QgsMemoryFeatureStoreData *old = d.constData();
+  const int rowCount = old->ids.size();
+
+  qint64 geometryBytes = 0;
+  for ( const QByteArray &block : old->geometryBlocks )
+    geometryBytes += block.size();
+
+  const bool compact = ( old->deletedCount > 0 && old->deletedCount >= rowCount / 2 ) ||
+                       ( old->unusedGeometryBytes > 0 && old->unusedGeometryBytes >= geometryBytes / 2 );
+  if ( !compact )
+  {
+    // the tree is built again once a quarter of the features are tested one by one,
+    // which keeps the cost of building it proportional to the number of changes
+    const int pendingRows = old->changedRows.size() + rowCount - old->treeRowCount;
+    if ( old->spatialIndex && pendingRows > std::max( MIN_PENDING_ROWS, ( rowCount - old->deletedCount ) / 4 ) )
+      buildSpatialIndex( *d.data() );
+    return;
+  }
+
+  QVector<int> rows;
+  rows.reserve( rowCount - old->deletedCount );
+  for ( int row = 0; row < rowCount; ++row )
+  {
+    if ( !old->deleted.testBit( row ) )
+      rows << row;
+  }
+
+  QgsMemoryFeatureStoreData *data = new QgsMemoryFeatureStoreData();
+  data->ids = keepRows( old->ids, rows );
+  data->deleted.resize( rows.size() );
+
+  data->columns.reserve( old->columns.size() );
+  for ( const Column &oldColumn : old->columns )
+  {
+    Column column;
+    column.type = oldColumn.type;
+    column.variantType = oldColumn.variantType;
+    column.states = keepRows( oldColumn.states, rows );
+    column.int64Values = keepRows( oldColumn.int64Values, rows );
+    column.doubleValues = keepRows( oldColumn.doubleValues, rows );
+    column.stringValues = keepRows( oldColumn.stringValues, rows );
+    column.variantValues = keepRows( oldColumn.variantValues, rows );
+    data->columns << column;
+  }
+
+  data->geometryLocations.fill( 0, rows.size() );
+  data->geometrySizes.fill( 0, rows.size() );
+  for ( int row = 0; row < rows.size(); ++row )
+  {
+    const int size = old->geometrySizes.at( rows.at( row ) );
+    if ( size > 0 )
+      memcpy( allocateGeometry( *data, row, size ), geometryData( *old, rows.at( row ) ), size );
+  }
+
+  data->spatialIndex = old->spatialIndex;
+  if ( data->spatialIndex )
+    buildSpatialIndex( *data );
+
+  d = data;
+}
+
+void QgsMemoryFeatureStore::addToBatch( int row, QgsFeatureBatch &batch, bool fetchGeometry ) const
+{
+  const QgsMemoryFeatureStoreData &data = *d;
+
+  batch.addRow( data.ids.at( row ) );
+  for ( int batchColumn = 0; batchColumn < batch.columnCount(); ++batchColumn )
+  {
+    const int field = batch.attributeIndex( batchColumn );
+    if ( field >= data.columns.size() )
+      continue;
+
+    const Column &column = data.columns.at( field );
+    if ( column.type == QgsFeatureBatch::VariantColumn || column.type != batch.columnType( batchColumn ) )
+    {
+      batch.setValue( batchColumn, columnValue( column, row ) );
+      continue;
+    }
+
+    if ( column.states.at( row ) != QgsMemoryFeatureStoreData::Value )
+      continue;
+
+    switch ( column.type )
+    {
+      case QgsFeatureBatch::Int64Column:
+        batch.setInt64( batchColumn, column.int64Values.at( row ) );
+        break;
+      case QgsFeatureBatch::DoubleColumn:
+        batch.setDouble( batchColumn, column.doubleValues.at( row ) );
+        break;
+      case QgsFeatureBatch::StringColumn:
+        batch.setString( batchColumn, column.stringValues.at( row ) );
+        break;
+      case QgsFeatureBatch::VariantColumn:
+        break;
+    }
+  }
+
+  const int size = data.geometrySizes.at( row );
+  if ( fetchGeometry && size > 0 )
+    memcpy( batch.allocateGeometryWkb( size ), geometryData( data, row ), size );
+}
+
+qint64 QgsMemoryFeatureStore::memoryUsage() const
+{
+  const QgsMemoryFeatureStoreData &data = *d;
+
+  qint64 bytes = sizeof( QgsMemoryFeatureStoreData );
+  bytes += data.ids.capacity() * sizeof( QgsFeatureId );
+  bytes += data.deleted.size() / 8;
+  bytes += data.geometryLocations.capacity() * sizeof( qint64 );
+  bytes += data.geometrySizes.capacity() * sizeof( int );
+  for ( const QByteArray &block : data.geometryBlocks )
+    bytes += block.capacity();
+
+  for ( const Column &column : data.columns )
+  {
+    bytes += column.states.capacity();
+    bytes += column.int64Values.capacity() * sizeof( qint64 );
+    bytes += column.doubleValues.capacity() * sizeof( double );
+    bytes += column.stringValues.capacity() * sizeof( QString );
+    bytes += column.variantValues.capacity() * sizeof( QVariant );
+    // approximation, shared strings are counted once per use
+    for ( const QString &string : column.stringValues )
+    {
+      if ( !string.isNull() )
+        bytes += sizeof( QArrayData ) + ( string.capacity() + 1 ) * sizeof( QChar );
+    }
+  }
+
+  if ( data.tree )
+    bytes += data.tree->memoryUsage();
+  bytes += data.changedRows.capacity() * sizeof( int );
+  return bytes;
+}
+
+///@endcond
@@ -0,0 +1,150 @@
+/***************************************************************************
+    qgsmemoryfeaturestore.h
+    ---------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSMEMORYFEATURESTORE_H
+#define QGSMEMORYFEATURESTORE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+#include "qgsrectangle.h"
+
+#include <QSharedDataPointer>
+#include <QVector>
+
+///@cond PRIVATE
+
+class QgsFeatureBatch;
+class QgsMemoryFeatureStoreData;
+
+/**
+ * \ingroup core
+ * Column oriented storage of the features of the memory provider.
+ *
+ * Rows are kept in ascending feature ID order. The values of each field are stored in a
+ * typed column (64 bit integers, doubles, strings, or variants for the other field types)
+ * and the geometries are stored as WKB in a few large blocks, so a feature costs a few
+ * dozen bytes instead of a QgsFeature, a QVariant per attribute and a geometry object.
+ *
+ * Deleted rows are only flagged, and changed geometries are appended to the WKB blocks.
+ * The storage is compacted by optimize() once enough space is wasted.
+ *
+ * The optional spatial index is a packed R-tree which is bulk loaded with the STR algorithm.
+ * Rows added or whose geometry changed since it was built are tested one by one, until
+ * optimize() decides it is worth building the tree again.
+ *
+ * The storage is implicitly shared: copies are cheap, and a copy only duplicates the columns
+ * which are modified afterwards. Copies can be read from different threads.
+ */
+class CORE_EXPORT QgsMemoryFeatureStore
+{
+  public:
+
+    //! Constructor for an empty storage without any column
+    QgsMemoryFeatureStore();
+    QgsMemoryFeatureStore( const QgsMemoryFeatureStore &other );
+    QgsMemoryFeatureStore &operator=( const QgsMemoryFeatureStore &other );
+    ~QgsMemoryFeatureStore();
+
+    //! Returns the number of rows, including the deleted ones
+    int rowCount() const;
+
+    //! Returns the number of features, i.e. of rows which are not deleted
+    long featureCount() const;
+
+    //! Returns the row of the feature with the given \a id, or -1 if there is no such feature
+    int rowForId( QgsFeatureId id ) const;
+
+    //! Returns true if the feature at \a row was deleted
+    bool isDeleted( int row ) const;
+
+    //! Returns the ID of the feature at \a row
+    QgsFeatureId id( int row ) const;
+
+    //! Returns true if the feature at \a row has a geometry
+    bool hasGeometry( int row ) const;
+
+    //! Returns the geometry of the feature at \a row
+    QgsGeometry geometry( int row ) const;
+
+    //! Returns the bounding box of the geometry of the feature at \a row
+    QgsRectangle boundingBox( int row ) const;
+
+    //! Returns the value of the attribute \a field of the feature at \a row
+    QVariant value( int row, int field ) const;
+
+    /**
+     * Returns the feature at \a row. If \a attributes is not null, only these attributes
+     * are filled. The geometry is only set if \a fetchGeometry is true.
+     */
+    QgsFeature feature( int row, const QgsFields &fields, const QgsAttributeList *attributes = nullptr, bool fetchGeometry = true ) const;
+
+    /**
+     * Adds the attributes and the geometry of \a feature at the end of the storage, with
+     * the given \a id. IDs must be added in ascending order.
+     */
+    void appendFeature( QgsFeatureId id, const QgsFeature &feature );
+
+    //! Deletes the feature at \a row
+    void deleteRow( int row );
+
+    //! Sets the value of the attribute \a field of the feature at \a row
+    void setValue( int row, int field, const QVariant &value );
+
+    //! Replaces the geometry of the feature at \a row
+    void setGeometry( int row, const QgsGeometry &geometry );
+
+    //! Adds a column for \a field, with null values for all features
+    void addColumn( const QgsField &field );
+
+    //! Removes the column of the attribute \a field
+    void removeColumn( int field );
+
+    //! Enables the spatial index
+    void createSpatialIndex();
+
+    //! Returns true if the spatial index is enabled
+    bool hasSpatialIndex() const;
+
+    /**
+     * Returns the rows of the features whose bounding box intersects \a rect, in ascending
+     * order. All rows are tested one by one if the spatial index is not enabled.
+     */
+    QVector<int> intersects( const QgsRectangle &rect ) const;
+
+    /**
+     * Compacts the storage if enough rows or geometries were deleted, and builds the
+     * spatial index again if too many geometries changed since it was built. Should be
+     * called once a set of changes is done.
+     */
+    void optimize();
+
+    /**
+     * Adds the feature at \a row at the end of \a batch, copying the values straight from
+     * the columns. The geometry is only copied if \a fetchGeometry is true.
+     */
+    void addToBatch( int row, QgsFeatureBatch &batch, bool fetchGeometry = true ) const;
+
+    //! Returns an estimate of the memory used by the storage, in bytes
+    qint64 memoryUsage() const;
+
+  private:
+
+    QSharedDataPointer<QgsMemoryFeatureStoreData> d;
+};
+
+///@endcond
+
+#endif // QGSMEMORYFEATURESTORE_H
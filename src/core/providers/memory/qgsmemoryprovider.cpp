@@ -20,7 +20,6 @@
 #include "qgsfields.h"
 #include "qgsgeometry.h"
 #include "qgslogger.h"
-#include "qgsspatialindex.h"
 #include "qgscoordinatereferencesystem.h"
 
 #include <QUrl>
@@ -185,10 +184,7 @@ QgsMemoryProvider::QgsMemoryProvider( const QString &uri, const ProviderOptions
 
 }
 
-QgsMemoryProvider::~QgsMemoryProvider()
-{
-  delete mSpatialIndex;
-}
+QgsMemoryProvider::~QgsMemoryProvider() = default;
 
 QString QgsMemoryProvider::providerKey()
 {
@@ -240,7 +236,7 @@ QString QgsMemoryProvider::dataSourceUri( bool expandAuthConfig ) const
     }
     uri.addQueryItem( QStringLiteral( "crs" ), crsDef );
   }
-  if ( mSpatialIndex )
+  if ( mStore.hasSpatialIndex() )
   {
     uri.addQueryItem( QStringLiteral( "index" ), QStringLiteral( "yes" ) );
   }
@@ -271,16 +267,16 @@ QgsFeatureIterator QgsMemoryProvider::getFeatures( const QgsFeatureRequest &requ
 
 QgsRectangle QgsMemoryProvider::extent() const
 {
-  if ( mExtent.isEmpty() && !mFeatures.isEmpty() )
+  if ( mExtent.isEmpty() && mStore.featureCount() > 0 )
   {
     mExtent.setMinimal();
     if ( mSubsetString.isEmpty() )
     {
       // fast way - iterate through all features
-      Q_FOREACH ( const QgsFeature &feat, mFeatures )
+      for ( int row = 0; row < mStore.rowCount(); ++row )
       {
-        if ( feat.hasGeometry() )
-          mExtent.combineExtentWith( feat.geometry().boundingBox() );
+        if ( !mStore.isDeleted( row ) && mStore.hasGeometry( row ) )
+          mExtent.combineExtentWith( mStore.boundingBox( row ) );
       }
     }
     else
@@ -294,7 +290,7 @@ QgsRectangle QgsMemoryProvider::extent() const
       }
     }
   }
-  else if ( mFeatures.isEmpty() )
+  else if ( mStore.featureCount() == 0 )
   {
     mExtent.setMinimal();
   }
@@ -310,7 +306,7 @@ QgsWkbTypes::Type QgsMemoryProvider::wkbType() const
 long QgsMemoryProvider::featureCount() const
 {
   if ( mSubsetString.isEmpty() )
-    return mFeatures.count();
+    return mStore.featureCount();
 
   // subset string set, no alternative but testing each feature
   QgsFeatureIterator fit = QgsFeatureIterator( new QgsMemoryFeatureIterator( new QgsMemoryFeatureSource( this ), true,  QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) ) );
@@ -344,7 +340,7 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
 {
   bool result = true;
   // whether or not to update the layer extent on the fly as we add features
-  bool updateExtent = mFeatures.isEmpty() || !mExtent.isEmpty();
+  bool updateExtent = mStore.featureCount() == 0 || !mExtent.isEmpty();
 
   int fieldCount = mFields.count();
 
@@ -386,21 +382,17 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
       continue;
     }
 
-    mFeatures.insert( mNextFeatureId, *it );
-
-    if ( it->hasGeometry() )
-    {
-      if ( updateExtent )
-        mExtent.combineExtentWith( it->geometry().boundingBox() );
+    mStore.appendFeature( mNextFeatureId, *it );
 
-      // update spatial index
-      if ( mSpatialIndex )
-        mSpatialIndex->insertFeature( *it );
-    }
+    if ( updateExtent && it->hasGeometry() )
+      mExtent.combineExtentWith( it->geometry().boundingBox() );
 
     mNextFeatureId++;
   }
 
+  // update spatial index
+  mStore.optimize();
+
   clearMinMaxCache();
   return result;
 }
@@ -409,18 +401,15 @@ bool QgsMemoryProvider::deleteFeatures( const QgsFeatureIds &id )
 {
   for ( QgsFeatureIds::const_iterator it = id.begin(); it != id.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( *it );
+    const int row = mStore.rowForId( *it );
 
     // check whether such feature exists
-    if ( fit == mFeatures.end() )
+    if ( row < 0 )
       continue;
 
-    // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->deleteFeature( *fit );
-
-    mFeatures.erase( fit );
+    mStore.deleteRow( row );
   }
+  mStore.optimize();
 
   updateExtents();
   clearMinMaxCache();
@@ -450,14 +439,7 @@ bool QgsMemoryProvider::addAttributes( const QList<QgsField> &attributes )
     }
     // add new field as a last one
     mFields.append( *it );
-
-    for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
-    {
-      QgsFeature &f = fit.value();
-      QgsAttributes attr = f.attributes();
-      attr.append( QVariant() );
-      f.setAttributes( attr );
-    }
+    mStore.addColumn( *it );
   }
   return true;
 }
@@ -496,14 +478,7 @@ bool QgsMemoryProvider::deleteAttributes( const QgsAttributeIds &attributes )
   {
     int idx = *it;
     mFields.remove( idx );
-
-    for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
-    {
-      QgsFeature &f = fit.value();
-      QgsAttributes attr = f.attributes();
-      attr.remove( idx );
-      f.setAttributes( attr );
-    }
+    mStore.removeColumn( idx );
   }
   clearMinMaxCache();
   return true;
@@ -513,13 +488,16 @@ bool QgsMemoryProvider::changeAttributeValues( const QgsChangedAttributesMap &at
 {
   for ( QgsChangedAttributesMap::const_iterator it = attr_map.begin(); it != attr_map.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
-    if ( fit == mFeatures.end() )
+    const int row = mStore.rowForId( it.key() );
+    if ( row < 0 )
       continue;
 
     const QgsAttributeMap &attrs = it.value();
     for ( QgsAttributeMap::const_iterator it2 = attrs.constBegin(); it2 != attrs.constEnd(); ++it2 )
-      fit->setAttribute( it2.key(), it2.value() );
+    {
+      if ( it2.key() >= 0 && it2.key() < mFields.count() )
+        mStore.setValue( row, it2.key(), it2.value() );
+    }
   }
   clearMinMaxCache();
   return true;
@@ -529,21 +507,16 @@ bool QgsMemoryProvider::changeGeometryValues( const QgsGeometryMap &geometry_map
 {
   for ( QgsGeometryMap::const_iterator it = geometry_map.begin(); it != geometry_map.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
-    if ( fit == mFeatures.end() )
+    const int row = mStore.rowForId( it.key() );
+    if ( row < 0 )
       continue;
 
-    // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->deleteFeature( *fit );
-
-    fit->setGeometry( it.value() );
-
-    // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->insertFeature( *fit );
+    mStore.setGeometry( row, it.value() );
   }
 
+  // update spatial index
+  mStore.optimize();
+
   updateExtents();
 
   return true;
@@ -578,16 +551,8 @@ bool QgsMemoryProvider::setSubsetString( const QString &theSQL, bool updateFeatu
 
 bool QgsMemoryProvider::createSpatialIndex()
 {
-  if ( !mSpatialIndex )
-  {
-    mSpatialIndex = new QgsSpatialIndex();
-
-    // add existing features to index
-    for ( QgsFeatureMap::const_iterator it = mFeatures.constBegin(); it != mFeatures.constEnd(); ++it )
-    {
-      mSpatialIndex->insertFeature( *it );
-    }
-  }
+  // bulk loads the existing features
+  mStore.createSpatialIndex();
   return true;
 }
 
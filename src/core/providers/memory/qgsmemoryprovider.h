@@ -18,12 +18,9 @@
 #include "qgsvectordataprovider.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsfields.h"
+#include "qgsmemoryfeaturestore.h"
 
 ///@cond PRIVATE
-typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap;
-
-class QgsSpatialIndex;
-
 class QgsMemoryFeatureIterator;
 
 class QgsMemoryProvider : public QgsVectorDataProvider
@@ -87,13 +84,10 @@ class QgsMemoryProvider : public QgsVectorDataProvider
     QgsWkbTypes::Type mWkbType;
     mutable QgsRectangle mExtent;
 
-    // features
-    QgsFeatureMap mFeatures;
+    // features, with the optional spatial index
+    QgsMemoryFeatureStore mStore;
     QgsFeatureId mNextFeatureId;
 
-    // indexing
-    QgsSpatialIndex *mSpatialIndex = nullptr;
-
     QString mSubsetString;
 
     friend class QgsMemoryFeatureSource;
@@ -39,6 +39,13 @@ const double QgsClipper::MIN_Y = -16000;
 const double QgsClipper::SMALL_NUM = 1e-12;
 
 QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent )
+{
+  QPolygonF line;
+  clippedLine( curve, clipExtent, line );
+  return line;
+}
+
+void QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent, QPolygonF &line )
 {
   const int nPoints = curve.numPoints();
 
@@ -46,7 +53,7 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
   double p1x_c, p1y_c; //clipped end coordinates
   double lastClipX = 0.0, lastClipY = 0.0; //last successfully clipped coords
 
-  QPolygonF line;
+  line.resize( 0 );
   line.reserve( nPoints + 1 );
 
   for ( int i = 0; i < nPoints; ++i )
@@ -89,7 +96,6 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
       }
     }
   }
-  return line;
 }
 
 void QgsClipper::connectSeparatedLines( double x0, double y0, double x1, double y1,
@@ -100,6 +100,15 @@ class CORE_EXPORT QgsClipper
 
     static void trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect );
 
+    /**
+     * Trims the given polygon to a rectangular box, using \a scratch as the temporary
+     * buffer between the clipping passes. Reusing the same scratch buffer for several
+     * polygons avoids allocating a new buffer for each of them.
+     * \note not available in Python bindings
+     * \since QGIS 3.4
+     */
+    static void trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect, QPolygonF &scratch ) SIP_SKIP;
+
     /**
      * Takes a linestring and clips it to clipExtent
      * \param curve the linestring
@@ -108,6 +117,15 @@ class CORE_EXPORT QgsClipper
      */
     static QPolygonF clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent );
 
+    /**
+     * Takes a linestring and clips it to \a clipExtent, writing the clipped line
+     * coordinates to \a line. Any previous content of \a line is discarded, but its
+     * allocated memory is reused.
+     * \note not available in Python bindings
+     * \since QGIS 3.4
+     */
+    static void clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent, QPolygonF &line ) SIP_SKIP;
+
   private:
 
     // Used when testing for equivalance to 0.0
@@ -202,6 +220,12 @@ inline void QgsClipper::trimFeature( QVector<double> &x,
 inline void QgsClipper::trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect )
 {
   QPolygonF tmpPts;
+  trimPolygon( pts, clipRect, tmpPts );
+}
+
+inline void QgsClipper::trimPolygon( QPolygonF &pts, const QgsRectangle &clipRect, QPolygonF &tmpPts )
+{
+  tmpPts.resize( 0 );
   tmpPts.reserve( pts.size() );
 
   trimPolygonToBoundary( pts, tmpPts, clipRect, XMax, clipRect.xMaximum() );
@@ -24,6 +24,7 @@
 #include "qgsdistancearea.h"
 #include "qgsunittypes.h"
 #include "qgsexpressionnode.h"
+#include "qgsexpressionbytecode_p.h"
 
 ///@cond
 
@@ -49,7 +50,11 @@ class QgsExpressionPrivate
       , mCalc( other.mCalc )
       , mDistanceUnit( other.mDistanceUnit )
       , mAreaUnit( other.mAreaUnit )
-    {}
+      , mBytecodeEnabled( other.mBytecodeEnabled )
+    {
+      if ( other.mBytecode && mRootNode )
+        mBytecode = other.mBytecode->cloneForTree( other.mRootNode, mRootNode );
+    }
 
     ~QgsExpressionPrivate()
     {
@@ -70,6 +75,9 @@ class QgsExpressionPrivate
     std::shared_ptr<QgsDistanceArea> mCalc;
     QgsUnitTypes::DistanceUnit mDistanceUnit = QgsUnitTypes::DistanceUnknownUnit;
     QgsUnitTypes::AreaUnit mAreaUnit = QgsUnitTypes::AreaUnknownUnit;
+
+    bool mBytecodeEnabled = true;
+    std::unique_ptr< QgsExpressionBytecode > mBytecode;
 };
 ///@endcond
 
@@ -0,0 +1,319 @@
+/***************************************************************************
+                         qgsfeaturebatch.cpp
+                         -------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsfeaturebatch.h"
+#include "qgsgeometry.h"
+
+void QgsFeatureBatch::setFields( const QgsFields &fields, const QgsAttributeList &attributes )
+{
+  QgsAttributeList validAttributes;
+  validAttributes.reserve( attributes.size() );
+  for ( int attributeIndex : attributes )
+  {
+    if ( attributeIndex >= 0 && attributeIndex < fields.count() && !validAttributes.contains( attributeIndex ) )
+      validAttributes << attributeIndex;
+  }
+
+  if ( fields == mFields && validAttributes.size() == mColumns.size() )
+  {
+    bool sameColumns = true;
+    for ( int column = 0; column < mColumns.size() && sameColumns; ++column )
+      sameColumns = mColumns.at( column ).attributeIndex == validAttributes.at( column );
+    if ( sameColumns )
+      return;
+  }
+
+  mFields = fields;
+  mColumns.clear();
+  mColumnIndexes.fill( -1, fields.count() );
+  mColumns.reserve( validAttributes.size() );
+  for ( int attributeIndex : qgis::as_const( validAttributes ) )
+  {
+    const QgsField field = fields.at( attributeIndex );
+    Column column;
+    column.attributeIndex = attributeIndex;
+    column.type = columnTypeForField( field );
+    column.variantType = field.type();
+    mColumnIndexes[ attributeIndex ] = mColumns.size();
+    mColumns << column;
+  }
+
+  mIds.clear();
+  mGeometryOffsets.clear();
+  mGeometryData.clear();
+}
+
+int QgsFeatureBatch::attributeIndex( int column ) const
+{
+  return mColumns.at( column ).attributeIndex;
+}
+
+int QgsFeatureBatch::columnIndex( int attributeIndex ) const
+{
+  return mColumnIndexes.value( attributeIndex, -1 );
+}
+
+QgsFeatureBatch::ColumnType QgsFeatureBatch::columnType( int column ) const
+{
+  return mColumns.at( column ).type;
+}
+
+QgsFeatureBatch::ColumnType QgsFeatureBatch::columnTypeForField( const QgsField &field )
+{
+  switch ( field.type() )
+  {
+    case QVariant::Bool:
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+      return Int64Column;
+
+    case QVariant::Double:
+      return DoubleColumn;
+
+    case QVariant::String:
+      return StringColumn;
+
+    default:
+      return VariantColumn;
+  }
+}
+
+void QgsFeatureBatch::clear()
+{
+  // resize() keeps the allocated memory
+  for ( Column &column : mColumns )
+  {
+    column.nulls.resize( 0 );
+    column.int64Values.resize( 0 );
+    column.doubleValues.resize( 0 );
+    column.stringValues.resize( 0 );
+    column.variantValues.resize( 0 );
+  }
+  mIds.resize( 0 );
+  mGeometryOffsets.resize( 0 );
+  // a byte array only keeps its memory when emptied if it was reserved
+  mGeometryData.reserve( mGeometryData.capacity() );
+  mGeometryData.resize( 0 );
+}
+
+int QgsFeatureBatch::geometryEnd( int row ) const
+{
+  return row + 1 < mGeometryOffsets.size() ? mGeometryOffsets.at( row + 1 ) : mGeometryData.size();
+}
+
+bool QgsFeatureBatch::hasGeometry( int row ) const
+{
+  return geometryEnd( row ) > mGeometryOffsets.at( row );
+}
+
+QByteArray QgsFeatureBatch::geometryWkb( int row ) const
+{
+  const int start = mGeometryOffsets.at( row );
+  return mGeometryData.mid( start, geometryEnd( row ) - start );
+}
+
+const unsigned char *QgsFeatureBatch::geometryWkbData( int row, int &size ) const
+{
+  const int start = mGeometryOffsets.at( row );
+  size = geometryEnd( row ) - start;
+  return reinterpret_cast< const unsigned char * >( mGeometryData.constData() ) + start;
+}
+
+QgsGeometry QgsFeatureBatch::geometry( int row ) const
+{
+  if ( !hasGeometry( row ) )
+    return QgsGeometry();
+
+  QgsGeometry geometry;
+  geometry.fromWkb( geometryWkb( row ) );
+  return geometry;
+}
+
+bool QgsFeatureBatch::isNull( int column, int row ) const
+{
+  return mColumns.at( column ).nulls.at( row );
+}
+
+qint64 QgsFeatureBatch::int64Value( int column, int row ) const
+{
+  return mColumns.at( column ).int64Values.at( row );
+}
+
+double QgsFeatureBatch::doubleValue( int column, int row ) const
+{
+  return mColumns.at( column ).doubleValues.at( row );
+}
+
+QString QgsFeatureBatch::stringValue( int column, int row ) const
+{
+  return mColumns.at( column ).stringValues.at( row );
+}
+
+QVariant QgsFeatureBatch::value( int column, int row ) const
+{
+  const Column &c = mColumns.at( column );
+  if ( c.nulls.at( row ) )
+    return QVariant( c.variantType );
+
+  switch ( c.type )
+  {
+    case Int64Column:
+    {
+      const qint64 value = c.int64Values.at( row );
+      switch ( c.variantType )
+      {
+        case QVariant::Bool:
+          return QVariant( value != 0 );
+        case QVariant::Int:
+          return QVariant( static_cast< int >( value ) );
+        case QVariant::UInt:
+          return QVariant( static_cast< uint >( value ) );
+        default:
+          return QVariant( static_cast< qlonglong >( value ) );
+      }
+    }
+
+    case DoubleColumn:
+      return QVariant( c.doubleValues.at( row ) );
+
+    case StringColumn:
+      return QVariant( c.stringValues.at( row ) );
+
+    case VariantColumn:
+      return c.variantValues.at( row );
+  }
+  return QVariant();
+}
+
+const qint64 *QgsFeatureBatch::int64Data( int column ) const
+{
+  return mColumns.at( column ).int64Values.constData();
+}
+
+const double *QgsFeatureBatch::doubleData( int column ) const
+{
+  return mColumns.at( column ).doubleValues.constData();
+}
+
+QgsFeature QgsFeatureBatch::feature( int row ) const
+{
+  QgsFeature feature( mFields, mIds.at( row ) );
+  for ( int column = 0; column < mColumns.size(); ++column )
+    feature.setAttribute( mColumns.at( column ).attributeIndex, value( column, row ) );
+  if ( hasGeometry( row ) )
+    feature.setGeometry( geometry( row ) );
+  return feature;
+}
+
+void QgsFeatureBatch::addRow( QgsFeatureId id )
+{
+  for ( Column &column : mColumns )
+  {
+    column.nulls << true;
+    switch ( column.type )
+    {
+      case Int64Column:
+        column.int64Values << 0;
+        break;
+      case DoubleColumn:
+        column.doubleValues << 0.0;
+        break;
+      case StringColumn:
+        column.stringValues << QString();
+        break;
+      case VariantColumn:
+        column.variantValues << QVariant();
+        break;
+    }
+  }
+  mIds << id;
+  mGeometryOffsets << mGeometryData.size();
+}
+
+void QgsFeatureBatch::addFeature( const QgsFeature &feature )
+{
+  addRow( feature.id() );
+  if ( feature.hasGeometry() )
+    setGeometry( feature.geometry() );
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( int column = 0; column < mColumns.size(); ++column )
+    setValue( column, attributes.value( mColumns.at( column ).attributeIndex ) );
+}
+
+void QgsFeatureBatch::setInt64( int column, qint64 value )
+{
+  Column &c = mColumns[ column ];
+  c.int64Values.last() = value;
+  c.nulls.last() = false;
+}
+
+void QgsFeatureBatch::setDouble( int column, double value )
+{
+  Column &c = mColumns[ column ];
+  c.doubleValues.last() = value;
+  c.nulls.last() = false;
+}
+
+void QgsFeatureBatch::setString( int column, const QString &value )
+{
+  Column &c = mColumns[ column ];
+  c.stringValues.last() = value;
+  c.nulls.last() = false;
+}
+
+void QgsFeatureBatch::setValue( int column, const QVariant &value )
+{
+  if ( value.isNull() )
+    return;
+
+  switch ( mColumns.at( column ).type )
+  {
+    case Int64Column:
+      setInt64( column, value.toLongLong() );
+      break;
+
+    case DoubleColumn:
+      setDouble( column, value.toDouble() );
+      break;
+
+    case StringColumn:
+      setString( column, value.toString() );
+      break;
+
+    case VariantColumn:
+    {
+      Column &c = mColumns[ column ];
+      c.variantValues.last() = value;
+      c.nulls.last() = false;
+      break;
+    }
+  }
+}
+
+void QgsFeatureBatch::setGeometry( const QgsGeometry &geometry )
+{
+  const QByteArray wkb = geometry.asWkb();
+  memcpy( allocateGeometryWkb( wkb.size() ), wkb.constData(), wkb.size() );
+}
+
+unsigned char *QgsFeatureBatch::allocateGeometryWkb( int size )
+{
+  const int start = mGeometryOffsets.last();
+  mGeometryData.resize( start + size );
+  return reinterpret_cast< unsigned char * >( mGeometryData.data() ) + start;
+}
@@ -0,0 +1,201 @@
+/***************************************************************************
+                         qgsfeaturebatch.h
+                         -----------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSFEATUREBATCH_H
+#define QGSFEATUREBATCH_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+
+#include <QByteArray>
+#include <QVector>
+
+/**
+ * \ingroup core
+ * A block of consecutive features stored column by column.
+ *
+ * Each fetched attribute is stored in a column of values of a single type: integer
+ * and boolean fields in an Int64Column, floating point fields in a DoubleColumn,
+ * strings in a StringColumn and everything else in a VariantColumn. The geometries of
+ * all features are stored as WKB, one after the other, in a single buffer.
+ *
+ * Batches are filled by QgsFeatureIterator::nextBatch(). Consumers which only need a
+ * few attribute values can read them directly from the columns, without creating a
+ * QgsFeature and a QVariant for every value.
+ *
+ * \since QGIS 3.4
+ */
+class CORE_EXPORT QgsFeatureBatch
+{
+  public:
+
+    //! Types of columns
+    enum ColumnType
+    {
+      Int64Column, //!< 64 bit integer values
+      DoubleColumn, //!< Double values
+      StringColumn, //!< String values
+      VariantColumn, //!< Values of any other type
+    };
+
+    //! Constructor for an empty batch without any column
+    QgsFeatureBatch() = default;
+
+    /**
+     * Sets the \a fields of the features and the indexes of the \a attributes stored
+     * in the columns of the batch. Attribute indexes which are not valid for \a fields
+     * are ignored.
+     *
+     * This removes all features from the batch, unless the fields and attributes
+     * did not change.
+     */
+    void setFields( const QgsFields &fields, const QgsAttributeList &attributes );
+
+    //! Returns the fields of the features in the batch
+    QgsFields fields() const { return mFields; }
+
+    //! Returns the number of columns
+    int columnCount() const { return mColumns.size(); }
+
+    //! Returns the attribute index of the values stored in \a column
+    int attributeIndex( int column ) const;
+
+    //! Returns the column storing the attribute \a attributeIndex, or -1 if it is not fetched
+    int columnIndex( int attributeIndex ) const;
+
+    //! Returns the type of \a column
+    ColumnType columnType( int column ) const;
+
+    //! Returns the type of column used to store the values of \a field
+    static ColumnType columnTypeForField( const QgsField &field );
+
+    //! Returns the number of features in the batch
+    int size() const { return mIds.size(); }
+
+    //! Returns true if the batch does not contain any feature
+    bool isEmpty() const { return mIds.isEmpty(); }
+
+    //! Removes all features, but keeps the columns and the memory allocated for them
+    void clear();
+
+    //! Returns the ID of the feature at \a row
+    QgsFeatureId id( int row ) const { return mIds.at( row ); }
+
+    //! Returns true if the feature at \a row has a geometry
+    bool hasGeometry( int row ) const;
+
+    //! Returns the WKB of the geometry of the feature at \a row, or an empty array if it has no geometry
+    QByteArray geometryWkb( int row ) const;
+
+    /**
+     * Returns a pointer to the WKB of the geometry of the feature at \a row, and stores
+     * its length in \a size. The pointer is valid until the batch is modified.
+     */
+    const unsigned char *geometryWkbData( int row, int &size ) const SIP_SKIP;
+
+    //! Returns the geometry of the feature at \a row
+    QgsGeometry geometry( int row ) const;
+
+    //! Returns true if the value of \a column is null at \a row
+    bool isNull( int column, int row ) const;
+
+    //! Returns the value of an Int64Column at \a row, or 0 if the value is null
+    qint64 int64Value( int column, int row ) const;
+
+    //! Returns the value of a DoubleColumn at \a row, or 0 if the value is null
+    double doubleValue( int column, int row ) const;
+
+    //! Returns the value of a StringColumn at \a row, or a null string if the value is null
+    QString stringValue( int column, int row ) const;
+
+    //! Returns the value of \a column at \a row, whatever the column type
+    QVariant value( int column, int row ) const;
+
+    /**
+     * Returns the values of an Int64Column, one per feature. The pointer is valid
+     * until the batch is modified.
+     */
+    const qint64 *int64Data( int column ) const SIP_SKIP;
+
+    /**
+     * Returns the values of a DoubleColumn, one per feature. The pointer is valid
+     * until the batch is modified.
+     */
+    const double *doubleData( int column ) const SIP_SKIP;
+
+    //! Returns the feature at \a row
+    QgsFeature feature( int row ) const;
+
+    /**
+     * Adds a feature with the given \a id at the end of the batch. All its values are
+     * null and it has no geometry until they are set.
+     */
+    void addRow( QgsFeatureId id );
+
+    //! Adds \a feature at the end of the batch
+    void addFeature( const QgsFeature &feature );
+
+    //! Sets the value of an Int64Column for the last feature
+    void setInt64( int column, qint64 value );
+
+    //! Sets the value of a DoubleColumn for the last feature
+    void setDouble( int column, double value );
+
+    //! Sets the value of a StringColumn for the last feature
+    void setString( int column, const QString &value );
+
+    //! Sets the value of \a column for the last feature, converting it to the column type
+    void setValue( int column, const QVariant &value );
+
+    //! Sets the geometry of the last feature
+    void setGeometry( const QgsGeometry &geometry );
+
+    /**
+     * Allocates \a size bytes for the WKB of the geometry of the last feature, replacing
+     * any geometry it had, and returns a pointer to them. The pointer is valid until
+     * the batch is modified.
+     */
+    unsigned char *allocateGeometryWkb( int size ) SIP_SKIP;
+
+  private:
+
+    struct Column
+    {
+      int attributeIndex = -1;
+      ColumnType type = VariantColumn;
+      QVariant::Type variantType = QVariant::Invalid;
+      QVector<bool> nulls;
+      QVector<qint64> int64Values;
+      QVector<double> doubleValues;
+      QVector<QString> stringValues;
+      QVector<QVariant> variantValues;
+    };
+
+    QgsFields mFields;
+    QVector<Column> mColumns;
+    QVector<int> mColumnIndexes;
+
+    QVector<QgsFeatureId> mIds;
+    //! Start of the WKB of each feature in mGeometryData
+    QVector<int> mGeometryOffsets;
+    QByteArray mGeometryData;
+
+    int geometryEnd( int row ) const;
+};
+
+#endif // QGSFEATUREBATCH_H
@@ -13,6 +13,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
 #include "qgslogger.h"
 
 #include "qgssimplifymethod.h"
@@ -71,15 +72,70 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
   return dataOk;
 }
 
+bool QgsAbstractFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  batch.clear();
+
+  QgsFeature f;
+  while ( batch.size() < maxFeatures && nextFeature( f ) )
+  {
+    if ( batch.isEmpty() )
+    {
+      const QgsFields fields = f.fields();
+      batch.setFields( fields, mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ? mRequest.subsetOfAttributes() : fields.allAttributesList() );
+    }
+    batch.addFeature( f );
+  }
+
+  return !batch.isEmpty();
+}
+
 bool QgsAbstractFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
-  while ( fetchFeature( f ) )
+  if ( !mFilterExpressionBuffer.isEmpty() )
+  {
+    f = mFilterExpressionBuffer.takeFirst();
+    return true;
+  }
+
+  // The filter is evaluated over blocks of features. The block grows with the number of
+  // features already returned, so requests which only want the first few matches don't
+  // read far ahead of what they consume.
+  int blockSize = qBound( 1, static_cast< int >( mFetchedCount ), 256 );
+  QgsFeatureList block;
+  while ( true )
   {
-    mRequest.expressionContext()->setFeature( f );
-    if ( mRequest.filterExpression()->evaluate( mRequest.expressionContext() ).toBool() )
+    block.clear();
+    block.reserve( blockSize );
+    while ( block.count() < blockSize )
+    {
+      QgsFeature feature;
+      if ( !fetchFeature( feature ) )
+        break;
+      block << feature;
+    }
+
+    if ( block.isEmpty() )
+      return false;
+
+    const QVariantList results = mRequest.filterExpression()->evaluateBlock( block, mRequest.expressionContext() );
+    for ( int i = 0; i < block.count(); ++i )
+    {
+      if ( results.at( i ).toBool() )
+        mFilterExpressionBuffer << block.at( i );
+    }
+
+    if ( !mFilterExpressionBuffer.isEmpty() )
+    {
+      f = mFilterExpressionBuffer.takeFirst();
       return true;
+    }
+
+    if ( block.count() < blockSize )
+      return false;
+
+    blockSize = std::min( blockSize * 2, 256 );
   }
-  return false;
 }
 
 bool QgsAbstractFeatureIterator::nextFeatureFilterFids( QgsFeature &f )
@@ -235,6 +291,16 @@ QgsFeatureIterator &QgsFeatureIterator::operator=( const QgsFeatureIterator &oth
   return *this;
 }
 
+bool QgsFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  if ( !mIter )
+  {
+    batch.clear();
+    return false;
+  }
+  return mIter->nextBatch( batch, maxFeatures );
+}
+
 bool QgsFeatureIterator::isValid() const
 {
   return mIter && mIter->isValid();
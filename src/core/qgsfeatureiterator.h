@@ -20,6 +20,7 @@
 #include "qgsindexedfeature.h"
 
 class QgsFeedback;
+class QgsFeatureBatch;
 
 /**
  * \ingroup core
@@ -46,6 +47,18 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     //! fetch next feature, return true on success
     virtual bool nextFeature( QgsFeature &f );
 
+    /**
+     * Fetches up to \a maxFeatures next features into \a batch, replacing its content.
+     * Returns true if at least one feature was fetched.
+     *
+     * The default implementation fetches the features one by one with nextFeature().
+     * Iterators which can fill the columns of the batch directly from their source
+     * should override it.
+     *
+     * \since QGIS 3.4
+     */
+    virtual bool nextBatch( QgsFeatureBatch &batch, int maxFeatures );
+
     //! reset the iterator to the starting position
     virtual bool rewind() = 0;
     //! end of iterating: free the resources / lock
@@ -201,6 +214,9 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     QList<QgsIndexedFeature> mCachedFeatures;
     QList<QgsIndexedFeature>::ConstIterator mFeatureIterator;
 
+    //! Features which passed the filter expression but have not been returned yet
+    QgsFeatureList mFilterExpressionBuffer;
+
     //! returns whether the iterator supports simplify geometries on provider side
     virtual bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const;
 
@@ -298,6 +314,18 @@ class CORE_EXPORT QgsFeatureIterator
     QgsFeatureIterator &operator=( const QgsFeatureIterator &other );
 
     bool nextFeature( QgsFeature &f );
+
+    /**
+     * Fetches up to \a maxFeatures next features into \a batch, replacing its content.
+     * Returns true if at least one feature was fetched.
+     *
+     * Fetching features in batches is faster than calling nextFeature() for every
+     * feature when the values are read directly from the columns of the batch.
+     *
+     * \since QGIS 3.4
+     */
+    bool nextBatch( QgsFeatureBatch &batch, int maxFeatures = 1000 );
+
     bool rewind();
     bool close();
 
@@ -378,7 +406,10 @@ inline bool QgsFeatureIterator::nextFeature( QgsFeature &f )
 inline bool QgsFeatureIterator::rewind()
 {
   if ( mIter )
+  {
     mIter->mFetchedCount = 0;
+    mIter->mFilterExpressionBuffer.clear();
+  }
 
   return mIter ? mIter->rewind() : false;
 }
@@ -386,14 +417,17 @@ inline bool QgsFeatureIterator::rewind()
 inline bool QgsFeatureIterator::close()
 {
   if ( mIter )
+  {
     mIter->mFetchedCount = 0;
+    mIter->mFilterExpressionBuffer.clear();
+  }
 
   return mIter ? mIter->close() : false;
 }
 
 inline bool QgsFeatureIterator::isClosed() const
 {
-  return mIter ? mIter->mClosed && !mIter->mZombie : true;
+  return mIter ? mIter->mClosed && !mIter->mZombie && mIter->mFilterExpressionBuffer.isEmpty() : true;
 }
 
 inline bool operator== ( const QgsFeatureIterator &fi1, const QgsFeatureIterator &fi2 )
@@ -0,0 +1,584 @@
+/***************************************************************************
+                         qgsimagequantizer.cpp
+                         ---------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsimagequantizer_p.h"
+#include "qgis.h"
+
+#include <QHash>
+#include <QSet>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define QGS_QUANTIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+///@cond PRIVATE
+
+namespace
+{
+  //! Colors are reduced to 5 bits per RGB component and 3 bits of alpha in the histogram
+  const int HISTOGRAM_BINS = 1 << 18;
+
+  //! Larger images are sampled by rows, which also keeps the bin sums in 32 bits
+  const qint64 MAX_HISTOGRAM_PIXELS = 1 << 22;
+
+  //! Number of rows mapped by each concurrent task
+  const int ROWS_PER_BLOCK = 32;
+
+  //! Value of the padding palette entries, far from any color
+  const qint16 PADDING_COMPONENT = 1000;
+
+  //! Fully transparent pixels share a single color
+  inline QRgb normalized( QRgb color )
+  {
+    return qAlpha( color ) == 0 ? 0 : color;
+  }
+
+  inline int binIndex( QRgb color )
+  {
+    return ( ( qAlpha( color ) >> 5 ) << 15 ) | ( ( qRed( color ) >> 3 ) << 10 ) | ( ( qGreen( color ) >> 3 ) << 5 ) | ( qBlue( color ) >> 3 );
+  }
+
+  //! Returns the component of a bin along a channel (0 red, 1 green, 2 blue, 3 alpha), in 8 bit units
+  inline int binComponent( int bin, int channel )
+  {
+    switch ( channel )
+    {
+      case 0:
+        return ( ( bin >> 10 ) & 31 ) << 3;
+      case 1:
+        return ( ( bin >> 5 ) & 31 ) << 3;
+      case 2:
+        return ( bin & 31 ) << 3;
+      default:
+        return ( bin >> 15 ) << 5;
+    }
+  }
+
+  QImage argb32( const QImage &image )
+  {
+    return image.format() == QImage::Format_ARGB32 ? image : image.convertToFormat( QImage::Format_ARGB32 );
+  }
+
+  /**
+   * Pixel counts and component sums of the histogram bins of an image.
+   */
+  class Histogram
+  {
+    public:
+
+      /**
+       * Builds the histogram of an ARGB32 \a image. The distinct colors of the image are
+       * collected if there are no more than \a exactColorCount of them.
+       */
+      Histogram( const QImage &image, int exactColorCount )
+        : mCounts( HISTOGRAM_BINS )
+        , mRed( HISTOGRAM_BINS )
+        , mGreen( HISTOGRAM_BINS )
+        , mBlue( HISTOGRAM_BINS )
+        , mAlpha( HISTOGRAM_BINS )
+      {
+        const int width = image.width();
+        const int height = image.height();
+        const qint64 pixels = static_cast< qint64 >( width ) * height;
+        const int rowStep = pixels > MAX_HISTOGRAM_PIXELS ? static_cast< int >( ( pixels + MAX_HISTOGRAM_PIXELS - 1 ) / MAX_HISTOGRAM_PIXELS ) : 1;
+
+        // colors missing from the sampled rows could not be mapped without loss
+        bool collectColors = exactColorCount > 0 && rowStep == 1;
+        QSet< QRgb > colors;
+        QRgb lastColor = 0;
+        bool hasLastColor = false;
+
+        for ( int y = 0; y < height; y += rowStep )
+        {
+          const QRgb *line = reinterpret_cast< const QRgb * >( image.constScanLine( y ) );
+          for ( int x = 0; x < width; ++x )
+          {
+            const QRgb color = normalized( line[x] );
+            const int bin = binIndex( color );
+            mCounts[bin]++;
+            mRed[bin] += qRed( color );
+            mGreen[bin] += qGreen( color );
+            mBlue[bin] += qBlue( color );
+            mAlpha[bin] += qAlpha( color );
+
+            if ( collectColors && ( !hasLastColor || color != lastColor ) )
+            {
+              colors.insert( color );
+              lastColor = color;
+              hasLastColor = true;
+              if ( colors.size() > exactColorCount )
+              {
+                collectColors = false;
+              }
+            }
+          }
+        }
+
+        if ( collectColors )
+        {
+          mColors.reserve( colors.size() );
+          for ( QRgb color : qgis::as_const( colors ) )
+            mColors << color;
+          std::sort( mColors.begin(), mColors.end() );
+        }
+
+        for ( int bin = 0; bin < HISTOGRAM_BINS; ++bin )
+        {
+          if ( mCounts[bin] > 0 )
+            mBins.push_back( bin );
+        }
+      }
+
+      //! Returns the non empty bins
+      const std::vector< int > &bins() const { return mBins; }
+
+      //! Returns the distinct colors of the image, or an empty vector if there are too many
+      const QVector< QRgb > &colors() const { return mColors; }
+
+      quint32 count( int bin ) const { return mCounts[bin]; }
+
+      //! Returns the average color of the pixels of a \a bin
+      QRgb average( int bin ) const
+      {
+        return average( &bin, &bin + 1 );
+      }
+
+      //! Returns the average color of the pixels of the bins in [\a begin, \a end)
+      QRgb average( const int *begin, const int *end ) const
+      {
+        quint64 count = 0;
+        quint64 red = 0;
+        quint64 green = 0;
+        quint64 blue = 0;
+        quint64 alpha = 0;
+        for ( auto it = begin; it != end; ++it )
+        {
+          count += mCounts[*it];
+          red += mRed[*it];
+          green += mGreen[*it];
+          blue += mBlue[*it];
+          alpha += mAlpha[*it];
+        }
+        if ( count == 0 )
+          return 0;
+
+        const quint64 half = count / 2;
+        return qRgba( static_cast< int >( ( red + half ) / count ), static_cast< int >( ( green + half ) / count ),
+                      static_cast< int >( ( blue + half ) / count ), static_cast< int >( ( alpha + half ) / count ) );
+      }
+
+    private:
+      std::vector< quint32 > mCounts;
+      std::vector< quint32 > mRed;
+      std::vector< quint32 > mGreen;
+      std::vector< quint32 > mBlue;
+      std::vector< quint32 > mAlpha;
+      std::vector< int > mBins;
+      QVector< QRgb > mColors;
+  };
+
+  //! Range of histogram bins reduced to a single palette color
+  struct ColorBox
+  {
+    int begin;
+    int end;
+    quint64 pixels;
+  };
+
+  /**
+   * Splits a box at the median pixel along its widest channel. The bins of the box
+   * are sorted in place.
+   */
+  void splitBox( const Histogram &histogram, std::vector< int > &bins, std::vector< ColorBox > &boxes, int boxIndex )
+  {
+    const ColorBox box = boxes[boxIndex];
+
+    int channel = 0;
+    int widestRange = -1;
+    for ( int c = 0; c < 4; ++c )
+    {
+      int min = 255;
+      int max = 0;
+      for ( int i = box.begin; i < box.end; ++i )
+      {
+        const int component = binComponent( bins[i], c );
+        min = std::min( min, component );
+        max = std::max( max, component );
+      }
+      if ( max - min > widestRange )
+      {
+        widestRange = max - min;
+        channel = c;
+      }
+    }
+
+    std::sort( bins.begin() + box.begin, bins.begin() + box.end, [channel]( int bin1, int bin2 )
+    {
+      return binComponent( bin1, channel ) < binComponent( bin2, channel );
+    } );
+
+    const quint64 half = box.pixels / 2;
+    quint64 sum = 0;
+    int split = box.begin;
+    while ( split < box.end - 1 )
+    {
+      sum += histogram.count( bins[split] );
+      ++split;
+      if ( sum >= half )
+        break;
+    }
+    // both boxes need at least one bin
+    split = std::max( box.begin + 1, std::min( split, box.end - 1 ) );
+
+    quint64 firstPixels = 0;
+    for ( int i = box.begin; i < split; ++i )
+      firstPixels += histogram.count( bins[i] );
+
+    boxes[boxIndex] = ColorBox { box.begin, split, firstPixels };
+    boxes.push_back( ColorBox { split, box.end, box.pixels - firstPixels } );
+  }
+
+  QVector< QRgb > medianCut( const Histogram &histogram, int colorCount )
+  {
+    std::vector< int > bins = histogram.bins();
+    if ( bins.empty() )
+      return QVector< QRgb >();
+
+    quint64 pixels = 0;
+    for ( int bin : bins )
+      pixels += histogram.count( bin );
+
+    std::vector< ColorBox > boxes;
+    boxes.reserve( colorCount );
+    boxes.push_back( ColorBox { 0, static_cast< int >( bins.size() ), pixels } );
+
+    // split the most populated box until there are enough colors or all the boxes hold a single bin
+    while ( static_cast< int >( boxes.size() ) < colorCount )
+    {
+      int selected = -1;
+      for ( int i = 0; i < static_cast< int >( boxes.size() ); ++i )
+      {
+        if ( boxes[i].end - boxes[i].begin > 1 && ( selected < 0 || boxes[i].pixels > boxes[selected].pixels ) )
+          selected = i;
+      }
+      if ( selected < 0 )
+        break;
+
+      splitBox( histogram, bins, boxes, selected );
+    }
+
+    QVector< QRgb > colorTable;
+    colorTable.reserve( static_cast< int >( boxes.size() ) );
+    for ( const ColorBox &box : boxes )
+    {
+      colorTable << histogram.average( bins.data() + box.begin, bins.data() + box.end );
+    }
+    return colorTable;
+  }
+
+  /**
+   * Maps colors to the index of the nearest palette color.
+   */
+  class ColorMapper
+  {
+    public:
+
+      /**
+       * Constructor for ColorMapper. The nearest palette color of every non empty
+       * bin of \a histogram is computed upfront.
+       */
+      ColorMapper( const QVector< QRgb > &colorTable, const Histogram &histogram )
+        : mColorTable( colorTable )
+        , mTable( HISTOGRAM_BINS, -1 )
+        , mPaletteBins( HISTOGRAM_BINS, false )
+      {
+        // palette components are interleaved as 16 bit (red, green) and (blue, alpha) pairs
+        mPaddedCount = ( colorTable.size() + 3 ) / 4 * 4;
+        mRedGreen.resize( 2 * mPaddedCount, PADDING_COMPONENT );
+        mBlueAlpha.resize( 2 * mPaddedCount, PADDING_COMPONENT );
+        for ( int i = 0; i < colorTable.size(); ++i )
+        {
+          const QRgb color = colorTable.at( i );
+          mRedGreen[2 * i] = static_cast< qint16 >( qRed( color ) );
+          mRedGreen[2 * i + 1] = static_cast< qint16 >( qGreen( color ) );
+          mBlueAlpha[2 * i] = static_cast< qint16 >( qBlue( color ) );
+          mBlueAlpha[2 * i + 1] = static_cast< qint16 >( qAlpha( color ) );
+
+          // exact palette colors are never mapped through their bin
+          if ( !mExactIndexes.contains( color ) )
+            mExactIndexes.insert( color, i );
+          mPaletteBins[binIndex( color )] = true;
+        }
+
+        std::vector< int > bins = histogram.bins();
+        QtConcurrent::blockingMap( bins, [this, &histogram]( int &bin )
+        {
+          mTable[bin] = static_cast< qint16 >( nearest( histogram.average( bin ) ) );
+        } );
+      }
+
+      //! Returns the index of the palette color nearest to \a color
+      inline int index( QRgb color ) const
+      {
+        color = normalized( color );
+        const int bin = binIndex( color );
+        if ( mPaletteBins[bin] )
+        {
+          const auto it = mExactIndexes.constFind( color );
+          if ( it != mExactIndexes.constEnd() )
+            return it.value();
+        }
+        const int index = mTable[bin];
+        // bins missing from a sampled histogram
+        return index >= 0 ? index : nearest( color );
+      }
+
+      //! Searches the palette color nearest to \a color
+      int nearest( QRgb color ) const
+      {
+#ifdef QGS_QUANTIZER_SSE2
+        const __m128i pixelRedGreen = _mm_set1_epi32( ( qGreen( color ) << 16 ) | qRed( color ) );
+        const __m128i pixelBlueAlpha = _mm_set1_epi32( ( qAlpha( color ) << 16 ) | qBlue( color ) );
+        const __m128i step = _mm_set1_epi32( 4 );
+        __m128i indexes = _mm_setr_epi32( 0, 1, 2, 3 );
+        __m128i bestIndexes = _mm_setzero_si128();
+        __m128i bestDistances = _mm_set1_epi32( std::numeric_limits< int >::max() );
+
+        for ( int i = 0; i < mPaddedCount; i += 4 )
+        {
+          // each 32 bit lane holds the squared distance of one palette color
+          const __m128i redGreen = _mm_sub_epi16( _mm_loadu_si128( reinterpret_cast< const __m128i * >( mRedGreen.data() + 2 * i ) ), pixelRedGreen );
+          const __m128i blueAlpha = _mm_sub_epi16( _mm_loadu_si128( reinterpret_cast< const __m128i * >( mBlueAlpha.data() + 2 * i ) ), pixelBlueAlpha );
+          const __m128i distances = _mm_add_epi32( _mm_madd_epi16( redGreen, redGreen ), _mm_madd_epi16( blueAlpha, blueAlpha ) );
+
+          const __m128i closer = _mm_cmplt_epi32( distances, bestDistances );
+          bestDistances = _mm_or_si128( _mm_and_si128( closer, distances ), _mm_andnot_si128( closer, bestDistances ) );
+          bestIndexes = _mm_or_si128( _mm_and_si128( closer, indexes ), _mm_andnot_si128( closer, bestIndexes ) );
+          indexes = _mm_add_epi32( indexes, step );
+        }
+
+        int distances[4];
+        int lanes[4];
+        _mm_storeu_si128( reinterpret_cast< __m128i * >( distances ), bestDistances );
+        _mm_storeu_si128( reinterpret_cast< __m128i * >( lanes ), bestIndexes );
+        int best = 0;
+        for ( int lane = 1; lane < 4; ++lane )
+        {
+          if ( distances[lane] < distances[best] || ( distances[lane] == distances[best] && lanes[lane] < lanes[best] ) )
+            best = lane;
+        }
+        return lanes[best];
+#else
+        const int red = qRed( color );
+        const int green = qGreen( color );
+        const int blue = qBlue( color );
+        const int alpha = qAlpha( color );
+        int best = 0;
+        int bestDistance = std::numeric_limits< int >::max();
+        for ( int i = 0; i < mPaddedCount; ++i )
+        {
+          const int dr = mRedGreen[2 * i] - red;
+          const int dg = mRedGreen[2 * i + 1] - green;
+          const int db = mBlueAlpha[2 * i] - blue;
+          const int da = mBlueAlpha[2 * i + 1] - alpha;
+          const int distance = dr * dr + dg * dg + db * db + da * da;
+          if ( distance < bestDistance )
+          {
+            bestDistance = distance;
+            best = i;
+          }
+        }
+        return best;
+#endif
+      }
+
+      QRgb color( int index ) const { return mColorTable.at( index ); }
+
+    private:
+      QVector< QRgb > mColorTable;
+      std::vector< qint16 > mTable;
+      std::vector< bool > mPaletteBins;
+      QHash< QRgb, int > mExactIndexes;
+      int mPaddedCount = 0;
+      std::vector< qint16 > mRedGreen;
+      std::vector< qint16 > mBlueAlpha;
+  };
+
+  //! Rows [begin, end) of the mapped image
+  struct RowBlock
+  {
+    int begin;
+    int end;
+  };
+
+  void mapRows( const QImage &source, uchar *bits, int bytesPerLine, const ColorMapper &mapper )
+  {
+    const int width = source.width();
+    const int height = source.height();
+
+    std::vector< RowBlock > blocks;
+    for ( int begin = 0; begin < height; begin += ROWS_PER_BLOCK )
+      blocks.push_back( RowBlock { begin, std::min( begin + ROWS_PER_BLOCK, height ) } );
+
+    QtConcurrent::blockingMap( blocks, [&source, bits, bytesPerLine, width, &mapper]( RowBlock & block )
+    {
+      for ( int y = block.begin; y < block.end; ++y )
+      {
+        const QRgb *line = reinterpret_cast< const QRgb * >( source.constScanLine( y ) );
+        uchar *indexes = bits + static_cast< qint64 >( y ) * bytesPerLine;
+
+        // maps are mostly made of runs of identical pixels
+        QRgb lastColor = line[0];
+        uchar lastIndex = static_cast< uchar >( mapper.index( lastColor ) );
+        for ( int x = 0; x < width; ++x )
+        {
+          if ( line[x] != lastColor )
+          {
+            lastColor = line[x];
+            lastIndex = static_cast< uchar >( mapper.index( lastColor ) );
+          }
+          indexes[x] = lastIndex;
+        }
+      }
+    } );
+  }
+
+  void mapRowsDithered( const QImage &source, uchar *bits, int bytesPerLine, const ColorMapper &mapper )
+  {
+    const int width = source.width();
+    const int height = source.height();
+
+    // Floyd-Steinberg errors of the current and next rows, in 1/16 units, with a pixel of margin on each side
+    std::vector< int > current( 3 * ( width + 2 ) );
+    std::vector< int > next( 3 * ( width + 2 ) );
+
+    for ( int y = 0; y < height; ++y )
+    {
+      const QRgb *line = reinterpret_cast< const QRgb * >( source.constScanLine( y ) );
+      uchar *indexes = bits + static_cast< qint64 >( y ) * bytesPerLine;
+      std::fill( next.begin(), next.end(), 0 );
+
+      for ( int x = 0; x < width; ++x )
+      {
+        const QRgb pixel = line[x];
+        const int alpha = qAlpha( pixel );
+        if ( alpha == 0 )
+        {
+          // the error is not diffused into transparent areas
+          indexes[x] = static_cast< uchar >( mapper.index( pixel ) );
+          continue;
+        }
+
+        int *error = current.data() + 3 * ( x + 1 );
+        const int red = qBound( 0, qRed( pixel ) + error[0] / 16, 255 );
+        const int green = qBound( 0, qGreen( pixel ) + error[1] / 16, 255 );
+        const int blue = qBound( 0, qBlue( pixel ) + error[2] / 16, 255 );
+
+        const int index = mapper.index( qRgba( red, green, blue, alpha ) );
+        indexes[x] = static_cast< uchar >( index );
+
+        const QRgb mapped = mapper.color( index );
+        const int componentErrors[3] = { red - qRed( mapped ), green - qGreen( mapped ), blue - qBlue( mapped ) };
+        int *right = error + 3;
+        int *below = next.data() + 3 * ( x + 1 );
+        for ( int c = 0; c < 3; ++c )
+        {
+          right[c] += componentErrors[c] * 7;
+          below[c - 3] += componentErrors[c] * 3;
+          below[c] += componentErrors[c] * 5;
+          below[c + 3] += componentErrors[c];
+        }
+      }
+
+      std::swap( current, next );
+    }
+  }
+
+  QVector< QRgb > histogramColorTable( const Histogram &histogram, int colorCount )
+  {
+    if ( !histogram.colors().isEmpty() )
+    {
+      // all the colors of the image fit in the palette
+      return histogram.colors();
+    }
+    return medianCut( histogram, colorCount );
+  }
+
+  QImage mapImage( const QImage &image, const QImage &source, const Histogram &histogram, const QVector< QRgb > &colorTable, bool dither )
+  {
+    const ColorMapper mapper( colorTable, histogram );
+
+    QImage result( source.width(), source.height(), QImage::Format_Indexed8 );
+    result.setColorTable( colorTable );
+    result.setDotsPerMeterX( image.dotsPerMeterX() );
+    result.setDotsPerMeterY( image.dotsPerMeterY() );
+    const QStringList keys = image.textKeys();
+    for ( const QString &key : keys )
+    {
+      result.setText( key, image.text( key ) );
+    }
+
+    if ( dither )
+    {
+      mapRowsDithered( source, result.bits(), result.bytesPerLine(), mapper );
+    }
+    else
+    {
+      mapRows( source, result.bits(), result.bytesPerLine(), mapper );
+    }
+    return result;
+  }
+
+} // namespace
+
+///@endcond
+
+QVector<QRgb> QgsImageQuantizer::colorTable( const QImage &image, int colorCount )
+{
+  colorCount = qBound( 1, colorCount, 256 );
+  return histogramColorTable( Histogram( argb32( image ), colorCount ), colorCount );
+}
+
+QImage QgsImageQuantizer::quantize( const QImage &image, const QVector<QRgb> &colorTable, bool dither )
+{
+  if ( image.isNull() || colorTable.isEmpty() || colorTable.size() > 256 )
+  {
+    return image.convertToFormat( QImage::Format_Indexed8, colorTable );
+  }
+
+  const QImage source = argb32( image );
+  return mapImage( image, source, Histogram( source, 0 ), colorTable, dither );
+}
+
+QImage QgsImageQuantizer::quantize( const QImage &image, int colorCount, bool dither )
+{
+  if ( image.isNull() )
+  {
+    return image.convertToFormat( QImage::Format_Indexed8 );
+  }
+
+  // the histogram is shared by the palette and the mapping
+  colorCount = qBound( 1, colorCount, 256 );
+  const QImage source = argb32( image );
+  const Histogram histogram( source, colorCount );
+  return mapImage( image, source, histogram, histogramColorTable( histogram, colorCount ), dither );
+}
@@ -0,0 +1,78 @@
+/***************************************************************************
+                         qgsimagequantizer_p.h
+                         ---------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSIMAGEQUANTIZER_P_H
+#define QGSIMAGEQUANTIZER_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+
+#include <QImage>
+#include <QVector>
+
+/**
+ * \ingroup core
+ * Reduces the colors of an image to a palette, e.g. for 8 bit PNG output.
+ *
+ * The palette is computed with a median cut over a histogram of the image where
+ * the colors are reduced to 5 bits per RGB component and 3 bits of alpha. Images
+ * with no more colors than the palette size are converted without loss.
+ *
+ * Pixels are mapped to the palette through a table holding the nearest palette
+ * color of each histogram bin, so the nearest color search only runs once per
+ * distinct bin. Rows are mapped concurrently unless the image is dithered.
+ *
+ * \since QGIS 3.4
+ */
+class CORE_EXPORT QgsImageQuantizer
+{
+  public:
+
+    /**
+     * Returns a palette of at most \a colorCount colors (up to 256) for \a image.
+     * Fully transparent pixels share a single palette color.
+     */
+    static QVector<QRgb> colorTable( const QImage &image, int colorCount = 256 );
+
+    /**
+     * Returns \a image converted to QImage::Format_Indexed8 with the given \a colorTable.
+     * Each pixel is mapped to the nearest palette color. If \a dither is true the
+     * quantization error is diffused to the neighboring pixels (Floyd-Steinberg).
+     */
+    static QImage quantize( const QImage &image, const QVector<QRgb> &colorTable, bool dither = false );
+
+    /**
+     * Returns \a image converted to QImage::Format_Indexed8 with a palette of at most
+     * \a colorCount colors computed by colorTable().
+     */
+    static QImage quantize( const QImage &image, int colorCount = 256, bool dither = false );
+};
+
+/// @endcond
+
+#endif // QGSIMAGEQUANTIZER_P_H
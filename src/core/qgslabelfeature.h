@@ -193,6 +193,22 @@ class CORE_EXPORT QgsLabelFeature
     //! Sets coordinates of the fixed position (relevant only if hasFixedPosition() returns true)
     void setFixedPosition( const QgsPointXY &point ) { mFixedPosition = point; }
 
+    /**
+     * Returns true if the fixed position is the placement of the label in a previous
+     * render of the map, rather than a position set by the user.
+     * \see setReusesPlacement()
+     * \since QGIS 3.4
+     */
+    bool reusesPlacement() const { return mReusesPlacement; }
+
+    /**
+     * Sets whether the fixed position is the placement of the label in a previous
+     * render of the map.
+     * \see reusesPlacement()
+     * \since QGIS 3.4
+     */
+    void setReusesPlacement( bool reuses ) { mReusesPlacement = reuses; }
+
     //! Whether the label should use a fixed angle instead of using angle from automatic placement
     bool hasFixedAngle() const { return mHasFixedAngle; }
     //! Sets whether the label should use a fixed angle instead of using angle from automatic placement
@@ -383,6 +399,8 @@ class CORE_EXPORT QgsLabelFeature
     bool mHasFixedPosition;
     //! fixed position for the label (instead of automatic placement)
     QgsPointXY mFixedPosition;
+    //! whether mFixedPosition comes from a previous render
+    bool mReusesPlacement = false;
     //! whether mFixedAngle should be respected
     bool mHasFixedAngle;
     //! fixed rotation for the label (instead of automatic choice)
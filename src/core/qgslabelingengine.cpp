@@ -16,6 +16,7 @@
 
 #include "qgslabelingengine.h"
 
+#include "qgslabelingstream_p.h"
 #include "qgslogger.h"
 
 #include "feature.h"
@@ -77,6 +78,9 @@ QgsLabelingEngine::QgsLabelingEngine()
 
 QgsLabelingEngine::~QgsLabelingEngine()
 {
+  // the stream may still be registering features of the providers
+  mStream.reset();
+
   qDeleteAll( mProviders );
   qDeleteAll( mSubProviders );
 }
@@ -112,7 +116,7 @@ void QgsLabelingEngine::removeProvider( QgsAbstractLabelProvider *provider )
   }
 }
 
-void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p )
+pal::Layer *QgsLabelingEngine::createPalLayer( QgsAbstractLabelProvider *provider, pal::Pal &p ) const
 {
   QgsAbstractLabelProvider::Flags flags = provider->flags();
 
@@ -155,15 +159,42 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
       break;
     default:
       Q_ASSERT( "unsupported upside-down label setting" && false );
-      return;
+      return nullptr;
   }
   l->setUpsidedownLabels( upsdnlabels );
 
+  return l;
+}
+
+void QgsLabelingEngine::createPalLayers( QgsAbstractLabelProvider *provider, pal::Pal &p, QHash<QgsAbstractLabelProvider *, pal::Layer *> &layers ) const
+{
+  pal::Layer *l = createPalLayer( provider, p );
+  if ( !l )
+    return;
+
+  layers.insert( provider, l );
+
+  Q_FOREACH ( QgsAbstractLabelProvider *subProvider, provider->subProviders() )
+  {
+    createPalLayers( subProvider, p, layers );
+  }
+}
+
+void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p )
+{
+  pal::Layer *l = mStream ? mStream->layer( provider ) : nullptr;
+  if ( !l )
+    l = createPalLayer( provider, p );
+  if ( !l )
+    return;
 
   QList<QgsLabelFeature *> features = provider->labelFeatures( context );
 
-  Q_FOREACH ( QgsLabelFeature *feature, features )
+  // the first features have already been registered while the layers were rendered
+  for ( int i = mStream ? mStream->featureCount( provider ) : 0; i < features.count(); ++i )
   {
+    QgsLabelFeature *feature = features.at( i );
+    reusePreviousPlacement( provider, feature );
     try
     {
       l->registerFeature( feature );
@@ -185,11 +216,95 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
 }
 
 
-void QgsLabelingEngine::run( QgsRenderContext &context )
+static QString placementKey( const QString &layerId, const QString &providerId )
+{
+  return layerId + '|' + providerId;
+}
+
+void QgsLabelingEngine::setPreviousPlacements( const QList<QgsLabelPosition> &placements )
+{
+  mPreviousPlacements.clear();
+
+  // PAL works in unrotated map coordinates
+  if ( !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
+    return;
+
+  QSet< QString > ambiguous;
+  for ( const QgsLabelPosition &placement : placements )
+  {
+    if ( placement.isDiagram || placement.upsideDown || placement.cornerPoints.isEmpty() )
+      continue;
+
+    const QString key = placementKey( placement.layerID, placement.providerID );
+    QHash< QgsFeatureId, QgsLabelPosition > &layerPlacements = mPreviousPlacements[key];
+    // features with several labels cannot be matched to their previous placement
+    if ( layerPlacements.contains( placement.featureId ) )
+      ambiguous << key + '|' + QString::number( placement.featureId );
+    else
+      layerPlacements.insert( placement.featureId, placement );
+  }
+
+  for ( auto it = mPreviousPlacements.begin(); it != mPreviousPlacements.end(); ++it )
+  {
+    for ( auto featureIt = it->begin(); featureIt != it->end(); )
+    {
+      if ( ambiguous.contains( it.key() + '|' + QString::number( featureIt.key() ) ) )
+        featureIt = it->erase( featureIt );
+      else
+        ++featureIt;
+    }
+  }
+}
+
+QList<QgsLabelPosition> QgsLabelingEngine::placements() const
+{
+  if ( !mResults || !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
+    return QList<QgsLabelPosition>();
+
+  return mResults->labelsWithinRect( mMapSettings.visibleExtent() );
+}
+
+bool QgsLabelingEngine::reusePreviousPlacement( QgsAbstractLabelProvider *provider, QgsLabelFeature *feature ) const
+{
+  if ( mPreviousPlacements.isEmpty() || feature->hasFixedPosition() )
+    return false;
+
+  // curved labels have one part per character, which a single position cannot restore
+  if ( provider->placement() == QgsPalLayerSettings::Curved || provider->placement() == QgsPalLayerSettings::PerimeterCurved )
+    return false;
+
+  const auto layerIt = mPreviousPlacements.constFind( placementKey( provider->layerId(), provider->providerId() ) );
+  if ( layerIt == mPreviousPlacements.constEnd() )
+    return false;
+
+  const auto it = layerIt->constFind( feature->id() );
+  if ( it == layerIt->constEnd() )
+    return false;
+
+  const QgsLabelPosition &placement = it.value();
+
+  // labels at the edge of the map are placed again, they may fit better now
+  if ( !mMapSettings.visibleExtent().contains( placement.labelRect ) )
+    return false;
+
+  if ( placement.labelText != feature->labelText()
+       || !qgsDoubleNear( placement.width, feature->size().width() )
+       || !qgsDoubleNear( placement.height, feature->size().height() ) )
+    return false;
+
+  feature->setHasFixedPosition( true );
+  feature->setFixedPosition( placement.cornerPoints.at( 0 ) );
+  feature->setHasFixedAngle( true );
+  feature->setFixedAngle( placement.rotation );
+  feature->setReusesPlacement( true );
+  return true;
+}
+
+std::unique_ptr< pal::Pal > QgsLabelingEngine::createPal() const
 {
   const QgsLabelingEngineSettings &settings = mMapSettings.labelingEngineSettings();
 
-  pal::Pal p;
+  std::unique_ptr< pal::Pal > p = qgis::make_unique< pal::Pal >();
   pal::SearchMethod s;
   switch ( settings.searchMethod() )
   {
@@ -210,17 +325,75 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
       s = pal::FALP;
       break;
   }
-  p.setSearch( s );
+  p->setSearch( s );
 
   // set number of candidates generated per feature
   int candPoint, candLine, candPolygon;
   settings.numCandidatePositions( candPoint, candLine, candPolygon );
-  p.setPointP( candPoint );
-  p.setLineP( candLine );
-  p.setPolyP( candPolygon );
+  p->setPointP( candPoint );
+  p->setLineP( candLine );
+  p->setPolyP( candPolygon );
 
-  p.setShowPartial( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
+  p->setShowPartial( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
+  p->setParallelSolving( settings.testFlag( QgsLabelingEngineSettings::ParallelSolving ) );
 
+  return p;
+}
+
+void QgsLabelingEngine::mapBoundary( QgsRectangle &extent, QgsGeometry &boundary ) const
+{
+  QgsGeometry extentGeom = QgsGeometry::fromRect( mMapSettings.visibleExtent() );
+  QPolygonF visiblePoly = mMapSettings.visiblePolygon();
+  visiblePoly.append( visiblePoly.at( 0 ) ); //close polygon
+  boundary = QgsGeometry::fromQPolygonF( visiblePoly );
+
+  if ( !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
+  {
+    //PAL features are prerotated, so extent also needs to be unrotated
+    extentGeom.rotate( -mMapSettings.rotation(), mMapSettings.visibleExtent().center() );
+    // yes - this is rotated in the opposite direction... phew, this is confusing!
+    boundary.rotate( mMapSettings.rotation(), mMapSettings.visibleExtent().center() );
+  }
+
+  extent = extentGeom.boundingBox();
+}
+
+void QgsLabelingEngine::startStreaming()
+{
+  if ( mStream )
+    return;
+
+  mPal = createPal();
+
+  // layers are created in the same order as in run(), which keeps the problem identical
+  QHash< QgsAbstractLabelProvider *, pal::Layer * > layers;
+  Q_FOREACH ( QgsAbstractLabelProvider *provider, mProviders )
+  {
+    createPalLayers( provider, *mPal, layers );
+  }
+
+  QgsRectangle extent;
+  QgsGeometry mapBoundaryGeom;
+  mapBoundary( extent, mapBoundaryGeom );
+  mStream.reset( new QgsLabelingStream( this, layers, mapBoundaryGeom ) );
+}
+
+void QgsLabelingEngine::run( QgsRenderContext &context )
+{
+  const QgsLabelingEngineSettings &settings = mMapSettings.labelingEngineSettings();
+
+  std::unique_ptr< pal::Pal > ownedPal;
+  if ( mStream )
+  {
+    // wait for the features registered while rendering
+    mStream->finish();
+    ownedPal = std::move( mPal );
+  }
+  else
+  {
+    ownedPal = createPal();
+  }
+  pal::Pal &p = *ownedPal;
 
   // for each provider: get labels and register them in PAL
   Q_FOREACH ( QgsAbstractLabelProvider *provider, mProviders )
@@ -236,25 +409,17 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
       delete context.expressionContext().popScope();
   }
 
+  // the stream refers to the PAL layers, which do not outlive this method
+  mStream.reset();
+
 
   // NOW DO THE LAYOUT (from QgsPalLabeling::drawLabeling)
 
   QPainter *painter = context.painter();
 
-  QgsGeometry extentGeom = QgsGeometry::fromRect( mMapSettings.visibleExtent() );
-  QPolygonF visiblePoly = mMapSettings.visiblePolygon();
-  visiblePoly.append( visiblePoly.at( 0 ) ); //close polygon
-  QgsGeometry mapBoundaryGeom = QgsGeometry::fromQPolygonF( visiblePoly );
-
-  if ( !qgsDoubleNear( mMapSettings.rotation(), 0.0 ) )
-  {
-    //PAL features are prerotated, so extent also needs to be unrotated
-    extentGeom.rotate( -mMapSettings.rotation(), mMapSettings.visibleExtent().center() );
-    // yes - this is rotated in the opposite direction... phew, this is confusing!
-    mapBoundaryGeom.rotate( mMapSettings.rotation(), mMapSettings.visibleExtent().center() );
-  }
-
-  QgsRectangle extent = extentGeom.boundingBox();
+  QgsRectangle extent;
+  QgsGeometry mapBoundaryGeom;
+  mapBoundary( extent, mapBoundaryGeom );
 
 
   p.registerCancelationCallback( &_palIsCanceled, reinterpret_cast< void * >( &context ) );
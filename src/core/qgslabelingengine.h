@@ -26,6 +26,7 @@
 
 
 class QgsLabelingEngine;
+class QgsLabelingStream;
 
 
 /**
@@ -200,6 +201,49 @@ class CORE_EXPORT QgsLabelingEngine
     //! Remove provider if the provider's initialization failed. Provider instance is deleted.
     void removeProvider( QgsAbstractLabelProvider *provider );
 
+    /**
+     * Starts registering the label features into the labeling engine while the layers
+     * are still being rendered, so that the candidates are ready when run() is called.
+     * Must be called once all providers have been added, and before any label
+     * feature is registered.
+     * \see stream()
+     * \since QGIS 3.4
+     */
+    void startStreaming();
+
+    /**
+     * Returns the stream which accepts label features while the layers are rendered,
+     * or nullptr if startStreaming() was not called. For internal use by the providers.
+     * \since QGIS 3.4
+     */
+    QgsLabelingStream *stream() const { return mStream.get(); }
+
+    /**
+     * Sets the label \a placements of a previous render of the map at the same scale.
+     * Labels of features which are still completely in view and whose text did not change
+     * keep their position, only the other labels are placed by the engine.
+     * Placements are ignored if the map is rotated.
+     * \see placements()
+     * \since QGIS 3.4
+     */
+    void setPreviousPlacements( const QList< QgsLabelPosition > &placements );
+
+    /**
+     * Returns the placements of the labels drawn by run(), to be passed to
+     * setPreviousPlacements() for the next render at the same scale.
+     * Returns an empty list if the map is rotated.
+     * \since QGIS 3.4
+     */
+    QList< QgsLabelPosition > placements() const;
+
+    /**
+     * Fixes the position of the label \a feature of \a provider to its previous placement,
+     * if it can be reused. Returns true if the position was fixed. For internal use.
+     * \see setPreviousPlacements()
+     * \since QGIS 3.4
+     */
+    bool reusePreviousPlacement( QgsAbstractLabelProvider *provider, QgsLabelFeature *feature ) const;
+
     //! compute the labeling with given map settings and providers
     void run( QgsRenderContext &context );
 
@@ -212,6 +256,18 @@ class CORE_EXPORT QgsLabelingEngine
   protected:
     void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p );
 
+    //! Creates a PAL instance configured with the engine settings
+    std::unique_ptr< pal::Pal > createPal() const;
+
+    //! Creates the PAL layer of \a provider, or returns nullptr if the provider's settings are not supported
+    pal::Layer *createPalLayer( QgsAbstractLabelProvider *provider, pal::Pal &p ) const;
+
+    //! Creates the PAL layers of \a provider and its sub providers, in the order used by processProvider()
+    void createPalLayers( QgsAbstractLabelProvider *provider, pal::Pal &p, QHash< QgsAbstractLabelProvider *, pal::Layer * > &layers ) const;
+
+    //! Computes the extent and the boundary of the map to label, in PAL coordinates
+    void mapBoundary( QgsRectangle &extent, QgsGeometry &boundary ) const;
+
   protected:
     //! Associated map settings instance
     QgsMapSettings mMapSettings;
@@ -223,6 +279,15 @@ class CORE_EXPORT QgsLabelingEngine
     //! Resulting labeling layout
     std::unique_ptr< QgsLabelingResults > mResults;
 
+    //! PAL instance receiving the streamed features
+    std::unique_ptr< pal::Pal > mPal;
+
+    //! Stream of label features registered while rendering
+    std::unique_ptr< QgsLabelingStream > mStream;
+
+    //! Placements of a previous render, by layer and provider id, then by feature id
+    QHash< QString, QHash< QgsFeatureId, QgsLabelPosition > > mPreviousPlacements;
+
 };
 
 
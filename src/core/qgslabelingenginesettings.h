@@ -37,6 +37,7 @@ class CORE_EXPORT QgsLabelingEngineSettings
       RenderOutlineLabels   = 1 << 3,  //!< Whether to render labels as text or outlines
       DrawLabelRectOnly     = 1 << 4,  //!< Whether to only draw the label rect and not the actual label text (used for unit tests)
       DrawCandidates        = 1 << 5,  //!< Whether to draw rectangles of generated candidates (good for debugging)
+      ParallelSolving       = 1 << 6,  //!< Whether to solve independent groups of colliding labels in parallel (since QGIS 3.4)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
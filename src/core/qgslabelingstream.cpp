@@ -0,0 +1,123 @@
+/***************************************************************************
+                         qgslabelingstream.cpp
+                         ---------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslabelingstream_p.h"
+#include "qgslabelfeature.h"
+#include "qgslabelingengine.h"
+#include "qgslogger.h"
+
+#include "layer.h"
+
+#include <QtConcurrentRun>
+
+///@cond PRIVATE
+
+QgsLabelingStream::QgsLabelingStream( const QgsLabelingEngine *engine, const QHash<QgsAbstractLabelProvider *, pal::Layer *> &layers, const QgsGeometry &mapBoundary )
+  : mEngine( engine )
+  , mLayers( layers )
+  , mMapBoundary( QgsGeos::asGeos( mapBoundary ) )
+{
+  mPreparedMapBoundary.reset( GEOSPrepare_r( QgsGeos::getGEOSHandler(), mMapBoundary.get() ) );
+
+  for ( pal::Layer *layer : qgis::as_const( mLayers ) )
+    layer->setPrepareCandidates( true );
+}
+
+QgsLabelingStream::~QgsLabelingStream()
+{
+  mMutex.lock();
+  mCanceled = true;
+  mMutex.unlock();
+
+  finish();
+}
+
+bool QgsLabelingStream::addFeature( QgsAbstractLabelProvider *provider, QgsLabelFeature *feature )
+{
+  QMutexLocker locker( &mMutex );
+
+  if ( !mAccepting || !mLayers.contains( provider ) )
+    return false;
+
+  mQueue.append( qMakePair( provider, feature ) );
+  mFeatureCounts[provider]++;
+
+  // the worker only runs while there is something to register, so that it does not hold
+  // a thread of the pool which the layers being rendered could use
+  if ( !mWorkerRunning )
+  {
+    mWorkerRunning = true;
+    mWorker = QtConcurrent::run( this, &QgsLabelingStream::process );
+  }
+  return true;
+}
+
+void QgsLabelingStream::finish()
+{
+  mMutex.lock();
+  mAccepting = false;
+  QFuture< void > worker = mWorker;
+  mMutex.unlock();
+
+  // no worker can be started anymore, and a running one drains the queue before exiting
+  worker.waitForFinished();
+
+  for ( pal::Layer *layer : qgis::as_const( mLayers ) )
+    layer->setPrepareCandidates( false );
+}
+
+int QgsLabelingStream::featureCount( QgsAbstractLabelProvider *provider ) const
+{
+  QMutexLocker locker( &mMutex );
+  return mFeatureCounts.value( provider );
+}
+
+void QgsLabelingStream::process()
+{
+  while ( true )
+  {
+    mMutex.lock();
+    if ( mQueue.isEmpty() || mCanceled )
+    {
+      mQueue.clear();
+      mWorkerRunning = false;
+      mMutex.unlock();
+      return;
+    }
+    const QList< QPair< QgsAbstractLabelProvider *, QgsLabelFeature * > > batch = mQueue;
+    mQueue.clear();
+    mMutex.unlock();
+
+    for ( const QPair< QgsAbstractLabelProvider *, QgsLabelFeature * > &item : batch )
+    {
+      pal::Layer *layer = mLayers.value( item.first );
+      mEngine->reusePreviousPlacement( item.first, item.second );
+      try
+      {
+        layer->registerFeature( item.second );
+      }
+      catch ( std::exception &e )
+      {
+        Q_UNUSED( e );
+        QgsDebugMsgLevel( QString( "Ignoring feature %1 due PAL exception:" ).arg( item.second->id() ) + QString::fromLatin1( e.what() ), 4 );
+        continue;
+      }
+      layer->prepareCandidates( mPreparedMapBoundary.get() );
+    }
+  }
+}
+
+///@endcond
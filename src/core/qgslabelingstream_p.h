@@ -0,0 +1,127 @@
+/***************************************************************************
+                         qgslabelingstream_p.h
+                         ---------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLABELINGSTREAM_P_H
+#define QGSLABELINGSTREAM_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+#include "qgsgeos.h"
+
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+
+class QgsAbstractLabelProvider;
+class QgsLabelFeature;
+class QgsLabelingEngine;
+
+namespace pal
+{
+  class Layer;
+}
+
+/**
+ * \ingroup core
+ * Registers label features into PAL layers while the map layers are still being rendered.
+ *
+ * Label providers hand their features to the stream as soon as they are created, from
+ * the threads rendering the layers. A worker registers them into their PAL layer, which
+ * builds the feature and obstacle indexes, and generates the label candidates of the
+ * new feature parts. The labeling engine then only has to extract and solve the problem
+ * once all layers are rendered.
+ *
+ * Features are registered in the order they were added by each provider, so the
+ * resulting problem is the same as when registering them after rendering.
+ *
+ * \since QGIS 3.4
+ */
+class CORE_EXPORT QgsLabelingStream
+{
+  public:
+
+    /**
+     * Constructor for QgsLabelingStream, for features of the providers of \a engine which
+     * have a PAL layer in \a layers. Candidates are restricted to \a mapBoundary, which must
+     * be the boundary later used to extract the problem.
+     */
+    QgsLabelingStream( const QgsLabelingEngine *engine, const QHash< QgsAbstractLabelProvider *, pal::Layer * > &layers, const QgsGeometry &mapBoundary );
+
+    //! Stops the stream, dropping the features which are still queued
+    ~QgsLabelingStream();
+
+    //! QgsLabelingStream cannot be copied
+    QgsLabelingStream( const QgsLabelingStream &other ) = delete;
+    //! QgsLabelingStream cannot be copied
+    QgsLabelingStream &operator=( const QgsLabelingStream &other ) = delete;
+
+    /**
+     * Queues the label \a feature of \a provider for registration. Returns false if the
+     * feature was not accepted, in which case the engine registers it after rendering.
+     * Thread safe.
+     */
+    bool addFeature( QgsAbstractLabelProvider *provider, QgsLabelFeature *feature );
+
+    /**
+     * Stops accepting features and waits until all queued features are registered.
+     */
+    void finish();
+
+    //! Returns the PAL layer of \a provider, or nullptr if the provider is not streamed
+    pal::Layer *layer( QgsAbstractLabelProvider *provider ) const { return mLayers.value( provider ); }
+
+    /**
+     * Returns the number of features accepted for \a provider. They are the first features
+     * returned by the provider's labelFeatures().
+     */
+    int featureCount( QgsAbstractLabelProvider *provider ) const;
+
+  private:
+
+    //! Registers the queued features until the queue is empty
+    void process();
+
+    const QgsLabelingEngine *mEngine = nullptr;
+    QHash< QgsAbstractLabelProvider *, pal::Layer * > mLayers;
+    geos::unique_ptr mMapBoundary;
+    geos::prepared_unique_ptr mPreparedMapBoundary;
+
+    mutable QMutex mMutex;
+    QList< QPair< QgsAbstractLabelProvider *, QgsLabelFeature * > > mQueue;
+    QHash< QgsAbstractLabelProvider *, int > mFeatureCounts;
+    bool mAccepting = true;
+    bool mCanceled = false;
+    bool mWorkerRunning = false;
+    QFuture< void > mWorker;
+};
+
+/// @endcond
+
+#endif // QGSLABELINGSTREAM_P_H
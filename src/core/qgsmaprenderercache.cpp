@@ -45,6 +45,8 @@ void QgsMapRendererCache::clearInternal()
   }
   mCachedImages.clear();
   mConnectedLayers.clear();
+  mLabelPlacements.clear();
+  mLabelPlacementLayers.clear();
 }
 
 void QgsMapRendererCache::dropUnusedConnections()
@@ -75,24 +77,53 @@ QSet<QgsWeakMapLayerPointer > QgsMapRendererCache::dependentLayers() const
         result << l;
     }
   }
+  Q_FOREACH ( const QgsWeakMapLayerPointer &l, mLabelPlacementLayers )
+  {
+    if ( l.data() )
+      result << l;
+  }
   return result;
 }
 
+void QgsMapRendererCache::connectToLayer( QgsMapLayer *layer )
+{
+  if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
+  {
+    connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
+    connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+    mConnectedLayers << layer;
+  }
+}
+
 bool QgsMapRendererCache::init( const QgsRectangle &extent, double scale )
 {
   QMutexLocker lock( &mMutex );
 
   // check whether the params are the same
-  if ( extent == mExtent &&
-       qgsDoubleNear( scale, mScale ) )
+  const bool sameScale = qgsDoubleNear( scale, mScale );
+  if ( extent == mExtent && sameScale )
     return true;
 
+  // label placements are still valid for a pan
+  const QList< QgsLabelPosition > labelPlacements = sameScale ? mLabelPlacements : QList< QgsLabelPosition >();
+  const QgsWeakMapLayerPointerList labelPlacementLayers = sameScale ? mLabelPlacementLayers : QgsWeakMapLayerPointerList();
+
   clearInternal();
 
   // set new params
   mExtent = extent;
   mScale = scale;
 
+  mLabelPlacements = labelPlacements;
+  Q_FOREACH ( const QgsWeakMapLayerPointer &layer, labelPlacementLayers )
+  {
+    if ( layer.data() )
+    {
+      mLabelPlacementLayers << layer;
+      connectToLayer( layer.data() );
+    }
+  }
+
   return false;
 }
 
@@ -109,12 +140,7 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
     if ( layer )
     {
       params.dependentLayers << layer;
-      if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
-      {
-        connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-        mConnectedLayers << layer;
-      }
+      connectToLayer( layer );
     }
   }
 
@@ -161,9 +187,43 @@ void QgsMapRendererCache::layerRequestedRepaint()
 
     it = mCachedImages.erase( it );
   }
+
+  if ( mLabelPlacementLayers.contains( layer ) )
+  {
+    mLabelPlacementLayers.removeAll( layer );
+    const QString layerId = layer->id();
+    for ( int i = mLabelPlacements.count() - 1; i >= 0; --i )
+    {
+      if ( mLabelPlacements.at( i ).layerID == layerId )
+        mLabelPlacements.removeAt( i );
+    }
+  }
   dropUnusedConnections();
 }
 
+void QgsMapRendererCache::setLabelPlacements( const QList<QgsLabelPosition> &placements, const QList<QgsMapLayer *> &dependentLayers )
+{
+  QMutexLocker lock( &mMutex );
+
+  mLabelPlacements = placements;
+  mLabelPlacementLayers.clear();
+  Q_FOREACH ( QgsMapLayer *layer, dependentLayers )
+  {
+    if ( layer )
+    {
+      mLabelPlacementLayers << layer;
+      connectToLayer( layer );
+    }
+  }
+  dropUnusedConnections();
+}
+
+QList<QgsLabelPosition> QgsMapRendererCache::labelPlacements() const
+{
+  QMutexLocker lock( &mMutex );
+  return mLabelPlacements;
+}
+
 void QgsMapRendererCache::clearCacheImage( const QString &cacheKey )
 {
   QMutexLocker lock( &mMutex );
@@ -23,6 +23,7 @@
 
 #include "qgsrectangle.h"
 #include "qgsmaplayer.h"
+#include "qgspallabeling.h"
 
 
 /**
@@ -97,6 +98,27 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     void clearCacheImage( const QString &cacheKey );
 
+    /**
+     * Stores the label \a placements of the last render of the map.
+     *
+     * Unlike the cached images, the placements are kept when the extent changes, as
+     * long as the scale stays the same. This lets the next render keep the labels of
+     * the features which are still in view at the same position.
+     *
+     * The placements of the \a dependentLayers are dropped when the layer triggers a repaint.
+     *
+     * \see labelPlacements()
+     * \since QGIS 3.4
+     */
+    void setLabelPlacements( const QList< QgsLabelPosition > &placements, const QList< QgsMapLayer * > &dependentLayers );
+
+    /**
+     * Returns the label placements of the last render at the current scale.
+     * \see setLabelPlacements()
+     * \since QGIS 3.4
+     */
+    QList< QgsLabelPosition > labelPlacements() const;
+
   private slots:
     //! Remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
@@ -115,6 +137,9 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! Disconnects from layers we no longer care about
     void dropUnusedConnections();
 
+    //! Listens to the repaint requests of \a layer
+    void connectToLayer( QgsMapLayer *layer );
+
     QSet< QgsWeakMapLayerPointer > dependentLayers() const;
 
     mutable QMutex mMutex;
@@ -123,6 +148,10 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
 
     //! Map of cache key to cache parameters
     QMap<QString, CacheParameters> mCachedImages;
+    //! Label placements, kept while the scale does not change
+    QList< QgsLabelPosition > mLabelPlacements;
+    //! Layers of the label placements
+    QgsWeakMapLayerPointerList mLabelPlacementLayers;
     //! List of all layers on which this cache is currently connected
     QSet< QgsWeakMapLayerPointer > mConnectedLayers;
 };
@@ -303,6 +303,7 @@ void QgsMapRendererCustomPainterJob::doRender()
       mLabelJob.complete = true;
       mLabelJob.renderingTime = labelTime.elapsed();
       mLabelJob.participatingLayers = _qgis_listRawToQPointer( mLabelingEngineV2->participatingLayers() );
+      mLabelJob.placements = mLabelingEngineV2->placements();
     }
   }
   if ( mLabelJob.img && mLabelJob.complete )
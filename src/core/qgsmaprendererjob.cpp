@@ -370,6 +370,10 @@ LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabe
   }
   else
   {
+    // labels of the features still in view keep their position after a pan
+    if ( mCache && labelingEngine2 )
+      labelingEngine2->setPreviousPlacements( mCache->labelPlacements() );
+
     if ( canUseLabelCache && ( mCache || !painter ) )
     {
       // Flattened image for drawing labels
@@ -437,6 +441,7 @@ void QgsMapRendererJob::cleanupLabelJob( LabelRenderJob &job )
     {
       QgsDebugMsg( "caching label result image" );
       mCache->setCacheImage( LABEL_CACHE_ID, *job.img, _qgis_listQPointerToRaw( job.participatingLayers ) );
+      mCache->setLabelPlacements( job.placements, _qgis_listQPointerToRaw( job.participatingLayers ) );
     }
 
     delete job.img;
@@ -28,6 +28,7 @@
 #include "qgsrendercontext.h"
 
 #include "qgsmapsettings.h"
+#include "qgspallabeling.h"
 
 
 class QgsLabelingEngine;
@@ -82,6 +83,8 @@ struct LabelRenderJob
   int renderingTime = -1;
   //! List of layers which participated in the labeling solution
   QList< QPointer< QgsMapLayer > > participatingLayers;
+  //! Placements of the rendered labels, kept in the cache for the next render at the same scale
+  QList< QgsLabelPosition > placements;
 };
 
 ///@endcond PRIVATE
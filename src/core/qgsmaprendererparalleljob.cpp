@@ -61,6 +61,10 @@ void QgsMapRendererParallelJob::start()
   mLayerJobs = prepareJobs( nullptr, mLabelingEngineV2.get() );
   mLabelJob = prepareLabelingJob( nullptr, mLabelingEngineV2.get(), canUseLabelCache );
 
+  // register the labels while the layers are rendered, unless they come from the cache
+  if ( mLabelingEngineV2 && !mLabelJob.cached )
+    mLabelingEngineV2->startStreaming();
+
   QgsDebugMsg( QString( "QThreadPool max thread count is %1" ).arg( QThreadPool::globalInstance()->maxThreadCount() ) );
 
   // start async job
@@ -319,6 +323,7 @@ void QgsMapRendererParallelJob::renderLabelsStatic( QgsMapRendererParallelJob *s
     job.renderingTime = labelTime.elapsed();
     job.complete = true;
     job.participatingLayers = _qgis_listRawToQPointer( self->mLabelingEngineV2->participatingLayers() );
+    job.placements = self->mLabelingEngineV2->placements();
     if ( job.img )
     {
       self->mFinalImage = composeImage( self->mSettings, self->mLayerJobs, self->mLabelJob );
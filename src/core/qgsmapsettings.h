@@ -216,6 +216,8 @@ class CORE_EXPORT QgsMapSettings
       RenderMapTile            = 0x100, //!< Draw map such that there are no problems between adjacent tiles
       RenderPartialOutput      = 0x200, //!< Whether to make extra effort to update map image with partially rendered layers (better for interactive map canvas). Added in QGIS 3.0
       RenderPreviewJob         = 0x400, //!< Render is a 'canvas preview' render, and shortcuts should be taken to ensure fast rendering
+      ParallelFeatureRendering = 0x800, //!< Allow rendering the features of large vector layers in parallel, split over several threads. Added in QGIS 3.4
+      ParallelRasterRendering  = 0x1000, //!< Allow rendering large raster layers in parallel, split over several threads. Added in QGIS 3.4
       // TODO: ignore scale-based visibility (overview)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -26,6 +26,8 @@
 #include "qgslinestring.h"
 #include "qgspolygon.h"
 #include "qgsgeometrycollection.h"
+#include "qgsgeometryfactory.h"
+#include "qgswkbview_p.h"
 
 QgsMapToPixelSimplifier::QgsMapToPixelSimplifier( int simplifyFlags, double tolerance, SimplifyAlgorithm simplifyAlgorithm )
   : mSimplifyFlags( simplifyFlags )
@@ -68,9 +70,11 @@ bool QgsMapToPixelSimplifier::equalSnapToGrid( double x1, double y1, double x2,
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 //! Generalize the WKB-geometry using the BBOX of the original geometry
+template< typename CloneFunction >
 static std::unique_ptr< QgsAbstractGeometry > generalizeWkbGeometryByBoundingBox(
   QgsWkbTypes::Type wkbType,
-  const QgsAbstractGeometry &geometry,
+  int nCoordinates,
+  const CloneFunction &cloneGeometry,
   const QgsRectangle &envelope,
   bool isRing )
 {
@@ -79,9 +83,9 @@ static std::unique_ptr< QgsAbstractGeometry > generalizeWkbGeometryByBoundingBox
   // If the geometry is already minimal skip the generalization
   int minimumSize = geometryType == QgsWkbTypes::LineString ? 2 : 5;
 
-  if ( geometry.nCoordinates() <= minimumSize )
+  if ( nCoordinates <= minimumSize )
   {
-    return std::unique_ptr< QgsAbstractGeometry >( geometry.clone() );
+    return cloneGeometry();
   }
 
   const double x1 = envelope.xMinimum();
@@ -118,226 +122,270 @@ static std::unique_ptr< QgsAbstractGeometry > generalizeWkbGeometryByBoundingBox
   }
 }
 
-std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyGeometry( int simplifyFlags,
-    SimplifyAlgorithm simplifyAlgorithm,
-    const QgsAbstractGeometry &geometry, double map2pixelTol,
-    bool isaLinearRing )
+static std::unique_ptr< QgsAbstractGeometry > generalizeWkbGeometryByBoundingBox( QgsWkbTypes::Type wkbType, const QgsAbstractGeometry &geometry, const QgsRectangle &envelope, bool isRing )
 {
-  bool isGeneralizable = true;
-  QgsWkbTypes::Type wkbType = geometry.wkbType();
+  return generalizeWkbGeometryByBoundingBox( wkbType, geometry.nCoordinates(), [&geometry]
+  {
+    return std::unique_ptr< QgsAbstractGeometry >( geometry.clone() );
+  }, envelope, isRing );
+}
 
-  // Can replace the geometry by its BBOX ?
-  QgsRectangle envelope = geometry.boundingBox();
-  if ( ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
-       isGeneralizableByMapBoundingBox( envelope, map2pixelTol ) )
+namespace
+{
+
+  //! Points of a curve, read through the generic QgsCurve interface
+  class CurvePoints
   {
-    return generalizeWkbGeometryByBoundingBox( wkbType, geometry, envelope, isaLinearRing );
-  }
+    public:
+      explicit CurvePoints( const QgsCurve &curve ) : mCurve( curve ) {}
+      int count() const { return mCurve.numPoints(); }
+      double x( int i ) const { return mCurve.xAt( i ); }
+      double y( int i ) const { return mCurve.yAt( i ); }
+      const QgsCurve *curve() const { return &mCurve; }
+      std::unique_ptr< QgsCurve > createEmptyOutput() const { return std::unique_ptr< QgsCurve >( qgsgeometry_cast< QgsCurve * >( mCurve.createEmptyWithSameType() ) ); }
+      std::unique_ptr< QgsAbstractGeometry > clone() const { return std::unique_ptr< QgsAbstractGeometry >( mCurve.clone() ); }
+
+    private:
+      const QgsCurve &mCurve;
+  };
+
+  //! Points of a line string, read straight from its coordinate arrays
+  class LineStringPoints
+  {
+    public:
+      explicit LineStringPoints( const QgsLineString &line ) : mLine( line ), mX( line.xData() ), mY( line.yData() ) {}
+      int count() const { return mLine.numPoints(); }
+      double x( int i ) const { return mX[i]; }
+      double y( int i ) const { return mY[i]; }
+      const QgsCurve *curve() const { return &mLine; }
+      std::unique_ptr< QgsCurve > createEmptyOutput() const { return nullptr; }
+      std::unique_ptr< QgsAbstractGeometry > clone() const { return std::unique_ptr< QgsAbstractGeometry >( mLine.clone() ); }
+
+    private:
+      const QgsLineString &mLine;
+      const double *mX = nullptr;
+      const double *mY = nullptr;
+  };
+
+  //! Points of a line string or polygon ring, read straight from the WKB
+  class WkbPoints
+  {
+    public:
+      explicit WkbPoints( const QgsWkbView::CoordinateSequence &sequence ) : mSequence( sequence ) {}
+      int count() const { return mSequence.count(); }
+      double x( int i ) const { return mSequence.x( i ); }
+      double y( int i ) const { return mSequence.y( i ); }
+      const QgsCurve *curve() const { return nullptr; }
+      std::unique_ptr< QgsCurve > createEmptyOutput() const { return nullptr; }
+      std::unique_ptr< QgsAbstractGeometry > clone() const { return mSequence.toLineString(); }
+
+    private:
+      const QgsWkbView::CoordinateSequence &mSequence;
+  };
 
-  if ( !( simplifyFlags & QgsMapToPixelSimplifier::SimplifyGeometry ) )
-    isGeneralizable = false;
+}
 
-  const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( wkbType );
+template< typename Points >
+std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyPoints( int simplifyFlags,
+    SimplifyAlgorithm simplifyAlgorithm, QgsWkbTypes::Type wkbType,
+    const Points &points, const QgsRectangle &envelope, double map2pixelTol,
+    bool isaLinearRing )
+{
+  bool isGeneralizable = ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyGeometry );
 
-  // Write the geometry
-  if ( flatType == QgsWkbTypes::LineString || flatType == QgsWkbTypes::CircularString )
-  {
-    const QgsCurve &srcCurve = dynamic_cast<const QgsCurve &>( geometry );
-    const int numPoints = srcCurve.numPoints();
+  const int numPoints = points.count();
 
-    std::unique_ptr<QgsCurve> output;
+  // output is only used for curves which are not line strings, line strings are built
+  // in an optimised way by directly constructing the final x/y vectors, which avoids
+  // calling the slower insertVertex method
+  std::unique_ptr<QgsCurve> output = points.createEmptyOutput();
 
-    QVector< double > lineStringX;
-    QVector< double > lineStringY;
-    if ( flatType == QgsWkbTypes::LineString )
-    {
-      // if we are making a linestring, we do it in an optimised way by directly constructing
-      // the final x/y vectors, which avoids calling the slower insertVertex method
-      lineStringX.reserve( numPoints );
-      lineStringY.reserve( numPoints );
-    }
-    else
-    {
-      output.reset( qgsgeometry_cast< QgsCurve * >( srcCurve.createEmptyWithSameType() ) );
-    }
+  QVector< double > lineStringX;
+  QVector< double > lineStringY;
+  if ( !output )
+  {
+    lineStringX.reserve( numPoints );
+    lineStringY.reserve( numPoints );
+  }
 
-    double x = 0.0, y = 0.0, lastX = 0.0, lastY = 0.0;
-    QgsRectangle r;
-    r.setMinimal();
+  double x = 0.0, y = 0.0, lastX = 0.0, lastY = 0.0;
+  QgsRectangle r;
+  r.setMinimal();
 
-    if ( numPoints <= ( isaLinearRing ? 4 : 2 ) )
-      isGeneralizable = false;
+  if ( numPoints <= ( isaLinearRing ? 4 : 2 ) )
+    isGeneralizable = false;
 
-    bool isLongSegment;
-    bool hasLongSegments = false; //-> To avoid replace the simplified geometry by its BBOX when there are 'long' segments.
+  bool isLongSegment;
+  bool hasLongSegments = false; //-> To avoid replace the simplified geometry by its BBOX when there are 'long' segments.
 
-    // Check whether the LinearRing is really closed.
-    if ( isaLinearRing )
-    {
-      isaLinearRing = qgsDoubleNear( srcCurve.xAt( 0 ), srcCurve.xAt( numPoints - 1 ) ) &&
-                      qgsDoubleNear( srcCurve.yAt( 0 ), srcCurve.yAt( numPoints - 1 ) );
-    }
+  // Check whether the LinearRing is really closed.
+  if ( isaLinearRing )
+  {
+    isaLinearRing = numPoints > 0 &&
+                    qgsDoubleNear( points.x( 0 ), points.x( numPoints - 1 ) ) &&
+                    qgsDoubleNear( points.y( 0 ), points.y( numPoints - 1 ) );
+  }
 
-    // Process each vertex...
-    switch ( simplifyAlgorithm )
+  // Process each vertex...
+  switch ( simplifyAlgorithm )
+  {
+    case SnapToGrid:
     {
-      case SnapToGrid:
-      {
-        double gridOriginX = envelope.xMinimum();
-        double gridOriginY = envelope.yMinimum();
+      double gridOriginX = envelope.xMinimum();
+      double gridOriginY = envelope.yMinimum();
 
-        // Use a factor for the maximum displacement distance for simplification, similar as GeoServer does
-        float gridInverseSizeXY = map2pixelTol != 0 ? ( float )( 1.0f / ( 0.8 * map2pixelTol ) ) : 0.0f;
+      // Use a factor for the maximum displacement distance for simplification, similar as GeoServer does
+      float gridInverseSizeXY = map2pixelTol != 0 ? ( float )( 1.0f / ( 0.8 * map2pixelTol ) ) : 0.0f;
 
-        const double *xData = nullptr;
-        const double *yData = nullptr;
-        if ( flatType == QgsWkbTypes::LineString )
-        {
-          xData = qgsgeometry_cast< const QgsLineString * >( &srcCurve )->xData();
-          yData = qgsgeometry_cast< const QgsLineString * >( &srcCurve )->yData();
-        }
+      for ( int i = 0; i < numPoints; ++i )
+      {
+        x = points.x( i );
+        y = points.y( i );
 
-        for ( int i = 0; i < numPoints; ++i )
+        if ( i == 0 ||
+             !isGeneralizable ||
+             !equalSnapToGrid( x, y, lastX, lastY, gridOriginX, gridOriginY, gridInverseSizeXY ) ||
+             ( !isaLinearRing && ( i == 1 || i >= numPoints - 2 ) ) )
         {
-          if ( xData && yData )
-          {
-            x = *xData++;
-            y = *yData++;
-          }
+          if ( output )
+            output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( x, y ) );
           else
           {
-            x = srcCurve.xAt( i );
-            y = srcCurve.yAt( i );
+            lineStringX.append( x );
+            lineStringY.append( y );
           }
-
-          if ( i == 0 ||
-               !isGeneralizable ||
-               !equalSnapToGrid( x, y, lastX, lastY, gridOriginX, gridOriginY, gridInverseSizeXY ) ||
-               ( !isaLinearRing && ( i == 1 || i >= numPoints - 2 ) ) )
-          {
-            if ( output )
-              output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( x, y ) );
-            else
-            {
-              lineStringX.append( x );
-              lineStringY.append( y );
-            }
-            lastX = x;
-            lastY = y;
-          }
-
-          r.combineExtentWith( x, y );
+          lastX = x;
+          lastY = y;
         }
-        break;
+
+        r.combineExtentWith( x, y );
       }
+      break;
+    }
 
-      case Visvalingam:
-      {
-        map2pixelTol *= map2pixelTol; //-> Use mappixelTol for 'Area' calculations.
+    case Visvalingam:
+    {
+      // WKB geometries are parsed before being simplified with this algorithm
+      Q_ASSERT( points.curve() );
 
-        EFFECTIVE_AREAS ea( srcCurve );
+      map2pixelTol *= map2pixelTol; //-> Use mappixelTol for 'Area' calculations.
 
-        int set_area = 0;
-        ptarray_calc_areas( &ea, isaLinearRing ? 4 : 2, set_area, map2pixelTol );
+      EFFECTIVE_AREAS ea( *points.curve() );
 
-        for ( int i = 0; i < numPoints; ++i )
+      int set_area = 0;
+      ptarray_calc_areas( &ea, isaLinearRing ? 4 : 2, set_area, map2pixelTol );
+
+      for ( int i = 0; i < numPoints; ++i )
+      {
+        if ( ea.res_arealist[ i ] > map2pixelTol )
         {
-          if ( ea.res_arealist[ i ] > map2pixelTol )
+          if ( output )
+            output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), ea.inpts.at( i ) );
+          else
           {
-            if ( output )
-              output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), ea.inpts.at( i ) );
-            else
-            {
-              lineStringX.append( ea.inpts.at( i ).x() );
-              lineStringY.append( ea.inpts.at( i ).y() );
-            }
+            lineStringX.append( ea.inpts.at( i ).x() );
+            lineStringY.append( ea.inpts.at( i ).y() );
           }
         }
-        break;
       }
+      break;
+    }
 
-      case Distance:
+    case Distance:
+    {
+      map2pixelTol *= map2pixelTol; //-> Use mappixelTol for 'LengthSquare' calculations.
+
+      for ( int i = 0; i < numPoints; ++i )
       {
-        map2pixelTol *= map2pixelTol; //-> Use mappixelTol for 'LengthSquare' calculations.
+        x = points.x( i );
+        y = points.y( i );
 
-        const double *xData = nullptr;
-        const double *yData = nullptr;
-        if ( flatType == QgsWkbTypes::LineString )
-        {
-          xData = qgsgeometry_cast< const QgsLineString * >( &srcCurve )->xData();
-          yData = qgsgeometry_cast< const QgsLineString * >( &srcCurve )->yData();
-        }
+        isLongSegment = false;
 
-        for ( int i = 0; i < numPoints; ++i )
+        if ( i == 0 ||
+             !isGeneralizable ||
+             ( isLongSegment = ( calculateLengthSquared2D( x, y, lastX, lastY ) > map2pixelTol ) ) ||
+             ( !isaLinearRing && ( i == 1 || i >= numPoints - 2 ) ) )
         {
-          if ( xData && yData )
-          {
-            x = *xData++;
-            y = *yData++;
-          }
+          if ( output )
+            output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( x, y ) );
           else
           {
-            x = srcCurve.xAt( i );
-            y = srcCurve.yAt( i );
-          }
-
-          isLongSegment = false;
-
-          if ( i == 0 ||
-               !isGeneralizable ||
-               ( isLongSegment = ( calculateLengthSquared2D( x, y, lastX, lastY ) > map2pixelTol ) ) ||
-               ( !isaLinearRing && ( i == 1 || i >= numPoints - 2 ) ) )
-          {
-            if ( output )
-              output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( x, y ) );
-            else
-            {
-              lineStringX.append( x );
-              lineStringY.append( y );
-            }
-            lastX = x;
-            lastY = y;
-
-            hasLongSegments |= isLongSegment;
+            lineStringX.append( x );
+            lineStringY.append( y );
           }
+          lastX = x;
+          lastY = y;
 
-          r.combineExtentWith( x, y );
+          hasLongSegments |= isLongSegment;
         }
+
+        r.combineExtentWith( x, y );
       }
     }
+  }
 
-    if ( !output )
+  if ( !output )
+  {
+    output = qgis::make_unique< QgsLineString >( lineStringX, lineStringY );
+  }
+  if ( output->numPoints() < ( isaLinearRing ? 4 : 2 ) )
+  {
+    // we simplified the geometry too much!
+    if ( !hasLongSegments )
     {
-      output = qgis::make_unique< QgsLineString >( lineStringX, lineStringY );
+      // approximate the geometry's shape by its bounding box
+      // (rect for linear ring / one segment for line string)
+      return generalizeWkbGeometryByBoundingBox( wkbType, numPoints, [&points] { return points.clone(); }, r, isaLinearRing );
     }
-    if ( output->numPoints() < ( isaLinearRing ? 4 : 2 ) )
+    else
     {
-      // we simplified the geometry too much!
-      if ( !hasLongSegments )
-      {
-        // approximate the geometry's shape by its bounding box
-        // (rect for linear ring / one segment for line string)
-        return generalizeWkbGeometryByBoundingBox( wkbType, geometry, r, isaLinearRing );
-      }
-      else
-      {
-        // Bad luck! The simplified geometry is invalid and approximation by bounding box
-        // would create artifacts due to long segments.
-        // We will return the original geometry
-        return std::unique_ptr< QgsAbstractGeometry >( geometry.clone() );
-      }
+      // Bad luck! The simplified geometry is invalid and approximation by bounding box
+      // would create artifacts due to long segments.
+      // We will return the original geometry
+      return points.clone();
     }
+  }
 
-    if ( isaLinearRing )
+  if ( isaLinearRing )
+  {
+    // make sure we keep the linear ring closed
+    if ( !qgsDoubleNear( lastX, output->xAt( 0 ) ) || !qgsDoubleNear( lastY, output->yAt( 0 ) ) )
     {
-      // make sure we keep the linear ring closed
-      if ( !qgsDoubleNear( lastX, output->xAt( 0 ) ) || !qgsDoubleNear( lastY, output->yAt( 0 ) ) )
-      {
-        output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( output->xAt( 0 ), output->yAt( 0 ) ) );
-      }
+      output->insertVertex( QgsVertexId( 0, 0, output->numPoints() ), QgsPoint( output->xAt( 0 ), output->yAt( 0 ) ) );
     }
+  }
+
+  return std::move( output );
+}
+
+std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyGeometry( int simplifyFlags,
+    SimplifyAlgorithm simplifyAlgorithm,
+    const QgsAbstractGeometry &geometry, double map2pixelTol,
+    bool isaLinearRing )
+{
+  QgsWkbTypes::Type wkbType = geometry.wkbType();
 
-    return std::move( output );
+  // Can replace the geometry by its BBOX ?
+  QgsRectangle envelope = geometry.boundingBox();
+  if ( ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
+       isGeneralizableByMapBoundingBox( envelope, map2pixelTol ) )
+  {
+    return generalizeWkbGeometryByBoundingBox( wkbType, geometry, envelope, isaLinearRing );
+  }
+
+  const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( wkbType );
+
+  // Write the geometry
+  if ( flatType == QgsWkbTypes::LineString )
+  {
+    const QgsLineString &srcLine = dynamic_cast<const QgsLineString &>( geometry );
+    return simplifyPoints( simplifyFlags, simplifyAlgorithm, wkbType, LineStringPoints( srcLine ), envelope, map2pixelTol, isaLinearRing );
+  }
+  else if ( flatType == QgsWkbTypes::CircularString )
+  {
+    const QgsCurve &srcCurve = dynamic_cast<const QgsCurve &>( geometry );
+    return simplifyPoints( simplifyFlags, simplifyAlgorithm, wkbType, CurvePoints( srcCurve ), envelope, map2pixelTol, isaLinearRing );
   }
   else if ( flatType == QgsWkbTypes::Polygon )
   {
@@ -369,6 +417,74 @@ std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyGeometry
   return std::unique_ptr< QgsAbstractGeometry >( geometry.clone() );
 }
 
+std::unique_ptr< QgsAbstractGeometry > QgsMapToPixelSimplifier::simplifyWkb( int simplifyFlags,
+    SimplifyAlgorithm simplifyAlgorithm,
+    const QgsWkbView &geometry, double map2pixelTol )
+{
+  QgsWkbTypes::Type wkbType = geometry.wkbType();
+
+  // Can replace the geometry by its BBOX ?
+  QgsRectangle envelope = geometry.boundingBox();
+  if ( ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
+       isGeneralizableByMapBoundingBox( envelope, map2pixelTol ) )
+  {
+    return generalizeWkbGeometryByBoundingBox( wkbType, geometry.nCoordinates(), [&geometry] { return geometry.materialize(); }, envelope, false );
+  }
+
+  const QgsWkbTypes::Type flatType = QgsWkbTypes::flatType( wkbType );
+
+  if ( flatType == QgsWkbTypes::LineString )
+  {
+    const QVector< QgsWkbView::CoordinateSequence > sequences = geometry.sequences();
+    return simplifyPoints( simplifyFlags, simplifyAlgorithm, wkbType, WkbPoints( sequences.at( 0 ) ), envelope, map2pixelTol, false );
+  }
+  else if ( flatType == QgsWkbTypes::Polygon )
+  {
+    const QVector< QgsWkbView::CoordinateSequence > rings = geometry.sequences();
+    std::unique_ptr<QgsPolygon> polygon( new QgsPolygon() );
+    for ( int i = 0; i < rings.count(); ++i )
+    {
+      const WkbPoints points( rings.at( i ) );
+      const QgsWkbTypes::Type ringType = rings.at( i ).wkbType();
+
+      // Can replace the ring by its BBOX ?
+      const QgsRectangle ringEnvelope = rings.at( i ).boundingBox();
+      std::unique_ptr< QgsAbstractGeometry > ring;
+      if ( ( simplifyFlags & QgsMapToPixelSimplifier::SimplifyEnvelope ) &&
+           isGeneralizableByMapBoundingBox( ringEnvelope, map2pixelTol ) )
+      {
+        ring = generalizeWkbGeometryByBoundingBox( ringType, points.count(), [&points] { return points.clone(); }, ringEnvelope, true );
+      }
+      else
+      {
+        ring = simplifyPoints( simplifyFlags, simplifyAlgorithm, ringType, points, ringEnvelope, map2pixelTol, true );
+      }
+
+      if ( i == 0 )
+        polygon->setExteriorRing( qgsgeometry_cast<QgsCurve *>( ring.release() ) );
+      else
+        polygon->addInteriorRing( qgsgeometry_cast<QgsCurve *>( ring.release() ) );
+    }
+    return std::move( polygon );
+  }
+  else if ( QgsWkbTypes::isMultiType( flatType ) && flatType != QgsWkbTypes::GeometryCollection )
+  {
+    // the type of multi geometries is set from their first part, like the parsed geometry would do
+    std::unique_ptr< QgsGeometryCollection > collection = QgsGeometryFactory::createCollectionOfType( wkbType );
+    const QVector< QgsWkbView > parts = geometry.parts();
+    for ( const QgsWkbView &part : parts )
+    {
+      std::unique_ptr< QgsAbstractGeometry > simplifiedPart = simplifyWkb( simplifyFlags, simplifyAlgorithm, part, map2pixelTol );
+      collection->addGeometry( simplifiedPart.release() );
+    }
+    return std::move( collection );
+  }
+
+  // points and generic geometry collections are handled by the regular code path
+  std::unique_ptr< QgsAbstractGeometry > parsed = geometry.materialize();
+  return simplifyGeometry( simplifyFlags, simplifyAlgorithm, *parsed, map2pixelTol, false );
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 bool QgsMapToPixelSimplifier::isGeneralizableByMapBoundingBox( const QgsRectangle &envelope, double map2pixelTol )
@@ -397,7 +513,8 @@ QgsGeometry QgsMapToPixelSimplifier::simplify( const QgsGeometry &geometry ) con
   }
 
   const bool isaLinearRing = flatType == QgsWkbTypes::Polygon;
-  const int numPoints = geometry.constGet()->nCoordinates();
+  const QgsWkbView *wkbView = geometry.wkbView();
+  const int numPoints = wkbView ? wkbView->nCoordinates() : geometry.constGet()->nCoordinates();
 
   if ( numPoints <= ( isaLinearRing ? 6 : 3 ) )
   {
@@ -412,5 +529,12 @@ QgsGeometry QgsMapToPixelSimplifier::simplify( const QgsGeometry &geometry ) con
     return geometry;
   }
 
+  // geometries which have not been parsed yet are simplified straight from their WKB,
+  // so that only the (much smaller) simplified geometry gets created
+  if ( wkbView && mSimplifyAlgorithm != Visvalingam )
+  {
+    return QgsGeometry( simplifyWkb( mSimplifyFlags, mSimplifyAlgorithm, *wkbView, mTolerance ) );
+  }
+
   return QgsGeometry( simplifyGeometry( mSimplifyFlags, mSimplifyAlgorithm, *geometry.constGet(), mTolerance, false ) );
 }
@@ -20,11 +20,13 @@
 #include "qgis_core.h"
 #include "qgis.h"
 #include "qgsgeometrysimplifier.h"
+#include "qgswkbtypes.h"
 #include <QPolygonF>
 
 class QgsAbstractGeometry;
 class QgsWkbPtr;
 class QgsConstWkbPtr;
+class QgsWkbView;
 
 
 /**
@@ -60,6 +62,13 @@ class CORE_EXPORT QgsMapToPixelSimplifier : public QgsAbstractGeometrySimplifier
     //! Simplify the geometry using the specified tolerance
     static std::unique_ptr<QgsAbstractGeometry> simplifyGeometry( int simplifyFlags, SimplifyAlgorithm simplifyAlgorithm, const QgsAbstractGeometry &geometry, double map2pixelTol, bool isaLinearRing );
 
+    //! Simplify a geometry straight from its WKB, without parsing it first
+    static std::unique_ptr<QgsAbstractGeometry> simplifyWkb( int simplifyFlags, SimplifyAlgorithm simplifyAlgorithm, const QgsWkbView &geometry, double map2pixelTol );
+
+    //! Simplify the points of a curve, as read through \a points
+    template< typename Points >
+    static std::unique_ptr<QgsAbstractGeometry> simplifyPoints( int simplifyFlags, SimplifyAlgorithm simplifyAlgorithm, QgsWkbTypes::Type wkbType, const Points &points, const QgsRectangle &envelope, double map2pixelTol, bool isaLinearRing );
+
   protected:
     //! Current simplification flags
     int mSimplifyFlags;
@@ -276,7 +276,17 @@ QgsGeometry QgsOgrUtils::ogrGeometryToQgsGeometry( OGRGeometryH geom )
 
   // get the wkb representation
   int memorySize = OGR_G_WkbSize( geom );
-  unsigned char *wkb = new unsigned char[memorySize];
+  QByteArray wkbArray( memorySize, Qt::Uninitialized );
+  ogrGeometryToWkb( geom, reinterpret_cast< unsigned char * >( wkbArray.data() ) );
+
+  // hand over the buffer without copying it, the geometry only parses it on demand
+  QgsGeometry g;
+  g.fromWkb( wkbArray );
+  return g;
+}
+
+void QgsOgrUtils::ogrGeometryToWkb( OGRGeometryH geom, unsigned char *wkb )
+{
   OGR_G_ExportToWkb( geom, ( OGRwkbByteOrder ) QgsApplication::endian(), wkb );
 
   // Read original geometry type
@@ -336,10 +346,6 @@ QgsGeometry QgsOgrUtils::ogrGeometryToQgsGeometry( OGRGeometryH geom )
     // Overwrite geom type
     memcpy( wkb + 1, &newType, sizeof( uint32_t ) );
   }
-
-  QgsGeometry g;
-  g.fromWkb( wkb, memorySize );
-  return g;
 }
 
 QgsFeatureList QgsOgrUtils::stringToFeatureList( const QString &string, const QgsFields &fields, QTextCodec *encoding )
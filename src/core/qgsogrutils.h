@@ -221,6 +221,15 @@ class CORE_EXPORT QgsOgrUtils
      */
     static QgsGeometry ogrGeometryToQgsGeometry( OGRGeometryH geom );
 
+    /**
+     * Writes the WKB representation of an OGR geometry to \a wkb, which must hold at
+     * least OGR_G_WkbSize() bytes. Geometry types which QGIS does not support are mapped
+     * to their closest supported type, like ogrGeometryToQgsGeometry() does.
+     * \see ogrGeometryToQgsGeometry()
+     * \since QGIS 3.4
+     */
+    static void ogrGeometryToWkb( OGRGeometryH geom, unsigned char *wkb );
+
     /**
      * Attempts to parse a string representing a collection of features using OGR. For example, this method can be
      * used to convert a GeoJSON encoded collection to a list of QgsFeatures.
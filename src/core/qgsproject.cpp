@@ -61,6 +61,8 @@
 #include <QTemporaryFile>
 #include <QDir>
 #include <QUrl>
+#include <QPointer>
+#include <QThreadStorage>
 
 
 #ifdef _MSC_VER
@@ -72,6 +74,9 @@
 // canonical project instance
 QgsProject *QgsProject::sProject = nullptr;
 
+// project instances of the threads which replace the canonical one, see setThreadInstance()
+static QThreadStorage< QPointer< QgsProject > > sThreadProjects;
+
 /**
     Take the given scope and key and convert them to a string list of key
     tokens that will be used to navigate through a Property hierarchy
@@ -389,9 +394,19 @@ void QgsProject::setInstance( QgsProject *project )
   sProject = project;
 }
 
+void QgsProject::setThreadInstance( QgsProject *project )
+{
+  sThreadProjects.setLocalData( QPointer< QgsProject >( project ) );
+}
 
 QgsProject *QgsProject::instance()
 {
+  if ( sThreadProjects.hasLocalData() )
+  {
+    if ( QgsProject *project = sThreadProjects.localData() )
+      return project;
+  }
+
   if ( !sProject )
   {
     sProject = new QgsProject;
@@ -1341,6 +1341,18 @@ class CORE_EXPORT QgsProject : public QObject, public QgsExpressionContextGenera
      */
     static void setInstance( QgsProject *project ) SIP_SKIP;
 
+    /**
+     * Set the project instance of the current thread to \a project, which replaces
+     * the instance set by setInstance() in that thread. A null \a project restores it.
+     *
+     * \note this is used by the server, which handles requests for different projects
+     * concurrently in worker threads
+     * \see instance()
+     * \note not available in Python bindings
+     * \since QGIS 3.4
+     */
+    static void setThreadInstance( QgsProject *project ) SIP_SKIP;
+
     /**
      * Read map layers from project file.
      * \param doc DOM document to parse
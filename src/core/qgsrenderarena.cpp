@@ -0,0 +1,77 @@
+/***************************************************************************
+                         qgsrenderarena.cpp
+                         ------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsrenderarena_p.h"
+#include "qgsruntimeprofiler.h"
+
+#include <algorithm>
+
+///@cond PRIVATE
+
+QPolygonF &QgsRenderArena::polygon( int sizeHint )
+{
+  mStatistics.acquisitions++;
+
+  if ( mUsed == mPolygons.size() )
+  {
+    mPolygons.emplace_back();
+    if ( sizeHint <= 0 )
+      mStatistics.allocations++;
+  }
+
+  QPolygonF &polygon = mPolygons[ mUsed++ ];
+  mStatistics.peakBuffers = std::max( mStatistics.peakBuffers, static_cast< int >( mUsed ) );
+
+  // resize() keeps the capacity, unless the buffer is still shared with a copy made
+  // before the last reset, in which case it detaches from it
+  polygon.resize( 0 );
+  if ( polygon.capacity() < sizeHint )
+  {
+    polygon.reserve( sizeHint );
+    mStatistics.allocations++;
+  }
+  return polygon;
+}
+
+void QgsRenderArena::reset()
+{
+  mUsed = 0;
+  mStatistics.resets++;
+}
+
+QgsRenderArena::Statistics QgsRenderArena::statistics() const
+{
+  Statistics statistics = mStatistics;
+  statistics.reservedBytes = 0;
+  for ( const QPolygonF &polygon : mPolygons )
+    statistics.reservedBytes += static_cast< qint64 >( polygon.capacity() ) * sizeof( QPointF );
+  return statistics;
+}
+
+void QgsRenderArena::reportStatistics( QgsRuntimeProfiler *profiler, const QString &prefix ) const
+{
+  if ( !profiler )
+    return;
+
+  const Statistics s = statistics();
+  profiler->addCounterValue( prefix + QStringLiteral( "acquisitions" ), s.acquisitions );
+  profiler->addCounterValue( prefix + QStringLiteral( "allocations" ), s.allocations );
+  profiler->addCounterValue( prefix + QStringLiteral( "resets" ), s.resets );
+  profiler->addCounterValue( prefix + QStringLiteral( "peak buffers" ), s.peakBuffers );
+  profiler->addCounterValue( prefix + QStringLiteral( "reserved bytes" ), s.reservedBytes );
+}
+
+///@endcond
@@ -0,0 +1,118 @@
+/***************************************************************************
+                         qgsrenderarena_p.h
+                         ------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSRENDERARENA_P_H
+#define QGSRENDERARENA_P_H
+
+#define SIP_NO_FILE
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include "qgis_core.h"
+
+#include <QPolygonF>
+#include <QString>
+#include <deque>
+
+class QgsRuntimeProfiler;
+
+/**
+ * \ingroup core
+ * A monotonic arena for the temporary buffers created while rendering features.
+ *
+ * A renderer owns one arena per layer job and attaches it to the render context.
+ * Buffers are handed out one after the other and stay valid until reset() is called,
+ * which recycles all of them at once: their memory is kept, so that once the arena
+ * has warmed up, rendering a feature does not allocate any coordinate buffer.
+ *
+ * Buffers are implicitly shared Qt containers. Anything which still holds a copy of a
+ * buffer after reset() keeps its data, the arena simply allocates a new one in that case.
+ *
+ * The arena is not thread safe, it must only be used by the thread rendering the job.
+ *
+ * \since QGIS 3.4
+ */
+class CORE_EXPORT QgsRenderArena
+{
+  public:
+
+    //! Allocation statistics of an arena
+    struct Statistics
+    {
+      //! Number of buffers handed out
+      qint64 acquisitions = 0;
+
+      //! Number of buffers which had to be allocated or grown when they were handed out
+      qint64 allocations = 0;
+
+      //! Number of times the arena was reset
+      qint64 resets = 0;
+
+      //! Highest number of buffers in use between two resets
+      int peakBuffers = 0;
+
+      //! Memory held by the arena, in bytes
+      qint64 reservedBytes = 0;
+    };
+
+    QgsRenderArena() = default;
+
+    //! QgsRenderArena cannot be copied
+    QgsRenderArena( const QgsRenderArena &other ) = delete;
+    //! QgsRenderArena cannot be copied
+    QgsRenderArena &operator=( const QgsRenderArena &other ) = delete;
+
+    /**
+     * Returns an empty polygon buffer, which can hold at least \a sizeHint points without
+     * allocating. The buffer remains valid until the next reset().
+     */
+    QPolygonF &polygon( int sizeHint = 0 );
+
+    /**
+     * Makes all buffers available again. References returned by polygon() must not
+     * be used after calling this method.
+     */
+    void reset();
+
+    //! Returns the allocation statistics of the arena
+    Statistics statistics() const;
+
+    /**
+     * Adds the statistics of the arena to the counters of \a profiler, using
+     * \a prefix as the start of the counter names.
+     */
+    void reportStatistics( QgsRuntimeProfiler *profiler, const QString &prefix ) const;
+
+  private:
+
+    // a deque, so that growing the arena does not move the buffers already handed out
+    std::deque< QPolygonF > mPolygons;
+    std::size_t mUsed = 0;
+    Statistics mStatistics;
+};
+
+/// @endcond
+
+#endif // QGSRENDERARENA_P_H
@@ -38,6 +38,7 @@
 class QPainter;
 class QgsAbstractGeometry;
 class QgsLabelingEngine;
+class QgsRenderArena;
 class QgsMapSettings;
 
 
@@ -72,6 +73,8 @@ class CORE_EXPORT QgsRenderContext
       Antialiasing             = 0x80,  //!< Use antialiasing while drawing
       RenderPartialOutput      = 0x100, //!< Whether to make extra effort to update map image with partially rendered layers (better for interactive map canvas). Added in QGIS 3.0
       RenderPreviewJob         = 0x200, //!< Render is a 'canvas preview' render, and shortcuts should be taken to ensure fast rendering
+      ParallelFeatureRendering = 0x400, //!< Allow rendering the features of large vector layers in parallel, split over several threads. Added in QGIS 3.4
+      ParallelRasterRendering  = 0x800, //!< Allow rendering large raster layers in parallel, split over several threads. Added in QGIS 3.4
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -339,6 +342,24 @@ class CORE_EXPORT QgsRenderContext
      */
     const QgsFeatureFilterProvider *featureFilterProvider() const;
 
+    /**
+     * Sets the \a arena used for the temporary buffers created while rendering features.
+     * The arena is owned by the caller and is not copied along with the context.
+     * \see renderArena()
+     * \note not available in Python bindings
+     * \since QGIS 3.4
+     */
+    void setRenderArena( QgsRenderArena *arena ) { mRenderArena = arena; } SIP_SKIP
+
+    /**
+     * Returns the arena used for the temporary buffers created while rendering features,
+     * or nullptr if none is set.
+     * \see setRenderArena()
+     * \note not available in Python bindings
+     * \since QGIS 3.4
+     */
+    QgsRenderArena *renderArena() const { return mRenderArena; } SIP_SKIP
+
     /**
      * Sets the segmentation tolerance applied when rendering curved geometries
     \param tolerance the segmentation tolerance*/
@@ -442,6 +463,9 @@ class CORE_EXPORT QgsRenderContext
 
     QgsPathResolver mPathResolver;
 
+    //! Arena for temporary rendering buffers, owned by the layer renderer and never copied
+    QgsRenderArena *mRenderArena = nullptr;
+
 #ifdef QGISDEBUG
     bool mHasTransformContext = false;
 #endif
@@ -54,9 +54,29 @@ void QgsRuntimeProfiler::end()
   QgsDebugMsg( QStringLiteral( "PROFILE: %1 - %2" ).arg( name ).arg( timing ) );
 }
 
+void QgsRuntimeProfiler::addCounterValue( const QString &name, double value )
+{
+  QMutexLocker locker( &mCounterMutex );
+  mCounters[ name ] += value;
+}
+
+double QgsRuntimeProfiler::counterValue( const QString &name ) const
+{
+  QMutexLocker locker( &mCounterMutex );
+  return mCounters.value( name, 0 );
+}
+
+QMap<QString, double> QgsRuntimeProfiler::counters() const
+{
+  QMutexLocker locker( &mCounterMutex );
+  return mCounters;
+}
+
 void QgsRuntimeProfiler::clear()
 {
   mProfileTimes.clear();
+  QMutexLocker locker( &mCounterMutex );
+  mCounters.clear();
 }
 
 double QgsRuntimeProfiler::totalTime()
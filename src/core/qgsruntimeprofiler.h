@@ -19,6 +19,8 @@
 #include "qgis_sip.h"
 #include <QPair>
 #include <QStack>
+#include <QMap>
+#include <QMutex>
 
 #include "qgis_core.h"
 
@@ -66,6 +68,35 @@ class CORE_EXPORT QgsRuntimeProfiler
      */
     const QList<QPair<QString, double > > profileTimes() const { return mProfileTimes; } SIP_SKIP
 
+    /**
+     * Adds \a value to the counter with the given \a name. Counters collect statistics
+     * which are not timings, e.g. the number of allocations made while rendering.
+     *
+     * Unlike the profile events, counters ignore the active group and can be updated
+     * from any thread.
+     *
+     * \see counterValue()
+     * \since QGIS 3.4
+     */
+    void addCounterValue( const QString &name, double value );
+
+    /**
+     * Returns the current value of the counter with the given \a name, or 0 if
+     * no value was added to this counter.
+     *
+     * \see addCounterValue()
+     * \since QGIS 3.4
+     */
+    double counterValue( const QString &name ) const;
+
+    /**
+     * Returns all the counters and their current values.
+     * \see addCounterValue()
+     * \note not available in Python bindings
+     * \since QGIS 3.4
+     */
+    QMap< QString, double > counters() const SIP_SKIP;
+
     /**
      * \brief clear Clear all profile data.
      */
@@ -78,11 +109,17 @@ class CORE_EXPORT QgsRuntimeProfiler
     double totalTime();
 
   private:
+#ifdef SIP_RUN
+    QgsRuntimeProfiler( const QgsRuntimeProfiler &other );
+#endif
+
     QString mGroupPrefix;
     QStack<QString> mGroupStack;
     QTime mProfileTime;
     QString mCurrentName;
     QList<QPair<QString, double > > mProfileTimes;
+    mutable QMutex mCounterMutex;
+    QMap< QString, double > mCounters;
 };
 
 #endif // QGSRUNTIMEPROFILER_H
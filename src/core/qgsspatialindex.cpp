@@ -22,10 +22,22 @@
 #include "qgslogger.h"
 #include "qgsfeaturesource.h"
 #include "qgsfeedback.h"
+#include "qgsapplication.h"
 
 #include "SpatialIndex.h"
 #include <QMutex>
 #include <QMutexLocker>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <algorithm>
+#include <cstring>
+#include <memory>
 
 using namespace SpatialIndex;
 
@@ -154,6 +166,274 @@ class QgsFeatureIteratorDataStream : public IDataStream
 };
 
 
+/**
+ * \ingroup core
+ * \class QgsSpatialIndexEntriesDataStream
+ * \brief Utility class for packing the entries of an existing R-tree into a new one. Not a part of public API.
+ * \note not available in Python bindings
+*/
+class QgsSpatialIndexEntriesDataStream : public IDataStream, private IVisitor
+{
+  public:
+    //! constructor - collects all the entries of \a tree
+    explicit QgsSpatialIndexEntriesDataStream( SpatialIndex::ISpatialIndex *tree )
+    {
+      double low[]  = { std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
+      double high[] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+      SpatialIndex::Region query( low, high, 2 );
+      tree->intersectsWithQuery( query, *this );
+    }
+
+    IData *getNext() override
+    {
+      if ( mNext >= mEntries.size() )
+        return nullptr;
+
+      Entry &entry = mEntries[ mNext++ ];
+      return new RTree::Data( 0, nullptr, entry.region, entry.id );
+    }
+
+    bool hasNext() override { return mNext < mEntries.size(); }
+
+    uint32_t size() override { return static_cast< uint32_t >( mEntries.size() ); }
+
+    void rewind() override { mNext = 0; }
+
+  private:
+
+    void visitNode( const INode &n ) override
+    { Q_UNUSED( n ); }
+
+    void visitData( const IData &d ) override
+    {
+      SpatialIndex::IShape *shape = nullptr;
+      d.getShape( &shape );
+      Entry entry;
+      entry.id = d.getIdentifier();
+      shape->getMBR( entry.region );
+      mEntries.push_back( entry );
+      delete shape;
+    }
+
+    void visitData( std::vector<const IData *> &v ) override
+    { Q_UNUSED( v ); }
+
+    struct Entry
+    {
+      SpatialIndex::id_type id;
+      SpatialIndex::Region region;
+    };
+
+    std::vector< Entry > mEntries;
+    std::size_t mNext = 0;
+};
+
+
+static const char *const FILE_MAGIC = "QGSSPIDX";
+static const quint32 FILE_VERSION = 1;
+// files are written in native byte order, files from machines with another byte order are rejected
+static const quint32 FILE_BYTE_ORDER = 0x01020304;
+
+/**
+ * \ingroup core
+ * \class QgsSpatialIndexPageStorage
+ * \brief Storage manager for R-trees which can be written to and read from index files. Not a part of public API.
+ *
+ * Index files are memory mapped when opened, pages are read from the mapping on demand.
+ * Pages which are stored or deleted afterwards are only changed in memory.
+ *
+ * \note not available in Python bindings
+*/
+class QgsSpatialIndexPageStorage : public SpatialIndex::IStorageManager
+{
+  public:
+
+    QgsSpatialIndexPageStorage() = default;
+
+    /**
+     * Opens the index file at \a path. Returns nullptr if the file is not a valid index file,
+     * or if \a sourceTimestamp is valid and does not match the timestamp stored in the file.
+     * The identifier of the header page of the tree is stored in \a indexId.
+     */
+    static std::unique_ptr< QgsSpatialIndexPageStorage > open( const QString &path, const QDateTime &sourceTimestamp, SpatialIndex::id_type &indexId )
+    {
+      std::unique_ptr< QgsSpatialIndexPageStorage > storage( new QgsSpatialIndexPageStorage() );
+      storage->mFile.setFileName( path );
+      if ( !storage->mFile.open( QIODevice::ReadOnly ) )
+        return nullptr;
+
+      const qint64 size = storage->mFile.size();
+      if ( size < static_cast< qint64 >( sizeof( FileHeader ) ) )
+        return nullptr;
+
+      storage->mMapped = storage->mFile.map( 0, size );
+      if ( !storage->mMapped )
+        return nullptr;
+      storage->mMappedSize = size;
+
+      const FileHeader *header = reinterpret_cast< const FileHeader * >( storage->mMapped );
+      if ( std::memcmp( header->magic, FILE_MAGIC, sizeof( header->magic ) ) != 0
+           || header->version != FILE_VERSION
+           || header->byteOrder != FILE_BYTE_ORDER
+           || header->pageCount < 0
+           || header->pageCount > ( size - static_cast< qint64 >( sizeof( FileHeader ) ) ) / static_cast< qint64 >( sizeof( PageEntry ) ) )
+        return nullptr;
+
+      if ( sourceTimestamp.isValid() && header->sourceTimestamp != sourceTimestamp.toMSecsSinceEpoch() )
+        return nullptr;
+
+      storage->mMappedPages = reinterpret_cast< const PageEntry * >( storage->mMapped + sizeof( FileHeader ) );
+      storage->mMappedPageCount = header->pageCount;
+      storage->mNextPage = header->nextPage;
+      indexId = header->indexId;
+      return storage;
+    }
+
+    /**
+     * Writes all pages to a new index file at \a path, together with the \a indexId of the
+     * header page of the tree and the \a sourceTimestamp of the indexed data.
+     */
+    bool write( const QString &path, const QDateTime &sourceTimestamp, SpatialIndex::id_type indexId ) const
+    {
+      QList< SpatialIndex::id_type > pages = mPages.keys();
+      for ( qint64 i = 0; i < mMappedPageCount; ++i )
+      {
+        if ( !mReplacedPages.contains( mMappedPages[i].id ) )
+          pages << mMappedPages[i].id;
+      }
+      // pages are written sorted by id, so that they can be looked up without building a hash on open
+      std::sort( pages.begin(), pages.end() );
+
+      FileHeader header;
+      std::memcpy( header.magic, FILE_MAGIC, sizeof( header.magic ) );
+      header.version = FILE_VERSION;
+      header.byteOrder = FILE_BYTE_ORDER;
+      header.sourceTimestamp = sourceTimestamp.isValid() ? sourceTimestamp.toMSecsSinceEpoch() : std::numeric_limits< qint64 >::min();
+      header.indexId = indexId;
+      header.nextPage = mNextPage;
+      header.pageCount = pages.size();
+
+      QVector< PageEntry > entries;
+      entries.reserve( pages.size() );
+      qint64 offset = sizeof( FileHeader ) + static_cast< qint64 >( pages.size() ) * sizeof( PageEntry );
+      for ( SpatialIndex::id_type page : qgis::as_const( pages ) )
+      {
+        PageEntry entry;
+        entry.id = page;
+        entry.offset = offset;
+        entry.length = pageData( page ).size();
+        offset += entry.length;
+        entries << entry;
+      }
+
+      QSaveFile file( path );
+      if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+
+      file.write( reinterpret_cast< const char * >( &header ), sizeof( FileHeader ) );
+      file.write( reinterpret_cast< const char * >( entries.constData() ), static_cast< qint64 >( entries.size() ) * sizeof( PageEntry ) );
+      for ( SpatialIndex::id_type page : qgis::as_const( pages ) )
+        file.write( pageData( page ) );
+
+      return file.commit();
+    }
+
+    void loadByteArray( const id_type page, uint32_t &len, uint8_t **data ) override
+    {
+      const QByteArray bytes = pageData( page );
+      if ( bytes.isNull() )
+        throw Tools::InvalidPageException( page );
+
+      len = static_cast< uint32_t >( bytes.size() );
+      *data = new uint8_t[len];
+      std::memcpy( *data, bytes.constData(), len );
+    }
+
+    void storeByteArray( id_type &page, const uint32_t len, const uint8_t *const data ) override
+    {
+      if ( page == StorageManager::NewPage )
+        page = mNextPage++;
+      else if ( !mPages.contains( page ) && !mappedPage( page ) )
+        throw Tools::InvalidPageException( page );
+
+      mPages.insert( page, QByteArray( reinterpret_cast< const char * >( data ), static_cast< int >( len ) ) );
+      if ( mappedPage( page ) )
+        mReplacedPages.insert( page );
+    }
+
+    void deleteByteArray( const id_type page ) override
+    {
+      if ( mPages.remove( page ) == 0 && !mappedPage( page ) )
+        throw Tools::InvalidPageException( page );
+
+      if ( mappedPage( page ) )
+        mReplacedPages.insert( page );
+    }
+
+    void flush() override {}
+
+  private:
+
+    struct FileHeader
+    {
+      char magic[8];
+      quint32 version;
+      quint32 byteOrder;
+      qint64 sourceTimestamp;
+      qint64 indexId;
+      qint64 nextPage;
+      qint64 pageCount;
+    };
+
+    struct PageEntry
+    {
+      qint64 id;
+      qint64 offset;
+      qint64 length;
+    };
+
+    //! Returns the entry of a page of the mapped file which was not replaced since, or nullptr
+    const PageEntry *mappedPage( SpatialIndex::id_type page ) const
+    {
+      if ( !mMappedPages || mReplacedPages.contains( page ) )
+        return nullptr;
+
+      const PageEntry *end = mMappedPages + mMappedPageCount;
+      const PageEntry *entry = std::lower_bound( mMappedPages, end, page, []( const PageEntry & e, SpatialIndex::id_type id ) { return e.id < id; } );
+      if ( entry == end || entry->id != page )
+        return nullptr;
+      return entry;
+    }
+
+    //! Returns the content of a page, or a null byte array if there is no such page
+    QByteArray pageData( SpatialIndex::id_type page ) const
+    {
+      const auto it = mPages.constFind( page );
+      if ( it != mPages.constEnd() )
+        return it.value();
+
+      const PageEntry *entry = mappedPage( page );
+      if ( !entry || entry->offset < 0 || entry->length < 0 || entry->offset + entry->length > mMappedSize )
+        return QByteArray();
+
+      // no copy, the mapping stays valid as long as the storage exists
+      return QByteArray::fromRawData( reinterpret_cast< const char * >( mMapped + entry->offset ), static_cast< int >( entry->length ) );
+    }
+
+    QFile mFile;
+    const uchar *mMapped = nullptr;
+    qint64 mMappedSize = 0;
+    const PageEntry *mMappedPages = nullptr;
+    qint64 mMappedPageCount = 0;
+
+    //! Pages stored in memory
+    QHash< SpatialIndex::id_type, QByteArray > mPages;
+    //! Pages of the mapped file which were stored again or deleted
+    QSet< SpatialIndex::id_type > mReplacedPages;
+    SpatialIndex::id_type mNextPage = 0;
+};
+
+
 /**
  * \ingroup core
  *  \class QgsSpatialIndexData
@@ -176,10 +456,31 @@ class QgsSpatialIndexData : public QSharedData
      * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
      * that of the spatial index construction.
      */
-    explicit QgsSpatialIndexData( const QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr )
+    explicit QgsSpatialIndexData( const QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr, QgsSpatialIndexPageStorage *pageStorage = nullptr )
     {
       QgsFeatureIteratorDataStream fids( fi, feedback );
-      initTree( &fids );
+      initTree( &fids, pageStorage );
+    }
+
+    /**
+     * Constructor for QgsSpatialIndexData which bulk loads the entries of \a inputStream into
+     * a tree stored in \a pageStorage. Ownership of \a pageStorage is transferred.
+     */
+    QgsSpatialIndexData( IDataStream *inputStream, QgsSpatialIndexPageStorage *pageStorage )
+    {
+      initTree( inputStream, pageStorage );
+    }
+
+    /**
+     * Constructor for QgsSpatialIndexData for an existing \a tree stored in \a pageStorage.
+     * Ownership of both is transferred.
+     */
+    QgsSpatialIndexData( SpatialIndex::ISpatialIndex *tree, QgsSpatialIndexPageStorage *pageStorage, SpatialIndex::id_type indexId )
+      : mStorage( pageStorage )
+      , mPageStorage( pageStorage )
+      , mRTree( tree )
+      , mIndexId( indexId )
+    {
     }
 
     QgsSpatialIndexData( const QgsSpatialIndexData &other )
@@ -205,10 +506,11 @@ class QgsSpatialIndexData : public QSharedData
 
     QgsSpatialIndexData &operator=( const QgsSpatialIndexData &rh ) = delete;
 
-    void initTree( IDataStream *inputStream = nullptr )
+    void initTree( IDataStream *inputStream = nullptr, QgsSpatialIndexPageStorage *pageStorage = nullptr )
     {
-      // for now only memory manager
-      mStorage = StorageManager::createNewMemoryStorageManager();
+      // page storage for indexes which are written to files, memory manager otherwise
+      mPageStorage = pageStorage;
+      mStorage = pageStorage ? pageStorage : StorageManager::createNewMemoryStorageManager();
 
       // R-Tree parameters
       double fillFactor = 0.7;
@@ -226,14 +528,21 @@ class QgsSpatialIndexData : public QSharedData
       else
         mRTree = RTree::createNewRTree( *mStorage, fillFactor, indexCapacity,
                                         leafCapacity, dimension, variant, indexId );
+      mIndexId = indexId;
     }
 
     //! Storage manager
     SpatialIndex::IStorageManager *mStorage = nullptr;
 
+    //! Storage manager, if the tree is stored in pages which can be written to a file
+    QgsSpatialIndexPageStorage *mPageStorage = nullptr;
+
     //! R-tree containing spatial index
     SpatialIndex::ISpatialIndex *mRTree = nullptr;
 
+    //! Identifier of the header page of the R-tree
+    SpatialIndex::id_type mIndexId = 0;
+
     mutable QMutex mMutex;
 
 };
@@ -378,6 +687,95 @@ QList<QgsFeatureId> QgsSpatialIndex::nearestNeighbor( const QgsPointXY &point, i
   return list;
 }
 
+bool QgsSpatialIndex::writeToFile( const QString &path, const QDateTime &sourceTimestamp ) const
+{
+  QMutexLocker locker( &d->mMutex );
+
+  try
+  {
+    if ( d->mPageStorage )
+    {
+      // makes sure the header page is up to date
+      d->mRTree->flush();
+      return d->mPageStorage->write( path, sourceTimestamp, d->mIndexId );
+    }
+
+    QgsSpatialIndexEntriesDataStream entries( d->mRTree );
+    QgsSpatialIndexData packed( &entries, new QgsSpatialIndexPageStorage() );
+    packed.mRTree->flush();
+    return packed.mPageStorage->write( path, sourceTimestamp, packed.mIndexId );
+  }
+  catch ( Tools::Exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "Tools::Exception caught: %1" ).arg( e.what().c_str() ) );
+  }
+  catch ( const std::exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "std::exception caught: %1" ).arg( e.what() ) );
+  }
+  return false;
+}
+
+QgsSpatialIndex QgsSpatialIndex::fromFile( const QString &path, const QDateTime &sourceTimestamp, bool *ok )
+{
+  if ( ok )
+    *ok = false;
+
+  SpatialIndex::id_type indexId = 0;
+  std::unique_ptr< QgsSpatialIndexPageStorage > storage = QgsSpatialIndexPageStorage::open( path, sourceTimestamp, indexId );
+  if ( !storage )
+    return QgsSpatialIndex();
+
+  SpatialIndex::ISpatialIndex *tree = nullptr;
+  try
+  {
+    // only reads the header page, nodes are read when queries visit them
+    tree = RTree::loadRTree( *storage, indexId );
+  }
+  catch ( Tools::Exception &e )
+  {
+    Q_UNUSED( e );
+    QgsDebugMsg( QString( "Cannot load spatial index from %1: %2" ).arg( path, e.what().c_str() ) );
+    return QgsSpatialIndex();
+  }
+
+  QgsSpatialIndex index;
+  index.d = new QgsSpatialIndexData( tree, storage.release(), indexId );
+  if ( ok )
+    *ok = true;
+  return index;
+}
+
+QgsSpatialIndex QgsSpatialIndex::fromCache( const QgsFeatureSource &source, const QString &sourceKey, const QDateTime &sourceTimestamp, QgsFeedback *feedback )
+{
+  if ( !sourceTimestamp.isValid() )
+    return QgsSpatialIndex( source, feedback );
+
+  const QString path = cacheFilePath( sourceKey );
+  bool ok = false;
+  QgsSpatialIndex index = fromFile( path, sourceTimestamp, &ok );
+  if ( ok )
+    return index;
+
+  // bulk load straight into pages which can be written to the cache
+  index.d = new QgsSpatialIndexData( source.getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) ), feedback, new QgsSpatialIndexPageStorage() );
+  if ( feedback && feedback->isCanceled() )
+    return index;
+
+  if ( !QDir().mkpath( QFileInfo( path ).absolutePath() ) || !index.writeToFile( path, sourceTimestamp ) )
+    QgsDebugMsg( QStringLiteral( "Cannot write spatial index cache file %1" ).arg( path ) );
+
+  return index;
+}
+
+QString QgsSpatialIndex::cacheFilePath( const QString &sourceKey )
+{
+  const QString hash = QString::fromLatin1( QCryptographicHash::hash( sourceKey.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+  return QgsApplication::qgisSettingsDirPath() + QStringLiteral( "cache/spatialindex/%1.qgsidx" ).arg( hash );
+}
+
 QAtomicInt QgsSpatialIndex::refs() const
 {
   return d->ref;
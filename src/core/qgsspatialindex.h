@@ -35,6 +35,7 @@ namespace SpatialIndex SIP_SKIP
 
 class QgsFeedback;
 class QgsFeature;
+class QDateTime;
 class QgsRectangle;
 class QgsPointXY;
 
@@ -149,6 +150,67 @@ class CORE_EXPORT QgsSpatialIndex
      */
     QList<QgsFeatureId> nearestNeighbor( const QgsPointXY &point, int neighbors ) const;
 
+    /* persistence */
+
+    /**
+     * Writes the index to the file at \a path, so that it can be opened again with fromFile()
+     * without scanning the features it was built from.
+     *
+     * The \a sourceTimestamp of the data the index was built from is stored alongside the index,
+     * and used by fromFile() to detect outdated index files.
+     *
+     * Indexes which were built in memory are packed again with the STR algorithm before
+     * being written.
+     *
+     * \returns true if the file was successfully written
+     * \see fromFile()
+     * \since QGIS 3.4
+     */
+    bool writeToFile( const QString &path, const QDateTime &sourceTimestamp ) const;
+
+    /**
+     * Opens an index which was written to the file at \a path by writeToFile().
+     *
+     * The file is memory mapped, and the nodes of the tree are only read when a query
+     * visits them, so opening an index is almost instant regardless of its size. Changes
+     * made to the returned index are kept in memory and never written back to the file.
+     *
+     * If \a sourceTimestamp is valid, the file is only used if it was written for the same
+     * timestamp.
+     *
+     * If the file cannot be used, \a ok is set to false and an empty index is returned.
+     *
+     * \see writeToFile()
+     * \since QGIS 3.4
+     */
+    static QgsSpatialIndex fromFile( const QString &path, const QDateTime &sourceTimestamp, bool *ok SIP_OUT = nullptr );
+
+    /**
+     * Returns an index of the features from \a source, using the persistent index cache.
+     *
+     * \a sourceKey uniquely identifies the source, e.g. the source of the layer, and \a sourceTimestamp
+     * is the time the source was last modified. If the cache holds an index for the same key and
+     * timestamp it is opened straight away, otherwise the index is bulk loaded from \a source and
+     * stored in the cache for later sessions.
+     *
+     * If \a sourceTimestamp is invalid, the cache is not used.
+     *
+     * The optional \a feedback object can be used to allow cancelation of bulk feature loading. Indexes
+     * of canceled loads are not stored in the cache.
+     *
+     * \see cacheFilePath()
+     * \since QGIS 3.4
+     */
+    static QgsSpatialIndex fromCache( const QgsFeatureSource &source, const QString &sourceKey, const QDateTime &sourceTimestamp, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Returns the path of the file used by fromCache() to store the index of the source
+     * identified by \a sourceKey.
+     *
+     * \since QGIS 3.4
+     */
+    static QString cacheFilePath( const QString &sourceKey );
+
     /* debugging */
 
     //! Gets reference count - just for debugging!
@@ -325,6 +325,15 @@ typedef QSet<int> QgsAttributeIds;
  *
  *   Determines whether the provider generates a spatial index.  The default is no.
  *
+ * -indexFile=(yes|no)
+ *
+ *   Determines whether the provider stores what it learns when scanning the file
+ *   (field types, extent, subset and spatial indexes, line positions) in index
+ *   files next to it, named after the file with .qdti and .qdti.rtree suffixes.
+ *   The index files are used instead of scanning the file again as long as the
+ *   file is unchanged.
+ *   The default is no.
+ *
  * -watchFile=(yes|no)
  *
  *   Defines whether the file will be monitored for changes. The default is
@@ -16,6 +16,7 @@
 #include "qgsvectorlayerlabelprovider.h"
 
 #include "qgsgeometry.h"
+#include "qgslabelingstream_p.h"
 #include "qgslabelsearchtree.h"
 #include "qgspallabeling.h"
 #include "qgstextlabelfeature.h"
@@ -260,7 +261,13 @@ void QgsVectorLayerLabelProvider::registerFeature( QgsFeature &feature, QgsRende
   QgsLabelFeature *label = nullptr;
   mSettings.registerFeature( feature, context, &label, obstacleGeometry );
   if ( label )
+  {
     mLabels << label;
+
+    // let the engine prepare the label while the layer is still rendering
+    if ( mEngine && mEngine->stream() )
+      mEngine->stream()->addFeature( this, label );
+  }
 }
 
 QgsGeometry QgsVectorLayerLabelProvider::getPointObstacleGeometry( QgsFeature &fet, QgsRenderContext &context, const QgsSymbolList &symbols )
@@ -467,7 +474,7 @@ void QgsVectorLayerLabelProvider::drawLabel( QgsRenderContext &context, pal::Lab
 
   // add to the results
   QString labeltext = label->getFeaturePart()->feature()->labelText();
-  mEngine->results()->mLabelSearchTree->insertLabel( label, label->getFeaturePart()->featureId(), mLayerId, labeltext, dFont, false, lf->hasFixedPosition(), mProviderId );
+  mEngine->results()->mLabelSearchTree->insertLabel( label, label->getFeaturePart()->featureId(), mLayerId, labeltext, dFont, false, lf->hasFixedPosition() && !lf->reusesPlacement(), mProviderId );
 }
 
 
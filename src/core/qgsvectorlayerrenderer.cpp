@@ -22,6 +22,9 @@
 #include "qgspallabeling.h"
 #include "qgsrenderer.h"
 #include "qgsrendercontext.h"
+#include "qgsrenderarena_p.h"
+#include "qgsruntimeprofiler.h"
+#include "qgsapplication.h"
 #include "qgssinglesymbolrenderer.h"
 #include "qgssymbollayer.h"
 #include "qgssymbol.h"
@@ -37,6 +40,42 @@
 #include "qgssettings.h"
 
 #include <QPicture>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+#include <algorithm>
+#include <cmath>
+
+// minimum number of features for splitting the rendering of a layer, below that the overhead of the tiles is not worth it
+static const long PARALLEL_RENDERING_MIN_FEATURES = 10000;
+
+// maximum number of tiles a layer is split into
+static const int PARALLEL_RENDERING_MAX_TILES = 8;
+
+// maximum memory used by the images of the tiles of a layer
+static const qint64 PARALLEL_RENDERING_MAX_IMAGE_BYTES = 256 * 1024 * 1024;
+
+// number of consecutive features rendered by a tile at once
+static const int PARALLEL_RENDERING_CHUNK_FEATURES = 2000;
+
+//! Renders chunks of consecutive features into its own image, in a worker thread
+struct QgsVectorLayerRenderer::Tile
+{
+  std::unique_ptr< QgsFeatureRenderer > renderer;
+  bool rendererStarted = false;
+  QgsRenderContext context;
+  QgsRenderArena arena;
+  QImage image;
+  QPainter::RenderHints renderHints;
+
+  //! Features of the chunk being rendered
+  QgsFeatureList features;
+  QFuture< void > future;
+  bool pending = false;
+
+  //! Rendered features of the chunk, registered for labeling when the chunk is composited
+  bool collectLabelFeatures = false;
+  QList< QgsFeature > labelFeatures;
+};
 
 
 QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context )
@@ -47,6 +86,7 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
   , mFields( layer->fields() )
   , mLabeling( false )
   , mDiagrams( false )
+  , mArena( new QgsRenderArena() )
 {
   mSource = new QgsVectorLayerFeatureSource( layer );
 
@@ -97,6 +137,8 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
   //register label and diagram layer to the labeling engine
   prepareLabeling( layer, mAttrNames );
   prepareDiagrams( layer, mAttrNames );
+
+  mParallelTileCount = parallelTileCount( layer );
 }
 
 
@@ -241,11 +283,18 @@ bool QgsVectorLayerRenderer::render()
   // in drawRenderer()
   fit.setInterruptionChecker( &mInterruptionChecker );
 
+  mContext.setRenderArena( mArena.get() );
+
   if ( ( mRenderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && mRenderer->usingSymbolLevels() )
     drawRendererLevels( fit );
+  else if ( mParallelTileCount > 1 )
+    drawRendererParallel( fit );
   else
     drawRenderer( fit );
 
+  mContext.setRenderArena( nullptr );
+  mArena->reportStatistics( QgsApplication::profiler(), QStringLiteral( "Rendering/Arena/" ) );
+
   if ( usingEffect )
   {
     mRenderer->paintEffect()->end( mContext );
@@ -279,37 +328,14 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
       bool sel = mContext.showSelection() && mSelectedFeatureIds.contains( fet.id() );
       bool drawMarker = ( mDrawVertexMarkers && mContext.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
 
-      // render feature
+      // render feature, the temporary buffers of the previous feature are not needed anymore
+      mArena->reset();
       bool rendered = mRenderer->renderFeature( fet, mContext, -1, sel, drawMarker );
 
       // labeling - register feature
       if ( rendered )
       {
-        // new labeling engine
-        if ( mContext.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
-        {
-          QgsGeometry obstacleGeometry;
-          QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, mContext );
-
-          if ( !symbols.isEmpty() && fet.geometry().type() == QgsWkbTypes::PointGeometry )
-          {
-            obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( fet, mContext, symbols );
-          }
-
-          if ( !symbols.isEmpty() )
-          {
-            QgsExpressionContextUtils::updateSymbolScope( symbols.at( 0 ), symbolScope );
-          }
-
-          if ( mLabelProvider )
-          {
-            mLabelProvider->registerFeature( fet, mContext, obstacleGeometry );
-          }
-          if ( mDiagramProvider )
-          {
-            mDiagramProvider->registerFeature( fet, mContext, obstacleGeometry );
-          }
-        }
+        registerLabelFeature( fet, symbolScope );
       }
     }
     catch ( const QgsCsException &cse )
@@ -325,6 +351,228 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
   stopRenderer( nullptr );
 }
 
+int QgsVectorLayerRenderer::parallelTileCount( QgsVectorLayer *layer ) const
+{
+  if ( !mRenderer || !mContext.testFlag( QgsRenderContext::ParallelFeatureRendering ) )
+    return 1;
+
+  // the order of the features matters for symbol levels and order by, and effects
+  // and blending modes apply to all the features of the layer at once
+  if ( ( ( mRenderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && mRenderer->usingSymbolLevels() )
+       || mRenderer->orderByEnabled()
+       || ( mRenderer->paintEffect() && mRenderer->paintEffect()->enabled() )
+       || ( mContext.useAdvancedEffects() && mFeatureBlendMode != QPainter::CompositionMode_SourceOver ) )
+    return 1;
+
+  // other renderers (point displacement, heatmap, inverted polygons...) combine
+  // features together and have to see all of them
+  const QString type = mRenderer->type();
+  if ( type != QLatin1String( "singleSymbol" ) && type != QLatin1String( "categorizedSymbol" ) && type != QLatin1String( "graduatedSymbol" ) )
+    return 1;
+
+  // bands are composited as images
+  QPainter *painter = mContext.painter();
+  if ( !painter || !painter->device() || painter->device()->devType() != QInternal::Image
+       || !painter->transform().isIdentity() || mContext.testFlag( QgsRenderContext::ForceVectorOutput ) )
+    return 1;
+
+  const long featureCount = layer->featureCount();
+  if ( featureCount >= 0 && featureCount < PARALLEL_RENDERING_MIN_FEATURES )
+    return 1;
+
+  int tileCount = std::min( QThreadPool::globalInstance()->maxThreadCount(), PARALLEL_RENDERING_MAX_TILES );
+  const QImage *image = static_cast< const QImage * >( painter->device() );
+  const qint64 imageBytes = static_cast< qint64 >( image->width() ) * image->height() * 4;
+  if ( imageBytes > 0 )
+    tileCount = static_cast< int >( std::min< qint64 >( tileCount, PARALLEL_RENDERING_MAX_IMAGE_BYTES / imageBytes ) );
+
+  return tileCount >= 2 ? tileCount : 1;
+}
+
+void QgsVectorLayerRenderer::drawRendererParallel( QgsFeatureIterator &fit )
+{
+  const QImage *device = static_cast< const QImage * >( mContext.painter()->device() );
+  const bool collectLabelFeatures = mContext.labelingEngine() && ( mLabelProvider || mDiagramProvider );
+
+  std::vector< Tile > tiles( mParallelTileCount );
+  for ( Tile &tile : tiles )
+  {
+    tile.renderer.reset( mRenderer->clone() );
+    if ( mDrawVertexMarkers )
+      tile.renderer->setVertexMarkerAppearance( mVertexMarkerStyle, mVertexMarkerSize );
+
+    tile.context = mContext;
+    tile.context.setPainter( nullptr );
+    tile.context.setRenderArena( nullptr );
+    tile.renderHints = mContext.painter()->renderHints();
+    tile.image = QImage( device->size(), QImage::Format_ARGB32_Premultiplied );
+    tile.image.setDotsPerMeterX( device->dotsPerMeterX() );
+    tile.image.setDotsPerMeterY( device->dotsPerMeterY() );
+    tile.image.setDevicePixelRatio( device->devicePixelRatio() );
+    tile.image.fill( Qt::transparent );
+    tile.collectLabelFeatures = collectLabelFeatures;
+  }
+
+  QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+  mContext.expressionContext().appendScope( symbolScope );
+
+  // Features are read in provider order and handed out to the tiles in chunks, round robin.
+  // Before a tile gets its next chunk, its previous one (the oldest chunk in flight) is
+  // composited and its features are registered for labeling, so the layer image and the
+  // labels are exactly those of the serial rendering.
+  int next = 0;
+  int chunkCount = 0;
+  bool finished = false;
+  QgsFeature fet;
+  while ( !finished )
+  {
+    Tile &tile = tiles[ next ];
+    finishTile( tile, symbolScope );
+
+    while ( tile.features.count() < PARALLEL_RENDERING_CHUNK_FEATURES )
+    {
+      if ( mContext.renderingStopped() || !fit.nextFeature( fet ) )
+      {
+        finished = true;
+        break;
+      }
+
+      if ( !fet.hasGeometry() || fet.geometry().isEmpty() )
+        continue; // skip features without geometry
+
+      tile.features << fet;
+    }
+
+    if ( tile.features.isEmpty() )
+      break;
+
+    tile.pending = true;
+    tile.future = QtConcurrent::run( [this, &tile] { drawTile( tile ); } );
+    chunkCount++;
+    next = ( next + 1 ) % mParallelTileCount;
+  }
+
+  // remaining chunks, oldest first
+  for ( int i = 0; i < mParallelTileCount; ++i )
+  {
+    finishTile( tiles[( next + i ) % mParallelTileCount ], symbolScope );
+  }
+
+  delete mContext.expressionContext().popScope();
+
+  for ( Tile &tile : tiles )
+  {
+    if ( tile.rendererStarted )
+    {
+      QPainter painter( &tile.image );
+      tile.context.setPainter( &painter );
+      tile.renderer->stopRender( tile.context );
+      tile.context.setPainter( nullptr );
+    }
+    tile.arena.reportStatistics( QgsApplication::profiler(), QStringLiteral( "Rendering/Arena/" ) );
+  }
+  QgsApplication::profiler()->addCounterValue( QStringLiteral( "Rendering/Parallel/chunks" ), chunkCount );
+
+  stopRenderer( nullptr );
+}
+
+void QgsVectorLayerRenderer::drawTile( Tile &tile )
+{
+  QPainter painter( &tile.image );
+  painter.setRenderHints( tile.renderHints );
+  tile.context.setPainter( &painter );
+  tile.context.setRenderArena( &tile.arena );
+
+  if ( !tile.rendererStarted )
+  {
+    tile.renderer->startRender( tile.context, mFields );
+    tile.rendererStarted = true;
+  }
+
+  QgsExpressionContextScope *symbolScope = QgsExpressionContextUtils::updateSymbolScope( nullptr, new QgsExpressionContextScope() );
+  tile.context.expressionContext().appendScope( symbolScope );
+
+  for ( QgsFeature &fet : tile.features )
+  {
+    try
+    {
+      if ( mContext.renderingStopped() )
+        break;
+
+      tile.context.expressionContext().setFeature( fet );
+
+      bool sel = tile.context.showSelection() && mSelectedFeatureIds.contains( fet.id() );
+      bool drawMarker = ( mDrawVertexMarkers && tile.context.drawEditingInformation() && ( !mVertexMarkerOnlyForSelection || sel ) );
+
+      tile.arena.reset();
+      if ( tile.renderer->renderFeature( fet, tile.context, -1, sel, drawMarker ) && tile.collectLabelFeatures )
+        tile.labelFeatures << fet;
+    }
+    catch ( const QgsCsException &cse )
+    {
+      Q_UNUSED( cse );
+      QgsDebugMsg( QString( "Failed to transform a point while drawing a feature with ID '%1'. Ignoring this feature. %2" )
+                   .arg( fet.id() ).arg( cse.what() ) );
+    }
+  }
+
+  delete tile.context.expressionContext().popScope();
+  tile.context.setRenderArena( nullptr );
+  tile.context.setPainter( nullptr );
+}
+
+void QgsVectorLayerRenderer::finishTile( Tile &tile, QgsExpressionContextScope *symbolScope )
+{
+  if ( !tile.pending )
+    return;
+
+  tile.future.waitForFinished();
+  tile.pending = false;
+  tile.features.clear();
+
+  mContext.painter()->drawImage( 0, 0, tile.image );
+  tile.image.fill( Qt::transparent );
+
+  if ( !mContext.renderingStopped() )
+  {
+    for ( QgsFeature &feature : tile.labelFeatures )
+    {
+      mContext.expressionContext().setFeature( feature );
+      registerLabelFeature( feature, symbolScope );
+    }
+  }
+  tile.labelFeatures.clear();
+}
+
+void QgsVectorLayerRenderer::registerLabelFeature( QgsFeature &feature, QgsExpressionContextScope *symbolScope )
+{
+  // new labeling engine
+  if ( !mContext.labelingEngine() || ( !mLabelProvider && !mDiagramProvider ) )
+    return;
+
+  QgsGeometry obstacleGeometry;
+  QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( feature, mContext );
+
+  if ( !symbols.isEmpty() && feature.geometry().type() == QgsWkbTypes::PointGeometry )
+  {
+    obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( feature, mContext, symbols );
+  }
+
+  if ( !symbols.isEmpty() )
+  {
+    QgsExpressionContextUtils::updateSymbolScope( symbols.at( 0 ), symbolScope );
+  }
+
+  if ( mLabelProvider )
+  {
+    mLabelProvider->registerFeature( feature, mContext, obstacleGeometry );
+  }
+  if ( mDiagramProvider )
+  {
+    mDiagramProvider->registerFeature( feature, mContext, obstacleGeometry );
+  }
+}
+
 void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
 {
   QHash< QgsSymbol *, QList<QgsFeature> > features; // key = symbol, value = array of features
@@ -454,6 +702,7 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
 
         try
         {
+          mArena->reset();
           mRenderer->renderFeature( *fit, mContext, layer, sel, drawMarker );
         }
         catch ( const QgsCsException &cse )
@@ -26,11 +26,13 @@ class QgsDiagramLayerSettings;
 
 class QgsFeatureIterator;
 class QgsSingleSymbolRenderer;
+class QgsRenderArena;
 
 #define SIP_NO_FILE
 
 #include <QList>
 #include <QPainter>
+#include <memory>
 
 typedef QList<int> QgsAttributeList;
 
@@ -102,6 +104,30 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsSingleSymbolRenderer *selRenderer );
 
+    //! Registers a rendered feature to the label and diagram providers
+    void registerLabelFeature( QgsFeature &feature, QgsExpressionContextScope *symbolScope );
+
+    /**
+     * Returns the number of tiles the layer can be split into to render features in parallel,
+     * or 1 if the layer has to be rendered serially.
+     */
+    int parallelTileCount( QgsVectorLayer *layer ) const;
+
+    struct Tile;
+
+    /**
+     * Draw layer by rendering chunks of consecutive features in parallel into separate images,
+     * which are then composited in provider order.
+     * QgsFeatureRenderer::startRender() needs to be called before using this method
+     */
+    void drawRendererParallel( QgsFeatureIterator &fit );
+
+    //! Renders the current chunk of features of a tile, called from a worker thread
+    void drawTile( Tile &tile );
+
+    //! Waits for the current chunk of a tile, composites it and registers its features for labeling
+    void finishTile( Tile &tile, QgsExpressionContextScope *symbolScope );
+
 
   protected:
 
@@ -149,6 +175,12 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 
     QgsVectorSimplifyMethod mSimplifyMethod;
     bool mSimplifyGeometry;
+
+    //! Recycles the temporary buffers created while rendering features, reset before each feature
+    std::unique_ptr< QgsRenderArena > mArena;
+
+    //! Number of tiles rendering features in parallel, 1 if the layer is rendered serially
+    int mParallelTileCount = 1;
 };
 
 
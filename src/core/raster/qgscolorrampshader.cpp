@@ -54,6 +54,9 @@ QgsColorRampShader::QgsColorRampShader( const QgsColorRampShader &other )
   if ( other.sourceColorRamp() )
     mSourceColorRamp.reset( other.sourceColorRamp()->clone() );
   mColorRampItemList = other.mColorRampItemList;
+
+  QMutexLocker locker( &other.mColorTablesMutex );
+  mColorTables = other.mColorTables;
 }
 
 QgsColorRampShader &QgsColorRampShader::operator=( const QgsColorRampShader &other )
@@ -71,6 +74,17 @@ QgsColorRampShader &QgsColorRampShader::operator=( const QgsColorRampShader &oth
   mLUTInitialized = other.mLUTInitialized;
   mClip = other.mClip;
   mColorRampItemList = other.mColorRampItemList;
+
+  if ( &other != this )
+  {
+    QMap< Qgis::DataType, QVector<QRgb> > colorTables;
+    {
+      QMutexLocker locker( &other.mColorTablesMutex );
+      colorTables = other.mColorTables;
+    }
+    QMutexLocker locker( &mColorTablesMutex );
+    mColorTables = colorTables;
+  }
   return *this;
 }
 
@@ -94,11 +108,13 @@ void QgsColorRampShader::setColorRampItemList( const QList<QgsColorRampShader::C
   // Reset the look up table when the color ramp is changed
   mLUTInitialized = false;
   mLUT.clear();
+  clearColorTables();
 }
 
 void QgsColorRampShader::setColorRampType( QgsColorRampShader::Type colorRampType )
 {
   mColorRampType = colorRampType;
+  clearColorTables();
 }
 
 bool QgsColorRampShader::isEmpty() const
@@ -120,6 +136,7 @@ void QgsColorRampShader::setColorRampType( const QString &type )
   {
     mColorRampType = Exact;
   }
+  clearColorTables();
 }
 
 QgsColorRamp *QgsColorRampShader::sourceColorRamp() const
@@ -484,6 +501,66 @@ bool QgsColorRampShader::shade( double redValue, double greenValue,
   return false;
 }
 
+QVector<QRgb> QgsColorRampShader::colorTable( Qgis::DataType dataType ) const
+{
+  int minimumValue = 0;
+  int size = 0;
+  switch ( dataType )
+  {
+    case Qgis::Byte:
+      size = 256;
+      break;
+    case Qgis::UInt16:
+      size = 65536;
+      break;
+    case Qgis::Int16:
+      minimumValue = -32768;
+      size = 65536;
+      break;
+    default:
+      return QVector<QRgb>();
+  }
+
+  QMutexLocker locker( &mColorTablesMutex );
+  QVector<QRgb> &table = mColorTables[ dataType ];
+  if ( table.isEmpty() )
+  {
+    table.resize( size );
+    QRgb *colors = table.data();
+    for ( int i = 0; i < size; ++i )
+    {
+      int red, green, blue, alpha;
+      if ( !shade( minimumValue + i, &red, &green, &blue, &alpha ) )
+      {
+        colors[i] = qRgba( 0, 0, 0, 0 );
+        continue;
+      }
+
+      if ( alpha < 255 )
+      {
+        // Working with premultiplied colors, so multiply values by alpha
+        red *= ( alpha / 255.0 );
+        blue *= ( alpha / 255.0 );
+        green *= ( alpha / 255.0 );
+      }
+      colors[i] = qRgba( red, green, blue, alpha );
+    }
+  }
+  return table;
+}
+
+void QgsColorRampShader::setClip( bool clip )
+{
+  mClip = clip;
+  clearColorTables();
+}
+
+void QgsColorRampShader::clearColorTables()
+{
+  QMutexLocker locker( &mColorTablesMutex );
+  mColorTables.clear();
+}
+
 void QgsColorRampShader::legendSymbologyItems( QList< QPair< QString, QColor > > &symbolItems ) const
 {
   QVector<QgsColorRampShader::ColorRampItem>::const_iterator colorRampIt = mColorRampItemList.constBegin();
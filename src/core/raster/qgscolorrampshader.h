@@ -24,6 +24,8 @@ originally part of the larger QgsRasterLayer class
 #include "qgis_core.h"
 #include "qgis.h"
 #include <QColor>
+#include <QMap>
+#include <QMutex>
 #include <QVector>
 #include <memory>
 
@@ -165,6 +167,18 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
                 int *returnRedValue SIP_OUT, int *returnGreenValue SIP_OUT,
                 int *returnBlueValue SIP_OUT, int *returnAlphaValue SIP_OUT ) const override;
 
+    /**
+     * Returns the colors of all the values of an integer raster of type \a dataType, indexed by
+     * the value minus the smallest value of the type. The colors are premultiplied, and values
+     * which are not shaded are transparent.
+     *
+     * Only Qgis::Byte, Qgis::UInt16 and Qgis::Int16 are supported, an empty table is returned for
+     * other data types. The table is computed on first use and kept until the shader changes.
+     * \note not available in Python bindings
+     * \since QGIS 3.4
+     */
+    QVector<QRgb> colorTable( Qgis::DataType dataType ) const SIP_SKIP;
+
     void legendSymbologyItems( QList< QPair< QString, QColor > > &symbolItems SIP_OUT ) const override;
 
     /**
@@ -190,7 +204,7 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
      * \param clip set to true to clip values which are out of range.
      * \see clip()
      */
-    void setClip( bool clip ) { mClip = clip; }
+    void setClip( bool clip );
 
     /**
      * Returns whether the shader will clip values which are out of range.
@@ -224,6 +238,13 @@ class CORE_EXPORT QgsColorRampShader : public QgsRasterShaderFunction
     mutable double mLUTFactor = 1.0;
     mutable bool mLUTInitialized = false;
 
+    //! Colors of all the values of the integer data types, built by colorTable()
+    mutable QMap< Qgis::DataType, QVector<QRgb> > mColorTables;
+    mutable QMutex mColorTablesMutex;
+
+    //! Discards the color tables, must be called whenever the result of shade() may change
+    void clearColorTables();
+
     //! Do not render values out of range
     bool mClip = false;
 };
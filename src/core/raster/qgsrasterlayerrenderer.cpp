@@ -21,10 +21,55 @@
 #include "qgsrasteriterator.h"
 #include "qgsrasterlayer.h"
 #include "qgsrasterprojector.h"
+#include "qgsrasterresamplefilter.h"
 #include "qgsrendercontext.h"
 #include "qgsproject.h"
 #include "qgsexception.h"
 
+#include <QImage>
+#include <QPainter>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <algorithm>
+#include <cmath>
+
+// minimum number of rows of the viewport rendered by each thread, below that the overhead of the pipe clones is not worth it
+static const int PARALLEL_RENDERING_MIN_ROWS = 128;
+
+// maximum number of threads a layer is split over
+static const int PARALLEL_RENDERING_MAX_WORKERS = 8;
+
+// maximum number of pixels requested from the pipe at once, as for QgsRasterIterator tiles
+static const qint64 PARALLEL_RENDERING_MAX_BAND_PIXELS = 2000 * 2000;
+
+// source pixels used on each side of an output pixel by the widest resampling kernel (cubic)
+static const int PARALLEL_RENDERING_RESAMPLING_RADIUS = 2;
+
+//! A horizontal band of the viewport, pulled through the pipe of a worker thread
+struct QgsRasterLayerRenderer::Band
+{
+  QgsRasterPipe *pipe = nullptr;
+  //! Extent requested from the pipe, including the padding
+  QgsRectangle extent;
+  int topRow = 0;
+  int rows = 0;
+  //! Rows requested above and below the band, cropped from the image
+  int paddingTop = 0;
+  int paddingBottom = 0;
+  QImage image;
+};
+
+//! Gives access to the image placement of QgsRasterDrawer, for the images of bands rendered in parallel
+class QgsRasterBandDrawer : public QgsRasterDrawer
+{
+  public:
+    QgsRasterBandDrawer()
+      : QgsRasterDrawer( nullptr )
+    {}
+
+    using QgsRasterDrawer::drawImage;
+};
+
 
 ///@cond PRIVATE
 
@@ -231,6 +276,13 @@ QgsRasterLayerRenderer::QgsRasterLayerRenderer( QgsRasterLayer *layer, QgsRender
   QgsRasterRenderer *rasterRenderer = mPipe->renderer();
   if ( rasterRenderer && !( rendererContext.flags() & QgsRenderContext::RenderPreviewJob ) )
     layer->refreshRendererIfNeeded( rasterRenderer, rendererContext.extent() );
+
+  // providers must be cloned in the main thread, one pipe for each worker rendering in parallel
+  const int workerCount = parallelWorkerCount( layer );
+  for ( int i = 1; i < workerCount; ++i )
+  {
+    mWorkerPipes.emplace_back( new QgsRasterPipe( *mPipe ) );
+  }
 }
 
 QgsRasterLayerRenderer::~QgsRasterLayerRenderer()
@@ -266,10 +318,17 @@ bool QgsRasterLayerRenderer::render()
     projector->setCrs( mRasterViewPort->mSrcCRS, mRasterViewPort->mDestCRS, mRasterViewPort->mSrcDatumTransform, mRasterViewPort->mDestDatumTransform );
   }
 
-  // Drawer to pipe?
-  QgsRasterIterator iterator( mPipe->last() );
-  QgsRasterDrawer drawer( &iterator );
-  drawer.draw( mPainter, mRasterViewPort, mMapToPixel, mFeedback );
+  if ( !mWorkerPipes.empty() )
+  {
+    drawParallel();
+  }
+  else
+  {
+    // Drawer to pipe?
+    QgsRasterIterator iterator( mPipe->last() );
+    QgsRasterDrawer drawer( &iterator );
+    drawer.draw( mPainter, mRasterViewPort, mMapToPixel, mFeedback );
+  }
 
   QgsDebugMsgLevel( QString( "total raster draw time (ms):     %1" ).arg( time.elapsed(), 5 ), 4 );
 
@@ -281,3 +340,127 @@ QgsFeedback *QgsRasterLayerRenderer::feedback() const
   return mFeedback;
 }
 
+int QgsRasterLayerRenderer::parallelWorkerCount( QgsRasterLayer *layer ) const
+{
+  if ( !mRasterViewPort || !mContext.testFlag( QgsRenderContext::ParallelRasterRendering ) )
+    return 1;
+
+  // providers without a known size are remote services (WMS...), which draw partial previews
+  // of the main pipe while loading and gain nothing from concurrent requests
+  QgsRasterDataProvider *provider = layer->dataProvider();
+  if ( !provider || !( provider->capabilities() & QgsRasterDataProvider::Size ) )
+    return 1;
+
+  // printers need the images to be modified before drawing (see QgsRasterDrawer::draw())
+  if ( !mPainter || !mPainter->device() || mPainter->device()->devType() != QInternal::Image )
+    return 1;
+
+  const int workerCount = std::min( { QThreadPool::globalInstance()->maxThreadCount(),
+                                      PARALLEL_RENDERING_MAX_WORKERS,
+                                      mRasterViewPort->mHeight / PARALLEL_RENDERING_MIN_ROWS
+                                    } );
+  return workerCount >= 2 ? workerCount : 1;
+}
+
+void QgsRasterLayerRenderer::drawParallel()
+{
+  const int workerCount = static_cast< int >( mWorkerPipes.size() ) + 1;
+  const int width = mRasterViewPort->mWidth;
+  const int height = mRasterViewPort->mHeight;
+
+  // each worker renders a contiguous run of bands, so the reads of its provider stay
+  // in a single region of the source and are done in as few requests as possible
+  const qint64 pixels = static_cast< qint64 >( width ) * height;
+  const int minBandCount = static_cast< int >( ( pixels + PARALLEL_RENDERING_MAX_BAND_PIXELS - 1 ) / PARALLEL_RENDERING_MAX_BAND_PIXELS );
+  const int bandsPerWorker = std::max( 1, ( minBandCount + workerCount - 1 ) / workerCount );
+  const int bandCount = std::min( workerCount * bandsPerWorker, height );
+  int rowsPerBand = ( height + bandCount - 1 ) / bandCount;
+
+  const QgsRectangle &extent = mRasterViewPort->mDrawnExtent;
+  const double yRes = extent.height() / height;
+
+  // the projector reprojects the bands as parts of the whole viewport, with its mesh and source grid
+  const bool reprojected = mRasterViewPort->mSrcCRS.isValid() && mRasterViewPort->mDestCRS.isValid() && mRasterViewPort->mSrcCRS != mRasterViewPort->mDestCRS;
+
+  // otherwise resampling kernels need the source pixels around the edges of the bands: each band is
+  // padded with the kernel radius in source pixels, and the padding is cropped from its image. Bands
+  // start on multiples of the padding, i.e. on source rows when zoomed in by a whole factor
+  int paddingRows = 0;
+  QgsRasterResampleFilter *resampleFilter = mPipe->resampleFilter();
+  const QgsRasterDataProvider *provider = mPipe->provider();
+  if ( !reprojected && provider && resampleFilter && ( resampleFilter->zoomedInResampler() || resampleFilter->zoomedOutResampler() ) )
+  {
+    const double rowsPerSourceRow = provider->extent().height() / provider->ySize() / yRes;
+    paddingRows = std::max( 1, static_cast< int >( std::ceil( PARALLEL_RENDERING_RESAMPLING_RADIUS * rowsPerSourceRow - 1e-6 ) ) );
+    rowsPerBand = ( rowsPerBand + paddingRows - 1 ) / paddingRows * paddingRows;
+  }
+
+  std::vector< std::vector< Band > > workers( workerCount );
+  for ( int i = 0, topRow = 0; topRow < height; ++i, topRow += rowsPerBand )
+  {
+    Band band;
+    band.pipe = i / bandsPerWorker == 0 ? mPipe : mWorkerPipes[ i / bandsPerWorker - 1 ].get();
+    band.topRow = topRow;
+    band.rows = std::min( rowsPerBand, height - topRow );
+    band.paddingTop = std::min( paddingRows, topRow );
+    band.paddingBottom = std::min( paddingRows, height - topRow - band.rows );
+    const int bottomRow = topRow + band.rows + band.paddingBottom;
+    const double yMaximum = extent.yMaximum() - ( topRow - band.paddingTop ) * yRes;
+    const double yMinimum = bottomRow == height ? extent.yMinimum() : extent.yMaximum() - bottomRow * yRes;
+    band.extent = QgsRectangle( extent.xMinimum(), yMinimum, extent.xMaximum(), yMaximum );
+    workers[ i / bandsPerWorker ].push_back( band );
+  }
+
+  for ( const std::unique_ptr< QgsRasterPipe > &pipe : mWorkerPipes )
+  {
+    if ( QgsRasterProjector *projector = pipe->projector() )
+      projector->setCrs( mRasterViewPort->mSrcCRS, mRasterViewPort->mDestCRS, mRasterViewPort->mSrcDatumTransform, mRasterViewPort->mDestDatumTransform );
+  }
+
+  if ( reprojected )
+  {
+    // the main pipe calculates the mesh of the viewport, the workers find it in the cache of meshes
+    if ( QgsRasterProjector *projector = mPipe->projector() )
+      projector->setDestinationGrid( extent, width, height );
+    for ( const std::unique_ptr< QgsRasterPipe > &pipe : mWorkerPipes )
+    {
+      if ( QgsRasterProjector *projector = pipe->projector() )
+        projector->setDestinationGrid( extent, width, height );
+    }
+  }
+
+  QtConcurrent::blockingMap( workers, [this, width]( std::vector< Band > &bands )
+  {
+    for ( Band &band : bands )
+    {
+      if ( mFeedback->isCanceled() )
+        break;
+
+      // last pipe filter has only 1 band
+      const int rows = band.paddingTop + band.rows + band.paddingBottom;
+      std::unique_ptr< QgsRasterBlock > block( band.pipe->last()->block( 1, band.extent, width, rows, mFeedback ) );
+      if ( !block )
+      {
+        QgsDebugMsg( "Cannot get block" );
+        continue;
+      }
+      band.image = block->image();
+      if ( rows != band.rows && !band.image.isNull() )
+        band.image = band.image.copy( 0, band.paddingTop, width, band.rows );
+    }
+  } );
+
+  if ( mFeedback->isCanceled() )
+    return;
+
+  QgsRasterBandDrawer drawer;
+  for ( const std::vector< Band > &bands : workers )
+  {
+    for ( const Band &band : bands )
+    {
+      if ( !band.image.isNull() )
+        drawer.drawImage( mPainter, mRasterViewPort, band.image, 0, band.topRow, mMapToPixel );
+    }
+  }
+}
+
@@ -20,6 +20,9 @@
 
 #include "qgsmaplayerrenderer.h"
 
+#include <memory>
+#include <vector>
+
 class QPainter;
 
 class QgsMapToPixel;
@@ -75,8 +78,28 @@ class CORE_EXPORT QgsRasterLayerRenderer : public QgsMapLayerRenderer
 
     QgsFeedback *feedback() const override;
 
+    /**
+     * Returns the number of threads the layer is rendered with, 1 if it is rendered serially.
+     * \since QGIS 3.4
+     */
+    int threadCount() const { return static_cast< int >( mWorkerPipes.size() ) + 1; }
+
   private:
 
+    /**
+     * Returns the number of threads the viewport can be split over to render the layer
+     * in parallel, or 1 if the layer has to be rendered serially.
+     */
+    int parallelWorkerCount( QgsRasterLayer *layer ) const;
+
+    struct Band;
+
+    /**
+     * Draw layer by splitting the viewport into horizontal bands, pulled in parallel
+     * through clones of the pipe and then drawn in order.
+     */
+    void drawParallel();
+
     QPainter *mPainter = nullptr;
     const QgsMapToPixel *mMapToPixel = nullptr;
     QgsRasterViewPort *mRasterViewPort = nullptr;
@@ -84,6 +107,13 @@ class CORE_EXPORT QgsRasterLayerRenderer : public QgsMapLayerRenderer
     QgsRasterPipe *mPipe = nullptr;
     QgsRenderContext &mContext;
 
+    /**
+     * Clones of the pipe used by the worker threads when the layer is rendered in parallel,
+     * as raster interfaces and providers must not be shared between threads. The first worker
+     * uses the main pipe. Empty if the layer is rendered serially.
+     */
+    std::vector< std::unique_ptr< QgsRasterPipe > > mWorkerPipes;
+
     //! feedback class for cancelation and preview generation
     QgsRasterLayerRendererFeedback *mFeedback = nullptr;
 
@@ -22,6 +22,10 @@
 #include "qgscoordinatetransform.h"
 #include "qgsexception.h"
 
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+
 
 QgsRasterProjector::QgsRasterProjector()
   : QgsRasterInterface( nullptr )
@@ -69,6 +73,67 @@ void QgsRasterProjector::setCrs( const QgsCoordinateReferenceSystem &srcCRS, con
 }
 
 
+// maximum number of control points kept in the cache of reprojection meshes
+static const int MESH_CACHE_MAX_POINTS = 256 * 1024;
+
+/**
+ * Identifies the reprojection mesh of a destination block. Consecutive blocks with the same CRS pair,
+ * extent and size (canvas redraws, repeated WMS tiles) have exactly the same mesh.
+ */
+struct ProjectorMeshKey
+{
+  QString srcCrs;
+  QString destCrs;
+  int srcDatumTransform;
+  int destDatumTransform;
+  QgsRectangle destExtent;
+  int destCols;
+  int destRows;
+  QgsRectangle srcRasterExtent;
+  double maxSrcXRes;
+  double maxSrcYRes;
+  QgsRasterProjector::Precision precision;
+
+  bool operator==( const ProjectorMeshKey &other ) const
+  {
+    // exact comparison, consistent with qHash()
+    return srcCrs == other.srcCrs && destCrs == other.destCrs
+           && srcDatumTransform == other.srcDatumTransform && destDatumTransform == other.destDatumTransform
+           && destExtent.xMinimum() == other.destExtent.xMinimum() && destExtent.yMinimum() == other.destExtent.yMinimum()
+           && destExtent.xMaximum() == other.destExtent.xMaximum() && destExtent.yMaximum() == other.destExtent.yMaximum()
+           && destCols == other.destCols && destRows == other.destRows
+           && srcRasterExtent.xMinimum() == other.srcRasterExtent.xMinimum() && srcRasterExtent.yMinimum() == other.srcRasterExtent.yMinimum()
+           && srcRasterExtent.xMaximum() == other.srcRasterExtent.xMaximum() && srcRasterExtent.yMaximum() == other.srcRasterExtent.yMaximum()
+           && maxSrcXRes == other.maxSrcXRes && maxSrcYRes == other.maxSrcYRes
+           && precision == other.precision;
+  }
+};
+
+static uint qHash( const ProjectorMeshKey &key, uint seed = 0 )
+{
+  uint hash = qHash( key.srcCrs, seed ) ^ qHash( key.destCrs, seed );
+  hash ^= qHash( key.destExtent.xMinimum(), seed ) ^ ( qHash( key.destExtent.yMaximum(), seed ) << 1 );
+  hash ^= qHash( key.destCols, seed ) ^ ( qHash( key.destRows, seed ) << 2 );
+  return hash ^ qHash( static_cast< int >( key.precision ), seed );
+}
+
+//! Control point matrix and source extent and size calculated for a destination block
+struct ProjectorMesh
+{
+  bool approximate;
+  QList< QList<QgsPointXY> > cpMatrix;
+  QList< QList<bool> > cpLegalMatrix;
+  int cpRows;
+  int cpCols;
+  QgsRectangle srcExtent;
+  int srcRows;
+  int srcCols;
+};
+
+//! Meshes are shared by all the projectors, which may run in several rendering threads
+static QMutex sMeshCacheMutex;
+static QCache< ProjectorMeshKey, ProjectorMesh > sMeshCache( MESH_CACHE_MAX_POINTS );
+
 ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height, QgsRasterInterface *input, const QgsCoordinateTransform &inverseCt, QgsRasterProjector::Precision precision )
   : mApproximate( false )
   , mInverseCt( inverseCt )
@@ -130,6 +195,57 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
     mApproximate = false;
   }
 
+  // The destination CRS of the inverse transform is the source of the projector
+  const ProjectorMeshKey meshKey
+  {
+    inverseCt.destinationCrs().toWkt(), inverseCt.sourceCrs().toWkt(),
+    inverseCt.destinationDatumTransformId(), inverseCt.sourceDatumTransformId(),
+    mDestExtent, mDestCols, mDestRows, mExtent, mMaxSrcXRes, mMaxSrcYRes, precision
+  };
+
+  if ( !loadMesh( meshKey ) )
+  {
+    calcMesh( inverseCt );
+
+    QMutexLocker locker( &sMeshCacheMutex );
+    sMeshCache.insert( meshKey, new ProjectorMesh { mApproximate, mCPMatrix, mCPLegalMatrix, mCPRows, mCPCols, mSrcExtent, mSrcRows, mSrcCols }, mCPRows * mCPCols );
+  }
+
+  mDestRowsPerMatrixRow = static_cast< float >( mDestRows ) / ( mCPRows - 1 );
+  mDestColsPerMatrixCol = static_cast< float >( mDestCols ) / ( mCPCols - 1 );
+
+  // init helper points
+  pHelperTop = new QgsPointXY[mDestCols];
+  pHelperBottom = new QgsPointXY[mDestCols];
+  calcHelper( 0, pHelperTop );
+  calcHelper( 1, pHelperBottom );
+  mHelperTopRow = 0;
+
+  mSrcYRes = mSrcExtent.height() / mSrcRows;
+  mSrcXRes = mSrcExtent.width() / mSrcCols;
+}
+
+bool ProjectorData::loadMesh( const ProjectorMeshKey &key )
+{
+  QMutexLocker locker( &sMeshCacheMutex );
+  const ProjectorMesh *mesh = sMeshCache.object( key );
+  if ( !mesh )
+    return false;
+
+  QgsDebugMsgLevel( "CP matrix found in cache", 4 );
+  mApproximate = mesh->approximate;
+  mCPMatrix = mesh->cpMatrix;
+  mCPLegalMatrix = mesh->cpLegalMatrix;
+  mCPRows = mesh->cpRows;
+  mCPCols = mesh->cpCols;
+  mSrcExtent = mesh->srcExtent;
+  mSrcRows = mesh->srcRows;
+  mSrcCols = mesh->srcCols;
+  return true;
+}
+
+void ProjectorData::calcMesh( const QgsCoordinateTransform &inverseCt )
+{
   // Always try to calculate mCPMatrix, it is used in calcSrcExtent() for both Approximate and Exact
   // Initialize the matrix by corners and middle points
   mCPCols = mCPRows = 3;
@@ -180,24 +296,13 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
     }
   }
   QgsDebugMsgLevel( QString( "CPMatrix size: mCPRows = %1 mCPCols = %2" ).arg( mCPRows ).arg( mCPCols ), 4 );
-  mDestRowsPerMatrixRow = static_cast< float >( mDestRows ) / ( mCPRows - 1 );
-  mDestColsPerMatrixCol = static_cast< float >( mDestCols ) / ( mCPCols - 1 );
 
   QgsDebugMsgLevel( "CPMatrix:", 5 );
   QgsDebugMsgLevel( cpToString(), 5 );
 
-  // init helper points
-  pHelperTop = new QgsPointXY[mDestCols];
-  pHelperBottom = new QgsPointXY[mDestCols];
-  calcHelper( 0, pHelperTop );
-  calcHelper( 1, pHelperBottom );
-  mHelperTopRow = 0;
-
   // Calculate source dimensions
   calcSrcExtent();
   calcSrcRowsCols();
-  mSrcYRes = mSrcExtent.height() / mSrcRows;
-  mSrcXRes = mSrcExtent.width() / mSrcCols;
 }
 
 ProjectorData::~ProjectorData()
@@ -422,6 +527,13 @@ void ProjectorData::nextHelper()
   mHelperTopRow++;
 }
 
+void ProjectorData::setHelperTopRow( int matrixRow )
+{
+  calcHelper( matrixRow, pHelperTop );
+  calcHelper( matrixRow + 1, pHelperBottom );
+  mHelperTopRow = matrixRow;
+}
+
 bool ProjectorData::srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
 {
   if ( mApproximate )
@@ -441,19 +553,13 @@ bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int
   QgsDebugMsgLevel( QString( "theDestRow = %1 mDestExtent.yMaximum() = %2 mDestYRes = %3" ).arg( destRow ).arg( mDestExtent.yMaximum() ).arg( mDestYRes ), 5 );
 #endif
 
-  // Get coordinate of center of destination cell
-  double x = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
-  double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
-  double z = 0;
-
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QString( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
-
-  if ( mInverseCt.isValid() )
+  // The centers of the destination cells are transformed a whole row at a time
+  if ( destRow != mPreciseRow )
   {
-    mInverseCt.transformInPlace( x, y, z );
+    calcPreciseRow( destRow );
   }
+  const double x = mPreciseSrcX[destCol];
+  const double y = mPreciseSrcY[destCol];
 
 #ifdef QGISDEBUG
   QgsDebugMsgLevel( QString( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
@@ -483,16 +589,65 @@ bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int
   return true;
 }
 
+void ProjectorData::calcPreciseRow( int destRow )
+{
+  mPreciseRow = destRow;
+  mPreciseSrcX.resize( mDestCols );
+  mPreciseSrcY.resize( mDestCols );
+  mPreciseSrcZ.fill( 0, mDestCols );
+
+  // Get coordinates of centers of destination cells
+  const double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+  {
+    mPreciseSrcX[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+    mPreciseSrcY[destCol] = y;
+  }
+
+  if ( !mInverseCt.isValid() )
+    return;
+
+  try
+  {
+    mInverseCt.transformCoords( mDestCols, mPreciseSrcX.data(), mPreciseSrcY.data(), mPreciseSrcZ.data() );
+  }
+  catch ( QgsCsException & )
+  {
+    // PROJ fails the whole row if a single point cannot be transformed,
+    // transform points one by one and leave the failing ones outside of the source
+    for ( int destCol = 0; destCol < mDestCols; ++destCol )
+    {
+      double x = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+      double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
+      double z = 0;
+      try
+      {
+        mInverseCt.transformInPlace( x, y, z );
+      }
+      catch ( QgsCsException & )
+      {
+        x = y = std::numeric_limits<double>::quiet_NaN();
+      }
+      mPreciseSrcX[destCol] = x;
+      mPreciseSrcY[destCol] = y;
+    }
+  }
+}
+
 bool ProjectorData::approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
 {
   int myMatrixRow = matrixRow( destRow );
   int myMatrixCol = matrixCol( destCol );
 
-  if ( myMatrixRow > mHelperTopRow )
+  if ( myMatrixRow == mHelperTopRow + 1 )
   {
-    // TODO: make it more robust (for random, not sequential reading)
     nextHelper();
   }
+  else if ( myMatrixRow != mHelperTopRow )
+  {
+    // the blocks of a destination grid start on any of its rows
+    setHelperTopRow( myMatrixRow );
+  }
 
   double myDestY = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
 
@@ -734,6 +889,50 @@ QString QgsRasterProjector::precisionLabel( Precision precision )
   return QStringLiteral( "Unknown" );
 }
 
+// source pixels read around the parts of a destination grid, the radius of the widest resampling kernel (cubic)
+static const int GRID_SOURCE_MARGIN = 2;
+
+void QgsRasterProjector::setDestinationGrid( const QgsRectangle &extent, int width, int height )
+{
+  if ( extent.isEmpty() || width <= 0 || height <= 0 )
+  {
+    mGridExtent = QgsRectangle();
+    mGridWidth = 0;
+    mGridHeight = 0;
+    return;
+  }
+
+  mGridExtent = extent;
+  mGridWidth = width;
+  mGridHeight = height;
+
+  // calculate the mesh of the grid now, projectors of other threads then find it in the cache
+  if ( mInput && mSrcCRS.isValid() && mDestCRS.isValid() && mSrcCRS != mDestCRS )
+  {
+    QgsCoordinateTransform inverseCt( mDestCRS, mSrcCRS, mDestDatumTransform, mSrcDatumTransform );
+    ProjectorData pd( mGridExtent, mGridWidth, mGridHeight, mInput, inverseCt, mPrecision );
+  }
+}
+
+bool QgsRasterProjector::gridPosition( const QgsRectangle &extent, int width, int height, int &row, int &col ) const
+{
+  if ( mGridExtent.isEmpty() || width <= 0 || height <= 0 )
+    return false;
+
+  const double xRes = mGridExtent.width() / mGridWidth;
+  const double yRes = mGridExtent.height() / mGridHeight;
+  const double x = ( extent.xMinimum() - mGridExtent.xMinimum() ) / xRes;
+  const double y = ( mGridExtent.yMaximum() - extent.yMaximum() ) / yRes;
+  col = static_cast< int >( std::round( x ) );
+  row = static_cast< int >( std::round( y ) );
+
+  // tolerance in cells of the grid
+  const double epsilon = 0.001;
+  return qgsDoubleNear( x, col, epsilon ) && qgsDoubleNear( y, row, epsilon )
+         && qgsDoubleNear( extent.width() / xRes, width, epsilon ) && qgsDoubleNear( extent.height() / yRes, height, epsilon )
+         && col >= 0 && row >= 0 && col + width <= mGridWidth && row + height <= mGridHeight;
+}
+
 QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &extent, int width, int height, QgsRasterBlockFeedback *feedback )
 {
   QgsDebugMsgLevel( QString( "extent:\n%1" ).arg( extent.toString() ), 4 );
@@ -755,7 +954,12 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
 
   QgsCoordinateTransform inverseCt( mDestCRS, mSrcCRS, mDestDatumTransform, mSrcDatumTransform );
 
-  ProjectorData pd( extent, width, height, mInput, inverseCt, mPrecision );
+  // a part of the destination grid is reprojected exactly as within the whole grid
+  int gridRow = 0;
+  int gridCol = 0;
+  const bool gridPart = gridPosition( extent, width, height, gridRow, gridCol ) && ( width < mGridWidth || height < mGridHeight );
+
+  ProjectorData pd( gridPart ? mGridExtent : extent, gridPart ? mGridWidth : width, gridPart ? mGridHeight : height, mInput, inverseCt, mPrecision );
 
   QgsDebugMsgLevel( QString( "srcExtent:\n%1" ).arg( pd.srcExtent().toString() ), 4 );
   QgsDebugMsgLevel( QString( "srcCols = %1 srcRows = %2" ).arg( pd.srcCols() ).arg( pd.srcRows() ), 4 );
@@ -767,7 +971,63 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
     return new QgsRasterBlock();
   }
 
-  std::unique_ptr< QgsRasterBlock > inputBlock( mInput->block( bandNo, pd.srcExtent(), pd.srcCols(), pd.srcRows(), feedback ) );
+  // Window of the source grid read from the input
+  QgsRectangle srcExtent = pd.srcExtent();
+  int srcTop = 0;
+  int srcLeft = 0;
+  int srcRows = pd.srcRows();
+  int srcCols = pd.srcCols();
+
+  // Source row and column of each pixel of a part of the grid, or -1 if outside of the source
+  QVector<int> gridSrcRowCols;
+  if ( gridPart )
+  {
+    gridSrcRowCols.resize( 2 * width * height );
+    int minRow = pd.srcRows();
+    int maxRow = -1;
+    int minCol = pd.srcCols();
+    int maxCol = -1;
+    int *rowCol = gridSrcRowCols.data();
+    for ( int i = 0; i < height; ++i )
+    {
+      for ( int j = 0; j < width; ++j, rowCol += 2 )
+      {
+        if ( !pd.srcRowCol( gridRow + i, gridCol + j, rowCol, rowCol + 1 ) )
+        {
+          rowCol[0] = -1;
+          continue;
+        }
+        minRow = std::min( minRow, rowCol[0] );
+        maxRow = std::max( maxRow, rowCol[0] );
+        minCol = std::min( minCol, rowCol[1] );
+        maxCol = std::max( maxCol, rowCol[1] );
+      }
+    }
+    if ( maxRow < 0 )
+    {
+      QgsDebugMsgLevel( "Grid part outside of source", 4 );
+      return new QgsRasterBlock();
+    }
+
+    // resampling filters read a few source pixels around each one, which must be the same as in the whole source grid
+    srcTop = std::max( 0, minRow - GRID_SOURCE_MARGIN );
+    srcLeft = std::max( 0, minCol - GRID_SOURCE_MARGIN );
+    srcRows = std::min( pd.srcRows(), maxRow + GRID_SOURCE_MARGIN + 1 ) - srcTop;
+    srcCols = std::min( pd.srcCols(), maxCol + GRID_SOURCE_MARGIN + 1 ) - srcLeft;
+
+    const double srcXRes = pd.srcExtent().width() / pd.srcCols();
+    const double srcYRes = pd.srcExtent().height() / pd.srcRows();
+    if ( srcLeft > 0 )
+      srcExtent.setXMinimum( pd.srcExtent().xMinimum() + srcLeft * srcXRes );
+    if ( srcLeft + srcCols < pd.srcCols() )
+      srcExtent.setXMaximum( pd.srcExtent().xMinimum() + ( srcLeft + srcCols ) * srcXRes );
+    if ( srcTop > 0 )
+      srcExtent.setYMaximum( pd.srcExtent().yMaximum() - srcTop * srcYRes );
+    if ( srcTop + srcRows < pd.srcRows() )
+      srcExtent.setYMinimum( pd.srcExtent().yMaximum() - ( srcTop + srcRows ) * srcYRes );
+  }
+
+  std::unique_ptr< QgsRasterBlock > inputBlock( mInput->block( bandNo, srcExtent, srcCols, srcRows, feedback ) );
   if ( !inputBlock || inputBlock->isEmpty() )
   {
     QgsDebugMsg( "No raster data!" );
@@ -811,10 +1071,20 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
       break;
     for ( int j = 0; j < width; ++j )
     {
-      bool inside = pd.srcRowCol( i, j, &srcRow, &srcCol );
-      if ( !inside ) continue; // we have everything set to no data
+      if ( gridPart )
+      {
+        const int *rowCol = gridSrcRowCols.constData() + 2 * ( static_cast< qgssize >( i ) * width + j );
+        if ( rowCol[0] < 0 ) continue;
+        srcRow = rowCol[0] - srcTop;
+        srcCol = rowCol[1] - srcLeft;
+      }
+      else
+      {
+        bool inside = pd.srcRowCol( i, j, &srcRow, &srcCol );
+        if ( !inside ) continue; // we have everything set to no data
+      }
 
-      qgssize srcIndex = static_cast< qgssize >( srcRow ) * pd.srcCols() + srcCol;
+      qgssize srcIndex = static_cast< qgssize >( srcRow ) * srcCols + srcCol;
 
       // isNoData() may be slow so we check doNoData first
       if ( doNoData && inputBlock->isNoData( srcRow, srcCol ) )
@@ -34,6 +34,7 @@
 #include "qgsrasterinterface.h"
 
 #include <cmath>
+#include <QVector>
 
 class QgsPointXY;
 
@@ -86,6 +87,20 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 
     QgsRasterBlock *block( int bandNo, const QgsRectangle &extent, int width, int height, QgsRasterBlockFeedback *feedback = nullptr ) override SIP_FACTORY;
 
+    /**
+     * Sets the extent and size of a destination grid which the following blocks are parts of,
+     * e.g. the viewport of a layer rendered in several bands.
+     *
+     * Blocks made of whole cells of the grid are reprojected with the mesh of the whole grid,
+     * and read from the matching part of its source grid with a margin for the resampling
+     * filters, so that adjacent blocks fit together. The mesh is calculated when the grid is
+     * set, and shared through the cache of meshes with the other projectors using the same grid.
+     * An empty \a extent resets the grid.
+     *
+     * \since QGIS 3.4
+     */
+    void setDestinationGrid( const QgsRectangle &extent, int width, int height );
+
     //! Calculate destination extent and size from source extent and size
     bool destExtentSize( const QgsRectangle &srcExtent, int srcXSize, int srcYSize,
                          QgsRectangle &destExtent SIP_OUT, int &destXSize SIP_OUT, int &destYSize SIP_OUT );
@@ -97,6 +112,13 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 
   private:
 
+    /**
+     * Returns in \a row and \a col the position in the destination grid of a block
+     * of \a width x \a height pixels covering \a extent.
+     * \returns true if the block is a part of the grid, made of whole cells
+     */
+    bool gridPosition( const QgsRectangle &extent, int width, int height, int &row, int &col ) const;
+
     //! Source CRS
     QgsCoordinateReferenceSystem mSrcCRS;
 
@@ -112,12 +134,23 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
     //! Requested precision
     Precision mPrecision = Approximate;
 
+    //! Extent of the destination grid, empty if not set
+    QgsRectangle mGridExtent;
+
+    //! Number of destination grid columns
+    int mGridWidth = 0;
+
+    //! Number of destination grid rows
+    int mGridHeight = 0;
+
 };
 
 
 #ifndef SIP_RUN
 /// @cond PRIVATE
 
+struct ProjectorMeshKey;
+
 /**
  * Internal class for reprojection of rasters - either exact or approximate.
  * QgsRasterProjector creates it and then keeps calling srcRowCol() to get source pixel position
@@ -146,6 +179,19 @@ class ProjectorData
 
   private:
 
+    /**
+     * Sets the control point matrix and the source extent and size from the cache
+     * of meshes, if a mesh was already calculated for the same block.
+     * \returns true if the mesh was found in the cache
+     */
+    bool loadMesh( const ProjectorMeshKey &key );
+
+    //! Calculate the control point matrix and the source extent and size
+    void calcMesh( const QgsCoordinateTransform &inverseCt );
+
+    //! Transform the centers of all the cells of a destination row to the source
+    void calcPreciseRow( int destRow );
+
     //! Returns the destination point for _current_ destination position.
     void destPointOnCPMatrix( int row, int col, double *theX, double *theY );
 
@@ -198,6 +244,9 @@ class ProjectorData
     //! Calc / switch helper
     void nextHelper();
 
+    //! Calc both helpers, for any matrix row
+    void setHelperTopRow( int matrixRow );
+
     //! Gets mCPMatrix as string
     QString cpToString();
 
@@ -278,6 +327,14 @@ class ProjectorData
     double mMaxSrcXRes;
     double mMaxSrcYRes;
 
+    //! Destination row transformed in mPreciseSrcX, mPreciseSrcY
+    int mPreciseRow = -1;
+
+    //! Source coordinates of the centers of the cells of the current destination row, in precise mode
+    QVector<double> mPreciseSrcX;
+    QVector<double> mPreciseSrcY;
+    QVector<double> mPreciseSrcZ;
+
 };
 
 /// @endcond
@@ -31,6 +31,7 @@
 #include <QDomElement>
 #include <QImage>
 #include <QPainter>
+#include <cmath>
 
 QgsRasterResampleFilter::QgsRasterResampleFilter( QgsRasterInterface *input )
   : QgsRasterInterface( input )
@@ -118,6 +119,14 @@ void QgsRasterResampleFilter::setZoomedOutResampler( QgsRasterResampler *r )
   mZoomedOutResampler.reset( r );
 }
 
+//! Returns the size of the oversampled block, whole numbers of pixels are not truncated because of the representation error of the oversampling
+static int oversampledSize( int size, double oversampling )
+{
+  const double oversampledSize = size * oversampling;
+  const double rounded = std::round( oversampledSize );
+  return static_cast< int >( qgsDoubleNear( oversampledSize, rounded, 1e-6 ) ? rounded : oversampledSize );
+}
+
 QgsRasterBlock *QgsRasterResampleFilter::block( int bandNo, QgsRectangle  const &extent, int width, int height, QgsRasterBlockFeedback *feedback )
 {
   Q_UNUSED( bandNo );
@@ -166,9 +175,10 @@ QgsRasterBlock *QgsRasterResampleFilter::block( int bandNo, QgsRectangle  const
   double oversamplingY = ( static_cast< double >( height ) * oversampling ) / height;
 
   // TODO: we must also increase the extent to get correct result on borders of parts
+  // (the layer renderer does it for the bands of the viewport rendered in parallel)
 
-  int resWidth = width * oversamplingX;
-  int resHeight = height * oversamplingY;
+  int resWidth = oversampledSize( width, oversamplingX );
+  int resHeight = oversampledSize( height, oversamplingY );
 
   std::unique_ptr< QgsRasterBlock > inputBlock( mInput->block( bandNumber, extent, resWidth, resHeight, feedback ) );
   if ( !inputBlock || inputBlock->isEmpty() )
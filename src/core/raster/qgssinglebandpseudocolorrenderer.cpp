@@ -26,6 +26,32 @@
 #include <QDomElement>
 #include <QImage>
 
+#include <cmath>
+#include <limits>
+
+namespace
+{
+
+  /**
+   * Converts \a count raw \a values to colors with a \a table indexed by the value minus
+   * \a offset. Values equal to \a noDataValue get \a noDataColor.
+   *
+   * The loop only does a load, a compare and a table lookup per pixel, without branches
+   * nor conversion to double, so that the compiler can unroll and vectorize it.
+   */
+  template <typename T>
+  void mapValuesToColors( const T *values, qgssize count, const QRgb *table, int offset, int noDataValue, QRgb noDataColor, QRgb *output )
+  {
+    for ( qgssize i = 0; i < count; ++i )
+    {
+      const int value = values[i];
+      const QRgb color = table[ value - offset ];
+      output[i] = value == noDataValue ? noDataColor : color;
+    }
+  }
+
+}
+
 QgsSingleBandPseudoColorRenderer::QgsSingleBandPseudoColorRenderer( QgsRasterInterface *input, int band, QgsRasterShader *shader )
   : QgsRasterRenderer( input, QStringLiteral( "singlebandpseudocolor" ) )
   , mShader( shader )
@@ -238,6 +264,89 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
   const QgsRasterShaderFunction *fcn = mShader->rasterShaderFunction();
 
   qgssize count = ( qgssize )width * height;
+
+  // integer rasters with at most 16 bits are rendered with the precomputed colors of all their values
+  const QgsColorRampShader *rampShader = dynamic_cast< const QgsColorRampShader * >( fcn );
+  QVector<QRgb> colorTable = rampShader ? rampShader->colorTable( inputBlock->dataType() ) : QVector<QRgb>();
+  if ( !colorTable.isEmpty() )
+  {
+    const int offset = inputBlock->dataType() == Qgis::Int16 ? -32768 : 0;
+
+    // a no data bitmap or an alpha band need a per pixel test
+    if ( !( inputBlock->hasNoData() && !inputBlock->hasNoDataValue() ) && mAlphaBand <= 0
+         && ( !hasTransparency || count >= static_cast< qgssize >( colorTable.size() ) ) )
+    {
+      if ( hasTransparency )
+      {
+        // the opacity only depends on the value, apply it to the table rather than to each pixel
+        QRgb *colors = colorTable.data();
+        for ( int i = 0; i < colorTable.size(); ++i )
+        {
+          double currentOpacity = mOpacity;
+          if ( mRasterTransparency )
+          {
+            currentOpacity = mRasterTransparency->alphaValue( offset + i, mOpacity * 255 ) / 255.0;
+          }
+          const QRgb color = colors[i];
+          colors[i] = qRgba( currentOpacity * qRed( color ), currentOpacity * qGreen( color ), currentOpacity * qBlue( color ), currentOpacity * qAlpha( color ) );
+        }
+      }
+
+      int noDataValue = std::numeric_limits<int>::min();
+      if ( inputBlock->hasNoDataValue() )
+      {
+        const double roundedNoDataValue = std::round( inputBlock->noDataValue() );
+        if ( qgsDoubleNear( roundedNoDataValue, inputBlock->noDataValue() ) && roundedNoDataValue >= offset && roundedNoDataValue < offset + colorTable.size() )
+          noDataValue = static_cast< int >( roundedNoDataValue );
+      }
+
+      switch ( inputBlock->dataType() )
+      {
+        case Qgis::Byte:
+          mapValuesToColors( reinterpret_cast< const quint8 * >( inputBlock->bits() ), count, colorTable.constData(), offset, noDataValue, myDefaultColor, outputBlockData );
+          break;
+        case Qgis::UInt16:
+          mapValuesToColors( reinterpret_cast< const quint16 * >( inputBlock->bits() ), count, colorTable.constData(), offset, noDataValue, myDefaultColor, outputBlockData );
+          break;
+        case Qgis::Int16:
+          mapValuesToColors( reinterpret_cast< const qint16 * >( inputBlock->bits() ), count, colorTable.constData(), offset, noDataValue, myDefaultColor, outputBlockData );
+          break;
+        default:
+          break;
+      }
+      return outputBlock.release();
+    }
+
+    const QRgb *colors = colorTable.constData();
+    for ( qgssize i = 0; i < count; i++ )
+    {
+      if ( inputBlock->isNoData( i ) )
+      {
+        outputBlockData[i] = myDefaultColor;
+        continue;
+      }
+      const double val = inputBlock->value( i );
+      const QRgb color = colors[ static_cast< int >( val ) - offset ];
+      if ( !hasTransparency )
+      {
+        outputBlockData[i] = color;
+        continue;
+      }
+
+      double currentOpacity = mOpacity;
+      if ( mRasterTransparency )
+      {
+        currentOpacity = mRasterTransparency->alphaValue( val, mOpacity * 255 ) / 255.0;
+      }
+      if ( mAlphaBand > 0 )
+      {
+        currentOpacity *= alphaBlock->value( i ) / 255.0;
+      }
+      outputBlockData[i] = qRgba( currentOpacity * qRed( color ), currentOpacity * qGreen( color ), currentOpacity * qBlue( color ), currentOpacity * qAlpha( color ) );
+    }
+    return outputBlock.release();
+  }
+
   for ( qgssize i = 0; i < count; i++ )
   {
     if ( inputBlock->isNoData( i ) )
@@ -40,6 +40,7 @@
 #include "qgsclipper.h"
 #include "qgsproperty.h"
 #include "qgscolorschemeregistry.h"
+#include "qgsrenderarena_p.h"
 
 #include <QColor>
 #include <QImage>
@@ -100,13 +101,53 @@ QgsSymbol::QgsSymbol( SymbolType type, const QgsSymbolLayerList &layers )
 }
 Q_NOWARN_DEPRECATED_POP
 
+///@cond PRIVATE
+
+// Copies the vertices of a curve to an existing buffer, so that its memory can be reused
+static void curveToPolygon( const QgsCurve &curve, QPolygonF &pts )
+{
+  const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( &curve );
+  if ( !line )
+  {
+    pts = curve.asQPolygonF();
+    return;
+  }
+
+  const int nb = line->numPoints();
+  pts.resize( nb );
+
+  const double *x = line->xData();
+  const double *y = line->yData();
+  QPointF *dest = pts.data();
+  for ( int i = 0; i < nb; ++i )
+  {
+    *dest++ = QPointF( *x++, *y++ );
+  }
+}
+
+// Returns a buffer from the arena of the render context, or the fallback buffer if rendering without arena
+static QPolygonF &scratchPolygon( QgsRenderContext &context, QPolygonF &fallback, int sizeHint = 0 )
+{
+  if ( QgsRenderArena *arena = context.renderArena() )
+    return arena->polygon( sizeHint );
+  return fallback;
+}
+
+///@endcond
+
 QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
+{
+  QPolygonF pts;
+  _getLineString( pts, context, curve, clipToExtent );
+  return pts;
+}
+
+void QgsSymbol::_getLineString( QPolygonF &pts, QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
   const unsigned int nPoints = curve.numPoints();
 
   QgsCoordinateTransform ct = context.coordinateTransform();
   const QgsMapToPixel &mtp = context.mapToPixel();
-  QPolygonF pts;
 
   //apply clipping for large lines to achieve a better rendering performance
   if ( clipToExtent && nPoints > 1 )
@@ -115,11 +156,11 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
     const double cw = e.width() / 10;
     const double ch = e.height() / 10;
     const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
-    pts = QgsClipper::clippedLine( curve, clipRect );
+    QgsClipper::clippedLine( curve, clipRect, pts );
   }
   else
   {
-    pts = curve.asQPolygonF();
+    curveToPolygon( curve, pts );
   }
 
   //transform the QPolygonF to screen coordinates
@@ -140,11 +181,16 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
   {
     mtp.transformInPlace( ptr->rx(), ptr->ry() );
   }
-
-  return pts;
 }
 
 QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
+{
+  QPolygonF poly;
+  _getPolygonRing( poly, context, curve, clipToExtent );
+  return poly;
+}
+
+void QgsSymbol::_getPolygonRing( QPolygonF &poly, QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
   const QgsCoordinateTransform ct = context.coordinateTransform();
   const QgsMapToPixel &mtp = context.mapToPixel();
@@ -153,16 +199,20 @@ QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve
   const double ch = e.height() / 10;
   QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
 
-  QPolygonF poly = curve.asQPolygonF();
-
   if ( curve.numPoints() < 1 )
-    return QPolygonF();
+  {
+    poly.resize( 0 );
+    return;
+  }
+
+  curveToPolygon( curve, poly );
 
   //clip close to view extent, if needed
   const QRectF ptsRect = poly.boundingRect();
   if ( clipToExtent && !context.extent().contains( ptsRect ) )
   {
-    QgsClipper::trimPolygon( poly, clipRect );
+    QPolygonF tmpPts;
+    QgsClipper::trimPolygon( poly, clipRect, scratchPolygon( context, tmpPts, poly.size() ) );
   }
 
   //transform the QPolygonF to screen coordinates
@@ -183,18 +233,18 @@ QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve
   {
     mtp.transformInPlace( ptr->rx(), ptr->ry() );
   }
-
-  return poly;
 }
 
 void QgsSymbol::_getPolygon( QPolygonF &pts, QList<QPolygonF> &holes, QgsRenderContext &context, const QgsPolygon &polygon, bool clipToExtent )
 {
   holes.clear();
 
-  pts = _getPolygonRing( context, *polygon.exteriorRing(), clipToExtent );
+  _getPolygonRing( pts, context, *polygon.exteriorRing(), clipToExtent );
   for ( int idx = 0; idx < polygon.numInteriorRings(); idx++ )
   {
-    const QPolygonF hole = _getPolygonRing( context, *( polygon.interiorRing( idx ) ), clipToExtent );
+    QPolygonF localHole;
+    QPolygonF &hole = scratchPolygon( context, localHole, polygon.interiorRing( idx )->numPoints() );
+    _getPolygonRing( hole, context, *( polygon.interiorRing( idx ) ), clipToExtent );
     if ( !hole.isEmpty() ) holes.append( hole );
   }
 }
@@ -827,7 +877,9 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
         break;
       }
       const QgsCurve &curve = dynamic_cast<const QgsCurve &>( *segmentizedGeometry.constGet() );
-      const QPolygonF pts = _getLineString( context, curve, !tileMapRendering && clipFeaturesToExtent() );
+      QPolygonF localPts;
+      QPolygonF &pts = scratchPolygon( context, localPts, curve.numPoints() );
+      _getLineString( pts, context, curve, !tileMapRendering && clipFeaturesToExtent() );
       static_cast<QgsLineSymbol *>( this )->renderPolyline( pts, &feature, context, layer, selected );
 
       if ( drawVertexMarker && !usingSegmentizedGeometry )
@@ -839,7 +891,8 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
     case QgsWkbTypes::Polygon:
     case QgsWkbTypes::Triangle:
     {
-      QPolygonF pts;
+      QPolygonF localPts;
+      QPolygonF &pts = scratchPolygon( context, localPts );
       QList<QPolygonF> holes;
       if ( mType != QgsSymbol::Fill )
       {
@@ -920,7 +973,9 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
 
         context.setGeometry( geomCollection.geometryN( i ) );
         const QgsCurve &curve = dynamic_cast<const QgsCurve &>( *geomCollection.geometryN( i ) );
-        const QPolygonF pts = _getLineString( context, curve, !tileMapRendering && clipFeaturesToExtent() );
+        QPolygonF localPts;
+        QPolygonF &pts = scratchPolygon( context, localPts, curve.numPoints() );
+        _getLineString( pts, context, curve, !tileMapRendering && clipFeaturesToExtent() );
         static_cast<QgsLineSymbol *>( this )->renderPolyline( pts, &feature, context, layer, selected );
 
         if ( drawVertexMarker && !usingSegmentizedGeometry )
@@ -947,7 +1002,8 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
         break;
       }
 
-      QPolygonF pts;
+      QPolygonF localPts;
+      QPolygonF &pts = scratchPolygon( context, localPts );
       QList<QPolygonF> holes;
 
       const QgsGeometryCollection &geomCollection = dynamic_cast<const QgsGeometryCollection &>( *segmentizedGeometry.constGet() );
@@ -497,6 +497,18 @@ class CORE_EXPORT QgsSymbol
     QgsSymbol( const QgsSymbol & );
 #endif
 
+    /**
+     * Writes a line string in screen coordinates from a QgsCurve in map coordinates to \a pts,
+     * reusing the memory already allocated by \a pts.
+     */
+    static void _getLineString( QPolygonF &pts, QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent );
+
+    /**
+     * Writes a polygon ring in screen coordinates from a QgsCurve in map coordinates to \a pts,
+     * reusing the memory already allocated by \a pts.
+     */
+    static void _getPolygonRing( QPolygonF &pts, QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent );
+
     /**
      * True if render has already been started - guards against multiple calls to
      * startRender() (usually a result of not cloning a shared symbol instance before rendering).
@@ -521,13 +521,18 @@ QgsDelimitedTextFeatureSource::QgsDelimitedTextFeatureSource( const QgsDelimited
   QUrl url = p->mFile->url();
 
   // make sure watcher not created when using iterator (e.g. for rendering, see issue #15558)
+  bool watched = false;
   if ( url.hasQueryItem( QStringLiteral( "watchFile" ) ) )
   {
+    watched = url.queryItemValue( QStringLiteral( "watchFile" ) ).toUpper().startsWith( 'Y' );
     url.removeQueryItem( QStringLiteral( "watchFile" ) );
   }
 
   mFile.reset( new QgsDelimitedTextFile() );
   mFile->setFromUrl( url );
+  // the provider expects the file to be rewritten, which a memory map does not survive
+  mFile->setUseMemoryMap( !watched );
+  mFile->setLineIndex( p->mFile->lineIndex(), p->mFile->lineIndexInterval() );
 
   mExpressionContext << QgsExpressionContextUtils::globalScope()
                      << QgsExpressionContextUtils::projectScope( QgsProject::instance() );
@@ -29,6 +29,59 @@
 #include <QRegExp>
 #include <QUrl>
 
+#include <algorithm>
+
+///@cond PRIVATE
+
+/**
+ * Read only device over a block of memory, which unlike QBuffer
+ * is not limited to 2GB.
+ */
+class QgsDelimitedTextMemoryDevice : public QIODevice
+{
+  public:
+    QgsDelimitedTextMemoryDevice( const char *data, qint64 size )
+      : mData( data )
+      , mSize( size )
+    {}
+
+    bool isSequential() const override { return false; }
+    qint64 size() const override { return mSize; }
+
+  protected:
+    qint64 readData( char *data, qint64 maxSize ) override
+    {
+      const qint64 count = std::min( maxSize, mSize - pos() );
+      if ( count <= 0 )
+        return 0;
+      memcpy( data, mData + pos(), count );
+      return count;
+    }
+
+    qint64 writeData( const char *, qint64 ) override { return -1; }
+
+  private:
+    const char *mData = nullptr;
+    qint64 mSize = 0;
+};
+
+///@endcond
+
+// True if the encoding represents each ASCII character with the same single byte,
+// and does not use ASCII bytes in the representation of other characters
+static bool isAsciiCompatible( QTextCodec *codec )
+{
+  if ( !codec )
+    return false;
+  const int mib = codec->mibEnum();
+  return mib == 106 // UTF-8
+         || mib == 3 // US-ASCII
+         || ( mib >= 4 && mib <= 12 ) // ISO-8859-1 to ISO-8859-9
+         || ( mib >= 109 && mib <= 112 ) // ISO-8859-13 to ISO-8859-16
+         || ( mib >= 2250 && mib <= 2258 ) // windows-1250 to windows-1258
+         || mib == 2084 || mib == 2088; // KOI8-R and KOI8-U
+}
+
 
 QgsDelimitedTextFile::QgsDelimitedTextFile( const QString &url )
   : mFileName( QString() )
@@ -54,6 +107,12 @@ void QgsDelimitedTextFile::close()
     delete mStream;
     mStream = nullptr;
   }
+  if ( mDevice )
+  {
+    delete mDevice;
+    mDevice = nullptr;
+  }
+  unmapFile();
   if ( mFile )
   {
     delete mFile;
@@ -85,7 +144,18 @@ bool QgsDelimitedTextFile::open()
     }
     if ( mFile )
     {
-      mStream = new QTextStream( mFile );
+      if ( mapFile() )
+      {
+        // Reading the records through the memory map avoids copying the file
+        // through the file buffers
+        mDevice = new QgsDelimitedTextMemoryDevice( mMappedData, mMappedSize );
+        mDevice->open( QIODevice::ReadOnly | QIODevice::Unbuffered );
+        mStream = new QTextStream( mDevice );
+      }
+      else
+      {
+        mStream = new QTextStream( mFile );
+      }
       if ( ! mEncoding.isEmpty() )
       {
         QTextCodec *codec = QTextCodec::codecForName( mEncoding.toLatin1() );
@@ -102,9 +172,36 @@ bool QgsDelimitedTextFile::open()
   return nullptr != mFile;
 }
 
+bool QgsDelimitedTextFile::mapFile()
+{
+  if ( mMappedData ) return true;
+  // Reading a mapped file which is truncated or rewritten raises SIGBUS, so
+  // a file which is expected to change is never mapped
+  if ( ! mFile || mUseWatcher || ! mUseMemoryMap ) return false;
+  const qint64 size = mFile->size();
+  if ( size <= 0 ) return false;
+  mMappedData = reinterpret_cast< const char * >( mFile->map( 0, size ) );
+  if ( ! mMappedData ) return false;
+  mMappedSize = size;
+  return true;
+}
+
+void QgsDelimitedTextFile::unmapFile()
+{
+  // The records are read through the map
+  if ( mDevice ) return;
+  // The map of a chunk belongs to the file it was split from
+  if ( mFile && mMappedData )
+    mFile->unmap( reinterpret_cast< uchar * >( const_cast< char * >( mMappedData ) ) );
+  mMappedData = nullptr;
+  mMappedSize = 0;
+}
+
 void QgsDelimitedTextFile::updateFile()
 {
   close();
+  mLineIndex.clear();
+  mLineIndexInterval = 0;
   emit fileUpdated();
 }
 
@@ -112,6 +209,8 @@ void QgsDelimitedTextFile::updateFile()
 void QgsDelimitedTextFile::resetDefinition()
 {
   close();
+  mLineIndex.clear();
+  mLineIndexInterval = 0;
   mFieldNames.clear();
   mMaxFieldCount = 0;
 }
@@ -307,6 +406,12 @@ void QgsDelimitedTextFile::setUseWatcher( bool useWatcher )
   mUseWatcher = useWatcher;
 }
 
+void QgsDelimitedTextFile::setUseMemoryMap( bool useMemoryMap )
+{
+  close();
+  mUseMemoryMap = useMemoryMap;
+}
+
 QString QgsDelimitedTextFile::type()
 {
   if ( mType == DelimTypeWhitespace ) return QStringLiteral( "whitespace" );
@@ -559,6 +664,228 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   return result;
 }
 
+QList<QgsDelimitedTextFile::Chunk> QgsDelimitedTextFile::splitRecords( qint64 chunkSize )
+{
+  QList<Chunk> chunks;
+  if ( ! mStream || mHoldCurrentRecord || chunkSize <= 0 || ! mapFile() ) return chunks;
+
+  // Records are located by looking at the bytes of the file rather than at
+  // decoded characters, which requires the special characters to be ASCII
+  // and to be encoded as the same bytes
+  if ( ! hasAsciiCompatibleEncoding() ) return chunks;
+  const QString specialChars = mDelimChars + mQuoteChar + mEscapeChar;
+  for ( const QChar &c : specialChars )
+  {
+    if ( c.unicode() >= 0x80 || c == '\n' || c == '\r' ) return chunks;
+  }
+
+  const qint64 start = mStream->pos();
+  if ( start < 0 ) return chunks;
+
+  // Only the quoted parser reads records spanning several lines
+  const bool multilineRecords = mParser == &QgsDelimitedTextFile::parseQuoted;
+  const char *data = mMappedData;
+  const qint64 size = mMappedSize;
+  long lineNumber = mLineNumber + 1;
+
+  Chunk chunk;
+  chunk.offset = start;
+  chunk.firstLineNumber = lineNumber;
+
+  // Same states as in parseQuoted().  A non ASCII byte may be part of a
+  // whitespace character or not, in which case it may have started a field.
+  bool escaped = false;
+  bool quoted = false;
+  char quoteChar = 0;
+  bool started = false;
+  bool mayHaveStarted = false;
+  bool ended = false;
+  bool invalid = false;
+
+  for ( qint64 i = start; i < size; i++ )
+  {
+    const char c = data[i];
+
+    // End of line, either \n or \r\n as read by QTextStream
+    if ( c == '\n' || ( c == '\r' && i + 1 < size && data[i + 1] == '\n' ) )
+    {
+      if ( c == '\r' ) i++;
+      lineNumber++;
+      // Quoted fields and escaped line ends continue on the next line
+      if ( ! invalid && ( quoted || escaped ) )
+      {
+        escaped = false;
+        continue;
+      }
+      escaped = false;
+      quoted = false;
+      started = false;
+      mayHaveStarted = false;
+      ended = false;
+      invalid = false;
+      if ( i + 1 - chunk.offset >= chunkSize && i + 1 < size )
+      {
+        chunk.size = i + 1 - chunk.offset;
+        chunks.append( chunk );
+        chunk.offset = i + 1;
+        chunk.firstLineNumber = lineNumber;
+      }
+      continue;
+    }
+
+    if ( ! multilineRecords || invalid ) continue;
+
+    if ( escaped )
+    {
+      escaped = false;
+      continue;
+    }
+
+    const QChar qc = QLatin1Char( c );
+    bool isQuote = false;
+    bool isEscape = false;
+    bool isDelim = mDelimChars.contains( qc );
+    if ( ! isDelim )
+    {
+      bool isQuoteChar = mQuoteChar.contains( qc );
+      isQuote = quoted ? c == quoteChar : isQuoteChar;
+      isEscape = mEscapeChar.contains( qc );
+      if ( isQuoteChar && isEscape ) isEscape = isQuote;
+    }
+
+    if ( isQuote )
+    {
+      if ( quoted )
+      {
+        if ( isEscape && i + 1 < size && data[i + 1] == quoteChar )
+        {
+          i++;
+        }
+        else
+        {
+          quoted = false;
+          ended = true;
+        }
+      }
+      else if ( ! started )
+      {
+        // Whether the quote starts a field depends on what the previous bytes decode to
+        if ( mayHaveStarted ) return QList<Chunk>();
+        quoteChar = c;
+        quoted = true;
+        started = true;
+      }
+      else
+      {
+        invalid = true;
+      }
+    }
+    else if ( isEscape )
+    {
+      escaped = true;
+    }
+    else if ( quoted )
+    {
+      continue;
+    }
+    else if ( isDelim )
+    {
+      started = false;
+      mayHaveStarted = false;
+      ended = false;
+    }
+    else if ( static_cast< unsigned char >( c ) >= 0x80 )
+    {
+      // Whether the record is valid depends on what the byte decodes to
+      if ( ended ) return QList<Chunk>();
+      if ( ! started ) mayHaveStarted = true;
+    }
+    else if ( ! qc.isSpace() )
+    {
+      if ( ended )
+        invalid = true;
+      else
+        started = true;
+    }
+  }
+
+  chunk.size = size - chunk.offset;
+  chunks.append( chunk );
+  return chunks;
+}
+
+bool QgsDelimitedTextFile::hasAsciiCompatibleEncoding() const
+{
+  if ( ! mStream || ! isAsciiCompatible( mStream->codec() ) ) return false;
+  // A UTF-16 byte order mark overrides the encoding
+  if ( mMappedSize >= 2 )
+  {
+    const unsigned char first = mMappedData[0];
+    const unsigned char second = mMappedData[1];
+    if ( ( first == 0xFF && second == 0xFE ) || ( first == 0xFE && second == 0xFF ) ) return false;
+  }
+  return true;
+}
+
+bool QgsDelimitedTextFile::buildLineIndex( int interval )
+{
+  mLineIndex.clear();
+  mLineIndexInterval = 0;
+  if ( ! open() || interval <= 0 ) return false;
+  const bool wasMapped = mMappedData;
+  if ( ! mapFile() ) return false;
+  if ( ! hasAsciiCompatibleEncoding() )
+  {
+    if ( ! wasMapped ) unmapFile();
+    return false;
+  }
+
+  const char *data = mMappedData;
+  const char *end = data + mMappedSize;
+  mLineIndex.reserve( static_cast< int >( std::min< qint64 >( mMappedSize / 16 / interval + 1, 1 << 20 ) ) );
+  long lineNumber = 1;
+  const char *line = data;
+  while ( line < end )
+  {
+    if ( ( lineNumber - 1 ) % interval == 0 ) mLineIndex.append( line - data );
+    const char *lineEnd = static_cast< const char * >( memchr( line, '\n', end - line ) );
+    if ( ! lineEnd ) break;
+    line = lineEnd + 1;
+    lineNumber++;
+  }
+  mLineIndexInterval = interval;
+  if ( ! wasMapped ) unmapFile();
+  return true;
+}
+
+void QgsDelimitedTextFile::setLineIndex( const QVector<qint64> &index, int interval )
+{
+  mLineIndex = index;
+  mLineIndexInterval = interval > 0 ? interval : 0;
+  if ( ! mLineIndexInterval ) mLineIndex.clear();
+}
+
+void QgsDelimitedTextFile::openChunk( const QgsDelimitedTextFile &file, const Chunk &chunk )
+{
+  close();
+  mMappedData = file.mMappedData + chunk.offset;
+  mMappedSize = chunk.size;
+  mDevice = new QgsDelimitedTextMemoryDevice( mMappedData, mMappedSize );
+  mDevice->open( QIODevice::ReadOnly | QIODevice::Unbuffered );
+  mStream = new QTextStream( mDevice );
+  mStream->setCodec( file.mStream->codec() );
+  mStream->setAutoDetectUnicode( false );
+  mLineNumber = chunk.firstLineNumber - 1;
+  mRecordNumber = 0;
+  mMaxRecordNumber = 0;
+}
+
+void QgsDelimitedTextFile::addChunkStatistics( long recordCount, int maxFieldCount )
+{
+  mMaxRecordNumber = std::max( mMaxRecordNumber, recordCount );
+  mMaxFieldCount = std::max( mMaxFieldCount, maxFieldCount );
+}
+
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bool skipBlank )
 {
   if ( ! mStream )
@@ -583,7 +910,20 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
 bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 {
   if ( ! mStream ) return false;
-  if ( mLineNumber > nextLineNumber - 1 )
+  // Jump to the closest indexed line before the next line, unless it is
+  // quicker to keep reading from the current line
+  const long indexed = mLineIndexInterval > 0 && nextLineNumber > 0 ? ( nextLineNumber - 1 ) / mLineIndexInterval : -1;
+  if ( indexed >= 0 && indexed < mLineIndex.size() )
+  {
+    const long indexedLineNumber = indexed * mLineIndexInterval + 1;
+    if ( mLineNumber > nextLineNumber - 1 || mLineNumber < indexedLineNumber - 1 )
+    {
+      mRecordNumber = -1;
+      mStream->seek( mLineIndex.at( indexed ) );
+      mLineNumber = indexedLineNumber - 1;
+    }
+  }
+  else if ( mLineNumber > nextLineNumber - 1 )
   {
     mRecordNumber = -1;
     mStream->seek( 0 );
@@ -22,11 +22,13 @@
 #include <QRegExp>
 #include <QUrl>
 #include <QObject>
+#include <QVector>
 
 class QgsFeature;
 class QgsField;
 class QFile;
 class QFileSystemWatcher;
+class QIODevice;
 class QTextStream;
 
 
@@ -94,6 +96,17 @@ class QgsDelimitedTextFile : public QObject
       DelimTypeRegexp
     };
 
+    //! A block of consecutive complete records of a file, see splitRecords()
+    struct Chunk
+    {
+      //! Offset of the first byte of the chunk in the file
+      qint64 offset = 0;
+      //! Number of bytes in the chunk
+      qint64 size = 0;
+      //! Line number of the first line of the chunk
+      long firstLineNumber = 1;
+    };
+
     explicit QgsDelimitedTextFile( const QString &url = QString() );
 
     ~QgsDelimitedTextFile() override;
@@ -298,6 +311,73 @@ class QgsDelimitedTextFile : public QObject
      */
     long recordCount() { return mMaxRecordNumber; }
 
+    /**
+     * Returns the maximum number of non empty fields found in a record
+     */
+    int maxFieldCount() const { return mMaxFieldCount; }
+
+    /**
+     * Splits the records which have not been read yet into chunks of at least
+     *  \a chunkSize bytes, which can be read concurrently with openChunk().
+     *  Records are only split at line ends, taking quoted fields and escaped
+     *  line ends into account.
+     *  If the records are not read through a memory map of the file, the file is
+     *  mapped until unmapFile() or close() is called, so the chunks must be read before.
+     *  \returns chunks  The chunks, or an empty list if the file cannot be memory mapped
+     *                 (see setUseMemoryMap()) or if its records cannot be located
+     *                 without decoding it (multibyte encodings other than UTF-8, non ASCII
+     *                 delimiter or quote characters)
+     */
+    QList<Chunk> splitRecords( qint64 chunkSize );
+
+    /**
+     * Releases the memory map of the file created by splitRecords(), once its
+     *  chunks have been read.  The map is kept if the records are read through it.
+     */
+    void unmapFile();
+
+    /**
+     * Builds an index of the positions of the lines of the file, which lets
+     *  setNextRecordId() jump close to a record rather than read all the lines
+     *  before it.  The position of one line in every \a interval lines is stored.
+     *  \returns valid  True if the index was built, which requires the file to be
+     *                 memory mappable (see setUseMemoryMap()) and its encoding to be
+     *                 ASCII compatible
+     */
+    bool buildLineIndex( int interval = 128 );
+
+    /**
+     * Returns the positions of lines stored by buildLineIndex(), or an empty
+     *  list if there is no line index
+     */
+    QVector<qint64> lineIndex() const { return mLineIndex; }
+
+    /**
+     * Returns the number of lines between the positions returned by lineIndex()
+     */
+    int lineIndexInterval() const { return mLineIndexInterval; }
+
+    /**
+     * Sets an index of line positions, as returned by lineIndex() and
+     *  lineIndexInterval() for the same file.  The index is discarded when
+     *  the definition of the file changes or the file is updated.
+     */
+    void setLineIndex( const QVector<qint64> &index, int interval );
+
+    /**
+     * Reads the records of a \a chunk of \a file, as returned by its splitRecords().
+     *  \a file must not be closed while the chunk is read.  Record ids are line numbers
+     *  in \a file, the chunk has no header line.
+     */
+    void openChunk( const QgsDelimitedTextFile &file, const Chunk &chunk );
+
+    /**
+     * Accounts for records read from chunks of the file by other instances
+     *  \param recordCount  The number of records in the chunks
+     *  \param maxFieldCount  The maximum number of non empty fields in a record of the chunks
+     */
+    void addChunkStatistics( long recordCount, int maxFieldCount );
+
     /**
      * Reset the file to reread from the beginning
      */
@@ -339,6 +419,14 @@ class QgsDelimitedTextFile : public QObject
 
     void setUseWatcher( bool useWatcher );
 
+    /**
+     * Set whether the file may be read through a memory map.  A mapped file which
+     *  is rewritten cannot be read anymore, so this should be disabled for files
+     *  which may change while they are read.  Watched files are never mapped.
+     * \param useMemoryMap True to read the file through a memory map, false otherwise
+     */
+    void setUseMemoryMap( bool useMemoryMap );
+
   signals:
 
     /**
@@ -390,6 +478,18 @@ class QgsDelimitedTextFile : public QObject
      */
     bool setNextLineNumber( long nextLineNumber );
 
+    /**
+     * Maps the file into memory, unless it is watched for changes or memory maps
+     *  are disabled.  Returns true if the file is mapped.
+     */
+    bool mapFile();
+
+    /**
+     * Returns true if each ASCII character of the file is represented by the same
+     *  single byte, which is never part of the representation of another character
+     */
+    bool hasAsciiCompatibleEncoding() const;
+
     /**
      * Utility routine to add a field to a record, accounting for trimming
      *  and discarding, and maximum field count
@@ -402,8 +502,17 @@ class QgsDelimitedTextFile : public QObject
     QString mFileName;
     QString mEncoding;
     QFile *mFile = nullptr;
+    // Memory map of the file (or of a chunk of it), read through mDevice unless the
+    // file is only mapped while it is split
+    const char *mMappedData = nullptr;
+    qint64 mMappedSize = 0;
+    QIODevice *mDevice = nullptr;
     QTextStream *mStream = nullptr;
+    // Positions of one line in every mLineIndexInterval lines
+    QVector<qint64> mLineIndex;
+    int mLineIndexInterval = 0;
     bool mUseWatcher = false;
+    bool mUseMemoryMap = true;
     QFileSystemWatcher *mWatcher = nullptr;
 
     // Parameters common to parsers
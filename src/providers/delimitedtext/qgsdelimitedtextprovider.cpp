@@ -23,10 +23,15 @@
 #include <QDataStream>
 #include <QTextStream>
 #include <QStringList>
+#include <QSaveFile>
 #include <QSettings>
 #include <QRegExp>
+#include <QThread>
 #include <QUrl>
 #include <QUrlQuery>
+#include <QtConcurrentMap>
+
+#include <algorithm>
 
 #include "qgsapplication.h"
 #include "qgsdataprovider.h"
@@ -38,6 +43,7 @@
 #include "qgsmessagelog.h"
 #include "qgsmessageoutput.h"
 #include "qgsrectangle.h"
+#include "qgssettings.h"
 #include "qgsspatialindex.h"
 #include "qgis.h"
 #include "qgsproviderregistry.h"
@@ -140,6 +146,11 @@ QgsDelimitedTextProvider::QgsDelimitedTextProvider( const QString &uri, const Pr
     mBuildSpatialIndex = ! url.queryItemValue( QStringLiteral( "spatialIndex" ) ).toLower().startsWith( 'n' );
   }
 
+  if ( url.hasQueryItem( QStringLiteral( "indexFile" ) ) )
+  {
+    mUseIndexFile = ! url.queryItemValue( QStringLiteral( "indexFile" ) ).toLower().startsWith( 'n' );
+  }
+
   if ( url.hasQueryItem( QStringLiteral( "subset" ) ) )
   {
     // We need to specify FullyDecoded so that %25 is decoded as %
@@ -363,8 +374,31 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   // 4) the type of each field
   //
   // Also build subset and spatial indexes.
+  //
+  // Large files are split into chunks which are scanned concurrently, then
+  // the results of the chunks are merged in the order of the file.
+  //
+  // The results can also be read from an index file written by a previous scan.
+
+  ScanResult initial;
+  initial.wkbType = mWkbType;
+  initial.geometryType = mGeometryType;
+  initial.wktHasPrefix = mWktHasPrefix;
+
+  const QString indexKey = mUseIndexFile ? indexFileKey() : QString();
+  QList<ScanResult> results;
+  const bool fromIndexFile = mUseIndexFile && readIndexFile( results, indexKey, buildSpatialIndex, buildSubsetIndex );
+  if ( !fromIndexFile && !scanChunks( results, initial, buildSpatialIndex, buildSubsetIndex ) )
+  {
+    results.clear();
+    results.append( initial );
+    results[0].spatialIndex = buildSpatialIndex ? mSpatialIndex.get() : nullptr;
+    mFile->reset();
+    scanRecords( *mFile, results[0], buildSpatialIndex, buildSubsetIndex );
+    results[0].recordCount = mFile->recordCount();
+    results[0].maxFieldCount = mFile->maxFieldCount();
+  }
 
-  QStringList parts;
   long nEmptyRecords = 0;
   long nBadFormatRecords = 0;
   long nIncompatibleGeometry = 0;
@@ -379,21 +413,404 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   QList<bool> couldBeDouble;
   bool foundFirstGeometry = false;
 
+  for ( const ScanResult &result : qgis::as_const( results ) )
+  {
+    nEmptyRecords += result.emptyRecords;
+    nBadFormatRecords += result.badFormatRecords;
+    nIncompatibleGeometry += result.incompatibleGeometry;
+    nInvalidGeometry += result.invalidGeometry;
+    nEmptyGeometry += result.emptyGeometry;
+    mNumberFeatures += result.numberFeatures;
+    mWktHasPrefix = mWktHasPrefix || result.wktHasPrefix;
+
+    if ( result.foundFirstGeometry )
+    {
+      mGeometryType = result.geometryType;
+      if ( !foundFirstGeometry )
+      {
+        mWkbType = result.wkbType;
+        mExtent = result.extent;
+        foundFirstGeometry = true;
+      }
+      else
+      {
+        if ( result.lastMultipartType != QgsWkbTypes::Unknown )
+          mWkbType = result.lastMultipartType;
+        mExtent.combineExtentWith( result.extent );
+      }
+    }
+
+    for ( const QPair< QgsFeatureId, QgsRectangle > &entry : result.spatialIndexEntries )
+      mSpatialIndex->insertFeature( entry.first, entry.second );
+
+    mSubsetIndex.append( result.subsetIndex );
+
+    for ( const QPair< QString, long > &invalidLine : result.invalidLines )
+      recordInvalidLine( invalidLine.first, invalidLine.second );
+    mNExtraInvalidLines += result.extraInvalidLines;
+
+    // A column can only have a type if all of its values in all chunks can be
+    // converted to it
+
+    for ( int i = 0; i < result.isEmpty.size(); i++ )
+    {
+      if ( result.isEmpty[i] )
+        continue;
+
+      while ( couldBeInt.size() <= i )
+      {
+        isEmpty.append( true );
+        couldBeInt.append( false );
+        couldBeLongLong.append( false );
+        couldBeDouble.append( false );
+      }
+
+      if ( isEmpty[i] )
+      {
+        isEmpty[i] = false;
+        couldBeInt[i] = result.couldBeInt[i];
+        couldBeLongLong[i] = result.couldBeLongLong[i];
+        couldBeDouble[i] = result.couldBeDouble[i];
+      }
+      else
+      {
+        couldBeInt[i] = couldBeInt[i] && result.couldBeInt[i];
+        couldBeLongLong[i] = couldBeLongLong[i] && result.couldBeLongLong[i];
+        couldBeDouble[i] = couldBeDouble[i] && result.couldBeDouble[i];
+      }
+    }
+  }
+
+  if ( mGeomRep == GeomNone && mNumberFeatures > 0 )
+    mWkbType = QgsWkbTypes::NoGeometry;
+
+  if ( !fromIndexFile )
+  {
+    mFile->buildLineIndex();
+    if ( mUseIndexFile )
+      writeIndexFile( results, indexKey, buildSpatialIndex, buildSubsetIndex );
+  }
+
+  // Now create the attribute fields.  Field types are integer by preference,
+  // failing that double, failing that text.
+
+  QStringList fieldNames = mFile->fieldNames();
+  mFieldCount = fieldNames.size();
+  attributeColumns.clear();
+  attributeFields.clear();
+
+  QString csvtMessage;
+  QStringList csvtTypes = readCsvtFieldTypes( mFile->fileName(), &csvtMessage );
+
+  for ( int i = 0; i < fieldNames.size(); i++ )
+  {
+    // Skip over WKT field ... don't want to display in attribute table
+    if ( i == mWktFieldIndex )
+      continue;
+
+    // Add the field index lookup for the column
+    attributeColumns.append( i );
+    QVariant::Type fieldType = QVariant::String;
+    QString typeName = QStringLiteral( "text" );
+    if ( i < csvtTypes.size() )
+    {
+      typeName = csvtTypes[i];
+    }
+    else if ( mDetectTypes && i < couldBeInt.size() )
+    {
+      if ( couldBeInt[i] )
+      {
+        typeName = QStringLiteral( "integer" );
+      }
+      else if ( couldBeLongLong[i] )
+      {
+        typeName = QStringLiteral( "longlong" );
+      }
+      else if ( couldBeDouble[i] )
+      {
+        typeName = QStringLiteral( "double" );
+      }
+    }
+    if ( typeName == QStringLiteral( "integer" ) )
+    {
+      fieldType = QVariant::Int;
+    }
+    else if ( typeName == QStringLiteral( "longlong" ) )
+    {
+      fieldType = QVariant::LongLong;
+    }
+    else if ( typeName == QStringLiteral( "real" ) || typeName == QStringLiteral( "double" ) )
+    {
+      typeName = QStringLiteral( "double" );
+      fieldType = QVariant::Double;
+    }
+    else
+    {
+      typeName = QStringLiteral( "text" );
+    }
+    attributeFields.append( QgsField( fieldNames[i], fieldType, typeName ) );
+  }
+
+
+  QgsDebugMsg( "Field count for the delimited text file is " + QString::number( attributeFields.size() ) );
+  QgsDebugMsg( "geometry type is: " + QString::number( mWkbType ) );
+  QgsDebugMsg( "feature count is: " + QString::number( mNumberFeatures ) );
+
+  QStringList warnings;
+  if ( ! csvtMessage.isEmpty() )
+    warnings.append( csvtMessage );
+  if ( nBadFormatRecords > 0 )
+    warnings.append( tr( "%1 records discarded due to invalid format" ).arg( nBadFormatRecords ) );
+  if ( nEmptyGeometry > 0 )
+    warnings.append( tr( "%1 records have missing geometry definitions" ).arg( nEmptyGeometry ) );
+  if ( nInvalidGeometry > 0 )
+    warnings.append( tr( "%1 records discarded due to invalid geometry definitions" ).arg( nInvalidGeometry ) );
+  if ( nIncompatibleGeometry > 0 )
+    warnings.append( tr( "%1 records discarded due to incompatible geometry types" ).arg( nIncompatibleGeometry ) );
+
+  reportErrors( warnings );
+
+  // Decide whether to use subset ids to index records rather than simple iteration through all
+  // If more than 10% of records are being skipped, then use index.  (Not based on any experimentation,
+  // could do with some analysis?)
+
+  if ( buildSubsetIndex )
+  {
+    long recordCount = mFile->recordCount();
+    recordCount -= recordCount / SUBSET_ID_THRESHOLD_FACTOR;
+    mUseSubsetIndex = mSubsetIndex.size() < recordCount;
+    if ( ! mUseSubsetIndex )
+      mSubsetIndex = QList<quintptr>();
+  }
+
+  mUseSpatialIndex = buildSpatialIndex;
+
+  mValid = mGeometryType != QgsWkbTypes::UnknownGeometry;
+  mLayerValid = mValid;
+
+  // If it is valid, then watch for changes to the file
+  connect( mFile.get(), &QgsDelimitedTextFile::fileUpdated, this, &QgsDelimitedTextProvider::onFileUpdated );
+}
+
+// The index file stores the results of the scan of the file, the positions of
+// its lines and its spatial index (in a separate file).  It is only used for
+// the same file size and modification time, and the same definition of the
+// layer.
+
+static const quint32 INDEX_FILE_MAGIC = 0x51445449; // QDTI
+static const quint32 INDEX_FILE_VERSION = 1;
+
+static QString indexFilePath( const QString &fileName )
+{
+  return fileName + QStringLiteral( ".qdti" );
+}
+
+static QString spatialIndexFilePath( const QString &fileName )
+{
+  return fileName + QStringLiteral( ".qdti.rtree" );
+}
+
+QString QgsDelimitedTextProvider::indexFileKey() const
+{
+  // Everything which affects the records read from the file and the features they define
+  QUrl url = mFile->url();
+  url.removeQueryItem( QStringLiteral( "watchFile" ) );
+  return QStringLiteral( "%1|%2|%3|%4|%5|%6|%7|%8|%9" ).arg( url.toString(),
+         QString::number( mGeomRep ),
+         mWktFieldName,
+         mXFieldName,
+         mYFieldName,
+         mDecimalPoint,
+         QString::number( mXyDms ),
+         QString::number( mDetectTypes ),
+         QString::number( mGeometryType ) );
+}
+
+bool QgsDelimitedTextProvider::readIndexFile( QList<ScanResult> &results, const QString &key, bool buildSpatialIndex, bool buildSubsetIndex )
+{
+  const QFileInfo fileInfo( mFile->fileName() );
+  QFile indexFile( indexFilePath( mFile->fileName() ) );
+  if ( !fileInfo.exists() || !indexFile.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &indexFile );
+  stream.setVersion( QDataStream::Qt_5_0 );
+
+  quint32 magic = 0;
+  quint32 version = 0;
+  stream >> magic >> version;
+  if ( magic != INDEX_FILE_MAGIC || version != INDEX_FILE_VERSION )
+    return false;
+
+  qint64 fileSize = 0;
+  qint64 fileModified = 0;
+  QString fileKey;
+  bool hasSpatialIndex = false;
+  bool hasSubsetIndex = false;
+  stream >> fileSize >> fileModified >> fileKey >> hasSpatialIndex >> hasSubsetIndex;
+  if ( stream.status() != QDataStream::Ok || fileSize != fileInfo.size() ||
+       fileModified != fileInfo.lastModified().toMSecsSinceEpoch() || fileKey != key ||
+       ( buildSpatialIndex && !hasSpatialIndex ) || ( buildSubsetIndex && !hasSubsetIndex ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Index file %1 is outdated" ).arg( indexFile.fileName() ) );
+    return false;
+  }
+
+  auto readLong = [&stream]( long & value )
+  {
+    qint64 v = 0;
+    stream >> v;
+    value = static_cast< long >( v );
+  };
+
+  QVector<qint64> lineIndex;
+  qint32 lineIndexInterval = 0;
+  quint32 resultCount = 0;
+  stream >> lineIndex >> lineIndexInterval >> resultCount;
+
+  QList<ScanResult> stored;
+  long recordCount = 0;
+  int maxFieldCount = 0;
+  for ( quint32 i = 0; i < resultCount && stream.status() == QDataStream::Ok; i++ )
+  {
+    ScanResult result;
+    qint32 wkbType = 0;
+    qint32 lastMultipartType = 0;
+    qint32 geometryType = 0;
+    qint32 resultMaxFieldCount = 0;
+    quint32 invalidLineCount = 0;
+    readLong( result.emptyRecords );
+    readLong( result.badFormatRecords );
+    readLong( result.incompatibleGeometry );
+    readLong( result.invalidGeometry );
+    readLong( result.emptyGeometry );
+    readLong( result.numberFeatures );
+    stream >> result.foundFirstGeometry >> result.extent >> wkbType >> lastMultipartType >> geometryType >> result.wktHasPrefix;
+    result.wkbType = static_cast< QgsWkbTypes::Type >( wkbType );
+    result.lastMultipartType = static_cast< QgsWkbTypes::Type >( lastMultipartType );
+    result.geometryType = static_cast< QgsWkbTypes::GeometryType >( geometryType );
+    stream >> result.isEmpty >> result.couldBeInt >> result.couldBeLongLong >> result.couldBeDouble >> result.subsetIndex;
+    stream >> invalidLineCount;
+    for ( quint32 j = 0; j < invalidLineCount && stream.status() == QDataStream::Ok; j++ )
+    {
+      QString message;
+      long lineNumber = 0;
+      stream >> message;
+      readLong( lineNumber );
+      result.invalidLines.append( qMakePair( message, lineNumber ) );
+    }
+    readLong( result.extraInvalidLines );
+    readLong( result.recordCount );
+    stream >> resultMaxFieldCount;
+    result.maxFieldCount = resultMaxFieldCount;
+
+    if ( !buildSubsetIndex )
+      result.subsetIndex.clear();
+    recordCount += result.recordCount;
+    maxFieldCount = std::max( maxFieldCount, result.maxFieldCount );
+    stored.append( result );
+  }
+  if ( stream.status() != QDataStream::Ok )
+    return false;
+
+  if ( buildSpatialIndex )
+  {
+    bool ok = false;
+    QgsSpatialIndex spatialIndex = QgsSpatialIndex::fromFile( spatialIndexFilePath( mFile->fileName() ), fileInfo.lastModified(), &ok );
+    if ( !ok )
+      return false;
+    mSpatialIndex = qgis::make_unique< QgsSpatialIndex >( spatialIndex );
+  }
+
+  mFile->setLineIndex( lineIndex, lineIndexInterval );
+  mFile->addChunkStatistics( recordCount, maxFieldCount );
+  results = stored;
+  return true;
+}
+
+void QgsDelimitedTextProvider::writeIndexFile( const QList<ScanResult> &results, const QString &key, bool buildSpatialIndex, bool buildSubsetIndex ) const
+{
+  const QFileInfo fileInfo( mFile->fileName() );
+  if ( buildSpatialIndex && !mSpatialIndex->writeToFile( spatialIndexFilePath( mFile->fileName() ), fileInfo.lastModified() ) )
+    buildSpatialIndex = false;
+
+  QSaveFile indexFile( indexFilePath( mFile->fileName() ) );
+  if ( !indexFile.open( QIODevice::WriteOnly ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Index file %1 cannot be written" ).arg( indexFile.fileName() ) );
+    return;
+  }
+
+  QDataStream stream( &indexFile );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << INDEX_FILE_MAGIC << INDEX_FILE_VERSION;
+  stream << static_cast< qint64 >( fileInfo.size() ) << fileInfo.lastModified().toMSecsSinceEpoch() << key << buildSpatialIndex << buildSubsetIndex;
+  stream << mFile->lineIndex() << static_cast< qint32 >( mFile->lineIndexInterval() ) << static_cast< quint32 >( results.size() );
+
+  for ( const ScanResult &result : results )
+  {
+    stream << static_cast< qint64 >( result.emptyRecords )
+           << static_cast< qint64 >( result.badFormatRecords )
+           << static_cast< qint64 >( result.incompatibleGeometry )
+           << static_cast< qint64 >( result.invalidGeometry )
+           << static_cast< qint64 >( result.emptyGeometry )
+           << static_cast< qint64 >( result.numberFeatures );
+    stream << result.foundFirstGeometry << result.extent
+           << static_cast< qint32 >( result.wkbType )
+           << static_cast< qint32 >( result.lastMultipartType )
+           << static_cast< qint32 >( result.geometryType )
+           << result.wktHasPrefix;
+    stream << result.isEmpty << result.couldBeInt << result.couldBeLongLong << result.couldBeDouble << result.subsetIndex;
+    stream << static_cast< quint32 >( result.invalidLines.size() );
+    for ( const QPair< QString, long > &invalidLine : result.invalidLines )
+      stream << invalidLine.first << static_cast< qint64 >( invalidLine.second );
+    stream << static_cast< qint64 >( result.extraInvalidLines )
+           << static_cast< qint64 >( result.recordCount )
+           << static_cast< qint32 >( result.maxFieldCount );
+  }
+
+  if ( stream.status() != QDataStream::Ok || !indexFile.commit() )
+    QgsDebugMsg( QStringLiteral( "Index file %1 cannot be written" ).arg( indexFile.fileName() ) );
+}
+
+// Scans the records of file up to its end.  This is called concurrently for
+// chunks of large files, so must only update the result.
+
+void QgsDelimitedTextProvider::scanRecords( QgsDelimitedTextFile &file, ScanResult &result, bool buildSpatialIndex, bool buildSubsetIndex ) const
+{
+  QStringList parts;
+
+  auto invalidLine = [&]( const QString & message )
+  {
+    if ( result.invalidLines.size() < mMaxInvalidLines )
+      result.invalidLines.append( qMakePair( message, static_cast< long >( file.recordId() ) ) );
+    else
+      result.extraInvalidLines++;
+  };
+
+  auto addToSpatialIndex = [&]( const QgsRectangle & bounds )
+  {
+    if ( result.spatialIndex )
+      result.spatialIndex->insertFeature( file.recordId(), bounds );
+    else
+      result.spatialIndexEntries.append( qMakePair( static_cast< QgsFeatureId >( file.recordId() ), bounds ) );
+  };
+
   while ( true )
   {
-    QgsDelimitedTextFile::Status status = mFile->nextRecord( parts );
+    QgsDelimitedTextFile::Status status = file.nextRecord( parts );
     if ( status == QgsDelimitedTextFile::RecordEOF )
       break;
     if ( status != QgsDelimitedTextFile::RecordOk )
     {
-      nBadFormatRecords++;
-      recordInvalidLine( tr( "Invalid record format at line %1" ) );
+      result.badFormatRecords++;
+      invalidLine( tr( "Invalid record format at line %1" ) );
       continue;
     }
     // Skip over empty records
     if ( recordIsEmpty( parts ) )
     {
-      nEmptyRecords++;
+      result.emptyRecords++;
       continue;
     }
 
@@ -404,8 +821,8 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
     {
       if ( mWktFieldIndex >= parts.size() || parts[mWktFieldIndex].isEmpty() )
       {
-        nEmptyGeometry++;
-        mNumberFeatures++;
+        result.emptyGeometry++;
+        result.numberFeatures++;
       }
       else
       {
@@ -414,44 +831,41 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
         QString sWkt = parts[mWktFieldIndex];
         QgsGeometry geom;
-        if ( !mWktHasPrefix && sWkt.indexOf( sWktPrefixRegexp ) >= 0 )
-          mWktHasPrefix = true;
-        geom = geomFromWkt( sWkt, mWktHasPrefix );
+        if ( !result.wktHasPrefix && sWkt.indexOf( sWktPrefixRegexp ) >= 0 )
+          result.wktHasPrefix = true;
+        geom = geomFromWkt( sWkt, result.wktHasPrefix );
 
         if ( !geom.isNull() )
         {
           QgsWkbTypes::Type type = geom.wkbType();
           if ( type != QgsWkbTypes::NoGeometry )
           {
-            if ( mGeometryType == QgsWkbTypes::UnknownGeometry || geom.type() == mGeometryType )
+            if ( result.geometryType == QgsWkbTypes::UnknownGeometry || geom.type() == result.geometryType )
             {
-              mGeometryType = geom.type();
-              if ( !foundFirstGeometry )
+              result.geometryType = geom.type();
+              if ( !result.foundFirstGeometry )
               {
-                mNumberFeatures++;
-                mWkbType = type;
-                mExtent = geom.boundingBox();
-                foundFirstGeometry = true;
+                result.numberFeatures++;
+                result.wkbType = type;
+                result.extent = geom.boundingBox();
+                result.foundFirstGeometry = true;
               }
               else
               {
-                mNumberFeatures++;
+                result.numberFeatures++;
                 if ( geom.isMultipart() )
-                  mWkbType = type;
+                  result.wkbType = type;
                 QgsRectangle bbox( geom.boundingBox() );
-                mExtent.combineExtentWith( bbox );
+                result.extent.combineExtentWith( bbox );
               }
+              if ( geom.isMultipart() )
+                result.lastMultipartType = type;
               if ( buildSpatialIndex )
-              {
-                QgsFeature f;
-                f.setId( mFile->recordId() );
-                f.setGeometry( geom );
-                mSpatialIndex->insertFeature( f );
-              }
+                addToSpatialIndex( geom.boundingBox() );
             }
             else
             {
-              nIncompatibleGeometry++;
+              result.incompatibleGeometry++;
               geomValid = false;
             }
           }
@@ -459,8 +873,8 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
         else
         {
           geomValid = false;
-          nInvalidGeometry++;
-          recordInvalidLine( tr( "Invalid WKT at line %1" ) );
+          result.invalidGeometry++;
+          invalidLine( tr( "Invalid WKT at line %1" ) );
         }
       }
     }
@@ -473,8 +887,8 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
       QString sY = mYFieldIndex < parts.size() ? parts[mYFieldIndex] : QString();
       if ( sX.isEmpty() && sY.isEmpty() )
       {
-        nEmptyGeometry++;
-        mNumberFeatures++;
+        result.emptyGeometry++;
+        result.numberFeatures++;
       }
       else
       {
@@ -483,47 +897,40 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
         if ( ok )
         {
-          if ( foundFirstGeometry )
+          if ( result.foundFirstGeometry )
           {
-            mExtent.combineExtentWith( pt.x(), pt.y() );
+            result.extent.combineExtentWith( pt.x(), pt.y() );
           }
           else
           {
             // Extent for the first point is just the first point
-            mExtent.set( pt.x(), pt.y(), pt.x(), pt.y() );
-            mWkbType = QgsWkbTypes::Point;
-            mGeometryType = QgsWkbTypes::PointGeometry;
-            foundFirstGeometry = true;
+            result.extent.set( pt.x(), pt.y(), pt.x(), pt.y() );
+            result.wkbType = QgsWkbTypes::Point;
+            result.geometryType = QgsWkbTypes::PointGeometry;
+            result.foundFirstGeometry = true;
           }
-          mNumberFeatures++;
+          result.numberFeatures++;
           if ( buildSpatialIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
-          {
-            QgsFeature f;
-            f.setId( mFile->recordId() );
-            f.setGeometry( QgsGeometry::fromPointXY( pt ) );
-            mSpatialIndex->insertFeature( f );
-          }
+            addToSpatialIndex( QgsRectangle( pt.x(), pt.y(), pt.x(), pt.y() ) );
         }
         else
         {
           geomValid = false;
-          nInvalidGeometry++;
-          recordInvalidLine( tr( "Invalid X or Y fields at line %1" ) );
+          result.invalidGeometry++;
+          invalidLine( tr( "Invalid X or Y fields at line %1" ) );
         }
       }
     }
     else
     {
-      mWkbType = QgsWkbTypes::NoGeometry;
-      mNumberFeatures++;
+      result.numberFeatures++;
     }
 
     if ( !geomValid )
       continue;
 
     if ( buildSubsetIndex )
-      mSubsetIndex.append( mFile->recordId() );
-
+      result.subsetIndex.append( file.recordId() );
 
     // If we are going to use this record, then assess the potential types of each column
 
@@ -538,23 +945,23 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
       // Expand the columns to include this non empty field if necessary
 
-      while ( couldBeInt.size() <= i )
+      while ( result.couldBeInt.size() <= i )
       {
-        isEmpty.append( true );
-        couldBeInt.append( false );
-        couldBeLongLong.append( false );
-        couldBeDouble.append( false );
+        result.isEmpty.append( true );
+        result.couldBeInt.append( false );
+        result.couldBeLongLong.append( false );
+        result.couldBeDouble.append( false );
       }
 
       // If this column has been empty so far then initiallize it
       // for possible types
 
-      if ( isEmpty[i] )
+      if ( result.isEmpty[i] )
       {
-        isEmpty[i] = false;
-        couldBeInt[i] = true;
-        couldBeLongLong[i] = true;
-        couldBeDouble[i] = true;
+        result.isEmpty[i] = false;
+        result.couldBeInt[i] = true;
+        result.couldBeLongLong[i] = true;
+        result.couldBeDouble[i] = true;
       }
 
       if ( ! mDetectTypes )
@@ -565,126 +972,93 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
       // Now test for still valid possible types for the field
       // Types are possible until first record which cannot be parsed
 
-      if ( couldBeInt[i] )
+      if ( result.couldBeInt[i] )
       {
-        value.toInt( &couldBeInt[i] );
+        value.toInt( &result.couldBeInt[i] );
       }
 
-      if ( couldBeLongLong[i] && ! couldBeInt[i] )
+      if ( result.couldBeLongLong[i] && ! result.couldBeInt[i] )
       {
-        value.toLongLong( &couldBeLongLong[i] );
+        value.toLongLong( &result.couldBeLongLong[i] );
       }
 
-      if ( couldBeDouble[i] && ! couldBeLongLong[i] )
+      if ( result.couldBeDouble[i] && ! result.couldBeLongLong[i] )
       {
         if ( ! mDecimalPoint.isEmpty() )
         {
           value.replace( mDecimalPoint, QLatin1String( "." ) );
         }
-        value.toDouble( &couldBeDouble[i] );
+        value.toDouble( &result.couldBeDouble[i] );
       }
     }
   }
 
-  // Now create the attribute fields.  Field types are integer by preference,
-  // failing that double, failing that text.
 
-  QStringList fieldNames = mFile->fieldNames();
-  mFieldCount = fieldNames.size();
-  attributeColumns.clear();
-  attributeFields.clear();
+}
 
-  QString csvtMessage;
-  QStringList csvtTypes = readCsvtFieldTypes( mFile->fileName(), &csvtMessage );
+// Scans chunks of the file concurrently.  Returns false if the file is not
+// worth splitting or cannot be split, or if the chunks disagree on the type of
+// geometry of the layer, in which case the file must be scanned sequentially.
 
-  for ( int i = 0; i < fieldNames.size(); i++ )
+bool QgsDelimitedTextProvider::scanChunks( QList<ScanResult> &results, const ScanResult &initial, bool buildSpatialIndex, bool buildSubsetIndex )
+{
+  const qint64 chunkSize = QgsSettings().value( QStringLiteral( "DelimitedText/scanChunkSize" ), 16 * 1024 * 1024, QgsSettings::Providers ).toLongLong();
+  if ( chunkSize <= 0 || QThread::idealThreadCount() < 2 )
+    return false;
+
+  if ( mFile->reset() != QgsDelimitedTextFile::RecordOk )
+    return false;
+  const QList<QgsDelimitedTextFile::Chunk> chunks = mFile->splitRecords( chunkSize );
+  if ( chunks.size() < 2 )
   {
-    // Skip over WKT field ... don't want to display in attribute table
-    if ( i == mWktFieldIndex )
-      continue;
-
-    // Add the field index lookup for the column
-    attributeColumns.append( i );
-    QVariant::Type fieldType = QVariant::String;
-    QString typeName = QStringLiteral( "text" );
-    if ( i < csvtTypes.size() )
-    {
-      typeName = csvtTypes[i];
-    }
-    else if ( mDetectTypes && i < couldBeInt.size() )
-    {
-      if ( couldBeInt[i] )
-      {
-        typeName = QStringLiteral( "integer" );
-      }
-      else if ( couldBeLongLong[i] )
-      {
-        typeName = QStringLiteral( "longlong" );
-      }
-      else if ( couldBeDouble[i] )
-      {
-        typeName = QStringLiteral( "double" );
-      }
-    }
-    if ( typeName == QStringLiteral( "integer" ) )
-    {
-      fieldType = QVariant::Int;
-    }
-    else if ( typeName == QStringLiteral( "longlong" ) )
-    {
-      fieldType = QVariant::LongLong;
-    }
-    else if ( typeName == QStringLiteral( "real" ) || typeName == QStringLiteral( "double" ) )
-    {
-      typeName = QStringLiteral( "double" );
-      fieldType = QVariant::Double;
-    }
-    else
-    {
-      typeName = QStringLiteral( "text" );
-    }
-    attributeFields.append( QgsField( fieldNames[i], fieldType, typeName ) );
+    mFile->unmapFile();
+    return false;
   }
 
-
-  QgsDebugMsg( "Field count for the delimited text file is " + QString::number( attributeFields.size() ) );
-  QgsDebugMsg( "geometry type is: " + QString::number( mWkbType ) );
-  QgsDebugMsg( "feature count is: " + QString::number( mNumberFeatures ) );
-
-  QStringList warnings;
-  if ( ! csvtMessage.isEmpty() )
-    warnings.append( csvtMessage );
-  if ( nBadFormatRecords > 0 )
-    warnings.append( tr( "%1 records discarded due to invalid format" ).arg( nBadFormatRecords ) );
-  if ( nEmptyGeometry > 0 )
-    warnings.append( tr( "%1 records have missing geometry definitions" ).arg( nEmptyGeometry ) );
-  if ( nInvalidGeometry > 0 )
-    warnings.append( tr( "%1 records discarded due to invalid geometry definitions" ).arg( nInvalidGeometry ) );
-  if ( nIncompatibleGeometry > 0 )
-    warnings.append( tr( "%1 records discarded due to incompatible geometry types" ).arg( nIncompatibleGeometry ) );
-
-  reportErrors( warnings );
-
-  // Decide whether to use subset ids to index records rather than simple iteration through all
-  // If more than 10% of records are being skipped, then use index.  (Not based on any experimentation,
-  // could do with some analysis?)
-
-  if ( buildSubsetIndex )
+  struct ChunkScan
   {
-    long recordCount = mFile->recordCount();
-    recordCount -= recordCount / SUBSET_ID_THRESHOLD_FACTOR;
-    mUseSubsetIndex = mSubsetIndex.size() < recordCount;
-    if ( ! mUseSubsetIndex )
-      mSubsetIndex = QList<quintptr>();
+    QgsDelimitedTextFile::Chunk chunk;
+    ScanResult result;
+  };
+  QVector< ChunkScan > scans;
+  scans.reserve( chunks.size() );
+  for ( const QgsDelimitedTextFile::Chunk &chunk : chunks )
+    scans.append( { chunk, initial } );
+
+  const QUrl url = mFile->url();
+  const QgsDelimitedTextFile *file = mFile.get();
+  QtConcurrent::blockingMap( scans, [ &, url, file ]( ChunkScan & scan )
+  {
+    QgsDelimitedTextFile chunkFile;
+    chunkFile.setFromUrl( url );
+    chunkFile.openChunk( *file, scan.chunk );
+    scanRecords( chunkFile, scan.result, buildSpatialIndex, buildSubsetIndex );
+    scan.result.recordCount = chunkFile.recordCount();
+    scan.result.maxFieldCount = chunkFile.maxFieldCount();
+  } );
+  mFile->unmapFile();
+
+  // Each chunk accepts the geometries of the type of its first geometry
+  QgsWkbTypes::GeometryType geometryType = initial.geometryType;
+  long recordCount = 0;
+  int maxFieldCount = 0;
+  results.clear();
+  for ( const ChunkScan &scan : qgis::as_const( scans ) )
+  {
+    if ( scan.result.foundFirstGeometry )
+    {
+      if ( geometryType == QgsWkbTypes::UnknownGeometry )
+        geometryType = scan.result.geometryType;
+      else if ( scan.result.geometryType != geometryType )
+        return false;
+    }
+    recordCount += scan.result.recordCount;
+    maxFieldCount = std::max( maxFieldCount, scan.result.maxFieldCount );
+    results.append( scan.result );
   }
 
-  mUseSpatialIndex = buildSpatialIndex;
-
-  mValid = mGeometryType != QgsWkbTypes::UnknownGeometry;
-  mLayerValid = mValid;
-
-  // If it is valid, then watch for changes to the file
-  connect( mFile.get(), &QgsDelimitedTextFile::fileUpdated, this, &QgsDelimitedTextProvider::onFileUpdated );
+  mFile->addChunkStatistics( recordCount, maxFieldCount );
+  return true;
 }
 
 // rescanFile.  Called if something has changed file definition, such as
@@ -746,6 +1120,11 @@ void QgsDelimitedTextProvider::rescanFile() const
     attributeColumns[i] = mFile->fieldIndex( attributeFields.at( i ).name() );
   }
 
+  // The positions of the lines are lost when the file is updated
+
+  if ( mFile->lineIndex().isEmpty() )
+    mFile->buildLineIndex();
+
   // Scan through the features in the file
 
   mSubsetIndex.clear();
@@ -908,11 +1287,11 @@ bool QgsDelimitedTextProvider::recordIsEmpty( QStringList &record )
   return true;
 }
 
-void QgsDelimitedTextProvider::recordInvalidLine( const QString &message )
+void QgsDelimitedTextProvider::recordInvalidLine( const QString &message, long lineNumber )
 {
   if ( mInvalidLines.size() < mMaxInvalidLines )
   {
-    mInvalidLines.append( message.arg( mFile->recordId() ) );
+    mInvalidLines.append( message.arg( lineNumber ) );
   }
   else
   {
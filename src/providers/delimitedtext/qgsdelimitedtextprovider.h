@@ -22,6 +22,7 @@
 #include "qgscoordinatereferencesystem.h"
 #include "qgsdelimitedtextfile.h"
 #include "qgsfields.h"
+#include "qgsrectangle.h"
 
 #include <QStringList>
 
@@ -192,14 +193,50 @@ class QgsDelimitedTextProvider : public QgsVectorDataProvider
 
   private:
 
+    //! What is learnt about the records of the file, or of a chunk of it, when scanning them
+    struct ScanResult
+    {
+      long emptyRecords = 0;
+      long badFormatRecords = 0;
+      long incompatibleGeometry = 0;
+      long invalidGeometry = 0;
+      long emptyGeometry = 0;
+      long numberFeatures = 0;
+      bool foundFirstGeometry = false;
+      QgsRectangle extent;
+      QgsWkbTypes::Type wkbType = QgsWkbTypes::NoGeometry;
+      // Type of the last multipart geometry, including the first geometry
+      QgsWkbTypes::Type lastMultipartType = QgsWkbTypes::Unknown;
+      QgsWkbTypes::GeometryType geometryType = QgsWkbTypes::UnknownGeometry;
+      bool wktHasPrefix = false;
+      QList<bool> isEmpty;
+      QList<bool> couldBeInt;
+      QList<bool> couldBeLongLong;
+      QList<bool> couldBeDouble;
+      QList<quintptr> subsetIndex;
+      // Features are inserted in this index if set, otherwise their bounding boxes are stored
+      QgsSpatialIndex *spatialIndex = nullptr;
+      QVector< QPair< QgsFeatureId, QgsRectangle > > spatialIndexEntries;
+      // Messages with a line number argument, and their line number
+      QList< QPair< QString, long > > invalidLines;
+      long extraInvalidLines = 0;
+      long recordCount = 0;
+      int maxFieldCount = 0;
+    };
+
     void scanFile( bool buildIndexes );
+    QString indexFileKey() const;
+    bool readIndexFile( QList<ScanResult> &results, const QString &key, bool buildSpatialIndex, bool buildSubsetIndex );
+    void writeIndexFile( const QList<ScanResult> &results, const QString &key, bool buildSpatialIndex, bool buildSubsetIndex ) const;
+    void scanRecords( QgsDelimitedTextFile &file, ScanResult &result, bool buildSpatialIndex, bool buildSubsetIndex ) const;
+    bool scanChunks( QList<ScanResult> &results, const ScanResult &initial, bool buildSpatialIndex, bool buildSubsetIndex );
 
     //some of these methods const, as they need to be called from const methods such as extent()
     void rescanFile() const;
     void resetCachedSubset() const;
     void resetIndexes() const;
     void clearInvalidLines() const;
-    void recordInvalidLine( const QString &message );
+    void recordInvalidLine( const QString &message, long lineNumber );
     void reportErrors( const QStringList &messages = QStringList(), bool showDialog = false ) const;
     static bool recordIsEmpty( QStringList &record );
     void setUriParameter( const QString &parameter, const QString &value );
@@ -271,6 +308,9 @@ class QgsDelimitedTextProvider : public QgsVectorDataProvider
     QgsWkbTypes::Type mWkbType = QgsWkbTypes::NoGeometry;
     QgsWkbTypes::GeometryType mGeometryType = QgsWkbTypes::UnknownGeometry;
 
+    // Index file storing the results of the scan of the file next to it
+    bool mUseIndexFile = false;
+
     // Spatial index
     bool mBuildSpatialIndex = false;
     mutable bool mUseSpatialIndex;
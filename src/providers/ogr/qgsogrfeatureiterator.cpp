@@ -27,10 +27,13 @@
 #include "qgsexception.h"
 #include "qgswkbtypes.h"
 #include "qgsogrtransaction.h"
+#include "qgsfeaturebatch.h"
 
 #include <QTextCodec>
 #include <QFile>
 
+#include <algorithm>
+
 // using from provider:
 // - setRelevantFields(), mRelevantFieldsForNextFeature
 // - ogrLayer
@@ -302,6 +305,140 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
 }
 
 
+bool QgsOgrFeatureIterator::canReadBatch() const
+{
+  switch ( mRequest.filterType() )
+  {
+    case QgsFeatureRequest::FilterNone:
+      break;
+    case QgsFeatureRequest::FilterExpression:
+      if ( !mExpressionCompiled )
+        return false;
+      break;
+    case QgsFeatureRequest::FilterFid:
+    case QgsFeatureRequest::FilterFids:
+      return false;
+  }
+
+  // everything readFeature() does on top of copying the values
+  return mRequest.orderBy().isEmpty() &&
+         !mTransform.isValid() &&
+         mSource->mOgrGeometryTypeFilter == wkbUnknown &&
+         ( mFilterRect.isNull() || !( mRequest.flags() & QgsFeatureRequest::ExactIntersect ) );
+}
+
+bool QgsOgrFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  if ( !canReadBatch() )
+    return QgsAbstractFeatureIterator::nextBatch( batch, maxFeatures );
+
+  QMutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr );
+
+  batch.clear();
+
+  if ( mClosed || !mOgrLayer )
+    return false;
+
+  batch.setFields( mSource->mFields, ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList() );
+
+  if ( mRequest.limit() >= 0 )
+    maxFeatures = static_cast< int >( std::min( static_cast< long >( maxFeatures ), mRequest.limit() - mFetchedCount ) );
+
+  // OGR field of each column, -1 for the fid
+  QVector<int> ogrFields( batch.columnCount() );
+  for ( int column = 0; column < batch.columnCount(); ++column )
+  {
+    const int attindex = batch.attributeIndex( column );
+    ogrFields[ column ] = mSource->mFirstFieldIsFid ? attindex - 1 : attindex;
+  }
+
+  const bool forceMulti = QgsWkbTypes::isMultiType( mSource->mWkbType );
+
+  gdal::ogr_feature_unique_ptr fet;
+  while ( batch.size() < maxFeatures )
+  {
+    fet.reset( OGR_L_GetNextFeature( mOgrLayer ) );
+    if ( !fet )
+    {
+      close();
+      break;
+    }
+
+    OGRGeometryH geom = mFetchGeometry ? OGR_F_GetGeometryRef( fet.get() ) : nullptr;
+    if ( !mFilterRect.isNull() )
+    {
+      if ( !geom || OGR_G_IsEmpty( geom ) )
+        continue;
+
+      OGREnvelope envelope;
+      OGR_G_GetEnvelope( geom, &envelope );
+      if ( !mFilterRect.intersects( QgsRectangle( envelope.MinX, envelope.MinY, envelope.MaxX, envelope.MaxY ) ) )
+        continue;
+    }
+
+    batch.addRow( featureId( fet.get() ) );
+
+    if ( geom )
+    {
+      unsigned char *wkb = batch.allocateGeometryWkb( OGR_G_WkbSize( geom ) );
+      QgsOgrUtils::ogrGeometryToWkb( geom, wkb );
+
+      uint32_t wkbType;
+      memcpy( &wkbType, wkb + 1, sizeof( uint32_t ) );
+      if ( forceMulti && !QgsWkbTypes::isMultiType( static_cast< QgsWkbTypes::Type >( wkbType ) ) )
+      {
+        // Insure that multipart datasets return multipart geometry
+        QgsGeometry g = batch.geometry( batch.size() - 1 );
+        g.convertToMultiType();
+        batch.setGeometry( g );
+      }
+    }
+
+    for ( int column = 0; column < batch.columnCount(); ++column )
+    {
+      const int ogrField = ogrFields.at( column );
+      if ( ogrField < 0 )
+      {
+        batch.setInt64( column, OGR_F_GetFID( fet.get() ) );
+        continue;
+      }
+
+      if ( !OGR_F_IsFieldSetAndNotNull( fet.get(), ogrField ) )
+        continue;
+
+      switch ( batch.columnType( column ) )
+      {
+        case QgsFeatureBatch::Int64Column:
+          batch.setInt64( column, OGR_F_GetFieldAsInteger64( fet.get(), ogrField ) );
+          break;
+
+        case QgsFeatureBatch::DoubleColumn:
+          batch.setDouble( column, OGR_F_GetFieldAsDouble( fet.get(), ogrField ) );
+          break;
+
+        case QgsFeatureBatch::StringColumn:
+        {
+          const char *value = OGR_F_GetFieldAsString( fet.get(), ogrField );
+          batch.setString( column, mSource->mEncoding ? mSource->mEncoding->toUnicode( value ) : QString::fromUtf8( value ) );
+          break;
+        }
+
+        case QgsFeatureBatch::VariantColumn:
+        {
+          bool ok = false;
+          const QVariant value = QgsOgrUtils::getOgrFeatureAttribute( fet.get(), mSource->mFieldsWithoutFid, ogrField, mSource->mEncoding, &ok );
+          if ( ok )
+            batch.setValue( column, value );
+          break;
+        }
+      }
+    }
+  }
+
+  mFetchedCount += batch.size();
+  return !batch.isEmpty();
+}
+
 bool QgsOgrFeatureIterator::rewind()
 {
   QMutexLocker locker( mSharedDS ? &mSharedDS->mutex() : nullptr );
@@ -384,21 +521,21 @@ void QgsOgrFeatureIterator::getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature
   f.setAttribute( attindex, value );
 }
 
-bool QgsOgrFeatureIterator::readFeature( gdal::ogr_feature_unique_ptr fet, QgsFeature &feature ) const
+QgsFeatureId QgsOgrFeatureIterator::featureId( OGRFeatureH fet ) const
 {
   if ( mOrigFidAdded )
   {
     OGRFeatureDefnH fdef = OGR_L_GetLayerDefn( mOgrLayer );
     int lastField = OGR_FD_GetFieldCount( fdef ) - 1;
     if ( lastField >= 0 )
-      feature.setId( OGR_F_GetFieldAsInteger64( fet.get(), lastField ) );
-    else
-      feature.setId( OGR_F_GetFID( fet.get() ) );
-  }
-  else
-  {
-    feature.setId( OGR_F_GetFID( fet.get() ) );
+      return OGR_F_GetFieldAsInteger64( fet, lastField );
   }
+  return OGR_F_GetFID( fet );
+}
+
+bool QgsOgrFeatureIterator::readFeature( gdal::ogr_feature_unique_ptr fet, QgsFeature &feature ) const
+{
+  feature.setId( featureId( fet.get() ) );
   feature.initAttributes( mSource->mFields.count() );
   feature.setFields( mSource->mFields ); // allow name-based attribute lookups
 
@@ -64,6 +64,7 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
 
     bool rewind() override;
     bool close() override;
+    bool nextBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
 
   protected:
     bool fetchFeature( QgsFeature &feature ) override;
@@ -73,6 +74,12 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
 
     bool readFeature( gdal::ogr_feature_unique_ptr fet, QgsFeature &feature ) const;
 
+    //! Returns the QGIS feature id of an OGR feature
+    QgsFeatureId featureId( OGRFeatureH fet ) const;
+
+    //! Returns true if batches can be read directly from the OGR layer
+    bool canReadBatch() const;
+
     //! Gets an attribute associated with a feature
     void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const;
 
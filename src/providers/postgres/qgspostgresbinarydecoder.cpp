@@ -0,0 +1,372 @@
+/***************************************************************************
+    qgspostgresbinarydecoder.cpp
+    ---------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgspostgresbinarydecoder.h"
+#include "qgsfield.h"
+
+#include <QDateTime>
+#include <QStringList>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+// type oids of the array elements which can be decoded
+static const quint32 BOOLOID = 16;
+static const quint32 INT8OID = 20;
+static const quint32 INT2OID = 21;
+static const quint32 INT4OID = 23;
+static const quint32 TEXTOID = 25;
+static const quint32 FLOAT4OID = 700;
+static const quint32 FLOAT8OID = 701;
+static const quint32 VARCHAROID = 1043;
+static const quint32 DATEOID = 1082;
+static const quint32 TIMEOID = 1083;
+static const quint32 TIMESTAMPOID = 1114;
+static const quint32 NUMERICOID = 1700;
+
+// dates and timestamps are sent relative to 2000-01-01
+static const qint64 POSTGRES_EPOCH_JDATE = 2451545;
+
+// binary values are always sent in network byte order
+template <typename T>
+static inline T readValue( const char *data )
+{
+  return qFromBigEndian<T>( reinterpret_cast< const uchar * >( data ) );
+}
+
+static QVariant::Type variantType( QgsPostgresBinaryDecoder::Format format )
+{
+  switch ( format )
+  {
+    case QgsPostgresBinaryDecoder::Bool:
+      return QVariant::Bool;
+    case QgsPostgresBinaryDecoder::Int2:
+    case QgsPostgresBinaryDecoder::Int4:
+      return QVariant::Int;
+    case QgsPostgresBinaryDecoder::Int8:
+      return QVariant::LongLong;
+    case QgsPostgresBinaryDecoder::Float4:
+    case QgsPostgresBinaryDecoder::Float8:
+    case QgsPostgresBinaryDecoder::Numeric:
+      return QVariant::Double;
+    case QgsPostgresBinaryDecoder::Date:
+      return QVariant::Date;
+    case QgsPostgresBinaryDecoder::Time:
+      return QVariant::Time;
+    case QgsPostgresBinaryDecoder::Timestamp:
+      return QVariant::DateTime;
+    case QgsPostgresBinaryDecoder::Text:
+      return QVariant::String;
+    case QgsPostgresBinaryDecoder::Array:
+    case QgsPostgresBinaryDecoder::Unsupported:
+      break;
+  }
+  return QVariant::Invalid;
+}
+
+static QgsPostgresBinaryDecoder::Format formatFromTypeName( const QString &typeName )
+{
+  if ( typeName == QLatin1String( "bool" ) )
+    return QgsPostgresBinaryDecoder::Bool;
+  else if ( typeName == QLatin1String( "int2" ) )
+    return QgsPostgresBinaryDecoder::Int2;
+  else if ( typeName == QLatin1String( "int4" ) )
+    return QgsPostgresBinaryDecoder::Int4;
+  else if ( typeName == QLatin1String( "int8" ) )
+    return QgsPostgresBinaryDecoder::Int8;
+  else if ( typeName == QLatin1String( "float4" ) )
+    return QgsPostgresBinaryDecoder::Float4;
+  else if ( typeName == QLatin1String( "float8" ) )
+    return QgsPostgresBinaryDecoder::Float8;
+  else if ( typeName == QLatin1String( "numeric" ) )
+    return QgsPostgresBinaryDecoder::Numeric;
+  else if ( typeName == QLatin1String( "date" ) )
+    return QgsPostgresBinaryDecoder::Date;
+  else if ( typeName == QLatin1String( "time" ) )
+    return QgsPostgresBinaryDecoder::Time;
+  else if ( typeName == QLatin1String( "timestamp" ) )
+    return QgsPostgresBinaryDecoder::Timestamp;
+  // not bpchar, which is fetched as text to strip the padding
+  else if ( typeName == QLatin1String( "text" ) || typeName == QLatin1String( "varchar" ) )
+    return QgsPostgresBinaryDecoder::Text;
+  return QgsPostgresBinaryDecoder::Unsupported;
+}
+
+static QgsPostgresBinaryDecoder::Format formatFromOid( quint32 oid )
+{
+  switch ( oid )
+  {
+    case BOOLOID:
+      return QgsPostgresBinaryDecoder::Bool;
+    case INT2OID:
+      return QgsPostgresBinaryDecoder::Int2;
+    case INT4OID:
+      return QgsPostgresBinaryDecoder::Int4;
+    case INT8OID:
+      return QgsPostgresBinaryDecoder::Int8;
+    case FLOAT4OID:
+      return QgsPostgresBinaryDecoder::Float4;
+    case FLOAT8OID:
+      return QgsPostgresBinaryDecoder::Float8;
+    case NUMERICOID:
+      return QgsPostgresBinaryDecoder::Numeric;
+    case DATEOID:
+      return QgsPostgresBinaryDecoder::Date;
+    case TIMEOID:
+      return QgsPostgresBinaryDecoder::Time;
+    case TIMESTAMPOID:
+      return QgsPostgresBinaryDecoder::Timestamp;
+    case TEXTOID:
+    case VARCHAROID:
+      return QgsPostgresBinaryDecoder::Text;
+  }
+  return QgsPostgresBinaryDecoder::Unsupported;
+}
+
+/**
+ * Returns the time of the day for \a usecs microseconds since midnight, rounded to
+ * milliseconds like Qt does when parsing the text representation.
+ */
+static QTime timeFromMicroseconds( qint64 usecs )
+{
+  const qint64 secs = usecs / 1000000;
+  const int msecs = std::min( static_cast< int >( std::round( ( usecs % 1000000 ) / 1000.0 ) ), 999 );
+  return QTime::fromMSecsSinceStartOfDay( static_cast< int >( secs * 1000 + msecs ) );
+}
+
+/**
+ * Returns the shortest decimal representation of a float4 \a value which reads back
+ * to the same value, as PostgreSQL prints it, so that 1.1::float4 does not become
+ * 1.100000023841858.
+ */
+static double float4ToDouble( float value )
+{
+  if ( !std::isfinite( value ) )
+    return value;
+
+  for ( int precision = 6; precision < 9; ++precision )
+  {
+    const double candidate = QByteArray::number( value, 'g', precision ).toDouble();
+    if ( static_cast< float >( candidate ) == value )
+      return candidate;
+  }
+  return QByteArray::number( value, 'g', 9 ).toDouble();
+}
+
+static QVariant numericToVariant( const char *data, int length )
+{
+  if ( length < 8 )
+    return QVariant( QVariant::Double );
+
+  const int ndigits = readValue<qint16>( data );
+  const int weight = readValue<qint16>( data + 2 );
+  const quint16 sign = readValue<quint16>( data + 4 );
+  if ( ndigits < 0 || length < 8 + 2 * ndigits )
+    return QVariant( QVariant::Double );
+
+  if ( sign == 0xC000 )
+    return std::numeric_limits<double>::quiet_NaN();
+
+  // the value is the sum of digit[i] * 10000^(weight - i), written as base 10 digits
+  // with an exponent, so that it is rounded to a double like its text representation
+  QByteArray text;
+  text.reserve( 4 * ndigits + 8 );
+  if ( sign == 0x4000 )
+    text += '-';
+  text += '0';
+  for ( int i = 0; i < ndigits; ++i )
+  {
+    const int digit = readValue<qint16>( data + 8 + 2 * i );
+    char group[5];
+    std::snprintf( group, sizeof( group ), "%04d", digit );
+    text.append( group, 4 );
+  }
+  text += 'e';
+  text += QByteArray::number( 4 * ( weight - ndigits + 1 ) );
+  return text.toDouble();
+}
+
+QgsPostgresBinaryDecoder::Format QgsPostgresBinaryDecoder::format( const QgsField &field )
+{
+  const QString typeName = field.typeName();
+  if ( typeName.startsWith( '_' ) )
+  {
+    const Format elementFormat = formatFromTypeName( typeName.mid( 1 ) );
+    const QVariant::Type listType = elementFormat == Text ? QVariant::StringList : QVariant::List;
+    if ( elementFormat == Unsupported || field.type() != listType || field.subType() != variantType( elementFormat ) )
+      return Unsupported;
+    return Array;
+  }
+
+  const Format format = formatFromTypeName( typeName );
+  // field types can be overridden, e.g. for domains
+  if ( format == Unsupported || field.type() != variantType( format ) )
+    return Unsupported;
+  return format;
+}
+
+QVariant QgsPostgresBinaryDecoder::decode( Format format, const QgsField &field, const char *data, int length )
+{
+  if ( format == Array )
+    return decodeArray( field, data, length );
+
+  return decodeValue( format, field.type(), data, length );
+}
+
+QVariant QgsPostgresBinaryDecoder::decodeValue( Format format, QVariant::Type type, const char *data, int length )
+{
+  switch ( format )
+  {
+    case Bool:
+      if ( length == 1 )
+        return *data != 0;
+      break;
+
+    case Int2:
+      if ( length == 2 )
+        return static_cast< int >( readValue<qint16>( data ) );
+      break;
+
+    case Int4:
+      if ( length == 4 )
+        return static_cast< int >( readValue<qint32>( data ) );
+      break;
+
+    case Int8:
+      if ( length == 8 )
+        return static_cast< qlonglong >( readValue<qint64>( data ) );
+      break;
+
+    case Float4:
+      if ( length == 4 )
+      {
+        const quint32 bits = readValue<quint32>( data );
+        float value;
+        std::memcpy( &value, &bits, sizeof( value ) );
+        return float4ToDouble( value );
+      }
+      break;
+
+    case Float8:
+      if ( length == 8 )
+      {
+        const quint64 bits = readValue<quint64>( data );
+        double value;
+        std::memcpy( &value, &bits, sizeof( value ) );
+        return value;
+      }
+      break;
+
+    case Numeric:
+      return numericToVariant( data, length );
+
+    case Date:
+      if ( length == 4 )
+      {
+        const qint32 days = readValue<qint32>( data );
+        // +/-infinity have no QDate equivalent
+        if ( days == std::numeric_limits<qint32>::min() || days == std::numeric_limits<qint32>::max() )
+          break;
+        return QDate::fromJulianDay( POSTGRES_EPOCH_JDATE + days );
+      }
+      break;
+
+    case Time:
+      if ( length == 8 )
+        return timeFromMicroseconds( readValue<qint64>( data ) );
+      break;
+
+    case Timestamp:
+      if ( length == 8 )
+      {
+        const qint64 usecs = readValue<qint64>( data );
+        if ( usecs == std::numeric_limits<qint64>::min() || usecs == std::numeric_limits<qint64>::max() )
+          break;
+
+        const qint64 usecsPerDay = 86400LL * 1000000;
+        qint64 days = usecs / usecsPerDay;
+        qint64 usecsOfDay = usecs % usecsPerDay;
+        if ( usecsOfDay < 0 )
+        {
+          days--;
+          usecsOfDay += usecsPerDay;
+        }
+        return QDateTime( QDate::fromJulianDay( POSTGRES_EPOCH_JDATE + days ), timeFromMicroseconds( usecsOfDay ) );
+      }
+      break;
+
+    case Text:
+      return QString::fromUtf8( data, length );
+
+    case Array:
+    case Unsupported:
+      break;
+  }
+
+  return QVariant( type );
+}
+
+QVariant QgsPostgresBinaryDecoder::decodeArray( const QgsField &field, const char *data, int length )
+{
+  const bool stringList = field.type() == QVariant::StringList;
+  if ( length < 12 )
+    return QVariant( field.type() );
+
+  const qint32 dimensions = readValue<qint32>( data );
+  const Format elementFormat = formatFromOid( readValue<quint32>( data + 8 ) );
+  if ( dimensions < 0 || elementFormat == Unsupported || length < 12 + 8 * dimensions )
+    return QVariant( field.type() );
+
+  // multi dimensional arrays are flattened
+  qint64 count = dimensions > 0 ? 1 : 0;
+  for ( int i = 0; i < dimensions; ++i )
+    count *= readValue<qint32>( data + 12 + 8 * i );
+
+  QStringList strings;
+  QVariantList values;
+  const char *end = data + length;
+  const char *p = data + 12 + 8 * dimensions;
+  for ( qint64 i = 0; i < count; ++i )
+  {
+    if ( end - p < 4 )
+      return QVariant( field.type() );
+    const qint32 elementLength = readValue<qint32>( p );
+    p += 4;
+
+    QVariant value;
+    if ( elementLength < 0 )
+    {
+      value = QVariant( field.subType() );
+    }
+    else
+    {
+      if ( end - p < elementLength )
+        return QVariant( field.type() );
+      value = decodeValue( elementFormat, field.subType(), p, elementLength );
+      p += elementLength;
+    }
+
+    if ( stringList )
+      strings << value.toString();
+    else
+      values << value;
+  }
+
+  if ( stringList )
+    return strings;
+  return values;
+}
@@ -0,0 +1,69 @@
+/***************************************************************************
+    qgspostgresbinarydecoder.h
+    ---------------------
+    begin                : October 2018
+    copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSPOSTGRESBINARYDECODER_H
+#define QGSPOSTGRESBINARYDECODER_H
+
+#include <QVariant>
+
+class QgsField;
+
+/**
+ * Decodes attribute values which were fetched from a binary cursor in their
+ * binary send format, without going through their text representation.
+ *
+ * Values are decoded to the same QVariant as QgsPostgresProvider::convertValue()
+ * returns for their text representation.
+ */
+class QgsPostgresBinaryDecoder
+{
+  public:
+
+    //! Binary formats which can be decoded
+    enum Format
+    {
+      Unsupported, //!< Value must be fetched as text
+      Bool,
+      Int2,
+      Int4,
+      Int8,
+      Float4,
+      Float8,
+      Numeric,
+      Date,
+      Time,
+      Timestamp,
+      Text,
+      Array, //!< One dimensional array of any of the other formats
+    };
+
+    /**
+     * Returns the binary format of the values of \a field, or Unsupported if
+     * the values must be fetched as text.
+     */
+    static Format format( const QgsField &field );
+
+    /**
+     * Decodes the \a length bytes at \a data, holding a non null value of
+     * \a field in the binary \a format.
+     */
+    static QVariant decode( Format format, const QgsField &field, const char *data, int length );
+
+  private:
+
+    static QVariant decodeValue( Format format, QVariant::Type type, const char *data, int length );
+    static QVariant decodeArray( const QgsField &field, const char *data, int length );
+};
+
+#endif // QGSPOSTGRESBINARYDECODER_H
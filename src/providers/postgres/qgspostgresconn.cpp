@@ -1069,7 +1069,7 @@ PGresult *QgsPostgresConn::PQexec( const QString &query, bool logError ) const
   if ( res )
   {
     int errorStatus = PQresultStatus( res );
-    if ( errorStatus != PGRES_COMMAND_OK && errorStatus != PGRES_TUPLES_OK )
+    if ( errorStatus != PGRES_COMMAND_OK && errorStatus != PGRES_TUPLES_OK && errorStatus != PGRES_COPY_IN )
     {
       if ( logError )
       {
@@ -1219,6 +1219,18 @@ PGresult *QgsPostgresConn::PQexecPrepared( const QString &stmtName, const QStrin
   return res;
 }
 
+int QgsPostgresConn::PQputCopyData( const QByteArray &data )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyData( mConn, data.constData(), data.size() );
+}
+
+int QgsPostgresConn::PQputCopyEnd()
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyEnd( mConn, nullptr );
+}
+
 void QgsPostgresConn::PQfinish()
 {
   Q_ASSERT( mConn );
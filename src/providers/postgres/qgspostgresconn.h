@@ -253,6 +253,8 @@ class QgsPostgresConn : public QObject
     PGresult *PQgetResult();
     PGresult *PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes );
     PGresult *PQexecPrepared( const QString &stmtName, const QStringList &params );
+    int PQputCopyData( const QByteArray &data );
+    int PQputCopyEnd();
 
     bool begin();
     bool commit();
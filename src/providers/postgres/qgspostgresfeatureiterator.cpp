@@ -13,6 +13,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsgeometry.h"
+#include "qgspostgresbinarydecoder.h"
 #include "qgspostgresconnpool.h"
 #include "qgspostgresexpressioncompiler.h"
 #include "qgspostgresfeatureiterator.h"
@@ -25,6 +26,7 @@
 
 #include <QElapsedTimer>
 #include <QObject>
+#include <algorithm>
 
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
@@ -69,6 +71,19 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
     return;
   }
 
+  QgsSettings settings;
+  mFeatureQueueSize = std::max( 1, settings.value( QStringLiteral( "PostgreSQL/featureQueueSize" ), mFeatureQueueSize, QgsSettings::Providers ).toInt() );
+  // a transaction connection is shared, it cannot be left with a query in flight between two calls
+  mPrefetch = !mIsTransactionConnection && settings.value( QStringLiteral( "PostgreSQL/prefetchFeatures" ), true, QgsSettings::Providers ).toBool();
+
+  // attributes of the types which can be decoded are fetched in their binary format instead of text
+  mAttributeFormats.fill( QgsPostgresBinaryDecoder::Unsupported, mSource->mFields.count() );
+  if ( settings.value( QStringLiteral( "PostgreSQL/binaryAttributes" ), true, QgsSettings::Providers ).toBool() )
+  {
+    for ( int idx = 0; idx < mSource->mFields.count(); ++idx )
+      mAttributeFormats[idx] = QgsPostgresBinaryDecoder::format( mSource->mFields.at( idx ) );
+  }
+
   mCursorName = mConn->uniqueCursorName();
   QString whereClause;
 
@@ -258,34 +273,37 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     timer.start();
 #endif
 
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
-
     lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
+    if ( !mFetchInFlight )
+      sendFetch();
 
+    // read all results, so that the connection is ready for the next query
     QgsPostgresResult queryResult;
     for ( ;; )
     {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
+      PGresult *result = mConn->PQgetResult();
+      if ( !result )
         break;
 
+      // takes ownership of the result
+      queryResult = result;
       if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
       {
         QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
+        queryResult = nullptr;
       }
+    }
+    mFetchInFlight = false;
 
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
-
+    int rows = queryResult.result() ? queryResult.PQntuples() : 0;
+    if ( rows > 0 )
+    {
       mLastFetch = rows < mFeatureQueueSize;
 
+      // keep the next fetch in flight while this batch is decoded and consumed
+      if ( mPrefetch && !mLastFetch )
+        sendFetch();
+
       for ( int row = 0; row < rows; row++ )
       {
         mFeatureQueue.enqueue( QgsFeature() );
@@ -367,6 +385,34 @@ bool QgsPostgresFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::
   return mOrderByCompiled;
 }
 
+void QgsPostgresFeatureIterator::sendFetch()
+{
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
+  QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    return;
+  }
+  mFetchInFlight = true;
+}
+
+void QgsPostgresFeatureIterator::discardPendingFetch()
+{
+  if ( !mFetchInFlight )
+    return;
+
+  // the connection cannot be used for anything else until all results were read
+  QgsPostgresResult result;
+  do
+  {
+    result = mConn->PQgetResult();
+  }
+  while ( result.result() );
+  mFetchInFlight = false;
+}
+
 void QgsPostgresFeatureIterator::lock()
 {
   if ( mIsTransactionConnection )
@@ -387,6 +433,7 @@ bool QgsPostgresFeatureIterator::rewind()
   // move cursor to first record
 
   lock();
+  discardPendingFetch();
   mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
   unlock();
   mFeatureQueue.clear();
@@ -402,6 +449,7 @@ bool QgsPostgresFeatureIterator::close()
     return false;
 
   lock();
+  discardPendingFetch();
   mConn->closeCursor( mCursorName );
   unlock();
 
@@ -637,7 +685,11 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    const QgsField fld = mSource->mFields.at( idx );
+    if ( mAttributeFormats.at( idx ) != QgsPostgresBinaryDecoder::Unsupported )
+      query += delim + QgsPostgresConn::quotedIdentifier( fld.name() );
+    else
+      query += delim + mConn->fieldExpression( fld );
   }
 
   query += " FROM " + mSource->mQuery;
@@ -814,7 +866,14 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
     return;
 
   const QgsField fld = mSource->mFields.at( idx );
-  QVariant v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+  const QgsPostgresBinaryDecoder::Format format = mAttributeFormats.at( idx );
+  QVariant v;
+  if ( format == QgsPostgresBinaryDecoder::Unsupported )
+    v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+  else if ( queryResult.PQgetisnull( row, col ) )
+    v = QVariant( fld.type() );
+  else
+    v = QgsPostgresBinaryDecoder::decode( format, fld, ::PQgetvalue( queryResult.result(), row, col ), ::PQgetlength( queryResult.result(), row, col ) );
   feature.setAttribute( idx, v );
 
   col++;
@@ -20,6 +20,7 @@
 #include <QQueue>
 
 #include "qgspostgresprovider.h"
+#include "qgspostgresbinarydecoder.h"
 
 class QgsPostgresProvider;
 class QgsPostgresResult;
@@ -93,6 +94,12 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
+    //! Sends the query fetching the next batch of features, without waiting for its result
+    void sendFetch();
+
+    //! Reads and drops the result of a fetch which was sent but not used
+    void discardPendingFetch();
+
     QString mCursorName;
 
     /**
@@ -104,6 +111,18 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     //! Maximal size of the feature queue
     int mFeatureQueueSize = 2000;
 
+    /**
+     * Sets to true, if the next batch of features is fetched while the current
+     * batch is decoded and consumed
+     */
+    bool mPrefetch = false;
+
+    //! Sets to true, if a fetch was sent and its result not read yet
+    bool mFetchInFlight = false;
+
+    //! Binary formats of the attributes which are not fetched as text, by field index
+    QVector<QgsPostgresBinaryDecoder::Format> mAttributeFormats;
+
     //! Number of retrieved features
     int mFetched = 0;
 
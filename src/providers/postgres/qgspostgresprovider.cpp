@@ -28,6 +28,7 @@
 #include "qgsvectorlayer.h"
 
 #include <QMessageBox>
+#include <QtEndian>
 
 #include "qgsvectorlayerexporter.h"
 #include "qgspostgresprovider.h"
@@ -2011,6 +2012,22 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   {
     conn->begin();
 
+    // Large batches which do not need the inserted keys back are loaded with COPY,
+    // which avoids a round trip to the server for every feature
+    const int copyThreshold = QgsSettings().value( QStringLiteral( "PostgreSQL/copyThreshold" ), 1000, QgsSettings::Providers ).toInt();
+    if ( ( flags & QgsFeatureSink::FastInsert ) && copyThreshold > 0 && flist.size() >= copyThreshold &&
+         ( mSpatialColType == SctNone || mSpatialColType == SctGeometry || mSpatialColType == SctGeography ) &&
+         copyFeatures( conn, flist ) )
+    {
+      returnvalue &= conn->commit();
+      if ( mTransaction )
+        mTransaction->dirtyLastSavePoint();
+
+      mShared->addFeaturesCounted( flist.size() );
+      conn->unlock();
+      return returnvalue;
+    }
+
     // Prepare the INSERT statement
     QString insert = QStringLiteral( "INSERT INTO %1(" ).arg( mQuery );
     QString values = QStringLiteral( ") VALUES (" );
@@ -2751,6 +2768,206 @@ void QgsPostgresProvider::appendGeomParam( const QgsGeometry &geom, QStringList
   params << param;
 }
 
+// size of the chunks of data sent to the server during a COPY
+static const int COPY_CHUNK_SIZE = 1024 * 1024;
+
+// returns wkb as EWKB with the SRID in its header. Unlike the "SRID=n;" prefix of
+// hex EWKB, the geography input function accepts this form too.
+static QByteArray ewkbWithSrid( const QByteArray &wkb, quint32 srid )
+{
+  if ( wkb.size() < 5 )
+    return wkb;
+
+  const bool littleEndian = wkb.at( 0 ) == 1;
+  const uchar *typePtr = reinterpret_cast< const uchar * >( wkb.constData() + 1 );
+  const quint32 type = ( littleEndian ? qFromLittleEndian<quint32>( typePtr ) : qFromBigEndian<quint32>( typePtr ) ) | 0x20000000;
+
+  QByteArray ewkb( wkb.size() + 4, Qt::Uninitialized );
+  uchar *ptr = reinterpret_cast< uchar * >( ewkb.data() );
+  ptr[0] = wkb.at( 0 );
+  if ( littleEndian )
+  {
+    qToLittleEndian<quint32>( type, ptr + 1 );
+    qToLittleEndian<quint32>( srid, ptr + 5 );
+  }
+  else
+  {
+    qToBigEndian<quint32>( type, ptr + 1 );
+    qToBigEndian<quint32>( srid, ptr + 5 );
+  }
+  memcpy( ptr + 9, wkb.constData() + 5, wkb.size() - 5 );
+  return ewkb;
+}
+
+// appends value to a row of a text format COPY
+static void appendCopyValue( QByteArray &row, const QString &value )
+{
+  if ( value.isNull() )
+  {
+    row += "\\N";
+    return;
+  }
+
+  const QByteArray utf8 = value.toUtf8();
+  for ( const char c : utf8 )
+  {
+    switch ( c )
+    {
+      case '\\':
+        row += "\\\\";
+        break;
+      case '\t':
+        row += "\\t";
+        break;
+      case '\n':
+        row += "\\n";
+        break;
+      case '\r':
+        row += "\\r";
+        break;
+      default:
+        row += c;
+    }
+  }
+}
+
+bool QgsPostgresProvider::copyFeatures( QgsPostgresConn *conn, const QgsFeatureList &flist )
+{
+  if ( connectionRO()->majorVersion() < 2 )
+    return false;
+
+  // A value is replaced by the column default when it is null or equal to the default
+  // clause, like paramValue() does for INSERT. COPY can only do this by leaving the
+  // column out, so it must apply to all or none of the features.
+  enum ColumnUse
+  {
+    Unused,
+    Defaulted,
+    Copied,
+  };
+
+  QVector<ColumnUse> columnUse( mAttributeFields.count(), Unused );
+  QStringList defaultValues;
+  defaultValues.reserve( mAttributeFields.count() );
+  for ( int idx = 0; idx < mAttributeFields.count(); ++idx )
+    defaultValues << defaultValueClause( idx );
+
+  for ( const QgsFeature &feature : flist )
+  {
+    const QgsAttributes attrs = feature.attributes();
+    for ( int idx = 0; idx < mAttributeFields.count(); ++idx )
+    {
+      const QString fieldName = mAttributeFields.at( idx ).name();
+      if ( fieldName.isEmpty() || fieldName == mGeometryColumn )
+        continue;
+
+      const QVariant value = attrs.value( idx, QVariant( QVariant::Int ) );
+      const QString &defVal = defaultValues.at( idx );
+      const bool defaulted = !defVal.isNull() && ( value.isNull() || value.toString() == defVal );
+      const ColumnUse use = defaulted ? Defaulted : Copied;
+
+      if ( columnUse[idx] == Unused )
+        columnUse[idx] = use;
+      else if ( columnUse[idx] != use )
+        return false;
+    }
+  }
+
+  QStringList columns;
+  QList<int> fieldId;
+  if ( !mGeometryColumn.isNull() )
+    columns << quotedIdentifier( mGeometryColumn );
+
+  for ( int idx = 0; idx < mAttributeFields.count(); ++idx )
+  {
+    if ( columnUse.at( idx ) != Copied )
+      continue;
+
+    columns << quotedIdentifier( mAttributeFields.at( idx ).name() );
+    fieldId << idx;
+  }
+
+  if ( columns.isEmpty() )
+    return false;
+
+  QString copy = QStringLiteral( "COPY %1(%2) FROM STDIN" ).arg( mQuery, columns.join( ',' ) );
+  QgsDebugMsg( QString( "copy addfeatures: %1" ).arg( copy ) );
+
+  QgsPostgresResult result( conn->PQexec( copy ) );
+  if ( result.PQresultStatus() != PGRES_COPY_IN )
+    throw PGException( result );
+
+  // geometries are sent as hex EWKB, which the geometry and geography input functions accept
+  const QString sridString = mRequestedSrid.isEmpty() ? mDetectedSrid : mRequestedSrid;
+  bool hasSrid = false;
+  const quint32 srid = sridString.toUInt( &hasSrid );
+
+  QByteArray data;
+  data.reserve( COPY_CHUNK_SIZE + COPY_CHUNK_SIZE / 4 );
+  bool sent = true;
+  for ( const QgsFeature &feature : flist )
+  {
+    bool firstColumn = true;
+    if ( !mGeometryColumn.isNull() )
+    {
+      const QgsGeometry geom = feature.geometry();
+      if ( geom.isNull() )
+      {
+        data += "\\N";
+      }
+      else
+      {
+        const QgsGeometry convertedGeom( convertToProviderType( geom ) );
+        const QByteArray wkb = convertedGeom ? convertedGeom.asWkb() : geom.asWkb();
+        data += ( hasSrid ? ewkbWithSrid( wkb, srid ) : wkb ).toHex();
+      }
+      firstColumn = false;
+    }
+
+    const QgsAttributes attrs = feature.attributes();
+    for ( int idx : qgis::as_const( fieldId ) )
+    {
+      const QVariant value = attrs.value( idx, QVariant( QVariant::Int ) );
+      if ( !firstColumn )
+        data += '\t';
+      appendCopyValue( data, value.isNull() ? QString() : value.toString() );
+      firstColumn = false;
+    }
+    data += '\n';
+
+    if ( data.size() >= COPY_CHUNK_SIZE )
+    {
+      sent = conn->PQputCopyData( data ) == 1;
+      data.truncate( 0 );
+      if ( !sent )
+        break;
+    }
+  }
+
+  if ( sent && !data.isEmpty() )
+    sent = conn->PQputCopyData( data ) == 1;
+  conn->PQputCopyEnd();
+
+  // the outcome of the COPY, including failures to send the data, is reported
+  // once the server has processed all of it
+  QgsPostgresResult copyResult;
+  while ( PGresult *res = conn->PQgetResult() )
+  {
+    if ( copyResult.result() && copyResult.PQresultStatus() != PGRES_COMMAND_OK )
+    {
+      // keep the first error
+      ::PQclear( res );
+      continue;
+    }
+    copyResult = res;
+  }
+
+  if ( copyResult.PQresultStatus() != PGRES_COMMAND_OK )
+    throw PGException( copyResult );
+
+  return true;
+}
+
 bool QgsPostgresProvider::changeGeometryValues( const QgsGeometryMap &geometry_map )
 {
 
@@ -434,6 +434,14 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     QgsVectorDataProvider::Capabilities mEnabledCapabilities = nullptr;
 
     void appendGeomParam( const QgsGeometry &geom, QStringList &param ) const;
+
+    /**
+     * Inserts the features of \a flist with a single COPY ... FROM STDIN statement.
+     * Returns false without sending anything when the features cannot be copied,
+     * e.g. when a column mixes explicit values with values which must be replaced
+     * by the column default. Throws PGException if the COPY fails.
+     */
+    bool copyFeatures( QgsPostgresConn *conn, const QgsFeatureList &flist );
     void appendPkParams( QgsFeatureId fid, QStringList &param ) const;
 
     QString paramValue( const QString &fieldvalue, const QString &defaultValue ) const;
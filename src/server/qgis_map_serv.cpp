@@ -21,11 +21,20 @@
 #include "qgsserver.h"
 #include "qgslogger.h"
 #include "qgsserverlogger.h"
+#include "qgsserversettings.h"
 #include "qgsfcgiserverresponse.h"
 #include "qgsfcgiserverrequest.h"
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+#include "qgsserverplugins.h"
+#endif
+
+#include <QMutex>
+#include <QThread>
 
 #include <fcgi_stdio.h>
 #include <cstdlib>
+#include <memory>
+#include <vector>
 
 int fcgi_accept()
 {
@@ -39,6 +48,54 @@ int fcgi_accept()
 #endif
 }
 
+/**
+ * Accepts and handles FCGI requests in its own thread, see QgsServerSettings::workerThreads()
+ */
+class QgsFcgiWorker : public QThread
+{
+  public:
+    explicit QgsFcgiWorker( QgsServer &server )
+      : mServer( server )
+    {}
+
+  protected:
+    void run() override
+    {
+      static QMutex sAcceptMutex;
+
+      FCGX_Request fcgiRequest;
+      FCGX_InitRequest( &fcgiRequest, 0, 0 );
+      while ( true )
+      {
+        int rc = 0;
+        {
+          // some platforms don't support concurrent accept() on the same socket
+          QMutexLocker locker( &sAcceptMutex );
+          rc = FCGX_Accept_r( &fcgiRequest );
+        }
+        if ( rc < 0 )
+        {
+          break;
+        }
+
+        QgsFcgiServerRequest request( &fcgiRequest );
+        QgsFcgiServerResponse response( request.method(), &fcgiRequest );
+        if ( ! request.hasError() )
+        {
+          mServer.handleRequest( request, response );
+        }
+        else
+        {
+          response.sendError( 400, "Bad request" );
+        }
+        FCGX_Finish_r( &fcgiRequest );
+      }
+    }
+
+  private:
+    QgsServer &mServer;
+};
+
 int main( int argc, char *argv[] )
 {
   // Test if the environ variable DISPLAY is defined
@@ -61,9 +118,51 @@ int main( int argc, char *argv[] )
   // since version 3.0 QgsServer now needs a qApp so initialize QgsApplication
   QgsApplication app( argc, argv, withDisplay, QString(), QStringLiteral( "server" ) );
   QgsServer server;
+
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   server.initPython();
 #endif
+
+  QgsServerSettings settings;
+  settings.load();
+  int workerThreads = settings.workerThreads();
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+  // python plugins, e.g. access control filters, are not thread safe: they would
+  // not be applied to the requests handled by the worker threads
+  if ( workerThreads > 1 && !QgsServerPlugins::serverPlugins().isEmpty() )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "QGIS_SERVER_WORKER_THREADS is ignored because server python plugins are loaded, requests are handled serially" ), QStringLiteral( "Server" ), Qgis::Critical );
+    workerThreads = 1;
+  }
+#endif
+  if ( workerThreads > 1 && !FCGX_IsCGI() )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Handling requests with %1 worker threads" ).arg( workerThreads ), QStringLiteral( "Server" ), Qgis::Info );
+
+    FCGX_Init();
+    std::vector< std::unique_ptr<QgsFcgiWorker> > workers;
+    int running = workerThreads;
+    for ( int i = 0; i < workerThreads; ++i )
+    {
+      workers.emplace_back( new QgsFcgiWorker( server ) );
+      QObject::connect( workers.back().get(), &QThread::finished, &app, [&running]
+      {
+        if ( --running == 0 )
+          QCoreApplication::quit();
+      } );
+      workers.back()->start();
+    }
+
+    // The main thread processes the events of the caches and of the logger
+    app.exec();
+    for ( const std::unique_ptr<QgsFcgiWorker> &worker : workers )
+    {
+      worker->wait();
+    }
+    app.exitQgis();
+    return 0;
+  }
+
   // Starts FCGI loop
   while ( fcgi_accept() >= 0 )
   {
@@ -18,6 +18,8 @@
 #include "qgscapabilitiescache.h"
 #include "qgslogger.h"
 #include <QCoreApplication>
+#include <QMutexLocker>
+#include <QThread>
 
 QgsCapabilitiesCache::QgsCapabilitiesCache()
 {
@@ -26,8 +28,12 @@ QgsCapabilitiesCache::QgsCapabilitiesCache()
 
 const QDomDocument *QgsCapabilitiesCache::searchCapabilitiesDocument( const QString &configFilePath, const QString &key )
 {
-  QCoreApplication::processEvents(); //get updates from file system watcher
+  if ( QThread::currentThread() == thread() )
+  {
+    QCoreApplication::processEvents(); //get updates from file system watcher
+  }
 
+  QMutexLocker locker( &mMutex );
   if ( mCachedCapabilities.contains( configFilePath ) && mCachedCapabilities[ configFilePath ].contains( key ) )
   {
     return &mCachedCapabilities[ configFilePath ][ key ];
@@ -38,19 +44,36 @@ const QDomDocument *QgsCapabilitiesCache::searchCapabilitiesDocument( const QStr
   }
 }
 
+QDomDocument QgsCapabilitiesCache::capabilitiesDocument( const QString &configFilePath, const QString &key )
+{
+  if ( QThread::currentThread() == thread() )
+  {
+    QCoreApplication::processEvents(); //get updates from file system watcher
+  }
+
+  QMutexLocker locker( &mMutex );
+  if ( mCachedCapabilities.contains( configFilePath ) && mCachedCapabilities[ configFilePath ].contains( key ) )
+  {
+    // deep copy, DOM documents are not thread safe even if implicitly shared
+    return mCachedCapabilities[ configFilePath ][ key ].cloneNode().toDocument();
+  }
+  return QDomDocument();
+}
+
 void QgsCapabilitiesCache::insertCapabilitiesDocument( const QString &configFilePath, const QString &key, const QDomDocument *doc )
 {
+  QMutexLocker locker( &mMutex );
   if ( mCachedCapabilities.size() > 40 )
   {
     //remove another cache entry to avoid memory problems
     QHash<QString, QHash<QString, QDomDocument> >::iterator capIt = mCachedCapabilities.begin();
-    mFileSystemWatcher.removePath( capIt.key() );
+    watchPath( capIt.key(), false );
     mCachedCapabilities.erase( capIt );
   }
 
   if ( !mCachedCapabilities.contains( configFilePath ) )
   {
-    mFileSystemWatcher.addPath( configFilePath );
+    watchPath( configFilePath, true );
     mCachedCapabilities.insert( configFilePath, QHash<QString, QDomDocument>() );
   }
 
@@ -59,13 +82,32 @@ void QgsCapabilitiesCache::insertCapabilitiesDocument( const QString &configFile
 
 void QgsCapabilitiesCache::removeCapabilitiesDocument( const QString &path )
 {
+  QMutexLocker locker( &mMutex );
   mCachedCapabilities.remove( path );
-  mFileSystemWatcher.removePath( path );
+  watchPath( path, false );
 }
 
 void QgsCapabilitiesCache::removeChangedEntry( const QString &path )
 {
   QgsDebugMsg( "Remove capabilities cache entry because file changed" );
+  QMutexLocker locker( &mMutex );
   mCachedCapabilities.remove( path );
   mFileSystemWatcher.removePath( path );
 }
+
+void QgsCapabilitiesCache::watchPath( const QString &path, bool watch )
+{
+  if ( QThread::currentThread() != thread() )
+  {
+    // the watcher belongs to the thread of the cache
+    QMetaObject::invokeMethod( this, "watchPath", Qt::QueuedConnection, Q_ARG( QString, path ), Q_ARG( bool, watch ) );
+  }
+  else if ( watch )
+  {
+    mFileSystemWatcher.addPath( path );
+  }
+  else
+  {
+    mFileSystemWatcher.removePath( path );
+  }
+}
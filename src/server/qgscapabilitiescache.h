@@ -21,6 +21,7 @@
 #include <QDomDocument>
 #include <QFileSystemWatcher>
 #include <QHash>
+#include <QMutex>
 #include <QObject>
 #include "qgis_server.h"
 
@@ -41,6 +42,16 @@ class SERVER_EXPORT QgsCapabilitiesCache : public QObject
      */
     const QDomDocument *searchCapabilitiesDocument( const QString &configFilePath, const QString &key );
 
+    /**
+     * Returns a copy of the cached capabilities document (or a null document if document for
+     * configuration file not in cache). Unlike searchCapabilitiesDocument(), it is safe
+     * to use when the requests are handled by several threads.
+     * \param configFilePath the project file path
+     * \param key key used to separate different version in different cache
+     * \since QGIS 3.4
+     */
+    QDomDocument capabilitiesDocument( const QString &configFilePath, const QString &key );
+
     /**
      * Inserts new capabilities document (creates a copy of the document, does not take ownership)
      * \param configFilePath the project file path
@@ -59,10 +70,14 @@ class SERVER_EXPORT QgsCapabilitiesCache : public QObject
   private:
     QHash< QString, QHash< QString, QDomDocument > > mCachedCapabilities;
     QFileSystemWatcher mFileSystemWatcher;
+    QMutex mMutex;
 
   private slots:
     //! Removes changed entry from this cache
     void removeChangedEntry( const QString &path );
+
+    //! Adds or removes a watched file, in the thread of the cache
+    void watchPath( const QString &path, bool watch );
 };
 
 #endif // QGSCAPABILITIESCACHE_H
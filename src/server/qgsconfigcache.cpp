@@ -21,6 +21,8 @@
 #include "qgsproject.h"
 
 #include <QFile>
+#include <QMutexLocker>
+#include <QThread>
 
 QgsConfigCache *QgsConfigCache::instance()
 {
@@ -39,6 +41,11 @@ QgsConfigCache::QgsConfigCache()
 
 const QgsProject *QgsConfigCache::project( const QString &path )
 {
+  if ( QThread::currentThread() != thread() )
+  {
+    return threadProject( path );
+  }
+
   if ( ! mProjectCache[ path ] )
   {
     std::unique_ptr<QgsProject> prj( new QgsProject() );
@@ -52,6 +59,58 @@ const QgsProject *QgsConfigCache::project( const QString &path )
   return mProjectCache[ path ];
 }
 
+const QgsProject *QgsConfigCache::threadProject( const QString &path )
+{
+  if ( !mThreadProjectCaches.hasLocalData() )
+  {
+    // deleted with the thread, and the projects with it
+    mThreadProjectCaches.setLocalData( new QCache<QString, ThreadProject>( mProjectCache.maxCost() ) );
+  }
+  QCache<QString, ThreadProject> *cache = mThreadProjectCaches.localData();
+
+  int version = 0;
+  {
+    QMutexLocker locker( &mProjectVersionsMutex );
+    version = mProjectVersions.value( path );
+  }
+
+  ThreadProject *entry = cache->object( path );
+  if ( entry && entry->version != version )
+  {
+    cache->remove( path );
+    entry = nullptr;
+  }
+
+  if ( !entry )
+  {
+    std::unique_ptr<QgsProject> prj( new QgsProject() );
+    if ( !prj->read( path ) )
+    {
+      QgsProject::setThreadInstance( nullptr );
+      return nullptr;
+    }
+    entry = new ThreadProject();
+    entry->project = std::move( prj );
+    entry->version = version;
+    cache->insert( path, entry );
+
+    // the watcher belongs to the thread of the cache
+    QMetaObject::invokeMethod( this, "watchPath", Qt::QueuedConnection, Q_ARG( QString, path ) );
+  }
+
+  // expressions and scopes which refer to QgsProject::instance() must see the project of the request
+  QgsProject::setThreadInstance( entry->project.get() );
+  return entry->project.get();
+}
+
+void QgsConfigCache::watchPath( const QString &path )
+{
+  if ( !mFileSystemWatcher.files().contains( path ) )
+  {
+    mFileSystemWatcher.addPath( path );
+  }
+}
+
 QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
 {
   //first open file
@@ -93,12 +152,19 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
 
 void QgsConfigCache::removeChangedEntry( const QString &path )
 {
+  {
+    QMutexLocker locker( &mProjectVersionsMutex );
+    ++mProjectVersions[ path ];
+  }
+
   mProjectCache.remove( path );
 
   //xml document must be removed last, as other config cache destructors may require it
   mXmlDocumentCache.remove( path );
 
   mFileSystemWatcher.removePath( path );
+
+  emit projectRemovedFromCache( path );
 }
 
 
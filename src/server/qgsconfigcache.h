@@ -22,9 +22,12 @@
 
 #include <QCache>
 #include <QFileSystemWatcher>
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QObject>
 #include <QDomDocument>
+#include <QThreadStorage>
 
 #include "qgis_server.h"
 #include "qgis_sip.h"
@@ -54,12 +57,25 @@ class SERVER_EXPORT QgsConfigCache : public QObject
     /**
      * If the project is not cached yet, then the project is read thanks to the
      * path. If the project is not available, then a nullptr is returned.
+     *
+     * Projects are not shared between threads: when called from another thread
+     * than the one of the cache, the project is read and cached for that thread
+     * only, and it is only valid in that thread.
      * \param path the filename of the QGIS project
      * \returns the project or nullptr if an error happened
      * \since QGIS 3.0
      */
     const QgsProject *project( const QString &path );
 
+  signals:
+
+    /**
+     * Emitted when a project is removed from the cache, e.g. because its file changed.
+     * \param path the path of the project
+     * \since QGIS 3.4
+     */
+    void projectRemovedFromCache( const QString &path );
+
   private:
     QgsConfigCache() SIP_FORCE;
 
@@ -72,9 +88,32 @@ class SERVER_EXPORT QgsConfigCache : public QObject
     QCache<QString, QDomDocument> mXmlDocumentCache;
     QCache<QString, QgsProject> mProjectCache;
 
+    //! Project read by a worker thread, with the version of the file it was read from
+    struct ThreadProject
+    {
+      std::unique_ptr<QgsProject> project;
+      int version = 0;
+    };
+
+    //! Projects of the other threads than the one of the cache, see QgsServerSettings::workerThreads()
+    QThreadStorage< QCache<QString, ThreadProject> * > mThreadProjectCaches;
+
+    /**
+     * Number of times each project file was changed. The projects of the other threads are
+     * reloaded when it changes, as they cannot be removed from the thread of the cache.
+     */
+    QHash<QString, int> mProjectVersions;
+    QMutex mProjectVersionsMutex;
+
+    //! Returns the project of the current thread, when it is not the thread of the cache
+    const QgsProject *threadProject( const QString &path );
+
   private slots:
     //! Removes changed entry from this cache
     void removeChangedEntry( const QString &path );
+
+    //! Watches a project file for changes, in the thread of the cache
+    void watchPath( const QString &path );
 };
 
 #endif // QGSCONFIGCACHE_H
@@ -26,6 +26,8 @@
 
 #include <QBuffer>
 
+struct FCGX_Request;
+
 /**
  * \ingroup server
  * \class QgsFcgiServerRequest
@@ -35,8 +37,17 @@
 class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
 {
   public:
+
+    //! Creates the request from the current FCGI request of the process, see FCGI_Accept()
     QgsFcgiServerRequest();
 
+    /**
+     * Creates the request from a FCGI request accepted with FCGX_Accept_r(),
+     * for requests handled in several threads.
+     * \since QGIS 3.4
+     */
+    explicit QgsFcgiServerRequest( FCGX_Request *fcgiRequest );
+
     QByteArray data() const override;
 
     /**
@@ -45,6 +56,11 @@ class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
     bool hasError() const { return mHasError; }
 
   private:
+    void init();
+
+    //! Returns a parameter of the request environment, or nullptr if not set
+    const char *param( const char *name ) const;
+
     void readData();
 
     // Log request info: print debug infos
@@ -54,6 +70,7 @@ class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
 
     QByteArray mData;
     bool       mHasError;
+    FCGX_Request *mFcgiRequest = nullptr;
 };
 
 #endif
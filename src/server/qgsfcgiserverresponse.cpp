@@ -37,6 +37,26 @@ QgsFcgiServerResponse::QgsFcgiServerResponse( QgsServerRequest::Method method )
   setDefaultHeaders();
 }
 
+QgsFcgiServerResponse::QgsFcgiServerResponse( QgsServerRequest::Method method, FCGX_Request *fcgiRequest )
+  : mMethod( method )
+  , mFcgiRequest( fcgiRequest )
+{
+  mBuffer.open( QIODevice::ReadWrite );
+  setDefaultHeaders();
+}
+
+void QgsFcgiServerResponse::writeOutput( const char *data, int size )
+{
+  if ( mFcgiRequest )
+  {
+    FCGX_PutStr( data, size, mFcgiRequest->out );
+  }
+  else
+  {
+    fwrite( ( void * )data, size, 1, FCGI_stdout );
+  }
+}
+
 void QgsFcgiServerResponse::removeHeader( const QString &key )
 {
   mHeaders.remove( key );
@@ -109,15 +129,17 @@ void QgsFcgiServerResponse::flush()
   if ( ! mHeadersSent )
   {
     // Send all headers
+    QByteArray headers;
     QMap<QString, QString>::const_iterator it;
     for ( it = mHeaders.constBegin(); it != mHeaders.constEnd(); ++it )
     {
-      fputs( it.key().toUtf8(), FCGI_stdout );
-      fputs( ": ", FCGI_stdout );
-      fputs( it.value().toUtf8(), FCGI_stdout );
-      fputs( "\n", FCGI_stdout );
+      headers.append( it.key().toUtf8() );
+      headers.append( ": " );
+      headers.append( it.value().toUtf8() );
+      headers.append( '\n' );
     }
-    fputs( "\n", FCGI_stdout );
+    headers.append( '\n' );
+    writeOutput( headers.constData(), headers.size() );
     mHeadersSent = true;
   }
 
@@ -131,11 +153,9 @@ void QgsFcgiServerResponse::flush()
   else if ( mBuffer.bytesAvailable() > 0 )
   {
     QByteArray &ba = mBuffer.buffer();
-    size_t count   = fwrite( ( void * )ba.data(), ba.size(), 1, FCGI_stdout );
+    writeOutput( ba.constData(), ba.size() );
 #ifdef QGISDEBUG
-    qDebug() << QStringLiteral( "Sent %1 blocks of %2 bytes" ).arg( count ).arg( ba.size() );
-#else
-    Q_UNUSED( count );
+    qDebug() << QStringLiteral( "Sent %1 bytes" ).arg( ba.size() );
 #endif
     // Reset the internal buffer
     ba.clear();
@@ -27,6 +27,8 @@
 
 #include <QBuffer>
 
+struct FCGX_Request;
+
 /**
  * \ingroup server
  * \class QgsFcgiServerResponse
@@ -43,6 +45,15 @@ class SERVER_EXPORT QgsFcgiServerResponse: public QgsServerResponse
      */
     QgsFcgiServerResponse( QgsServerRequest::Method method = QgsServerRequest::GetMethod );
 
+    /**
+     * Constructor for QgsFcgiServerResponse writing to a FCGI request accepted
+     * with FCGX_Accept_r(), for requests handled in several threads.
+     * \param method The HTTP method
+     * \param fcgiRequest The FCGI request
+     * \since QGIS 3.4
+     */
+    QgsFcgiServerResponse( QgsServerRequest::Method method, FCGX_Request *fcgiRequest );
+
     void setHeader( const QString &key, const QString &value ) override;
 
     void removeHeader( const QString &key ) override;
@@ -77,12 +88,17 @@ class SERVER_EXPORT QgsFcgiServerResponse: public QgsServerResponse
     void setDefaultHeaders();
 
   private:
+
+    //! Writes data to the FCGI output stream
+    void writeOutput( const char *data, int size );
+
     QMap<QString, QString> mHeaders;
     QBuffer mBuffer;
     bool mFinished    = false;
     bool mHeadersSent = false;
     QgsServerRequest::Method mMethod;
     int mStatusCode = 0;
+    FCGX_Request *mFcgiRequest = nullptr;
 };
 
 #endif
@@ -45,6 +45,7 @@
 #include <QImage>
 #include <QSettings>
 #include <QDateTime>
+#include <QThread>
 
 // TODO: remove, it's only needed by a single debug message
 #include <fcgi_stdio.h>
@@ -267,7 +268,11 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
   Qgis::MessageLevel logLevel = QgsServerLogger::instance()->logLevel();
   QTime time; //used for measuring request time if loglevel < 1
 
-  qApp->processEvents();
+  // Worker threads don't own the watchers of the caches, the main thread processes their events
+  if ( QThread::currentThread() == qApp->thread() )
+  {
+    qApp->processEvents();
+  }
 
   if ( logLevel == Qgis::Info )
   {
@@ -141,6 +141,11 @@ QByteArray QgsServerCacheManager::getCachedImage( const QgsProject *project, con
   bool cache = true;
   QString key = getCacheKey( cache, accessControl );
 
+  if ( !cache )
+  {
+    return QByteArray();
+  }
+
   QgsServerCacheFilterMap::const_iterator scIterator;
   for ( scIterator = mPluginsServerCaches->constBegin(); scIterator != mPluginsServerCaches->constEnd(); ++scIterator )
   {
@@ -158,6 +163,11 @@ bool QgsServerCacheManager::setCachedImage( const QByteArray *img, const QgsProj
   bool cache = true;
   QString key = getCacheKey( cache, accessControl );
 
+  if ( !cache )
+  {
+    return false;
+  }
+
   QgsServerCacheFilterMap::const_iterator scIterator;
   for ( scIterator = mPluginsServerCaches->constBegin(); scIterator != mPluginsServerCaches->constEnd(); ++scIterator )
   {
@@ -203,6 +213,11 @@ void QgsServerCacheManager::registerServerCache( QgsServerCacheFilter *serverCac
   mPluginsServerCaches->insert( priority, serverCache );
 }
 
+bool QgsServerCacheManager::hasCaches() const
+{
+  return mPluginsServerCaches && !mPluginsServerCaches->isEmpty();
+}
+
 QString QgsServerCacheManager::getCacheKey( bool &cache, QgsAccessControl *accessControl ) const
 {
   QStringList cacheKeyList;
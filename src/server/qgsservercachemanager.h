@@ -134,6 +134,12 @@ class SERVER_EXPORT QgsServerCacheManager
      */
     void registerServerCache( QgsServerCacheFilter *serverCache, int priority = 0 );
 
+    /**
+     * Returns true if at least one server cache filter has been registered
+     * \since QGIS 3.4
+     */
+    bool hasCaches() const;
+
   private:
     QString getCacheKey( bool &cache, QgsAccessControl *accessControl ) const;
     //! The ServerCache plugins registry
@@ -19,6 +19,11 @@
 
 #include "qgsserverinterfaceimpl.h"
 #include "qgsconfigcache.h"
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+#include "qgsservernativecachefilter.h"
+#endif
+
+#include <limits>
 
 //! Constructor
 QgsServerInterfaceImpl::QgsServerInterfaceImpl( QgsCapabilitiesCache *capCache, QgsServiceRegistry *srvRegistry, QgsServerSettings *settings )
@@ -26,10 +31,18 @@ QgsServerInterfaceImpl::QgsServerInterfaceImpl( QgsCapabilitiesCache *capCache,
   , mServiceRegistry( srvRegistry )
   , mServerSettings( settings )
 {
-  mRequestHandler = nullptr;
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   mAccessControls = new QgsAccessControl();
   mCacheManager.reset( new QgsServerCacheManager() );
+
+  if ( mServerSettings && ( mServerSettings->nativeCacheMemorySize() > 0 || mServerSettings->nativeCacheDiskSize() > 0 ) )
+  {
+    mNativeCache.reset( new QgsServerNativeCacheFilter( this, mServerSettings->nativeCacheMemorySize(),
+                        mServerSettings->nativeCacheDiskSize(),
+                        mServerSettings->cacheDirectory() + QStringLiteral( "/server" ) ) );
+    // caches of plugins are queried first, whatever their priority
+    mCacheManager->registerServerCache( mNativeCache.get(), std::numeric_limits<int>::max() );
+  }
 #endif
 }
 
@@ -44,23 +57,24 @@ QgsServerInterfaceImpl::~QgsServerInterfaceImpl()
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   delete mAccessControls;
   mCacheManager.reset();
+  mNativeCache.reset();
 #endif
 }
 
 
 void QgsServerInterfaceImpl::clearRequestHandler()
 {
-  mRequestHandler = nullptr;
+  mRequestState.localData().requestHandler = nullptr;
 }
 
 void QgsServerInterfaceImpl::setRequestHandler( QgsRequestHandler *requestHandler )
 {
-  mRequestHandler = requestHandler;
+  mRequestState.localData().requestHandler = requestHandler;
 }
 
 void QgsServerInterfaceImpl::setConfigFilePath( const QString &configFilePath )
 {
-  mConfigFilePath = configFilePath;
+  mRequestState.localData().configFilePath = configFilePath;
 }
 
 void QgsServerInterfaceImpl::registerFilter( QgsServerFilter *filter, int priority )
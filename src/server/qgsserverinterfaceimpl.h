@@ -26,6 +26,10 @@
 #include "qgscapabilitiescache.h"
 #include "qgsservercachemanager.h"
 
+#include <QThreadStorage>
+
+class QgsServerNativeCacheFilter;
+
 /**
  * \ingroup server
  * \class QgsServerInterfaceImpl
@@ -48,7 +52,7 @@ class QgsServerInterfaceImpl : public QgsServerInterface
     void clearRequestHandler() override;
     QgsCapabilitiesCache *capabilitiesCache() override { return mCapabilitiesCache; }
     //! Returns the QgsRequestHandler, to be used only in server plugins
-    QgsRequestHandler  *requestHandler() override { return mRequestHandler; }
+    QgsRequestHandler  *requestHandler() override { return mRequestState.localData().requestHandler; }
     void registerFilter( QgsServerFilter *filter, int priority = 0 ) override;
     QgsServerFiltersMap filters() override { return mFilters; }
 
@@ -78,7 +82,7 @@ class QgsServerInterfaceImpl : public QgsServerInterface
     QgsServerCacheManager *cacheManager() const override;
 
     QString getEnv( const QString &name ) const override;
-    QString configFilePath() override { return mConfigFilePath; }
+    QString configFilePath() override { return mRequestState.localData().configFilePath; }
     void setConfigFilePath( const QString &configFilePath ) override;
     void setFilters( QgsServerFiltersMap *filters ) override;
     void removeConfigCacheEntry( const QString &path ) override;
@@ -89,12 +93,21 @@ class QgsServerInterfaceImpl : public QgsServerInterface
 
   private:
 
-    QString mConfigFilePath;
+    //! State of the request handled by a thread
+    struct RequestState
+    {
+      QgsRequestHandler *requestHandler = nullptr;
+      QString configFilePath;
+    };
+
+    //! Requests may be handled concurrently by several threads, see QgsServerSettings::workerThreads()
+    QThreadStorage<RequestState> mRequestState;
+
     QgsServerFiltersMap mFilters;
     QgsAccessControl *mAccessControls = nullptr;
     std::unique_ptr<QgsServerCacheManager> mCacheManager = nullptr;
+    std::unique_ptr<QgsServerNativeCacheFilter> mNativeCache;
     QgsCapabilitiesCache *mCapabilitiesCache = nullptr;
-    QgsRequestHandler *mRequestHandler = nullptr;
     QgsServiceRegistry *mServiceRegistry = nullptr;
     QgsServerSettings *mServerSettings = nullptr;
 };
@@ -0,0 +1,307 @@
+/***************************************************************************
+                        qgsservernativecachefilter.cpp
+                        ------------------------------
+  Cache of documents and images shipped with QGIS Server
+
+  begin                : 2018-10-16
+  copyright            : (C) 2018 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsservernativecachefilter.h"
+#include "qgsconfigcache.h"
+#include "qgsmessagelog.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <limits>
+
+QgsServerNativeCacheFilter::QgsServerNativeCacheFilter( const QgsServerInterface *serverInterface, qint64 memorySize, qint64 diskSize, const QString &directory )
+  : QgsServerCacheFilter( serverInterface )
+  , mDiskSize( diskSize )
+  , mDirectory( directory )
+{
+  // costs are in KiB as QCache costs are int
+  mMemoryCache.setMaxCost( static_cast<int>( std::min<qint64>( memorySize / 1024, std::numeric_limits<int>::max() ) ) );
+
+  if ( mDiskSize > 0 )
+  {
+    if ( !QDir().mkpath( mDirectory.absolutePath() ) )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Cannot create server cache directory %1, disk cache disabled" ).arg( directory ), QStringLiteral( "Server" ), Qgis::Warning );
+      mDiskSize = 0;
+    }
+    else
+    {
+      // the cache directory is kept between runs
+      QDirIterator it( mDirectory.absolutePath(), QDir::Files, QDirIterator::Subdirectories );
+      while ( it.hasNext() )
+      {
+        it.next();
+        mDiskUsed += it.fileInfo().size();
+      }
+    }
+  }
+
+  mConfigCacheConnection = QObject::connect( QgsConfigCache::instance(), &QgsConfigCache::projectRemovedFromCache, [this]( const QString & path )
+  {
+    removeProject( path );
+  } );
+}
+
+QgsServerNativeCacheFilter::~QgsServerNativeCacheFilter()
+{
+  QObject::disconnect( mConfigCacheConnection );
+}
+
+QByteArray QgsServerNativeCacheFilter::getCachedDocument( const QgsProject *project, const QgsServerRequest &request, const QString &key ) const
+{
+  return entry( entryKey( QStringLiteral( "documents" ), project, request, key ) );
+}
+
+bool QgsServerNativeCacheFilter::setCachedDocument( const QDomDocument *doc, const QgsProject *project, const QgsServerRequest &request, const QString &key ) const
+{
+  if ( !doc )
+  {
+    return false;
+  }
+  return setEntry( entryKey( QStringLiteral( "documents" ), project, request, key ), doc->toByteArray() );
+}
+
+bool QgsServerNativeCacheFilter::deleteCachedDocument( const QgsProject *project, const QgsServerRequest &request, const QString &key ) const
+{
+  return removeEntry( entryKey( QStringLiteral( "documents" ), project, request, key ) );
+}
+
+bool QgsServerNativeCacheFilter::deleteCachedDocuments( const QgsProject *project ) const
+{
+  if ( !project )
+  {
+    return false;
+  }
+  return removeEntries( projectShard( project->fileName() ) + QStringLiteral( "/documents/" ) );
+}
+
+QByteArray QgsServerNativeCacheFilter::getCachedImage( const QgsProject *project, const QgsServerRequest &request, const QString &key ) const
+{
+  return entry( entryKey( QStringLiteral( "images" ), project, request, key ) );
+}
+
+bool QgsServerNativeCacheFilter::setCachedImage( const QByteArray *img, const QgsProject *project, const QgsServerRequest &request, const QString &key ) const
+{
+  if ( !img || img->isEmpty() )
+  {
+    return false;
+  }
+  return setEntry( entryKey( QStringLiteral( "images" ), project, request, key ), *img );
+}
+
+bool QgsServerNativeCacheFilter::deleteCachedImage( const QgsProject *project, const QgsServerRequest &request, const QString &key ) const
+{
+  return removeEntry( entryKey( QStringLiteral( "images" ), project, request, key ) );
+}
+
+bool QgsServerNativeCacheFilter::deleteCachedImages( const QgsProject *project ) const
+{
+  if ( !project )
+  {
+    return false;
+  }
+  return removeEntries( projectShard( project->fileName() ) + QStringLiteral( "/images/" ) );
+}
+
+void QgsServerNativeCacheFilter::removeProject( const QString &path ) const
+{
+  removeEntries( projectShard( path ) + '/' );
+}
+
+QString QgsServerNativeCacheFilter::projectShard( const QString &path )
+{
+  return QString::fromLatin1( QCryptographicHash::hash( path.toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+}
+
+QString QgsServerNativeCacheFilter::entryKey( const QString &kind, const QgsProject *project, const QgsServerRequest &request, const QString &key )
+{
+  // documents embed the URL of the service, e.g. the OnlineResource of capabilities
+  QByteArray identifier = request.url().adjusted( QUrl::RemoveUserInfo | QUrl::RemoveQuery | QUrl::RemoveFragment ).toString( QUrl::FullyEncoded ).toUtf8();
+  identifier += '\n';
+  // the parameters are sorted and their names are upper case
+  identifier += request.serverParameters().urlQuery().toString( QUrl::FullyEncoded ).toUtf8();
+  identifier += '\n';
+  identifier += key.toUtf8();
+  identifier += '\n';
+  // entries of a previous version of the project are never read again
+  identifier += QByteArray::number( project ? project->lastModified().toMSecsSinceEpoch() : 0 );
+  const QByteArray data = request.data();
+  if ( !data.isEmpty() )
+  {
+    identifier += '\n';
+    identifier += data;
+  }
+
+  const QString hash = QString::fromLatin1( QCryptographicHash::hash( identifier, QCryptographicHash::Sha1 ).toHex() );
+  return QStringLiteral( "%1/%2/%3/%4" ).arg( projectShard( project ? project->fileName() : QString() ), kind, hash.left( 2 ), hash );
+}
+
+QByteArray QgsServerNativeCacheFilter::entry( const QString &entryKey ) const
+{
+  QMutexLocker locker( &mMutex );
+  if ( QByteArray *content = mMemoryCache.object( entryKey ) )
+  {
+    return *content;
+  }
+
+  if ( mDiskSize <= 0 )
+  {
+    return QByteArray();
+  }
+
+  QFile file( mDirectory.filePath( entryKey ) );
+  if ( !file.open( QIODevice::ReadOnly ) )
+  {
+    return QByteArray();
+  }
+  const QByteArray content = file.readAll();
+
+  // keep the most used entries in memory
+  const int cost = static_cast<int>( content.size() / 1024 ) + 1;
+  if ( cost <= mMemoryCache.maxCost() )
+  {
+    mMemoryCache.insert( entryKey, new QByteArray( content ), cost );
+  }
+  return content;
+}
+
+bool QgsServerNativeCacheFilter::setEntry( const QString &entryKey, const QByteArray &content ) const
+{
+  QMutexLocker locker( &mMutex );
+  bool cached = false;
+
+  const int cost = static_cast<int>( content.size() / 1024 ) + 1;
+  if ( cost <= mMemoryCache.maxCost() )
+  {
+    mMemoryCache.insert( entryKey, new QByteArray( content ), cost );
+    cached = true;
+  }
+
+  if ( mDiskSize > 0 && content.size() <= mDiskSize )
+  {
+    const QString path = mDirectory.filePath( entryKey );
+    const qint64 previousSize = QFileInfo( path ).size();
+    expireDisk( content.size() - previousSize );
+
+    mDirectory.mkpath( QFileInfo( path ).path() );
+    QSaveFile file( path );
+    if ( file.open( QIODevice::WriteOnly ) && file.write( content ) == content.size() && file.commit() )
+    {
+      mDiskUsed += content.size() - previousSize;
+      cached = true;
+    }
+  }
+
+  return cached;
+}
+
+bool QgsServerNativeCacheFilter::removeEntry( const QString &entryKey ) const
+{
+  QMutexLocker locker( &mMutex );
+  bool removed = mMemoryCache.remove( entryKey );
+
+  if ( mDiskSize > 0 )
+  {
+    QFile file( mDirectory.filePath( entryKey ) );
+    const qint64 size = file.size();
+    if ( file.exists() && file.remove() )
+    {
+      mDiskUsed -= size;
+      removed = true;
+    }
+  }
+  return removed;
+}
+
+bool QgsServerNativeCacheFilter::removeEntries( const QString &prefix ) const
+{
+  QMutexLocker locker( &mMutex );
+  bool removed = false;
+
+  const QList<QString> keys = mMemoryCache.keys();
+  for ( const QString &key : keys )
+  {
+    if ( key.startsWith( prefix ) )
+    {
+      mMemoryCache.remove( key );
+      removed = true;
+    }
+  }
+
+  if ( mDiskSize > 0 )
+  {
+    QDir dir( mDirectory.filePath( prefix ) );
+    if ( dir.exists() )
+    {
+      QDirIterator it( dir.absolutePath(), QDir::Files, QDirIterator::Subdirectories );
+      while ( it.hasNext() )
+      {
+        it.next();
+        mDiskUsed -= it.fileInfo().size();
+      }
+      removed = dir.removeRecursively() || removed;
+    }
+  }
+  return removed;
+}
+
+void QgsServerNativeCacheFilter::expireDisk( qint64 size ) const
+{
+  if ( mDiskUsed + size <= mDiskSize )
+  {
+    return;
+  }
+
+  QList<QFileInfo> files;
+  QDirIterator it( mDirectory.absolutePath(), QDir::Files, QDirIterator::Subdirectories );
+  while ( it.hasNext() )
+  {
+    it.next();
+    files << it.fileInfo();
+  }
+  std::sort( files.begin(), files.end(), []( const QFileInfo & a, const QFileInfo & b )
+  {
+    return a.lastModified() < b.lastModified();
+  } );
+
+  // free some more space than needed, not to scan the directory for each new entry
+  const qint64 target = mDiskSize * 9 / 10 - size;
+  mDiskUsed = 0;
+  for ( const QFileInfo &file : qgis::as_const( files ) )
+  {
+    mDiskUsed += file.size();
+  }
+  for ( const QFileInfo &file : qgis::as_const( files ) )
+  {
+    if ( mDiskUsed <= target )
+    {
+      break;
+    }
+    if ( QFile::remove( file.absoluteFilePath() ) )
+    {
+      mDiskUsed -= file.size();
+    }
+  }
+}
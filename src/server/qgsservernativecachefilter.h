@@ -0,0 +1,104 @@
+/***************************************************************************
+                        qgsservernativecachefilter.h
+                        ----------------------------
+  Cache of documents and images shipped with QGIS Server
+
+  begin                : 2018-10-16
+  copyright            : (C) 2018 by the QGIS Project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERNATIVECACHEFILTER_H
+#define QGSSERVERNATIVECACHEFILTER_H
+
+#define SIP_NO_FILE
+
+#include "qgsservercachefilter.h"
+#include "qgis_server.h"
+
+#include <QCache>
+#include <QDir>
+#include <QMutex>
+
+/**
+ * \ingroup server
+ * \class QgsServerNativeCacheFilter
+ * \brief Server cache of documents and images with an in-memory tier and an on-disk tier.
+ *
+ * Entries are identified by the project path, the last modification time of the project,
+ * the normalized request parameters and the access control key. The memory tier evicts the
+ * least recently used entries, the disk tier the oldest ones. The disk tier is sharded by
+ * project and by the first characters of the entry hash.
+ *
+ * The entries of a project are removed when QgsConfigCache removes the project, e.g.
+ * because its file changed.
+ * \since QGIS 3.4
+ */
+class SERVER_EXPORT QgsServerNativeCacheFilter : public QgsServerCacheFilter
+{
+  public:
+
+    /**
+     * Constructor
+     * \param serverInterface the server interface
+     * \param memorySize maximum size in bytes of the memory tier, 0 to disable it
+     * \param diskSize maximum size in bytes of the disk tier, 0 to disable it
+     * \param directory the directory of the disk tier
+     */
+    QgsServerNativeCacheFilter( const QgsServerInterface *serverInterface, qint64 memorySize, qint64 diskSize, const QString &directory );
+
+    ~QgsServerNativeCacheFilter() override;
+
+    QByteArray getCachedDocument( const QgsProject *project, const QgsServerRequest &request, const QString &key ) const override;
+    bool setCachedDocument( const QDomDocument *doc, const QgsProject *project, const QgsServerRequest &request, const QString &key ) const override;
+    bool deleteCachedDocument( const QgsProject *project, const QgsServerRequest &request, const QString &key ) const override;
+    bool deleteCachedDocuments( const QgsProject *project ) const override;
+    QByteArray getCachedImage( const QgsProject *project, const QgsServerRequest &request, const QString &key ) const override;
+    bool setCachedImage( const QByteArray *img, const QgsProject *project, const QgsServerRequest &request, const QString &key ) const override;
+    bool deleteCachedImage( const QgsProject *project, const QgsServerRequest &request, const QString &key ) const override;
+    bool deleteCachedImages( const QgsProject *project ) const override;
+
+    /**
+     * Removes all the cached documents and images of a project
+     * \param path the path of the project
+     */
+    void removeProject( const QString &path ) const;
+
+  private:
+
+    //! Returns the name of the shard of a project
+    static QString projectShard( const QString &path );
+
+    //! Returns the key of an entry, which is also its path relative to the cache directory
+    static QString entryKey( const QString &kind, const QgsProject *project, const QgsServerRequest &request, const QString &key );
+
+    QByteArray entry( const QString &entryKey ) const;
+    bool setEntry( const QString &entryKey, const QByteArray &content ) const;
+    bool removeEntry( const QString &entryKey ) const;
+
+    //! Removes the entries whose key starts with \a prefix
+    bool removeEntries( const QString &prefix ) const;
+
+    //! Removes the oldest files until \a size bytes can be added to the disk tier
+    void expireDisk( qint64 size ) const;
+
+    mutable QCache<QString, QByteArray> mMemoryCache;
+    qint64 mDiskSize = 0;
+    mutable qint64 mDiskUsed = 0;
+    QDir mDirectory;
+
+    //! Cache filters are called by the threads handling requests
+    mutable QMutex mMutex;
+
+    QMetaObject::Connection mConfigCacheConnection;
+};
+
+#endif // QGSSERVERNATIVECACHEFILTER_H
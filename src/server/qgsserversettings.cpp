@@ -130,6 +130,61 @@ void QgsServerSettings::initSettings()
                                QVariant()
                              };
   mSettings[ sCacheSize.envVar ] = sCacheSize;
+
+  // worker threads
+  const Setting sWorkerThreads = { QgsServerSettingsEnv::QGIS_SERVER_WORKER_THREADS,
+                                   QgsServerSettingsEnv::DEFAULT_VALUE,
+                                   "Number of threads handling FCGI requests concurrently",
+                                   "/qgis/worker_threads",
+                                   QVariant::Int,
+                                   QVariant( 1 ),
+                                   QVariant()
+                                 };
+  mSettings[ sWorkerThreads.envVar ] = sWorkerThreads;
+
+  // wmts metatile columns
+  const Setting sWmtsMetatileColumns = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_COLUMNS,
+                                         QgsServerSettingsEnv::DEFAULT_VALUE,
+                                         "Number of columns of the blocks of tiles rendered together by WMTS GetTile",
+                                         "/qgis/wmts_metatile_columns",
+                                         QVariant::Int,
+                                         QVariant( 1 ),
+                                         QVariant()
+                                       };
+  mSettings[ sWmtsMetatileColumns.envVar ] = sWmtsMetatileColumns;
+
+  // wmts metatile rows
+  const Setting sWmtsMetatileRows = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_ROWS,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      "Number of rows of the blocks of tiles rendered together by WMTS GetTile",
+                                      "/qgis/wmts_metatile_rows",
+                                      QVariant::Int,
+                                      QVariant( 1 ),
+                                      QVariant()
+                                    };
+  mSettings[ sWmtsMetatileRows.envVar ] = sWmtsMetatileRows;
+
+  // native cache memory size
+  const Setting sNativeCacheMemorySize = { QgsServerSettingsEnv::QGIS_SERVER_NATIVE_CACHE_MEMORY_SIZE,
+                                           QgsServerSettingsEnv::DEFAULT_VALUE,
+                                           "Specify the size of the memory tier of the built-in cache",
+                                           "/cache/native_memory_size",
+                                           QVariant::LongLong,
+                                           QVariant( 0 ),
+                                           QVariant()
+                                         };
+  mSettings[ sNativeCacheMemorySize.envVar ] = sNativeCacheMemorySize;
+
+  // native cache disk size
+  const Setting sNativeCacheDiskSize = { QgsServerSettingsEnv::QGIS_SERVER_NATIVE_CACHE_DISK_SIZE,
+                                         QgsServerSettingsEnv::DEFAULT_VALUE,
+                                         "Specify the size of the disk tier of the built-in cache",
+                                         "/cache/native_disk_size",
+                                         QVariant::LongLong,
+                                         QVariant( 0 ),
+                                         QVariant()
+                                       };
+  mSettings[ sNativeCacheDiskSize.envVar ] = sNativeCacheDiskSize;
 }
 
 void QgsServerSettings::load()
@@ -305,3 +360,28 @@ QString QgsServerSettings::cacheDirectory() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_CACHE_DIRECTORY ).toString();
 }
+
+int QgsServerSettings::workerThreads() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WORKER_THREADS ).toInt();
+}
+
+int QgsServerSettings::wmtsMetatileColumns() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_COLUMNS ).toInt();
+}
+
+int QgsServerSettings::wmtsMetatileRows() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_ROWS ).toInt();
+}
+
+qint64 QgsServerSettings::nativeCacheMemorySize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_NATIVE_CACHE_MEMORY_SIZE ).toLongLong();
+}
+
+qint64 QgsServerSettings::nativeCacheDiskSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_NATIVE_CACHE_DISK_SIZE ).toLongLong();
+}
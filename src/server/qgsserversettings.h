@@ -59,7 +59,12 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_PROJECT_FILE,
       MAX_CACHE_LAYERS,
       QGIS_SERVER_CACHE_DIRECTORY,
-      QGIS_SERVER_CACHE_SIZE
+      QGIS_SERVER_CACHE_SIZE,
+      QGIS_SERVER_WORKER_THREADS,
+      QGIS_SERVER_WMTS_METATILE_COLUMNS,
+      QGIS_SERVER_WMTS_METATILE_ROWS,
+      QGIS_SERVER_NATIVE_CACHE_MEMORY_SIZE,
+      QGIS_SERVER_NATIVE_CACHE_DISK_SIZE
     };
     Q_ENUM( EnvVar )
 };
@@ -160,6 +165,43 @@ class SERVER_EXPORT QgsServerSettings
       */
     QString cacheDirectory() const;
 
+    /**
+     * Returns the number of threads handling FCGI requests concurrently. Requests are
+      * handled one at a time when server python plugins are loaded, as they are not thread safe.
+      * \returns the number of worker threads, 1 if requests are handled one at a time.
+      * \since QGIS 3.4
+      */
+    int workerThreads() const;
+
+    /**
+     * Returns the number of columns of the blocks of tiles rendered together by WMTS GetTile.
+      * \returns the number of columns of a metatile, 1 if tiles are rendered one at a time.
+      * \since QGIS 3.4
+      */
+    int wmtsMetatileColumns() const;
+
+    /**
+     * Returns the number of rows of the blocks of tiles rendered together by WMTS GetTile.
+      * \returns the number of rows of a metatile, 1 if tiles are rendered one at a time.
+      * \since QGIS 3.4
+      */
+    int wmtsMetatileRows() const;
+
+    /**
+     * Returns the maximum size of the memory tier of the built-in cache of documents and images.
+      * \returns the size in bytes, 0 if the memory tier is disabled.
+      * \since QGIS 3.4
+      */
+    qint64 nativeCacheMemorySize() const;
+
+    /**
+     * Returns the maximum size of the disk tier of the built-in cache of documents and images.
+     * The files are stored in the "server" subdirectory of cacheDirectory().
+      * \returns the size in bytes, 0 if the disk tier is disabled.
+      * \since QGIS 3.4
+      */
+    qint64 nativeCacheDiskSize() const;
+
   private:
     void initSettings();
     QVariant value( QgsServerSettingsEnv::EnvVar envVar ) const;
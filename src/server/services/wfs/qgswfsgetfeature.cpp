@@ -32,11 +32,12 @@
 #include "qgsfilterrestorer.h"
 #include "qgsproject.h"
 #include "qgsogcutils.h"
-#include "qgsjsonutils.h"
 
 #include "qgswfsgetfeature.h"
 
+#include <QJsonDocument>
 #include <QStringList>
+#include <QTextStream>
 
 namespace QgsWfs
 {
@@ -60,11 +61,26 @@ namespace QgsWfs
       const QgsCoordinateReferenceSystem &outputCrs;
     };
 
-    QString createFeatureGeoJSON( QgsFeature *feat, const createFeatureParams &params );
+    //! Features serialized but not yet written to the response
+    struct featureBuffer
+    {
+      //! UTF-8 content, reused for all the features
+      QByteArray data;
+
+      //! Document used to build the GML of geometries
+      QDomDocument gmlDoc;
+
+      //! Transform of the GeoJSON geometries to EPSG:4326
+      QgsCoordinateTransform geoJsonTransform;
+    };
 
-    QDomElement createFeatureGML2( QgsFeature *feat, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project );
+    //! Size of the blocks of features written to the response
+    const int FEATURE_BUFFER_SIZE = 64 * 1024;
 
-    QDomElement createFeatureGML3( QgsFeature *feat, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project );
+    void createFeatureGeoJSON( QByteArray &out, QgsFeature *feat, QgsCoordinateTransform &transform, const createFeatureParams &params );
+
+    void createFeatureGML( QByteArray &out, QgsFeature *feat, QDomDocument &doc, QgsWfsParameters::Format format,
+                           const createFeatureParams &params, const QgsProject *project );
 
     void hitGetFeature( const QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project,
                         QgsWfsParameters::Format format, int numberOfFeatures, const QStringList &typeNames );
@@ -73,15 +89,13 @@ namespace QgsWfs
                           QgsWfsParameters::Format format, int prec, QgsCoordinateReferenceSystem &crs,
                           QgsRectangle *rect, const QStringList &typeNames );
 
-    void setGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format, QgsFeature *feat, int featIdx,
+    void setGetFeature( QgsServerResponse &response, featureBuffer &buffer, QgsWfsParameters::Format format, QgsFeature *feat, int featIdx,
                         const createFeatureParams &params, const QgsProject *project );
 
-    void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format );
+    void endGetFeature( QgsServerResponse &response, featureBuffer &buffer, QgsWfsParameters::Format format );
 
     QgsServerRequest::Parameters mRequestParameters;
     QgsWfsParameters mWfsParameters;
-    /* GeoJSON Exporter */
-    QgsJsonExporter mJsonExporter;
   }
 
   void writeGetFeature( QgsServerInterface *serverIface, const QgsProject *project,
@@ -187,6 +201,9 @@ namespace QgsWfs
     long iteratedFeatures = 0;
     // sent features
     QgsFeature feature;
+    featureBuffer buffer;
+    buffer.data.reserve( 2 * FEATURE_BUFFER_SIZE );
+    buffer.geoJsonTransform.setDestinationCrs( QgsCoordinateReferenceSystem( 4326, QgsCoordinateReferenceSystem::EpsgCrsId ) );
     qIt = aRequest.queries.begin();
     for ( ; qIt != aRequest.queries.end(); ++qIt )
     {
@@ -401,7 +418,7 @@ namespace QgsWfs
 
           if ( iteratedFeatures >= aRequest.startIndex )
           {
-            setGetFeature( response, aRequest.outputFormat, &feature, sentFeatures, cfp, project );
+            setGetFeature( response, buffer, aRequest.outputFormat, &feature, sentFeatures, cfp, project );
             ++sentFeatures;
           }
           ++iteratedFeatures;
@@ -423,7 +440,7 @@ namespace QgsWfs
       // End of GetFeature
       if ( iteratedFeatures <= aRequest.startIndex )
         startGetFeature( request, response, project, aRequest.outputFormat, requestPrecision, requestCrs, &requestRect, typeNameList );
-      endGetFeature( response, aRequest.outputFormat );
+      endGetFeature( response, buffer, aRequest.outputFormat );
     }
 
   }
@@ -1164,7 +1181,7 @@ namespace QgsWfs
       }
     }
 
-    void setGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format, QgsFeature *feat, int featIdx,
+    void setGetFeature( QgsServerResponse &response, featureBuffer &buffer, QgsWfsParameters::Format format, QgsFeature *feat, int featIdx,
                         const createFeatureParams &params, const QgsProject *project )
     {
       if ( !feat->isValid() )
@@ -1172,189 +1189,291 @@ namespace QgsWfs
 
       if ( format == QgsWfsParameters::Format::GeoJSON )
       {
-        QString fcString;
-        if ( featIdx == 0 )
-          fcString += QLatin1String( "  " );
-        else
-          fcString += QLatin1String( " ," );
-        mJsonExporter.setSourceCrs( params.crs );
-        mJsonExporter.setIncludeGeometry( false );
-        mJsonExporter.setIncludeAttributes( !params.attributeIndexes.isEmpty() );
-        mJsonExporter.setAttributes( params.attributeIndexes );
-        fcString += createFeatureGeoJSON( feat, params );
-        fcString += QLatin1String( "\n" );
-
-        response.write( fcString.toUtf8() );
+        buffer.data += featIdx == 0 ? "  " : " ,";
+        createFeatureGeoJSON( buffer.data, feat, buffer.geoJsonTransform, params );
+        buffer.data += '\n';
       }
       else
       {
-        QDomDocument gmlDoc;
-        QDomElement featureElement;
-        if ( format == QgsWfsParameters::Format::GML3 )
-        {
-          featureElement = createFeatureGML3( feat, gmlDoc, params, project );
-          gmlDoc.appendChild( featureElement );
-        }
-        else
-        {
-          featureElement = createFeatureGML2( feat, gmlDoc, params, project );
-          gmlDoc.appendChild( featureElement );
-        }
-        response.write( gmlDoc.toByteArray() );
+        createFeatureGML( buffer.data, feat, buffer.gmlDoc, format, params, project );
       }
 
-      // Stream partial content
-      response.flush();
+      // Stream partial content: the first feature as soon as possible, then by blocks
+      if ( featIdx == 0 || buffer.data.size() >= FEATURE_BUFFER_SIZE )
+      {
+        response.write( buffer.data );
+        response.flush();
+        // keeps the reserved capacity
+        buffer.data.resize( 0 );
+      }
     }
 
-    void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format )
+    void endGetFeature( QgsServerResponse &response, featureBuffer &buffer, QgsWfsParameters::Format format )
     {
-      QString fcString;
       if ( format == QgsWfsParameters::Format::GeoJSON )
       {
-        fcString += QLatin1String( " ]\n" );
-        fcString += QLatin1String( "}" );
+        buffer.data += " ]\n";
+        buffer.data += '}';
       }
       else
       {
-        fcString = QStringLiteral( "</wfs:FeatureCollection>\n" );
+        buffer.data += "</wfs:FeatureCollection>\n";
       }
-      response.write( fcString.toUtf8() );
+      response.write( buffer.data );
+      buffer.data.resize( 0 );
     }
 
-
-    QString createFeatureGeoJSON( QgsFeature *feat, const createFeatureParams &params )
+    /**
+     * Appends \a text in UTF-8 to \a out, escaped the same way as QDom escapes the text
+     * of elements, or the values of attributes if \a attribute is true.
+     */
+    void appendEscaped( QByteArray &out, const QString &text, bool attribute )
     {
-      QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, FID_TO_STRING( feat->id() ) );
-      //QgsJsonExporter force transform geometry to ESPG:4326
-      //and the RFC 7946 GeoJSON specification recommends limiting coordinate precision to 6
-      //Q_UNUSED( prec );
-
-      //copy feature so we can modify its geometry as required
-      QgsFeature f( *feat );
-      QgsGeometry geom = feat->geometry();
-      if ( !geom.isNull() && params.withGeom && params.geometryName != QLatin1String( "NONE" ) )
+      const QByteArray utf8 = text.toUtf8();
+      // multi-bytes UTF-8 sequences never contain ASCII bytes
+      for ( const char c : utf8 )
       {
-        mJsonExporter.setIncludeGeometry( true );
-        if ( params.geometryName == QLatin1String( "EXTENT" ) )
-        {
-          QgsRectangle box = geom.boundingBox();
-          f.setGeometry( QgsGeometry::fromRect( box ) );
-        }
-        else if ( params.geometryName == QLatin1String( "CENTROID" ) )
+        switch ( c )
         {
-          f.setGeometry( geom.centroid() );
+          case '<':
+            out += "&lt;";
+            break;
+          case '&':
+            out += "&amp;";
+            break;
+          case '"':
+            out += attribute ? "&quot;" : "\"";
+            break;
+          case '>':
+            out += out.endsWith( "]]" ) ? "&gt;" : ">";
+            break;
+          case '\n':
+            out += attribute ? "&#xa;" : "\n";
+            break;
+          case '\t':
+            out += attribute ? "&#x9;" : "\t";
+            break;
+          case '\r':
+            out += "&#xd;";
+            break;
+          default:
+            out += c;
         }
       }
-
-      return mJsonExporter.exportFeature( f, QVariantMap(), id );
     }
 
-
-    QDomElement createFeatureGML2( QgsFeature *feat, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project )
+    /**
+     * Appends \a element in UTF-8 to \a out, indented as if it was at \a depth in
+     * the feature document.
+     */
+    void appendElement( QByteArray &out, const QDomElement &element, int depth )
     {
-      //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      QByteArray xml;
+      QTextStream stream( &xml );
+      stream.setCodec( "UTF-8" );
+      element.save( stream, 1 );
+      stream.flush();
+
+      // QDom indents a detached element with its own depth
+      int elementDepth = 0;
+      while ( elementDepth < xml.size() && xml.at( elementDepth ) == ' ' )
+        ++elementDepth;
+      const QByteArray indent( std::max( depth - elementDepth, 0 ), ' ' );
+
+      int start = 0;
+      while ( start < xml.size() )
+      {
+        int end = xml.indexOf( '\n', start );
+        if ( end < 0 )
+          end = xml.size() - 1;
+        out += indent;
+        out.append( xml.constData() + start, end - start + 1 );
+        start = end + 1;
+      }
+    }
 
-      //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + params.typeName /*qgs:%TYPENAME%*/ );
-      typeNameElement.setAttribute( QStringLiteral( "fid" ), params.typeName + "." + QString::number( feat->id() ) );
-      featureElement.appendChild( typeNameElement );
+    /**
+     * Appends \a value in UTF-8 to \a out, encoded the same way as QgsJsonUtils::encodeValue().
+     */
+    void appendJsonValue( QByteArray &out, const QVariant &value )
+    {
+      if ( value.isNull() )
+      {
+        out += "null";
+        return;
+      }
 
-      //add geometry column (as gml)
-      QgsGeometry geom = feat->geometry();
-      if ( geom && params.withGeom && params.geometryName != QLatin1String( "NONE" ) )
+      switch ( value.type() )
       {
-        int prec = params.precision;
-        QgsCoordinateReferenceSystem crs = params.crs;
-        QgsCoordinateTransform mTransform( crs, params.outputCrs, project );
-        try
+        case QVariant::Int:
+        case QVariant::UInt:
+        case QVariant::LongLong:
+        case QVariant::ULongLong:
+        case QVariant::Double:
+          out += value.toString().toUtf8();
+          break;
+
+        case QVariant::Bool:
+          out += value.toBool() ? "true" : "false";
+          break;
+
+        case QVariant::StringList:
+        case QVariant::List:
+        case QVariant::Map:
+          out += QJsonDocument::fromVariant( value ).toJson( QJsonDocument::Compact );
+          break;
+
+        default:
         {
-          QgsGeometry transformed = geom;
-          if ( transformed.transform( mTransform ) == 0 )
+          out += '"';
+          const QByteArray utf8 = value.toString().toUtf8();
+          // multi-bytes UTF-8 sequences never contain ASCII bytes
+          for ( const char c : utf8 )
           {
-            geom = transformed;
-            crs = params.outputCrs;
-            if ( crs.isGeographic() && !params.crs.isGeographic() )
-              prec = std::min( params.precision + 3, 6 );
+            switch ( c )
+            {
+              case '\\':
+                out += "\\\\";
+                break;
+              case '"':
+                out += "\\\"";
+                break;
+              case '\r':
+                out += "\\r";
+                break;
+              case '\b':
+                out += "\\b";
+                break;
+              case '\t':
+                out += "\\t";
+                break;
+              case '/':
+                out += "\\/";
+                break;
+              case '\n':
+                out += "\\n";
+                break;
+              default:
+                out += c;
+            }
           }
+          out += '"';
         }
-        catch ( QgsCsException &cse )
-        {
-          Q_UNUSED( cse );
-        }
+      }
+    }
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
-        QDomElement gmlElem;
+    void createFeatureGeoJSON( QByteArray &out, QgsFeature *feat, QgsCoordinateTransform &transform, const createFeatureParams &params )
+    {
+      // The feature is written as QgsJsonExporter would have exported it, with its default
+      // precision of 6 and the geometry transformed to EPSG:4326 as RFC 7946 requires.
+      const int prec = 6;
+
+      out += "{\n   \"type\":\"Feature\",\n";
+
+      out += "   \"id\":";
+      appendJsonValue( out, QStringLiteral( "%1.%2" ).arg( params.typeName, FID_TO_STRING( feat->id() ) ) );
+      out += ",\n";
+
+      QgsGeometry geom = feat->geometry();
+      if ( !geom.isNull() && params.withGeom && params.geometryName != QLatin1String( "NONE" ) )
+      {
         if ( params.geometryName == QLatin1String( "EXTENT" ) )
         {
-          QgsGeometry bbox = QgsGeometry::fromRect( geom.boundingBox() );
-          gmlElem = QgsOgcUtils::geometryToGML( bbox, doc, prec );
+          geom = QgsGeometry::fromRect( geom.boundingBox() );
         }
         else if ( params.geometryName == QLatin1String( "CENTROID" ) )
         {
-          QgsGeometry centroid = geom.centroid();
-          gmlElem = QgsOgcUtils::geometryToGML( centroid, doc, prec );
+          geom = geom.centroid();
         }
-        else
+      }
+      else
+      {
+        geom = QgsGeometry();
+      }
+
+      if ( !geom.isNull() )
+      {
+        if ( params.crs.isValid() )
         {
-          const QgsAbstractGeometry *abstractGeom = geom.constGet();
-          if ( abstractGeom )
+          if ( transform.sourceCrs() != params.crs )
+            transform.setSourceCrs( params.crs );
+          try
           {
-            gmlElem = abstractGeom->asGml2( doc, prec, "http://www.opengis.net/gml" );
+            QgsGeometry transformed = geom;
+            if ( transformed.transform( transform ) == 0 )
+              geom = transformed;
           }
-        }
-
-        if ( !gmlElem.isNull() )
-        {
-          QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
-          QDomElement boxElem = QgsOgcUtils::rectangleToGMLBox( &box, doc, prec );
-
-          if ( crs.isValid() )
+          catch ( QgsCsException &cse )
           {
-            boxElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-            gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
+            Q_UNUSED( cse );
           }
+        }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
-
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+        if ( QgsWkbTypes::flatType( geom.wkbType() ) != QgsWkbTypes::Point )
+        {
+          const QgsRectangle box = geom.boundingBox();
+          out += "   \"bbox\":[";
+          out += qgsDoubleToString( box.xMinimum(), prec ).toUtf8();
+          out += ", ";
+          out += qgsDoubleToString( box.yMinimum(), prec ).toUtf8();
+          out += ", ";
+          out += qgsDoubleToString( box.xMaximum(), prec ).toUtf8();
+          out += ", ";
+          out += qgsDoubleToString( box.yMaximum(), prec ).toUtf8();
+          out += "],\n";
         }
+        out += "   \"geometry\":\n   ";
+        out += geom.asJson( prec ).toUtf8();
+        out += ",\n";
+      }
+      else
+      {
+        out += "   \"geometry\":null,\n";
       }
 
-      //read all attribute values from the feature
-      QgsAttributes featureAttributes = feat->attributes();
-      QgsFields fields = feat->fields();
-      for ( int i = 0; i < params.attributeIndexes.count(); ++i )
+      // the attributes are written in the order of the fields
+      out += "   \"properties\":";
+      const int propertiesStart = out.size();
+      if ( !params.attributeIndexes.isEmpty() )
       {
-        int idx = params.attributeIndexes[i];
-        if ( idx >= fields.count() )
+        const QgsAttributes featureAttributes = feat->attributes();
+        const QgsFields fields = feat->fields();
+        for ( int i = 0; i < fields.count(); ++i )
         {
-          continue;
+          if ( !params.attributeIndexes.contains( i ) )
+            continue;
+
+          out += out.size() == propertiesStart ? "{\n" : ",\n";
+          out += "      \"";
+          out += fields.at( i ).name().toUtf8();
+          out += "\":";
+          appendJsonValue( out, featureAttributes.at( i ) );
         }
-        QString attributeName = fields.at( idx ).name();
-
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ) );
-        QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
       }
+      out += out.size() == propertiesStart ? "null\n" : "\n   }\n";
 
-      return featureElement;
+      out += '}';
     }
 
-    QDomElement createFeatureGML3( QgsFeature *feat, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project )
+
+    void createFeatureGML( QByteArray &out, QgsFeature *feat, QDomDocument &doc, QgsWfsParameters::Format format,
+                           const createFeatureParams &params, const QgsProject *project )
     {
+      // The feature is written as QDom would have saved it with an indentation of 1,
+      // only the GML of the geometry is still built with QDom.
+      const bool gml3 = format == QgsWfsParameters::Format::GML3;
+
       //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      out += "<gml:featureMember>\n";
 
       //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + params.typeName /*qgs:%TYPENAME%*/ );
-      typeNameElement.setAttribute( QStringLiteral( "gml:id" ), params.typeName + "." + QString::number( feat->id() ) );
-      featureElement.appendChild( typeNameElement );
+      const QByteArray typeNameTag = "qgs:" + params.typeName.toUtf8();
+      out += " <";
+      out += typeNameTag;
+      out += gml3 ? " gml:id=\"" : " fid=\"";
+      appendEscaped( out, params.typeName + "." + QString::number( feat->id() ), true );
+      out += "\">\n";
+      const int childrenStart = out.size();
 
       //add geometry column (as gml)
       QgsGeometry geom = feat->geometry();
@@ -1379,32 +1498,34 @@ namespace QgsWfs
           Q_UNUSED( cse );
         }
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
         QDomElement gmlElem;
         if ( params.geometryName == QLatin1String( "EXTENT" ) )
         {
           QgsGeometry bbox = QgsGeometry::fromRect( geom.boundingBox() );
-          gmlElem = QgsOgcUtils::geometryToGML( bbox, doc, QStringLiteral( "GML3" ), prec );
+          gmlElem = gml3 ? QgsOgcUtils::geometryToGML( bbox, doc, QStringLiteral( "GML3" ), prec )
+                    : QgsOgcUtils::geometryToGML( bbox, doc, prec );
         }
         else if ( params.geometryName == QLatin1String( "CENTROID" ) )
         {
           QgsGeometry centroid = geom.centroid();
-          gmlElem = QgsOgcUtils::geometryToGML( centroid, doc, QStringLiteral( "GML3" ), prec );
+          gmlElem = gml3 ? QgsOgcUtils::geometryToGML( centroid, doc, QStringLiteral( "GML3" ), prec )
+                    : QgsOgcUtils::geometryToGML( centroid, doc, prec );
         }
         else
         {
           const QgsAbstractGeometry *abstractGeom = geom.constGet();
           if ( abstractGeom )
           {
-            gmlElem = abstractGeom->asGml3( doc, prec, "http://www.opengis.net/gml" );
+            gmlElem = gml3 ? abstractGeom->asGml3( doc, prec, "http://www.opengis.net/gml" )
+                      : abstractGeom->asGml2( doc, prec, "http://www.opengis.net/gml" );
           }
         }
 
         if ( !gmlElem.isNull() )
         {
           QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
-          QDomElement boxElem = QgsOgcUtils::rectangleToGMLEnvelope( &box, doc, prec );
+          QDomElement boxElem = gml3 ? QgsOgcUtils::rectangleToGMLEnvelope( &box, doc, prec )
+                                : QgsOgcUtils::rectangleToGMLBox( &box, doc, prec );
 
           if ( crs.isValid() )
           {
@@ -1412,11 +1533,13 @@ namespace QgsWfs
             gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
           }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
+          out += "  <gml:boundedBy>\n";
+          appendElement( out, boxElem, 3 );
+          out += "  </gml:boundedBy>\n";
 
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          out += "  <qgs:geometry>\n";
+          appendElement( out, gmlElem, 3 );
+          out += "  </qgs:geometry>\n";
         }
       }
 
@@ -1431,19 +1554,32 @@ namespace QgsWfs
           continue;
         }
         QString attributeName = fields.at( idx ).name();
-
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ) );
-        QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
+        const QByteArray fieldTag = "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ).toUtf8();
+
+        out += "  <";
+        out += fieldTag;
+        out += '>';
+        appendEscaped( out, featureAttributes[idx].toString(), false );
+        out += "</";
+        out += fieldTag;
+        out += ">\n";
       }
 
-      return featureElement;
+      if ( out.size() == childrenStart )
+      {
+        // no child element
+        out.chop( 2 );
+        out += "/>\n";
+      }
+      else
+      {
+        out += " </";
+        out += typeNameTag;
+        out += ">\n";
+      }
+      out += "</gml:featureMember>\n";
     }
 
-
-
-
   } // namespace
 
 } // samespace QgsWfs
@@ -118,7 +118,11 @@ namespace QgsWms
 
     if ( !capabilitiesDocument && cache ) //capabilities xml not in cache plugins
     {
-      capabilitiesDocument = capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey );
+      doc = capabilitiesCache->capabilitiesDocument( configFilePath, cacheKey );
+      if ( !doc.isNull() )
+      {
+        capabilitiesDocument = &doc;
+      }
     }
 
     if ( !capabilitiesDocument ) //capabilities xml not in cache. Create a new one
@@ -135,7 +139,7 @@ namespace QgsWms
       else if ( cache )
       {
         capabilitiesCache->insertCapabilitiesDocument( configFilePath, cacheKey, &doc );
-        capabilitiesDocument = capabilitiesCache->searchCapabilitiesDocument( configFilePath, cacheKey );
+        capabilitiesDocument = &doc;
       }
       if ( !capabilitiesDocument )
       {
@@ -34,6 +34,22 @@ namespace QgsWms
     Q_UNUSED( version );
 
     QgsServerRequest::Parameters params = request.parameters();
+    QString format = params.value( QStringLiteral( "FORMAT" ), QStringLiteral( "PNG" ) );
+
+    // Get cached image
+    QgsAccessControl *accessControl = serverIface->accessControls();
+    QgsServerCacheManager *cacheManager = serverIface->cacheManager();
+    if ( cacheManager )
+    {
+      // only images of a supported format are cached
+      const QByteArray content = cacheManager->getCachedImage( project, request, accessControl );
+      if ( !content.isEmpty() )
+      {
+        response.setHeader( QStringLiteral( "Content-Type" ), parseImageFormat( format ) == JPEG ? QStringLiteral( "image/jpeg" ) : QStringLiteral( "image/png" ) );
+        response.write( content );
+        return;
+      }
+    }
 
     QgsWmsParameters wmsParameters( QUrlQuery( request.url() ) );
     QgsRenderer renderer( serverIface, project, wmsParameters );
@@ -42,8 +58,13 @@ namespace QgsWms
 
     if ( result )
     {
-      QString format = params.value( QStringLiteral( "FORMAT" ), QStringLiteral( "PNG" ) );
       writeImage( response, *result,  format, renderer.getImageQuality() );
+      if ( cacheManager )
+      {
+        QByteArray content = response.data();
+        if ( !content.isEmpty() )
+          cacheManager->setCachedImage( &content, project, request, accessControl );
+      }
     }
     else
     {
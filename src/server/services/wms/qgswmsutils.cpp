@@ -21,7 +21,7 @@
 
 #include "qgsmodule.h"
 #include "qgswmsutils.h"
-#include "qgsmediancut.h"
+#include "qgsimagequantizer_p.h"
 #include "qgsconfigcache.h"
 #include "qgsserverprojectutils.h"
 
@@ -117,16 +117,10 @@ namespace QgsWms
         saveFormat = "PNG";
         break;
       case PNG8:
-      {
-        QVector<QRgb> colorTable;
-        medianCut( colorTable, 256, img );
-        result = img.convertToFormat( QImage::Format_Indexed8, colorTable,
-                                      Qt::ColorOnly | Qt::ThresholdDither |
-                                      Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
-      }
-      contentType = "image/png";
-      saveFormat = "PNG";
-      break;
+        result = QgsImageQuantizer::quantize( img, 256 );
+        contentType = "image/png";
+        saveFormat = "PNG";
+        break;
       case PNG16:
         result = img.convertToFormat( QImage::Format_ARGB4444_Premultiplied );
         contentType = "image/png";
@@ -17,12 +17,164 @@
 #include "qgswmtsutils.h"
 #include "qgswmtsparameters.h"
 #include "qgswmtsgettile.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsserversettings.h"
+#include "qgsserverprojectutils.h"
 
+#include <QBuffer>
 #include <QImage>
 
+#include <algorithm>
+
 namespace QgsWmts
 {
 
+  namespace
+  {
+
+    /**
+     * Renders the block of tiles containing the requested tile in a single WMS GetMap,
+     * caches the sibling tiles and writes the requested tile to the response.
+     * Returns false if the block could not be rendered, or if no cache filter is
+     * registered to store the sibling tiles in.
+     */
+    bool writeMetatile( QgsServerInterface *serverIface, const QgsProject *project,
+                        const QgsWmtsParameters &params, QUrlQuery query,
+                        const QgsServerRequest &request, QgsServerResponse &response,
+                        int metatileColumns, int metatileRows )
+    {
+      // the parameters have already been checked while translating them to the WMS query
+      const tileMatrixInfo tmi = getTileMatrixInfo( params.tileMatrixSet(), project );
+      const tileMatrixSetDef tms = getTileMatrixSet( tmi, getProjectMinScale( project ) );
+      const tileMatrixDef tm = tms.tileMatrixList.at( params.tileMatrixAsInt() );
+      const int tileRow = params.tileRowAsInt();
+      const int tileCol = params.tileColAsInt();
+
+      // rendering the siblings is only worth it if they can be served later
+      QgsServerCacheManager *cacheManager = serverIface->cacheManager();
+      if ( !cacheManager || !cacheManager->hasCaches() )
+      {
+        return false;
+      }
+
+      // block of tiles containing the requested one, clipped to the tile matrix
+      const int firstCol = ( tileCol / metatileColumns ) * metatileColumns;
+      const int firstRow = ( tileRow / metatileRows ) * metatileRows;
+      const int cols = std::min( firstCol + metatileColumns, tm.col ) - firstCol;
+      const int rows = std::min( firstRow + metatileRows, tm.row ) - firstRow;
+      if ( cols * rows <= 1 )
+      {
+        return false;
+      }
+
+      const int tileWidth = 256;
+      const int tileHeight = 256;
+      const double res = tm.resolution;
+      const double minx = tm.left + firstCol * ( tileWidth * res );
+      const double miny = tm.top - ( firstRow + rows ) * ( tileHeight * res );
+      const double maxx = tm.left + ( firstCol + cols ) * ( tileWidth * res );
+      const double maxy = tm.top - firstRow * ( tileHeight * res );
+      QString bbox;
+      if ( tms.ref == "EPSG:4326" )
+      {
+        bbox = qgsDoubleToString( miny, 6 ) + ',' +
+               qgsDoubleToString( minx, 6 ) + ',' +
+               qgsDoubleToString( maxy, 6 ) + ',' +
+               qgsDoubleToString( maxx, 6 );
+      }
+      else
+      {
+        bbox = qgsDoubleToString( minx, 6 ) + ',' +
+               qgsDoubleToString( miny, 6 ) + ',' +
+               qgsDoubleToString( maxx, 6 ) + ',' +
+               qgsDoubleToString( maxy, 6 );
+      }
+
+      const QString bboxName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::BBOX );
+      const QString widthName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::WIDTH );
+      const QString heightName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::HEIGHT );
+      query.removeAllQueryItems( bboxName );
+      query.removeAllQueryItems( widthName );
+      query.removeAllQueryItems( heightName );
+      query.addQueryItem( bboxName, bbox );
+      query.addQueryItem( widthName, QString::number( cols * tileWidth ) );
+      query.addQueryItem( heightName, QString::number( rows * tileHeight ) );
+
+      // the block is rendered lossless, each tile is then encoded in the requested format
+      const QString formatName = QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::FORMAT );
+      query.removeAllQueryItems( formatName );
+      query.addQueryItem( formatName, QStringLiteral( "image/png" ) );
+
+      // render the whole block at once, labels are placed once for all the tiles
+      QgsServerParameters wmsParams( query );
+      QgsServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
+      QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
+      if ( !service )
+      {
+        return false;
+      }
+      QgsBufferServerResponse metatileResponse;
+      service->executeRequest( wmsRequest, metatileResponse, project );
+
+      QImage metatile;
+      if ( metatileResponse.statusCode() != 200 || !metatile.loadFromData( metatileResponse.data() ) ||
+           metatile.width() != cols * tileWidth || metatile.height() != rows * tileHeight )
+      {
+        // e.g. the block is larger than the maximum size of WMS images
+        return false;
+      }
+
+      QString contentType;
+      QString saveFormat;
+      int imageQuality = -1;
+      if ( params.format() == QgsWmtsParameters::Format::JPG )
+      {
+        contentType = QStringLiteral( "image/jpeg" );
+        saveFormat = QStringLiteral( "JPEG" );
+        // same quality as the tiles rendered one at a time by the WMS
+        imageQuality = QgsServerProjectUtils::wmsImageQuality( *project );
+      }
+      else
+      {
+        contentType = QStringLiteral( "image/png" );
+        saveFormat = QStringLiteral( "PNG" );
+      }
+
+      QgsAccessControl *accessControl = serverIface->accessControls();
+      QByteArray tileContent;
+      for ( int row = 0; row < rows; ++row )
+      {
+        for ( int col = 0; col < cols; ++col )
+        {
+          const bool requestedTile = firstRow + row == tileRow && firstCol + col == tileCol;
+
+          QByteArray content;
+          QBuffer buffer( &content );
+          buffer.open( QIODevice::WriteOnly );
+          metatile.copy( col * tileWidth, row * tileHeight, tileWidth, tileHeight ).save( &buffer, qPrintable( saveFormat ), imageQuality );
+
+          if ( requestedTile )
+          {
+            tileContent = content;
+            cacheManager->setCachedImage( &content, project, request, accessControl );
+          }
+          else
+          {
+            // siblings are requested with the same parameters but the tile position
+            QgsServerRequest siblingRequest( request );
+            siblingRequest.setParameter( QStringLiteral( "TILEROW" ), QString::number( firstRow + row ) );
+            siblingRequest.setParameter( QStringLiteral( "TILECOL" ), QString::number( firstCol + col ) );
+            cacheManager->setCachedImage( &content, project, siblingRequest, accessControl );
+          }
+        }
+      }
+
+      response.setHeader( QStringLiteral( "Content-Type" ), contentType );
+      response.write( tileContent );
+      return true;
+    }
+  }
+
   void writeGetTile( QgsServerInterface *serverIface, const QgsProject *project,
                      const QString &version, const QgsServerRequest &request,
                      QgsServerResponse &response )
@@ -65,6 +217,15 @@ namespace QgsWmts
     }
 
 
+    const QgsServerSettings *settings = serverIface->serverSettings();
+    const int metatileColumns = settings ? std::max( settings->wmtsMetatileColumns(), 1 ) : 1;
+    const int metatileRows = settings ? std::max( settings->wmtsMetatileRows(), 1 ) : 1;
+    if ( metatileColumns * metatileRows > 1 &&
+         writeMetatile( serverIface, project, params, query, request, response, metatileColumns, metatileRows ) )
+    {
+      return;
+    }
+
     QgsServerParameters wmsParams( query );
     QgsServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
     QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
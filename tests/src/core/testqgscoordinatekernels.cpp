@@ -0,0 +1,393 @@
+/***************************************************************************
+     testqgscoordinatekernels.cpp
+     --------------------------------------
+    Date                 : October 2018
+    Copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QTransform>
+#include <QVector>
+
+#include <cmath>
+#include <limits>
+
+#include "qgsapplication.h"
+#include "qgscoordinatekernels_p.h"
+#include "qgslinestring.h"
+#include "qgspolygon.h"
+
+Q_DECLARE_METATYPE( QgsCoordinateKernels::Implementation )
+
+class TestQgsCoordinateKernels : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+
+    void boundingBox_data();
+    void boundingBox();
+    void length_data();
+    void length();
+    void shoelace_data();
+    void shoelace();
+    void affineTransform_data();
+    void affineTransform();
+    void scaleTranslate_data();
+    void scaleTranslate();
+    void lineString_data();
+    void lineString();
+
+    void benchmarkBoundingBox_data();
+    void benchmarkBoundingBox();
+    void benchmarkLength_data();
+    void benchmarkLength();
+    void benchmarkArea_data();
+    void benchmarkArea();
+    void benchmarkAffineTransform_data();
+    void benchmarkAffineTransform();
+
+  private:
+    void addImplementations();
+    void addImplementationsAndCounts();
+    static void randomCoordinates( int count, QVector< double > &x, QVector< double > &y );
+};
+
+void TestQgsCoordinateKernels::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsCoordinateKernels::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsCoordinateKernels::cleanup()
+{
+  QgsCoordinateKernels::setImplementation( QgsCoordinateKernels::bestImplementation() );
+}
+
+void TestQgsCoordinateKernels::addImplementations()
+{
+  QTest::addColumn< QgsCoordinateKernels::Implementation >( "implementation" );
+  QTest::addColumn< int >( "count" );
+
+  // implementations not supported by the CPU silently fall back to the best one
+  QTest::newRow( "scalar" ) << QgsCoordinateKernels::Scalar << 100000;
+  QTest::newRow( "sse2" ) << QgsCoordinateKernels::Sse2 << 100000;
+  QTest::newRow( "avx2" ) << QgsCoordinateKernels::Avx2 << 100000;
+}
+
+void TestQgsCoordinateKernels::addImplementationsAndCounts()
+{
+  QTest::addColumn< QgsCoordinateKernels::Implementation >( "implementation" );
+  QTest::addColumn< int >( "count" );
+
+  // odd sizes exercise the scalar tails of the vector loops
+  const QList< int > counts = QList< int >() << 0 << 1 << 2 << 3 << 4 << 5 << 7 << 8 << 9 << 1001;
+  for ( int count : counts )
+  {
+    QTest::newRow( QStringLiteral( "scalar %1" ).arg( count ).toLatin1() ) << QgsCoordinateKernels::Scalar << count;
+    QTest::newRow( QStringLiteral( "sse2 %1" ).arg( count ).toLatin1() ) << QgsCoordinateKernels::Sse2 << count;
+    QTest::newRow( QStringLiteral( "avx2 %1" ).arg( count ).toLatin1() ) << QgsCoordinateKernels::Avx2 << count;
+  }
+}
+
+void TestQgsCoordinateKernels::randomCoordinates( int count, QVector<double> &x, QVector<double> &y )
+{
+  qsrand( count + 1 );
+  x.resize( count );
+  y.resize( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    x[i] = -1000.0 + 2000.0 * qrand() / RAND_MAX;
+    y[i] = -1000.0 + 2000.0 * qrand() / RAND_MAX;
+  }
+}
+
+void TestQgsCoordinateKernels::boundingBox_data()
+{
+  addImplementationsAndCounts();
+}
+
+void TestQgsCoordinateKernels::boundingBox()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > x;
+  QVector< double > y;
+  randomCoordinates( count, x, y );
+  if ( count > 3 )
+  {
+    x[2] = std::numeric_limits<double>::quiet_NaN();
+    y[count - 1] = std::numeric_limits<double>::quiet_NaN();
+  }
+
+  double expectedXMin = std::numeric_limits<double>::max();
+  double expectedYMin = std::numeric_limits<double>::max();
+  double expectedXMax = -std::numeric_limits<double>::max();
+  double expectedYMax = -std::numeric_limits<double>::max();
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( x[i] < expectedXMin )
+      expectedXMin = x[i];
+    if ( x[i] > expectedXMax )
+      expectedXMax = x[i];
+    if ( y[i] < expectedYMin )
+      expectedYMin = y[i];
+    if ( y[i] > expectedYMax )
+      expectedYMax = y[i];
+  }
+
+  QgsCoordinateKernels::setImplementation( implementation );
+  double xMin, yMin, xMax, yMax;
+  QgsCoordinateKernels::boundingBox( x.constData(), y.constData(), count, xMin, yMin, xMax, yMax );
+  QCOMPARE( xMin, expectedXMin );
+  QCOMPARE( yMin, expectedYMin );
+  QCOMPARE( xMax, expectedXMax );
+  QCOMPARE( yMax, expectedYMax );
+}
+
+void TestQgsCoordinateKernels::length_data()
+{
+  addImplementationsAndCounts();
+}
+
+void TestQgsCoordinateKernels::length()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > x;
+  QVector< double > y;
+  randomCoordinates( count, x, y );
+
+  double expected = 0;
+  for ( int i = 1; i < count; ++i )
+  {
+    expected += std::sqrt( ( x[i] - x[i - 1] ) * ( x[i] - x[i - 1] ) + ( y[i] - y[i - 1] ) * ( y[i] - y[i - 1] ) );
+  }
+
+  QgsCoordinateKernels::setImplementation( implementation );
+  QGSCOMPARENEAR( QgsCoordinateKernels::length( x.constData(), y.constData(), count ), expected, 1e-6 );
+}
+
+void TestQgsCoordinateKernels::shoelace_data()
+{
+  addImplementationsAndCounts();
+}
+
+void TestQgsCoordinateKernels::shoelace()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > x;
+  QVector< double > y;
+  randomCoordinates( count, x, y );
+
+  double expected = 0;
+  for ( int i = 0; i < count - 1; ++i )
+  {
+    expected += x[i] * y[i + 1] - y[i] * x[i + 1];
+  }
+
+  QgsCoordinateKernels::setImplementation( implementation );
+  QGSCOMPARENEAR( QgsCoordinateKernels::shoelace( x.constData(), y.constData(), count ), expected, 1e-4 );
+}
+
+void TestQgsCoordinateKernels::affineTransform_data()
+{
+  addImplementationsAndCounts();
+}
+
+void TestQgsCoordinateKernels::affineTransform()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > x;
+  QVector< double > y;
+  randomCoordinates( count, x, y );
+
+  const QTransform t = QTransform::fromTranslate( 10, -20 ).rotate( 33 ).scale( 1.5, 0.5 );
+  QVector< double > expectedX( count );
+  QVector< double > expectedY( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    t.map( x[i], y[i], &expectedX[i], &expectedY[i] );
+  }
+
+  QgsCoordinateKernels::setImplementation( implementation );
+  QgsCoordinateKernels::affineTransform( x.data(), y.data(), count, t.m11(), t.m12(), t.m21(), t.m22(), t.dx(), t.dy() );
+  for ( int i = 0; i < count; ++i )
+  {
+    QCOMPARE( x[i], expectedX[i] );
+    QCOMPARE( y[i], expectedY[i] );
+  }
+}
+
+void TestQgsCoordinateKernels::scaleTranslate_data()
+{
+  addImplementationsAndCounts();
+}
+
+void TestQgsCoordinateKernels::scaleTranslate()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > values;
+  QVector< double > unused;
+  randomCoordinates( count, values, unused );
+  QVector< double > expected = values;
+  for ( int i = 0; i < count; ++i )
+  {
+    expected[i] = expected[i] * 2.5 - 3;
+  }
+
+  QgsCoordinateKernels::setImplementation( implementation );
+  QgsCoordinateKernels::scaleTranslate( values.data(), count, 2.5, -3 );
+  QCOMPARE( values, expected );
+}
+
+void TestQgsCoordinateKernels::lineString_data()
+{
+  addImplementations();
+}
+
+void TestQgsCoordinateKernels::lineString()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QgsCoordinateKernels::setImplementation( implementation );
+
+  QgsLineString ring( QVector< double >() << 0 << 10 << 10 << 0 << 0,
+                      QVector< double >() << 0 << 0 << 5 << 5 << 0,
+                      QVector< double >() << 1 << 2 << 3 << 4 << 1,
+                      QVector< double >() << 5 << 6 << 7 << 8 << 5 );
+  QCOMPARE( ring.boundingBox(), QgsRectangle( 0, 0, 10, 5 ) );
+  QGSCOMPARENEAR( ring.length(), 30, 1e-12 );
+
+  QgsPolygon polygon;
+  polygon.setExteriorRing( ring.clone() );
+  QGSCOMPARENEAR( polygon.area(), 50, 1e-12 );
+
+  ring.transform( QTransform::fromScale( 2, 3 ).translate( 1, 1 ), 1, 2, 3, 4 );
+  QCOMPARE( ring.pointN( 2 ), QgsPoint( QgsWkbTypes::PointZM, 22, 18, 7, 31 ) );
+  QCOMPARE( ring.boundingBox(), QgsRectangle( 2, 3, 22, 18 ) );
+
+  // projective transforms keep going through QTransform::map
+  QgsLineString projected( QVector< QgsPoint >() << QgsPoint( 1, 1 ) << QgsPoint( 2, 3 ) );
+  QTransform projective( 1, 0, 0.5, 0, 1, 0, 0, 0, 1 );
+  projected.transform( projective );
+  QCOMPARE( projected.pointN( 1 ), QgsPoint( 1, 1.5 ) );
+}
+
+void TestQgsCoordinateKernels::benchmarkBoundingBox_data()
+{
+  addImplementations();
+}
+
+void TestQgsCoordinateKernels::benchmarkBoundingBox()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > x;
+  QVector< double > y;
+  randomCoordinates( count, x, y );
+  QgsCoordinateKernels::setImplementation( implementation );
+
+  double xMin, yMin, xMax, yMax;
+  QBENCHMARK
+  {
+    QgsCoordinateKernels::boundingBox( x.constData(), y.constData(), count, xMin, yMin, xMax, yMax );
+  }
+}
+
+void TestQgsCoordinateKernels::benchmarkLength_data()
+{
+  addImplementations();
+}
+
+void TestQgsCoordinateKernels::benchmarkLength()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > x;
+  QVector< double > y;
+  randomCoordinates( count, x, y );
+  QgsLineString line( x, y );
+  QgsCoordinateKernels::setImplementation( implementation );
+
+  QBENCHMARK
+  {
+    line.length();
+  }
+}
+
+void TestQgsCoordinateKernels::benchmarkArea_data()
+{
+  addImplementations();
+}
+
+void TestQgsCoordinateKernels::benchmarkArea()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > x;
+  QVector< double > y;
+  randomCoordinates( count, x, y );
+  x.append( x.at( 0 ) );
+  y.append( y.at( 0 ) );
+  QgsPolygon polygon;
+  polygon.setExteriorRing( new QgsLineString( x, y ) );
+  QgsCoordinateKernels::setImplementation( implementation );
+
+  QBENCHMARK
+  {
+    polygon.area();
+  }
+}
+
+void TestQgsCoordinateKernels::benchmarkAffineTransform_data()
+{
+  addImplementations();
+}
+
+void TestQgsCoordinateKernels::benchmarkAffineTransform()
+{
+  QFETCH( QgsCoordinateKernels::Implementation, implementation );
+  QFETCH( int, count );
+
+  QVector< double > x;
+  QVector< double > y;
+  randomCoordinates( count, x, y );
+  QgsLineString line( x, y );
+  const QTransform t = QTransform::fromTranslate( 1, 1 ).rotate( 0.1 );
+  QgsCoordinateKernels::setImplementation( implementation );
+
+  QBENCHMARK
+  {
+    line.transform( t );
+  }
+}
+
+QGSTEST_MAIN( TestQgsCoordinateKernels )
+#include "testqgscoordinatekernels.moc"
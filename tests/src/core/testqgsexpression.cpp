@@ -3148,6 +3148,275 @@ class TestQgsExpression: public QObject
 
       QCOMPARE( v.toDateTime().toMSecsSinceEpoch(), v2.toDateTime().toMSecsSinceEpoch() );
     }
+
+    void bytecode_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<bool>( "compiled" );
+
+      QTest::newRow( "literal" ) << "1" << false;
+      QTest::newRow( "column" ) << "\"int\"" << false;
+      QTest::newRow( "static" ) << "1 + 2" << false;
+      QTest::newRow( "int arithmetic" ) << "\"int\" * 3 - 1" << true;
+      QTest::newRow( "int division" ) << "\"int\" / 2" << true;
+      QTest::newRow( "int integer division" ) << "\"int\" // 2" << true;
+      QTest::newRow( "mod zero" ) << "\"int\" % 0" << true;
+      QTest::newRow( "div zero" ) << "\"double\" / 0" << true;
+      QTest::newRow( "mixed arithmetic" ) << "\"int\" + \"double\" ^ 2" << true;
+      QTest::newRow( "null arithmetic" ) << "\"null\" + 1" << true;
+      QTest::newRow( "null string plus" ) << "\"null\" + 'a'" << true;
+      QTest::newRow( "string plus" ) << "\"string\" + 'a'" << true;
+      QTest::newRow( "string int plus" ) << "'5' + \"int\"" << true;
+      QTest::newRow( "unary minus" ) << "-\"double\"" << true;
+      QTest::newRow( "unary minus string" ) << "-\"string\"" << true;
+      QTest::newRow( "not" ) << "NOT \"int\"" << true;
+      QTest::newRow( "compare int" ) << "\"int\" >= 5" << true;
+      QTest::newRow( "compare double" ) << "\"double\" = 2.5" << true;
+      QTest::newRow( "compare string" ) << "\"string\" < 'zzz'" << true;
+      QTest::newRow( "compare string number" ) << "\"string\" = 5" << true;
+      QTest::newRow( "compare null" ) << "\"null\" <> 5" << true;
+      QTest::newRow( "is null" ) << "\"null\" IS NULL" << true;
+      QTest::newRow( "is not" ) << "\"int\" IS NOT 5" << true;
+      QTest::newRow( "and or" ) << "\"int\" > 3 AND (\"double\" < 1 OR \"null\")" << true;
+      QTest::newRow( "and string" ) << "\"int\" AND \"string\"" << true;
+      QTest::newRow( "concat" ) << "\"string\" || '-' || \"int\"" << true;
+      QTest::newRow( "concat null" ) << "\"string\" || \"null\"" << true;
+      QTest::newRow( "like" ) << "\"string\" LIKE 'ro%'" << false;
+      QTest::newRow( "like in operator" ) << "\"string\" LIKE 'ro%' AND \"int\" > 1" << true;
+      QTest::newRow( "function" ) << "abs(\"int\" - 10) * 2" << true;
+      QTest::newRow( "in" ) << "\"int\" IN (1, 7, 9) OR \"double\" > 1" << true;
+      QTest::newRow( "case" ) << "CASE WHEN \"int\" > 10 THEN 'big' WHEN \"int\" > 5 THEN \"string\" ELSE \"double\" END" << true;
+      QTest::newRow( "case no else" ) << "CASE WHEN \"null\" THEN 1 END" << true;
+      QTest::newRow( "eval error" ) << "\"int\" + to_int('x') * 2" << true;
+      QTest::newRow( "datetime" ) << "to_datetime('2018-10-01 00:00:00') + to_interval(\"int\" || ' days') > to_datetime('2018-10-05 00:00:00')" << true;
+    }
+
+    void bytecode()
+    {
+      QFETCH( QString, string );
+      QFETCH( bool, compiled );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "double" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "string" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "null" ), QVariant::Int ) );
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+
+      QgsExpression treeExp( string );
+      treeExp.setBytecodeEnabled( false );
+      QVERIFY( treeExp.prepare( &context ) );
+      QVERIFY( !treeExp.hasBytecode() );
+
+      QgsExpression bytecodeExp( string );
+      QVERIFY( bytecodeExp.isBytecodeEnabled() );
+      QVERIFY( bytecodeExp.prepare( &context ) );
+      QCOMPARE( bytecodeExp.hasBytecode(), compiled );
+
+      // implicitly shared copies must keep a working program
+      QgsExpression copy( bytecodeExp );
+      copy.setGeomCalculator( nullptr );
+      QCOMPARE( copy.hasBytecode(), compiled );
+
+      const QList< QVariantList > rows = QList< QVariantList >()
+                                         << ( QVariantList() << 7 << 2.5 << QStringLiteral( "road" ) << QVariant( QVariant::Int ) )
+                                         << ( QVariantList() << 12 << 0.5 << QStringLiteral( "5" ) << QVariant( QVariant::Int ) )
+                                         << ( QVariantList() << 0 << -1.0 << QVariant( QVariant::String ) << QVariant( QVariant::Int ) )
+                                         << ( QVariantList() << QVariant( QVariant::Int ) << QVariant( QVariant::Double ) << QStringLiteral( "x" ) << 3 );
+      for ( const QVariantList &row : rows )
+      {
+        QgsFeature f( fields );
+        f.setAttributes( row.toVector() );
+        context.setFeature( f );
+
+        const QVariant expected = treeExp.evaluate( &context );
+        const QVariant result = bytecodeExp.evaluate( &context );
+        const QVariant copyResult = copy.evaluate( &context );
+        QCOMPARE( result, expected );
+        QCOMPARE( result.type(), expected.type() );
+        QCOMPARE( result.isNull(), expected.isNull() );
+        QCOMPARE( copyResult, expected );
+        QCOMPARE( bytecodeExp.hasEvalError(), treeExp.hasEvalError() );
+        QCOMPARE( bytecodeExp.evalErrorString(), treeExp.evalErrorString() );
+      }
+    }
+
+    void bytecodeSharedCopies()
+    {
+      // copies share the compiled program, evaluating them concurrently must not share registers
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int" ), QVariant::Int ) );
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+      QgsExpression exp( QStringLiteral( "CASE WHEN \"int\" % 2 = 0 THEN \"int\" * 3 - 1 ELSE \"int\" + 1000 END" ) );
+      QVERIFY( exp.prepare( &context ) );
+      QVERIFY( exp.hasBytecode() );
+
+      // each item holds a thread number, then the number of wrong results of that thread
+      QList< int > mismatches;
+      for ( int i = 0; i < 8; ++i )
+        mismatches << i;
+      QtConcurrent::blockingMap( mismatches, [&exp, &fields]( int &item )
+      {
+        const int thread = item;
+        QgsExpression copy( exp );
+        QgsExpressionContext threadContext;
+        threadContext.setFields( fields );
+        int mismatchCount = 0;
+        for ( int i = 0; i < 20000; ++i )
+        {
+          const int value = thread * 100000 + i;
+          QgsFeature f( fields );
+          f.setAttributes( QgsAttributes() << value );
+          threadContext.setFeature( f );
+          const int expected = value % 2 == 0 ? value * 3 - 1 : value + 1000;
+          if ( copy.evaluate( &threadContext ).toInt() != expected )
+            mismatchCount++;
+        }
+        item = mismatchCount;
+      } );
+      for ( int mismatchCount : qgis::as_const( mismatches ) )
+        QCOMPARE( mismatchCount, 0 );
+    }
+
+    void evaluateBlock_data()
+    {
+      bytecode_data();
+    }
+
+    void evaluateBlock()
+    {
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "double" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "string" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "null" ), QVariant::Int ) );
+
+      QgsFeatureList features;
+      for ( int i = 0; i < 50; ++i )
+      {
+        QgsFeature f( fields, i );
+        f.setAttributes( QgsAttributes() << ( i % 7 ? QVariant( i - 10 ) : QVariant( QVariant::Int ) )
+                         << i * 0.25
+                         << ( i % 3 ? QStringLiteral( "road%1" ).arg( i ) : QString::number( i ) )
+                         << ( i % 5 ? QVariant( QVariant::Int ) : QVariant( i ) ) );
+        features << f;
+      }
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+
+      for ( bool useBytecode : { false, true } )
+      {
+        QgsExpression exp( string );
+        exp.setBytecodeEnabled( useBytecode );
+        QVERIFY( exp.prepare( &context ) );
+
+        QString firstError;
+        QVariantList expected;
+        for ( const QgsFeature &f : qgis::as_const( features ) )
+        {
+          context.setFeature( f );
+          expected << exp.evaluate( &context );
+          if ( firstError.isNull() && exp.hasEvalError() )
+            firstError = exp.evalErrorString();
+        }
+
+        const QVariantList results = exp.evaluateBlock( features, &context );
+        QCOMPARE( results.count(), features.count() );
+        for ( int i = 0; i < results.count(); ++i )
+        {
+          QCOMPARE( results.at( i ), expected.at( i ) );
+          QCOMPARE( results.at( i ).type(), expected.at( i ).type() );
+        }
+        QCOMPARE( exp.evalErrorString(), firstError );
+      }
+    }
+
+    void evaluateBlockFilter()
+    {
+      // filtering an iterator evaluates the filter over blocks of features
+      QgsVectorLayer layer( QStringLiteral( "Point?field=col1:integer" ), QStringLiteral( "layer" ), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      for ( int i = 0; i < 1000; ++i )
+      {
+        QgsFeature f( layer.fields() );
+        f.setAttributes( QgsAttributes() << i );
+        features << f;
+      }
+      layer.dataProvider()->addFeatures( features );
+
+      QgsFeatureRequest request;
+      request.setFilterExpression( QStringLiteral( "col1 % 3 = 0 AND col1 > 100" ) );
+      QgsFeatureIterator it = layer.dataProvider()->getFeatures( request );
+      QgsFeature f;
+      int count = 0;
+      int expected = 102;
+      while ( it.nextFeature( f ) )
+      {
+        QCOMPARE( f.attribute( 0 ).toInt(), expected );
+        expected += 3;
+        count++;
+      }
+      QCOMPARE( count, 300 );
+
+      request.setLimit( 2 );
+      it = layer.dataProvider()->getFeatures( request );
+      count = 0;
+      while ( it.nextFeature( f ) )
+        count++;
+      QCOMPARE( count, 2 );
+    }
+
+    void bytecodeBenchmark_data()
+    {
+      QTest::addColumn<bool>( "bytecode" );
+
+      QTest::newRow( "tree walker" ) << false;
+      QTest::newRow( "bytecode" ) << true;
+    }
+
+    void bytecodeBenchmark()
+    {
+      QFETCH( bool, bytecode );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "class" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "width" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "type" ), QVariant::String ) );
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+
+      QgsExpression exp( QStringLiteral( "CASE WHEN \"class\" % 3 = 0 AND \"width\" > 2.5 THEN \"class\" * 2 + \"width\" "
+                                         "WHEN \"type\" = 'road' THEN -\"width\" ELSE \"class\" / 4 END" ) );
+      exp.setBytecodeEnabled( bytecode );
+      QVERIFY( exp.prepare( &context ) );
+      QCOMPARE( exp.hasBytecode(), bytecode );
+
+      QgsFeatureList features;
+      for ( int i = 0; i < 1000; ++i )
+      {
+        QgsFeature f( fields, i );
+        f.setAttributes( QgsAttributes() << i << i * 0.01 << ( i % 2 ? QStringLiteral( "road" ) : QStringLiteral( "path" ) ) );
+        features << f;
+      }
+
+      // each iteration evaluates 1000 features, so the reported time per iteration is the cost per 1000 features
+      QBENCHMARK
+      {
+        for ( const QgsFeature &f : qgis::as_const( features ) )
+        {
+          context.setFeature( f );
+          exp.evaluate( &context );
+        }
+      }
+    }
 };
 
 QGSTEST_MAIN( TestQgsExpression )
@@ -82,6 +82,7 @@ class TestQgsGeometry : public QObject
     void isEmpty();
     void operatorBool();
     void equality();
+    void lazyWkb();
     void vertexIterator();
 
 
@@ -436,6 +437,34 @@ void TestQgsGeometry::operatorBool()
   QVERIFY( !geom );
 }
 
+void TestQgsGeometry::lazyWkb()
+{
+  const QByteArray wkb = QgsGeometry::fromWkt( QStringLiteral( "LineString( 1 2, 3 4, 5 7 )" ) ).asWkb();
+  QVERIFY( wkb.isDetached() );
+
+  QgsGeometry geom;
+  geom.fromWkb( wkb );
+  QVERIFY( geom.wkbView() );
+  QVERIFY( !wkb.isDetached() );
+  QCOMPARE( geom.boundingBox(), QgsRectangle( 1, 2, 5, 7 ) );
+
+  // shared copies keep the WKB, another copy may be reading it
+  QgsGeometry copy( geom );
+  QCOMPARE( geom.constGet()->nCoordinates(), 3 );
+  QVERIFY( !geom.wkbView() );
+  QVERIFY( !wkb.isDetached() );
+
+  // once parsed, an unshared geometry releases the WKB
+  copy = QgsGeometry();
+  QCOMPARE( geom.constGet()->nCoordinates(), 3 );
+  QVERIFY( wkb.isDetached() );
+  QCOMPARE( geom.asWkb(), wkb );
+
+  geom.fromWkb( wkb );
+  QCOMPARE( geom.asWkt(), QStringLiteral( "LineString (1 2, 3 4, 5 7)" ) );
+  QVERIFY( wkb.isDetached() );
+}
+
 void TestQgsGeometry::equality()
 {
   // null geometries
@@ -0,0 +1,238 @@
+/***************************************************************************
+     testqgsimagequantizer.cpp
+     --------------------------------------
+    Date                 : October 2018
+    Copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QImage>
+#include <QPainter>
+#include <QLinearGradient>
+
+#include <cmath>
+
+#include "qgsapplication.h"
+#include "qgsimagequantizer_p.h"
+
+class TestQgsImageQuantizer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void fewColors();
+    void transparentPixels();
+    void colorCount();
+    void gradient();
+    void dither();
+    void imageProperties();
+
+    void benchmarkColorTable();
+    void benchmarkQImageConversion();
+    void benchmarkQuantize();
+    void benchmarkQuantizeDithered();
+
+  private:
+    static QImage mapImage( int width, int height );
+};
+
+void TestQgsImageQuantizer::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsImageQuantizer::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QImage TestQgsImageQuantizer::mapImage( int width, int height )
+{
+  // antialiased shapes over a gradient, roughly like a rendered map
+  QImage image( width, height, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::transparent );
+  QPainter painter( &image );
+  painter.setRenderHint( QPainter::Antialiasing );
+  QLinearGradient gradient( 0, 0, width, height );
+  gradient.setColorAt( 0, QColor( 200, 230, 250 ) );
+  gradient.setColorAt( 1, QColor( 120, 160, 90 ) );
+  painter.fillRect( QRect( 0, 0, width, height / 2 ), gradient );
+  qsrand( 1 );
+  for ( int i = 0; i < 200; ++i )
+  {
+    painter.setPen( QPen( QColor( qrand() % 256, qrand() % 256, qrand() % 256 ), 1 + qrand() % 4 ) );
+    painter.setBrush( QColor( qrand() % 256, qrand() % 256, qrand() % 256, 128 + qrand() % 128 ) );
+    painter.drawEllipse( QPoint( qrand() % width, qrand() % height ), 10 + qrand() % ( width / 8 ), 10 + qrand() % ( height / 8 ) );
+  }
+  painter.end();
+  return image;
+}
+
+void TestQgsImageQuantizer::fewColors()
+{
+  QImage image( 100, 80, QImage::Format_ARGB32 );
+  image.fill( qRgb( 255, 0, 0 ) );
+  for ( int x = 0; x < 100; ++x )
+  {
+    image.setPixel( x, 10, qRgb( 254, 1, 0 ) );
+    image.setPixel( x, 20, qRgba( 0, 0, 255, 100 ) );
+  }
+
+  // colors of the same histogram bin are kept apart
+  const QVector<QRgb> colors = QgsImageQuantizer::colorTable( image, 256 );
+  QCOMPARE( colors.size(), 3 );
+
+  const QImage result = QgsImageQuantizer::quantize( image, 256 );
+  QCOMPARE( result.format(), QImage::Format_Indexed8 );
+  QCOMPARE( result.size(), image.size() );
+  for ( int y = 0; y < image.height(); ++y )
+  {
+    for ( int x = 0; x < image.width(); ++x )
+    {
+      QCOMPARE( result.pixel( x, y ), image.pixel( x, y ) );
+    }
+  }
+}
+
+void TestQgsImageQuantizer::transparentPixels()
+{
+  QImage image( 10, 10, QImage::Format_ARGB32 );
+  image.fill( qRgba( 10, 20, 30, 0 ) );
+  image.setPixel( 1, 1, qRgba( 200, 20, 30, 0 ) );
+  image.setPixel( 2, 2, qRgb( 200, 20, 30 ) );
+
+  const QVector<QRgb> colors = QgsImageQuantizer::colorTable( image, 256 );
+  QCOMPARE( colors.size(), 2 );
+
+  const QImage result = QgsImageQuantizer::quantize( image, 256 );
+  QCOMPARE( qAlpha( result.pixel( 0, 0 ) ), 0 );
+  QCOMPARE( result.pixelIndex( 0, 0 ), result.pixelIndex( 1, 1 ) );
+  QCOMPARE( result.pixel( 2, 2 ), qRgb( 200, 20, 30 ) );
+}
+
+void TestQgsImageQuantizer::colorCount()
+{
+  const QImage image = mapImage( 256, 256 );
+  QCOMPARE( QgsImageQuantizer::colorTable( image, 256 ).size(), 256 );
+  QCOMPARE( QgsImageQuantizer::colorTable( image, 16 ).size(), 16 );
+  QCOMPARE( QgsImageQuantizer::quantize( image, 16 ).colorCount(), 16 );
+  QCOMPARE( QgsImageQuantizer::colorTable( QImage(), 256 ).size(), 0 );
+}
+
+void TestQgsImageQuantizer::gradient()
+{
+  QImage image( 256, 256, QImage::Format_ARGB32 );
+  for ( int y = 0; y < 256; ++y )
+  {
+    for ( int x = 0; x < 256; ++x )
+    {
+      image.setPixel( x, y, qRgb( x, y, 128 ) );
+    }
+  }
+
+  const QImage result = QgsImageQuantizer::quantize( image, 256 );
+  QCOMPARE( result.colorCount(), 256 );
+  int maxError = 0;
+  for ( int y = 0; y < 256; ++y )
+  {
+    for ( int x = 0; x < 256; ++x )
+    {
+      const QRgb mapped = result.pixel( x, y );
+      maxError = std::max( maxError, std::abs( qRed( mapped ) - x ) );
+      maxError = std::max( maxError, std::abs( qGreen( mapped ) - y ) );
+      maxError = std::max( maxError, std::abs( qBlue( mapped ) - 128 ) );
+      QCOMPARE( qAlpha( mapped ), 255 );
+    }
+  }
+  QVERIFY2( maxError <= 24, QString::number( maxError ).toLatin1() );
+}
+
+void TestQgsImageQuantizer::dither()
+{
+  QImage image( 64, 64, QImage::Format_ARGB32 );
+  image.fill( qRgb( 100, 100, 100 ) );
+  const QVector<QRgb> colorTable = QVector<QRgb>() << qRgb( 0, 0, 0 ) << qRgb( 255, 255, 255 );
+
+  // without dithering every pixel gets the nearest color
+  const QImage flat = QgsImageQuantizer::quantize( image, colorTable, false );
+  QCOMPARE( flat.pixel( 10, 10 ), qRgb( 0, 0, 0 ) );
+  QCOMPARE( flat.pixel( 63, 63 ), qRgb( 0, 0, 0 ) );
+
+  // the dithered image keeps the average color
+  const QImage dithered = QgsImageQuantizer::quantize( image, colorTable, true );
+  double sum = 0;
+  for ( int y = 0; y < 64; ++y )
+  {
+    for ( int x = 0; x < 64; ++x )
+    {
+      sum += qRed( dithered.pixel( x, y ) );
+    }
+  }
+  QGSCOMPARENEAR( sum / ( 64 * 64 ), 100, 8 );
+}
+
+void TestQgsImageQuantizer::imageProperties()
+{
+  QImage image = mapImage( 100, 100 );
+  image.setDotsPerMeterX( 5000 );
+  image.setDotsPerMeterY( 6000 );
+  image.setText( QStringLiteral( "key" ), QStringLiteral( "value" ) );
+
+  const QImage result = QgsImageQuantizer::quantize( image, 256 );
+  QCOMPARE( result.dotsPerMeterX(), 5000 );
+  QCOMPARE( result.dotsPerMeterY(), 6000 );
+  QCOMPARE( result.text( QStringLiteral( "key" ) ), QStringLiteral( "value" ) );
+}
+
+void TestQgsImageQuantizer::benchmarkColorTable()
+{
+  const QImage image = mapImage( 2048, 2048 ).convertToFormat( QImage::Format_ARGB32 );
+  QBENCHMARK
+  {
+    QgsImageQuantizer::colorTable( image, 256 );
+  }
+}
+
+void TestQgsImageQuantizer::benchmarkQImageConversion()
+{
+  // mapping previously used for PNG8 WMS output
+  const QImage image = mapImage( 2048, 2048 ).convertToFormat( QImage::Format_ARGB32 );
+  const QVector<QRgb> colorTable = QgsImageQuantizer::colorTable( image, 256 );
+  QBENCHMARK
+  {
+    image.convertToFormat( QImage::Format_Indexed8, colorTable, Qt::ColorOnly | Qt::ThresholdDither | Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+  }
+}
+
+void TestQgsImageQuantizer::benchmarkQuantize()
+{
+  const QImage image = mapImage( 2048, 2048 ).convertToFormat( QImage::Format_ARGB32 );
+  QBENCHMARK
+  {
+    QgsImageQuantizer::quantize( image, 256 );
+  }
+}
+
+void TestQgsImageQuantizer::benchmarkQuantizeDithered()
+{
+  const QImage image = mapImage( 2048, 2048 ).convertToFormat( QImage::Format_ARGB32 );
+  QBENCHMARK
+  {
+    QgsImageQuantizer::quantize( image, 256, true );
+  }
+}
+
+QGSTEST_MAIN( TestQgsImageQuantizer )
+#include "testqgsimagequantizer.moc"
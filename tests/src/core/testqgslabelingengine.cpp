@@ -16,8 +16,10 @@
 #include "qgstest.h"
 
 #include <qgsapplication.h>
+#include <qgsexpressioncontext.h>
 #include <qgslabelingengine.h>
 #include <qgsproject.h>
+#include <qgsmaprendererparalleljob.h>
 #include <qgsmaprenderersequentialjob.h>
 #include <qgsreadwritecontext.h>
 #include <qgsrulebasedlabeling.h>
@@ -51,6 +53,8 @@ class TestQgsLabelingEngine : public QObject
     void testRegisterFeatureUnprojectible();
     void testRotateHidePartial();
     void testParallelLabelSmallFeature();
+    void testParallelSolving();
+    void testStreaming();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -768,5 +772,161 @@ void TestQgsLabelingEngine::testParallelLabelSmallFeature()
   //  QVERIFY( imageCheck( "label_rotate_hide_partial", img, 20 ) );
 }
 
+void TestQgsLabelingEngine::testParallelSolving()
+{
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "'label'" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::OverPoint;
+
+  // isolated points, and groups of colliding points far away from each other
+  auto createLayer = []( int groupSize ) -> QgsVectorLayer *
+  {
+    QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:4326&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) );
+    layer->setRenderer( new QgsNullSymbolRenderer() );
+    QgsFeatureList features;
+    for ( int group = 0; group < 12; ++group )
+    {
+      const double x = ( group % 4 ) * 40;
+      const double y = ( group / 4 ) * 40;
+      for ( int i = 0; i < groupSize; ++i )
+      {
+        QgsFeature f( layer->fields(), features.size() );
+        f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x + i * 0.7, y + i * 0.3 ) ) );
+        features << f;
+      }
+    }
+    layer->dataProvider()->addFeatures( features );
+    return layer;
+  };
+
+  auto render = [&]( QgsVectorLayer * layer, bool parallel, QgsLabelingEngineSettings::Search searchMethod = QgsLabelingEngineSettings::Chain ) -> QImage
+  {
+    QgsMapSettings mapSettings;
+    mapSettings.setDestinationCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ) );
+    mapSettings.setOutputSize( QSize( 640, 480 ) );
+    mapSettings.setExtent( QgsRectangle( -20, -20, 150, 110 ) );
+    mapSettings.setLayers( QList<QgsMapLayer *>() << layer );
+    mapSettings.setOutputDpi( 96 );
+
+    QgsLabelingEngineSettings engineSettings = mapSettings.labelingEngineSettings();
+    engineSettings.setSearchMethod( searchMethod );
+    engineSettings.setFlag( QgsLabelingEngineSettings::DrawLabelRectOnly, true );
+    engineSettings.setFlag( QgsLabelingEngineSettings::ParallelSolving, parallel );
+    mapSettings.setLabelingEngineSettings( engineSettings );
+
+    QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+    img.fill( Qt::white );
+    QPainter p( &img );
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.setPainter( &p );
+
+    QgsVectorLayerLabelProvider *provider = new QgsVectorLayerLabelProvider( layer, QStringLiteral( "test" ), true, &settings );
+    QgsLabelingEngine engine;
+    engine.setMapSettings( mapSettings );
+    engine.addProvider( provider );
+    engine.run( context );
+    p.end();
+    engine.removeProvider( provider );
+    return img;
+  };
+
+  // labels without any conflict
+  std::unique_ptr< QgsVectorLayer > isolated( createLayer( 1 ) );
+  QCOMPARE( render( isolated.get(), true ), render( isolated.get(), false ) );
+
+  // groups of colliding labels are solved concurrently, and placed exactly as by the serial solver
+  std::unique_ptr< QgsVectorLayer > groups( createLayer( 4 ) );
+  QCOMPARE( render( groups.get(), true ), render( groups.get(), false ) );
+  QCOMPARE( render( groups.get(), true, QgsLabelingEngineSettings::Falp ), render( groups.get(), false, QgsLabelingEngineSettings::Falp ) );
+  QVERIFY( render( groups.get(), true ) != render( isolated.get(), true ) );
+
+  std::unique_ptr< QgsVectorLayer > denseGroups( createLayer( 9 ) );
+  const QImage parallel = render( denseGroups.get(), true );
+  QCOMPARE( parallel, render( denseGroups.get(), false ) );
+  QCOMPARE( render( denseGroups.get(), true, QgsLabelingEngineSettings::Falp ), render( denseGroups.get(), false, QgsLabelingEngineSettings::Falp ) );
+
+  // the merged result does not depend on the scheduling
+  for ( int i = 0; i < 5; ++i )
+    QCOMPARE( render( denseGroups.get(), true ), parallel );
+
+  // the flag is enabled by default, and stored in the project
+  QgsLabelingEngineSettings engineSettings;
+  QVERIFY( engineSettings.testFlag( QgsLabelingEngineSettings::ParallelSolving ) );
+  QgsProject project;
+  engineSettings.setFlag( QgsLabelingEngineSettings::ParallelSolving, false );
+  engineSettings.writeSettingsToProject( &project );
+  QgsLabelingEngineSettings readSettings;
+  readSettings.readSettingsFromProject( &project );
+  QVERIFY( !readSettings.testFlag( QgsLabelingEngineSettings::ParallelSolving ) );
+}
+
+void TestQgsLabelingEngine::testStreaming()
+{
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "Class" );
+  setDefaultLabelParams( settings );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 640, 480 ) );
+  mapSettings.setExtent( vl->extent() );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl );
+  mapSettings.setOutputDpi( 96 );
+
+  auto render = [&]( bool streaming ) -> QImage
+  {
+    QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+    img.fill( Qt::white );
+    QPainter p( &img );
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.setPainter( &p );
+    context.expressionContext().appendScope( QgsExpressionContextUtils::layerScope( vl ) );
+
+    QgsLabelingEngine engine;
+    engine.setMapSettings( mapSettings );
+    QgsVectorLayerLabelProvider *provider = new QgsVectorLayerLabelProvider( vl, QString(), false, &settings );
+    engine.addProvider( provider );
+    QSet<QString> attributes;
+    provider->prepare( context, attributes );
+
+    // features registered after the engine started streaming are registered in PAL straight away
+    if ( streaming )
+      engine.startStreaming();
+    QgsFeature f;
+    QgsFeatureIterator it = vl->getFeatures();
+    while ( it.nextFeature( f ) )
+    {
+      context.expressionContext().setFeature( f );
+      provider->registerFeature( f, context );
+    }
+    engine.run( context );
+    p.end();
+    return img;
+  };
+
+  const QImage streamed = render( true );
+  QCOMPARE( streamed, render( false ) );
+
+  // the parallel renderer streams the labels while the layers are rendered
+  vl->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+  vl->setLabelsEnabled( true );
+
+  QgsMapRendererSequentialJob sequentialJob( mapSettings );
+  sequentialJob.start();
+  sequentialJob.waitForFinished();
+  std::unique_ptr< QgsLabelingResults > sequentialResults( sequentialJob.takeLabelingResults() );
+
+  QgsMapRendererParallelJob parallelJob( mapSettings );
+  parallelJob.start();
+  parallelJob.waitForFinished();
+  std::unique_ptr< QgsLabelingResults > parallelResults( parallelJob.takeLabelingResults() );
+
+  vl->setLabeling( nullptr );
+
+  QVERIFY( !sequentialResults->labelsWithinRect( mapSettings.extent() ).isEmpty() );
+  QCOMPARE( parallelResults->labelsWithinRect( mapSettings.extent() ).count(), sequentialResults->labelsWithinRect( mapSettings.extent() ).count() );
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
@@ -38,6 +38,12 @@
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 #include <qgsproject.h>
+#include "qgsvectordataprovider.h"
+#include "qgscategorizedsymbolrenderer.h"
+#include "qgsruntimeprofiler.h"
+#include "qgssymbol.h"
+
+#include <QThreadPool>
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -76,6 +82,10 @@ class TestQgsMapRendererJob : public QObject
     void testFourAdjacentTiles_data();
     void testFourAdjacentTiles();
 
+    //! Checks that rendering the features of a large layer in parallel gives the same image
+    void testParallelFeatureRendering_data();
+    void testParallelFeatureRendering();
+
   private:
     QString mEncoding;
     QgsVectorFileWriter::WriterError mError =  QgsVectorFileWriter::NoError ;
@@ -330,6 +340,98 @@ void TestQgsMapRendererJob::testFourAdjacentTiles()
   QVERIFY( result );
 }
 
+void TestQgsMapRendererJob::testParallelFeatureRendering_data()
+{
+  QTest::addColumn<bool>( "polygons" );
+
+  QTest::newRow( "points" ) << false;
+  QTest::newRow( "overlapping polygons" ) << true;
+}
+
+void TestQgsMapRendererJob::testParallelFeatureRendering()
+{
+  QFETCH( bool, polygons );
+
+  // large enough to be split, the stacking order of the overlapping polygons is the provider order
+  QgsVectorLayer *layer = new QgsVectorLayer( polygons ? QStringLiteral( "Polygon?crs=epsg:4326&field=class:integer" ) : QStringLiteral( "Point?crs=epsg:4326&field=class:integer" ),
+      QStringLiteral( "features" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  qsrand( 1 );
+  for ( int i = 0; i < 12000; ++i )
+  {
+    QgsFeature feature( layer->fields() );
+    feature.setAttributes( QgsAttributes() << i % 5 );
+    if ( polygons )
+    {
+      const double x = ( qrand() % 1100 ) / 10.0;
+      const double y = ( qrand() % 900 ) / 10.0;
+      feature.setGeometry( QgsGeometry::fromRect( QgsRectangle( x, y, x + 2 + qrand() % 8, y + 2 + qrand() % 8 ) ) );
+    }
+    else
+    {
+      feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i % 120 + 0.5, i / 120 + 0.5 ) ) );
+    }
+    features << feature;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsCategoryList categories;
+  const QStringList colors = QStringList() << QStringLiteral( "#e31a1c" ) << QStringLiteral( "#1f78b4" ) << QStringLiteral( "#33a02c" ) << QStringLiteral( "#ff7f00" ) << QStringLiteral( "#6a3d9a" );
+  for ( int i = 0; i < colors.count(); ++i )
+  {
+    QgsSymbol *symbol = QgsSymbol::defaultSymbol( layer->geometryType() );
+    symbol->setColor( QColor( colors.at( i ) ) );
+    categories << QgsRendererCategory( i, symbol, QString::number( i ) );
+  }
+  layer->setRenderer( new QgsCategorizedSymbolRenderer( QStringLiteral( "class" ), categories ) );
+  QgsProject::instance()->addMapLayer( layer );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setExtent( QgsRectangle( 0, 0, 120, 100 ) );
+  mapSettings.setOutputSize( QSize( 1200, 1000 ) );
+  mapSettings.setOutputDpi( 96 );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << layer );
+
+  QgsMapRendererSequentialJob serialJob( mapSettings );
+  serialJob.start();
+  serialJob.waitForFinished();
+  const QImage serialImage = serialJob.renderedImage();
+
+  // make sure the layer is split even on a single core machine
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( std::max( maxThreadCount, 4 ) );
+  const double chunks = QgsApplication::profiler()->counterValue( QStringLiteral( "Rendering/Parallel/chunks" ) );
+
+  mapSettings.setFlag( QgsMapSettings::ParallelFeatureRendering );
+  QgsMapRendererSequentialJob parallelJob( mapSettings );
+  parallelJob.start();
+  parallelJob.waitForFinished();
+  const QImage parallelImage = parallelJob.renderedImage();
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QgsProject::instance()->removeMapLayer( layer );
+
+  // 12000 features are rendered in several chunks
+  QVERIFY( QgsApplication::profiler()->counterValue( QStringLiteral( "Rendering/Parallel/chunks" ) ) >= chunks + 6 );
+
+  // chunks are composited as images, allow for rounding differences on antialiased edges only
+  QCOMPARE( parallelImage.size(), serialImage.size() );
+  int maxDifference = 0;
+  for ( int y = 0; y < serialImage.height(); ++y )
+  {
+    for ( int x = 0; x < serialImage.width(); ++x )
+    {
+      const QRgb serial = serialImage.pixel( x, y );
+      const QRgb parallel = parallelImage.pixel( x, y );
+      maxDifference = std::max( { maxDifference, std::abs( qRed( serial ) - qRed( parallel ) ), std::abs( qGreen( serial ) - qGreen( parallel ) ),
+                                  std::abs( qBlue( serial ) - qBlue( parallel ) ), std::abs( qAlpha( serial ) - qAlpha( parallel ) )
+                                } );
+    }
+  }
+  QVERIFY2( maxDifference <= 2, QString::number( maxDifference ).toLatin1() );
+}
+
 
 QGSTEST_MAIN( TestQgsMapRendererJob )
 #include "testqgsmaprendererjob.moc"
@@ -0,0 +1,471 @@
+/***************************************************************************
+     testqgsmemoryfeaturestore.cpp
+     --------------------------------------
+    Date                 : October 2018
+    Copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QDate>
+
+#include "qgsapplication.h"
+#include "qgsfeaturebatch.h"
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgsmemoryfeaturestore.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+class TestQgsMemoryFeatureStore : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void values();
+    void geometries();
+    void deleteAndCompact();
+    void spatialIndex();
+    void implicitSharing();
+    void provider();
+
+    void benchmarkAddPoints_data();
+    void benchmarkAddPoints();
+    void memoryPerFeature();
+    void benchmarkIterate_data();
+    void benchmarkIterate();
+    void benchmarkIterateBatches_data();
+    void benchmarkIterateBatches();
+
+  private:
+    static QgsFields fields();
+    static QgsFeature randomPoint( int i );
+    static std::unique_ptr< QgsVectorLayer > pointLayer( int count );
+};
+
+void TestQgsMemoryFeatureStore::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsMemoryFeatureStore::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsFields TestQgsMemoryFeatureStore::fields()
+{
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "int" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "long" ), QVariant::LongLong ) );
+  fields.append( QgsField( QStringLiteral( "double" ), QVariant::Double ) );
+  fields.append( QgsField( QStringLiteral( "string" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "date" ), QVariant::Date ) );
+  return fields;
+}
+
+QgsFeature TestQgsMemoryFeatureStore::randomPoint( int i )
+{
+  QgsFeature f( fields() );
+  f.setAttributes( QgsAttributes() << i << QVariant( static_cast< qlonglong >( i ) * 1000000 ) << i / 10.0 << QStringLiteral( "point %1" ).arg( i ) << QDate( 2018, 10, 1 + i % 30 ) );
+  f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( -1000.0 + 2000.0 * qrand() / RAND_MAX, -1000.0 + 2000.0 * qrand() / RAND_MAX ) ) );
+  return f;
+}
+
+std::unique_ptr< QgsVectorLayer > TestQgsMemoryFeatureStore::pointLayer( int count )
+{
+  std::unique_ptr< QgsVectorLayer > layer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857&field=int:integer&field=long:int8&field=double:double&field=string:string&field=date:date" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+
+  qsrand( 1 );
+  QgsFeatureList features;
+  for ( int i = 0; i < count; ++i )
+  {
+    features << randomPoint( i );
+    if ( features.size() == 10000 )
+    {
+      layer->dataProvider()->addFeatures( features );
+      features.clear();
+    }
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+void TestQgsMemoryFeatureStore::values()
+{
+  QgsMemoryFeatureStore store;
+  const QgsFields fields = TestQgsMemoryFeatureStore::fields();
+  for ( const QgsField &field : fields )
+    store.addColumn( field );
+
+  QgsFeature f( fields );
+  f.setAttributes( QgsAttributes() << 5 << QVariant( 5000000000LL ) << 1.5 << QStringLiteral( "a" ) << QDate( 2018, 10, 1 ) );
+  store.appendFeature( 1, f );
+  f.setAttributes( QgsAttributes() << QVariant( QVariant::Int ) << QVariant() << QVariant( QVariant::Double ) << QString() << QVariant( QVariant::Date ) );
+  store.appendFeature( 2, f );
+  QCOMPARE( store.rowCount(), 2 );
+  QCOMPARE( store.featureCount(), 2L );
+
+  QCOMPARE( store.value( 0, 0 ), QVariant( 5 ) );
+  QCOMPARE( store.value( 0, 0 ).type(), QVariant::Int );
+  QCOMPARE( store.value( 0, 1 ), QVariant( 5000000000LL ) );
+  QCOMPARE( store.value( 0, 1 ).type(), QVariant::LongLong );
+  QCOMPARE( store.value( 0, 2 ), QVariant( 1.5 ) );
+  QCOMPARE( store.value( 0, 3 ), QVariant( QStringLiteral( "a" ) ) );
+  QCOMPARE( store.value( 0, 4 ), QVariant( QDate( 2018, 10, 1 ) ) );
+
+  // null values keep their type, invalid values stay invalid
+  QVERIFY( store.value( 1, 0 ).isNull() );
+  QCOMPARE( store.value( 1, 0 ).type(), QVariant::Int );
+  QVERIFY( !store.value( 1, 1 ).isValid() );
+  QVERIFY( store.value( 1, 2 ).isNull() );
+  QCOMPARE( store.value( 1, 2 ).type(), QVariant::Double );
+  QVERIFY( store.value( 1, 3 ).isNull() );
+  QCOMPARE( store.value( 1, 3 ).type(), QVariant::String );
+  QVERIFY( store.value( 1, 4 ).isNull() );
+
+  // values of another type than the field are returned unchanged
+  store.setValue( 1, 0, QStringLiteral( "not a number" ) );
+  QCOMPARE( store.value( 1, 0 ), QVariant( QStringLiteral( "not a number" ) ) );
+  QCOMPARE( store.value( 0, 0 ), QVariant( 5 ) );
+  QCOMPARE( store.value( 0, 0 ).type(), QVariant::Int );
+
+  store.setValue( 0, 2, 2.5 );
+  QCOMPARE( store.value( 0, 2 ), QVariant( 2.5 ) );
+
+  const QgsFeature feature = store.feature( 0, fields );
+  QVERIFY( feature.isValid() );
+  QCOMPARE( feature.id(), 1LL );
+  QCOMPARE( feature.attributes(), QgsAttributes() << 5 << QVariant( 5000000000LL ) << 2.5 << QStringLiteral( "a" ) << QDate( 2018, 10, 1 ) );
+
+  const QgsAttributeList subset = QgsAttributeList() << 3;
+  const QgsFeature subsetFeature = store.feature( 0, fields, &subset );
+  QCOMPARE( subsetFeature.attributes().size(), 5 );
+  QCOMPARE( subsetFeature.attribute( 3 ), QVariant( QStringLiteral( "a" ) ) );
+  QVERIFY( subsetFeature.attribute( 0 ).isNull() );
+
+  store.removeColumn( 1 );
+  QCOMPARE( store.value( 0, 1 ), QVariant( 2.5 ) );
+  store.addColumn( QgsField( QStringLiteral( "new" ), QVariant::Int ) );
+  QVERIFY( !store.value( 0, 4 ).isValid() );
+
+  QgsFeatureBatch batch;
+  QgsFields batchFields = fields;
+  batchFields.remove( 1 );
+  batchFields.append( QgsField( QStringLiteral( "new" ), QVariant::Int ) );
+  batch.setFields( batchFields, batchFields.allAttributesList() );
+  store.addToBatch( 0, batch );
+  store.addToBatch( 1, batch );
+  QCOMPARE( batch.size(), 2 );
+  QCOMPARE( batch.int64Value( 0, 0 ), 5LL );
+  QCOMPARE( batch.doubleValue( 1, 0 ), 2.5 );
+  QCOMPARE( batch.stringValue( 2, 0 ), QStringLiteral( "a" ) );
+  QCOMPARE( batch.value( 3, 0 ), QVariant( QDate( 2018, 10, 1 ) ) );
+  QVERIFY( batch.isNull( 4, 0 ) );
+  QVERIFY( batch.isNull( 2, 1 ) );
+}
+
+void TestQgsMemoryFeatureStore::geometries()
+{
+  QgsMemoryFeatureStore store;
+  QgsFeature f;
+  f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 10 0, 10 5, 0 0))" ) ) );
+  store.appendFeature( 1, f );
+  f.clearGeometry();
+  store.appendFeature( 2, f );
+  f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "CircularStringZ (0 0 1, 1 1 2, 2 0 3)" ) ) );
+  store.appendFeature( 3, f );
+
+  QVERIFY( store.hasGeometry( 0 ) );
+  QCOMPARE( store.geometry( 0 ).asWkt(), QStringLiteral( "Polygon ((0 0, 10 0, 10 5, 0 0))" ) );
+  QCOMPARE( store.boundingBox( 0 ), QgsRectangle( 0, 0, 10, 5 ) );
+  QVERIFY( !store.hasGeometry( 1 ) );
+  QVERIFY( store.geometry( 1 ).isNull() );
+  QCOMPARE( store.geometry( 2 ).asWkt(), QStringLiteral( "CircularStringZ (0 0 1, 1 1 2, 2 0 3)" ) );
+  QCOMPARE( store.boundingBox( 2 ), store.geometry( 2 ).boundingBox() );
+
+  store.setGeometry( 0, QgsGeometry::fromWkt( QStringLiteral( "Polygon ((0 0, 1 0, 1 1, 0 0))" ) ) );
+  QCOMPARE( store.geometry( 0 ).asWkt(), QStringLiteral( "Polygon ((0 0, 1 0, 1 1, 0 0))" ) );
+  store.setGeometry( 2, QgsGeometry() );
+  QVERIFY( !store.hasGeometry( 2 ) );
+
+  // replaced geometries are dropped when compacting
+  store.optimize();
+  QCOMPARE( store.rowCount(), 3 );
+  QCOMPARE( store.geometry( 0 ).asWkt(), QStringLiteral( "Polygon ((0 0, 1 0, 1 1, 0 0))" ) );
+}
+
+void TestQgsMemoryFeatureStore::deleteAndCompact()
+{
+  QgsMemoryFeatureStore store;
+  store.addColumn( QgsField( QStringLiteral( "id" ), QVariant::Int ) );
+  store.addColumn( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+  for ( int i = 0; i < 100; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i << QStringLiteral( "f%1" ).arg( i ) );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    store.appendFeature( 10 + i, f );
+  }
+
+  QCOMPARE( store.rowForId( 9 ), -1 );
+  QCOMPARE( store.rowForId( 10 ), 0 );
+  QCOMPARE( store.rowForId( 109 ), 99 );
+  QCOMPARE( store.rowForId( 110 ), -1 );
+
+  for ( int i = 0; i < 60; i += 2 )
+    store.deleteRow( store.rowForId( 10 + i ) );
+  QCOMPARE( store.featureCount(), 70L );
+  QCOMPARE( store.rowForId( 10 ), -1 );
+  QVERIFY( store.isDeleted( 0 ) );
+
+  // not enough deleted rows yet
+  store.optimize();
+  QCOMPARE( store.rowCount(), 100 );
+
+  for ( int i = 1; i < 60; i += 2 )
+    store.deleteRow( store.rowForId( 10 + i ) );
+  store.optimize();
+  QCOMPARE( store.rowCount(), 40 );
+  QCOMPARE( store.featureCount(), 40L );
+  for ( int i = 60; i < 100; ++i )
+  {
+    const int row = store.rowForId( 10 + i );
+    QCOMPARE( row, i - 60 );
+    QCOMPARE( store.value( row, 0 ), QVariant( i ) );
+    QCOMPARE( store.value( row, 1 ), QVariant( QStringLiteral( "f%1" ).arg( i ) ) );
+    QCOMPARE( store.geometry( row ).asWkt(), QStringLiteral( "Point (%1 %1)" ).arg( i ) );
+  }
+}
+
+void TestQgsMemoryFeatureStore::spatialIndex()
+{
+  QgsMemoryFeatureStore indexed;
+  QgsMemoryFeatureStore plain;
+  qsrand( 1 );
+  for ( int i = 0; i < 5000; ++i )
+  {
+    const QgsFeature f = randomPoint( i );
+    indexed.appendFeature( i, f );
+    plain.appendFeature( i, f );
+  }
+  indexed.createSpatialIndex();
+  QVERIFY( indexed.hasSpatialIndex() );
+  QVERIFY( !plain.hasSpatialIndex() );
+
+  auto check = [&indexed, &plain]()
+  {
+    const QList< QgsRectangle > rects = QList< QgsRectangle >() << QgsRectangle( -1000, -1000, 1000, 1000 ) << QgsRectangle( 0, 0, 100, 100 )
+                                        << QgsRectangle( -500, 200, -480, 900 ) << QgsRectangle( 2000, 2000, 3000, 3000 );
+    for ( const QgsRectangle &rect : rects )
+    {
+      const QVector<int> expected = plain.intersects( rect );
+      QCOMPARE( indexed.intersects( rect ), expected );
+      for ( int row : expected )
+        QVERIFY( plain.boundingBox( row ).intersects( rect ) );
+    }
+  };
+  check();
+
+  // changed, deleted and added features before and after the tree is built again
+  for ( int i = 0; i < 5000; i += 7 )
+  {
+    const QgsGeometry geometry = QgsGeometry::fromPointXY( QgsPointXY( i / 10.0, i / 10.0 ) );
+    indexed.setGeometry( i, geometry );
+    plain.setGeometry( i, geometry );
+  }
+  for ( int i = 1; i < 5000; i += 11 )
+  {
+    indexed.deleteRow( i );
+    plain.deleteRow( i );
+  }
+  for ( int i = 5000; i < 8000; ++i )
+  {
+    const QgsFeature f = randomPoint( i );
+    indexed.appendFeature( i, f );
+    plain.appendFeature( i, f );
+  }
+  check();
+
+  indexed.optimize();
+  plain.optimize();
+  check();
+}
+
+void TestQgsMemoryFeatureStore::implicitSharing()
+{
+  QgsMemoryFeatureStore store;
+  store.addColumn( QgsField( QStringLiteral( "id" ), QVariant::Int ) );
+  QgsFeature f;
+  f.setAttributes( QgsAttributes() << 1 );
+  f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 1, 1 ) ) );
+  store.appendFeature( 1, f );
+
+  const QgsMemoryFeatureStore copy = store;
+  store.setValue( 0, 0, 2 );
+  store.setGeometry( 0, QgsGeometry::fromPointXY( QgsPointXY( 2, 2 ) ) );
+  store.appendFeature( 2, f );
+  store.deleteRow( 0 );
+
+  QCOMPARE( copy.rowCount(), 1 );
+  QVERIFY( !copy.isDeleted( 0 ) );
+  QCOMPARE( copy.value( 0, 0 ), QVariant( 1 ) );
+  QCOMPARE( copy.geometry( 0 ).asWkt(), QStringLiteral( "Point (1 1)" ) );
+}
+
+void TestQgsMemoryFeatureStore::provider()
+{
+  std::unique_ptr< QgsVectorLayer > layer = pointLayer( 2000 );
+  QVERIFY( layer->isValid() );
+  QCOMPARE( layer->featureCount(), 2000L );
+  QVERIFY( layer->dataProvider()->createSpatialIndex() );
+
+  const QgsRectangle rect( -100, -100, 100, 100 );
+  QgsFeatureIds expected;
+  QgsFeature f;
+  QgsFeatureIterator it = layer->dataProvider()->getFeatures();
+  while ( it.nextFeature( f ) )
+  {
+    if ( f.geometry().boundingBox().intersects( rect ) )
+      expected << f.id();
+  }
+  QVERIFY( !expected.isEmpty() );
+
+  QgsFeatureIds found;
+  it = layer->dataProvider()->getFeatures( QgsFeatureRequest().setFilterRect( rect ) );
+  while ( it.nextFeature( f ) )
+    found << f.id();
+  QCOMPARE( found, expected );
+
+  QgsFeatureIds batchFound;
+  QgsFeatureBatch batch;
+  it = layer->dataProvider()->getFeatures( QgsFeatureRequest().setFilterRect( rect ).setSubsetOfAttributes( QgsAttributeList() << 2 ) );
+  while ( it.nextBatch( batch, 100 ) )
+  {
+    QCOMPARE( batch.columnCount(), 1 );
+    for ( int row = 0; row < batch.size(); ++row )
+    {
+      batchFound << batch.id( row );
+      QCOMPARE( batch.doubleValue( 0, row ), ( batch.id( row ) - 1 ) / 10.0 );
+      QVERIFY( batch.hasGeometry( row ) );
+    }
+  }
+  QCOMPARE( batchFound, expected );
+
+  QVERIFY( layer->dataProvider()->deleteFeatures( expected ) );
+  QCOMPARE( layer->dataProvider()->featureCount(), 2000L - expected.size() );
+  it = layer->dataProvider()->getFeatures( QgsFeatureRequest().setFilterRect( rect ) );
+  QVERIFY( !it.nextFeature( f ) );
+
+  QgsFeatureId moved = 1;
+  while ( expected.contains( moved ) )
+    moved++;
+  QgsGeometryMap geometries;
+  geometries.insert( moved, QgsGeometry::fromPointXY( QgsPointXY( 1, 2 ) ) );
+  QVERIFY( layer->dataProvider()->changeGeometryValues( geometries ) );
+  it = layer->dataProvider()->getFeatures( QgsFeatureRequest().setFilterRect( rect ) );
+  QVERIFY( it.nextFeature( f ) );
+  QCOMPARE( f.id(), moved );
+  QCOMPARE( f.attribute( QStringLiteral( "int" ) ), QVariant( static_cast< int >( moved - 1 ) ) );
+  QVERIFY( !it.nextFeature( f ) );
+}
+
+void TestQgsMemoryFeatureStore::benchmarkAddPoints_data()
+{
+  QTest::addColumn< int >( "count" );
+  QTest::newRow( "1M points" ) << 1000000;
+}
+
+void TestQgsMemoryFeatureStore::benchmarkAddPoints()
+{
+  QFETCH( int, count );
+
+  std::unique_ptr< QgsVectorLayer > layer;
+  QBENCHMARK
+  {
+    layer = pointLayer( count );
+  }
+  QCOMPARE( layer->featureCount(), static_cast< long >( count ) );
+}
+
+void TestQgsMemoryFeatureStore::memoryPerFeature()
+{
+  const int count = 1000000;
+  QgsMemoryFeatureStore store;
+  const QgsFields fields = TestQgsMemoryFeatureStore::fields();
+  for ( const QgsField &field : fields )
+    store.addColumn( field );
+
+  qsrand( 1 );
+  for ( int i = 0; i < count; ++i )
+    store.appendFeature( i + 1, randomPoint( i ) );
+  store.createSpatialIndex();
+
+  // 21 bytes of WKB per point, plus the values and the string data
+  const double bytesPerFeature = static_cast< double >( store.memoryUsage() ) / count;
+  QVERIFY2( bytesPerFeature < 250, QString::number( bytesPerFeature ).toLatin1() );
+}
+
+void TestQgsMemoryFeatureStore::benchmarkIterate_data()
+{
+  QTest::addColumn< int >( "count" );
+  QTest::newRow( "1M points" ) << 1000000;
+}
+
+void TestQgsMemoryFeatureStore::benchmarkIterate()
+{
+  QFETCH( int, count );
+
+  std::unique_ptr< QgsVectorLayer > layer = pointLayer( count );
+  double sum = 0;
+  QBENCHMARK
+  {
+    sum = 0;
+    QgsFeature f;
+    QgsFeatureIterator it = layer->dataProvider()->getFeatures();
+    while ( it.nextFeature( f ) )
+      sum += f.attribute( 2 ).toDouble();
+  }
+  QVERIFY( sum > 0 );
+}
+
+void TestQgsMemoryFeatureStore::benchmarkIterateBatches_data()
+{
+  QTest::addColumn< int >( "count" );
+  QTest::newRow( "1M points" ) << 1000000;
+}
+
+void TestQgsMemoryFeatureStore::benchmarkIterateBatches()
+{
+  QFETCH( int, count );
+
+  std::unique_ptr< QgsVectorLayer > layer = pointLayer( count );
+  double sum = 0;
+  QBENCHMARK
+  {
+    sum = 0;
+    QgsFeatureBatch batch;
+    QgsFeatureIterator it = layer->dataProvider()->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() << 2 ) );
+    while ( it.nextBatch( batch ) )
+    {
+      const double *values = batch.doubleData( 0 );
+      for ( int row = 0; row < batch.size(); ++row )
+        sum += values[row];
+    }
+  }
+  QVERIFY( sum > 0 );
+}
+
+QGSTEST_MAIN( TestQgsMemoryFeatureStore )
+#include "testqgsmemoryfeaturestore.moc"
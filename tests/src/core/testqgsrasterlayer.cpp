@@ -22,6 +22,7 @@
 #include <QPainter>
 #include <QTime>
 #include <QDesktopServices>
+#include <QThreadPool>
 
 #include "cpl_conv.h"
 #include "gdal.h"
@@ -42,6 +43,11 @@
 #include "qgsrasterdataprovider.h"
 #include "qgsrastershader.h"
 #include "qgsrastertransparency.h"
+#include "qgsrasterprojector.h"
+#include "qgsrasterresamplefilter.h"
+#include "qgscubicrasterresampler.h"
+#include "qgsrasterlayerrenderer.h"
+#include "qgsrendercontext.h"
 
 //qgis unit test includes
 #include <qgsrenderchecker.h>
@@ -86,6 +92,9 @@ class TestQgsRasterLayer : public QObject
     void regression992(); //test for issue #992 - GeoJP2 images improperly displayed as all black
     void testRefreshRendererIfNeeded();
     void sample();
+    void parallelRendering_data();
+    void parallelRendering();
+    void projectorRepeatedBlocks();
 
 
   private:
@@ -808,5 +817,106 @@ void TestQgsRasterLayer::sample()
   QVERIFY( !ok );
 }
 
+void TestQgsRasterLayer::parallelRendering_data()
+{
+  QTest::addColumn<bool>( "cubic" );
+  QTest::addColumn<bool>( "reprojected" );
+
+  QTest::newRow( "nearest" ) << false << false;
+  QTest::newRow( "cubic" ) << true << false;
+  QTest::newRow( "reprojected" ) << false << true;
+}
+
+void TestQgsRasterLayer::parallelRendering()
+{
+  QFETCH( bool, cubic );
+  QFETCH( bool, reprojected );
+
+  std::unique_ptr< QgsRasterLayer > rl = qgis::make_unique< QgsRasterLayer >( mTestDataDir + "landsat.tif", QStringLiteral( "landsat" ) );
+  QVERIFY( rl->isValid() );
+  if ( cubic )
+    rl->resampleFilter()->setZoomedInResampler( new QgsCubicRasterResampler() );
+
+  // 4 times the resolution of the source, split in bands which start on a source row
+  QgsMapSettings mapSettings;
+  mapSettings.setLayers( QList<QgsMapLayer *>() << rl.get() );
+  mapSettings.setExtent( rl->extent() );
+  if ( reprojected )
+  {
+    const QgsCoordinateReferenceSystem destCrs( QStringLiteral( "EPSG:4326" ) );
+    mapSettings.setDestinationCrs( destCrs );
+    mapSettings.setExtent( QgsCoordinateTransform( rl->crs(), destCrs, QgsProject::instance() ).transformBoundingBox( rl->extent() ) );
+  }
+  else
+  {
+    mapSettings.setDestinationCrs( rl->crs() );
+  }
+  mapSettings.setOutputSize( QSize( 800, 800 ) );
+
+  // the layer renderer is used directly to know whether it was split over several threads
+  auto render = [&mapSettings, &rl, reprojected]( bool parallel, int &threadCount )
+  {
+    QImage image( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+    image.fill( 0 );
+    QPainter painter( &image );
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.setPainter( &painter );
+    context.setFlag( QgsRenderContext::ParallelRasterRendering, parallel );
+    if ( reprojected )
+    {
+      context.setCoordinateTransform( mapSettings.layerTransform( rl.get() ) );
+      context.setExtent( mapSettings.mapToLayerCoordinates( rl.get(), mapSettings.visibleExtent() ) );
+    }
+    std::unique_ptr< QgsRasterLayerRenderer > renderer( static_cast< QgsRasterLayerRenderer * >( rl->createMapRenderer( context ) ) );
+    threadCount = renderer->threadCount();
+    renderer->render();
+    painter.end();
+    return image;
+  };
+
+  // at least 2 threads, whatever the machine running the test
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( std::max( maxThreadCount, 4 ) );
+
+  int serialThreadCount = 0;
+  const QImage serialImage = render( false, serialThreadCount );
+  int parallelThreadCount = 0;
+  const QImage parallelImage = render( true, parallelThreadCount );
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  QCOMPARE( serialThreadCount, 1 );
+  QVERIFY( parallelThreadCount > 1 );
+  QVERIFY( parallelImage == serialImage );
+}
+
+void TestQgsRasterLayer::projectorRepeatedBlocks()
+{
+  std::unique_ptr< QgsRasterLayer > rl = qgis::make_unique< QgsRasterLayer >( mTestDataDir + "landsat.tif", QStringLiteral( "landsat" ) );
+  QVERIFY( rl->isValid() );
+
+  QgsRasterProjector projector;
+  projector.setInput( rl->dataProvider() );
+  projector.setCrs( rl->crs(), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ) );
+  QgsRectangle extent;
+  int width = 0;
+  int height = 0;
+  QVERIFY( projector.destExtentSize( rl->extent(), rl->width(), rl->height(), extent, width, height ) );
+
+  // the second block of each precision reuses the cached mesh, and must be identical to the first one
+  const QList<QgsRasterProjector::Precision> precisions = QList<QgsRasterProjector::Precision>() << QgsRasterProjector::Approximate << QgsRasterProjector::Exact;
+  for ( QgsRasterProjector::Precision precision : precisions )
+  {
+    projector.setPrecision( precision );
+    std::unique_ptr< QgsRasterBlock > block1( projector.block( 1, extent, width, height ) );
+    std::unique_ptr< QgsRasterBlock > block2( projector.block( 1, extent, width, height ) );
+    QVERIFY( block1->isValid() );
+    QCOMPARE( block2->data(), block1->data() );
+
+    // the center pixel is inside the source
+    QVERIFY( !block1->isNoData( height / 2, width / 2 ) );
+  }
+}
+
 QGSTEST_MAIN( TestQgsRasterLayer )
 #include "testqgsrasterlayer.moc"
@@ -0,0 +1,140 @@
+/***************************************************************************
+     testqgsrenderarena.cpp
+     --------------------------------------
+    Date                 : October 2018
+    Copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsrenderarena_p.h"
+#include "qgsruntimeprofiler.h"
+
+class TestQgsRenderArena : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void reuse();
+    void stableReferences();
+    void sharedCopies();
+    void statistics();
+    void profilerCounters();
+};
+
+void TestQgsRenderArena::reuse()
+{
+  QgsRenderArena arena;
+
+  QPolygonF &first = arena.polygon( 100 );
+  QVERIFY( first.isEmpty() );
+  QVERIFY( first.capacity() >= 100 );
+  for ( int i = 0; i < 100; ++i )
+    first << QPointF( i, i );
+  const QPointF *data = first.constData();
+
+  arena.reset();
+
+  // the memory of the first buffer is handed out again
+  QPolygonF &second = arena.polygon( 50 );
+  QVERIFY( second.isEmpty() );
+  QCOMPARE( second.constData(), data );
+  QCOMPARE( arena.statistics().allocations, 1LL );
+}
+
+void TestQgsRenderArena::stableReferences()
+{
+  QgsRenderArena arena;
+
+  QPolygonF &first = arena.polygon();
+  first << QPointF( 1, 2 );
+
+  // growing the arena must not move the buffers in use
+  QList< QPolygonF * > others;
+  for ( int i = 0; i < 100; ++i )
+  {
+    QPolygonF &other = arena.polygon( 10 );
+    other << QPointF( i, i );
+    others << &other;
+  }
+
+  QCOMPARE( first.size(), 1 );
+  QCOMPARE( first.at( 0 ), QPointF( 1, 2 ) );
+  for ( int i = 0; i < others.size(); ++i )
+    QCOMPARE( others.at( i )->at( 0 ), QPointF( i, i ) );
+  QCOMPARE( arena.statistics().peakBuffers, 101 );
+}
+
+void TestQgsRenderArena::sharedCopies()
+{
+  QgsRenderArena arena;
+
+  QPolygonF &buffer = arena.polygon();
+  buffer << QPointF( 1, 2 ) << QPointF( 3, 4 );
+  const QPolygonF copy = buffer;
+
+  arena.reset();
+  QPolygonF &reused = arena.polygon();
+  reused << QPointF( 5, 6 );
+
+  // copies made before the reset keep their data
+  QCOMPARE( copy.size(), 2 );
+  QCOMPARE( copy.at( 1 ), QPointF( 3, 4 ) );
+  QCOMPARE( reused.size(), 1 );
+}
+
+void TestQgsRenderArena::statistics()
+{
+  QgsRenderArena arena;
+  QCOMPARE( arena.statistics().acquisitions, 0LL );
+
+  for ( int feature = 0; feature < 10; ++feature )
+  {
+    arena.reset();
+    arena.polygon( 20 );
+    arena.polygon( 10 );
+  }
+
+  const QgsRenderArena::Statistics stats = arena.statistics();
+  QCOMPARE( stats.acquisitions, 20LL );
+  QCOMPARE( stats.allocations, 2LL );
+  QCOMPARE( stats.resets, 10LL );
+  QCOMPARE( stats.peakBuffers, 2 );
+  QVERIFY( stats.reservedBytes >= static_cast< qint64 >( 30 * sizeof( QPointF ) ) );
+
+  // a larger size hint grows the buffer
+  arena.reset();
+  arena.polygon( 1000 );
+  QCOMPARE( arena.statistics().allocations, 3LL );
+}
+
+void TestQgsRenderArena::profilerCounters()
+{
+  QgsRuntimeProfiler profiler;
+  QCOMPARE( profiler.counterValue( QStringLiteral( "arena/acquisitions" ) ), 0.0 );
+
+  QgsRenderArena arena;
+  arena.polygon( 5 );
+  arena.polygon( 5 );
+  arena.reportStatistics( &profiler, QStringLiteral( "arena/" ) );
+  arena.reportStatistics( &profiler, QStringLiteral( "arena/" ) );
+
+  // counters accumulate the reports of all jobs
+  QCOMPARE( profiler.counterValue( QStringLiteral( "arena/acquisitions" ) ), 4.0 );
+  QCOMPARE( profiler.counterValue( QStringLiteral( "arena/allocations" ) ), 4.0 );
+  QCOMPARE( profiler.counters().value( QStringLiteral( "arena/peak buffers" ) ), 4.0 );
+
+  profiler.clear();
+  QVERIFY( profiler.counters().isEmpty() );
+}
+
+QGSTEST_MAIN( TestQgsRenderArena )
+#include "testqgsrenderarena.moc"
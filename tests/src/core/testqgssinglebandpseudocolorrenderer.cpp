@@ -0,0 +1,357 @@
+/***************************************************************************
+     testqgssinglebandpseudocolorrenderer.cpp
+     --------------------------------------
+    Date                 : October 2018
+    Copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgscolorrampshader.h"
+#include "qgsrasterblock.h"
+#include "qgsrasterinterface.h"
+#include "qgsrastershader.h"
+#include "qgsrastertransparency.h"
+#include "qgssinglebandpseudocolorrenderer.h"
+
+///@cond PRIVATE
+
+//! Raster input returning copies of fixed blocks, band 2 being an alpha band
+class TestBlockInput : public QgsRasterInterface
+{
+  public:
+    TestBlockInput( Qgis::DataType dataType, int width, int height )
+      : mDataType( dataType )
+      , mWidth( width )
+      , mHeight( height )
+    {}
+
+    QgsRasterInterface *clone() const override { return new TestBlockInput( *this ); }
+    Qgis::DataType dataType( int bandNo ) const override { return bandNo == 2 ? Qgis::Byte : mDataType; }
+    int bandCount() const override { return 2; }
+    QgsRectangle extent() const override { return QgsRectangle( 0, 0, mWidth, mHeight ); }
+    int xSize() const override { return mWidth; }
+    int ySize() const override { return mHeight; }
+
+    QgsRasterBlock *block( int bandNo, const QgsRectangle &, int width, int height, QgsRasterBlockFeedback * = nullptr ) override
+    {
+      if ( width != mWidth || height != mHeight )
+        return new QgsRasterBlock();
+
+      QgsRasterBlock *block = new QgsRasterBlock( dataType( bandNo ), width, height );
+      QByteArray &data = bandNo == 2 ? mAlphaData : mData;
+      if ( data.isEmpty() )
+      {
+        for ( qgssize i = 0; i < static_cast< qgssize >( width ) * height; ++i )
+        {
+          if ( bandNo == 2 )
+            block->setValue( i, ( i * 7 ) % 256 );
+          else if ( mDataType == Qgis::Byte )
+            block->setValue( i, i % 256 );
+          else if ( mDataType == Qgis::Int16 )
+            block->setValue( i, static_cast< int >( i % 65536 ) - 32768 );
+          else
+            block->setValue( i, static_cast< double >( i % 65536 ) );
+        }
+        data = block->data();
+      }
+      else
+      {
+        block->setData( data );
+      }
+      if ( bandNo == 1 && mHasNoDataValue )
+        block->setNoDataValue( mNoDataValue );
+      if ( bandNo == 1 && mNoDataBitmapIndex >= 0 )
+        block->setIsNoData( mNoDataBitmapIndex );
+      return block;
+    }
+
+    Qgis::DataType mDataType;
+    int mWidth;
+    int mHeight;
+    bool mHasNoDataValue = false;
+    double mNoDataValue = 0;
+    int mNoDataBitmapIndex = -1;
+
+  private:
+    QByteArray mData;
+    QByteArray mAlphaData;
+};
+
+///@endcond
+
+/**
+ * \ingroup UnitTests
+ * Checks that the colors rendered by QgsSingleBandPseudoColorRenderer match the ones of
+ * QgsColorRampShader::shade().
+ */
+class TestQgsSingleBandPseudoColorRenderer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void colorTable();
+    void renderMatchesShader_data();
+    void renderMatchesShader();
+    void shaderChanges();
+
+    void benchmarkRender_data();
+    void benchmarkRender();
+
+  private:
+
+    static QgsColorRampShader *createShader( QgsColorRampShader::Type type, double minimum, double maximum, bool clip );
+    static QVector<QRgb> expectedColors( QgsRasterInterface *input, QgsSingleBandPseudoColorRenderer &renderer, const QgsColorRampShader &shader );
+    static QVector<QRgb> renderedColors( QgsSingleBandPseudoColorRenderer &renderer, int width, int height );
+};
+
+void TestQgsSingleBandPseudoColorRenderer::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsSingleBandPseudoColorRenderer::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsColorRampShader *TestQgsSingleBandPseudoColorRenderer::createShader( QgsColorRampShader::Type type, double minimum, double maximum, bool clip )
+{
+  QgsColorRampShader *shader = new QgsColorRampShader( minimum, maximum, nullptr, type );
+  QList<QgsColorRampShader::ColorRampItem> items;
+  const int itemCount = 10;
+  for ( int i = 0; i < itemCount; ++i )
+  {
+    // integer and fractional breaks, with a semi transparent color
+    const double value = minimum + ( maximum - minimum ) * i / ( itemCount - 1 ) + ( i % 2 ? 0.5 : 0 );
+    items << QgsColorRampShader::ColorRampItem( value, QColor::fromHsv( i * 36, 200, 255, i == 3 ? 100 : 255 ) );
+  }
+  shader->setColorRampItemList( items );
+  shader->setClip( clip );
+  return shader;
+}
+
+QVector<QRgb> TestQgsSingleBandPseudoColorRenderer::expectedColors( QgsRasterInterface *input, QgsSingleBandPseudoColorRenderer &renderer, const QgsColorRampShader &shader )
+{
+  // same computation as the generic rendering, pixel by pixel
+  const int width = input->xSize();
+  const int height = input->ySize();
+  std::unique_ptr< QgsRasterBlock > block( input->block( 1, input->extent(), width, height ) );
+  std::unique_ptr< QgsRasterBlock > alphaBlock( input->block( 2, input->extent(), width, height ) );
+  const bool hasTransparency = renderer.usesTransparency();
+
+  QVector<QRgb> colors( width * height );
+  for ( int i = 0; i < colors.size(); ++i )
+  {
+    int red, green, blue, alpha;
+    if ( block->isNoData( i ) || !shader.shade( block->value( i ), &red, &green, &blue, &alpha ) )
+    {
+      colors[i] = qRgba( 0, 0, 0, 0 );
+      continue;
+    }
+    if ( alpha < 255 )
+    {
+      red *= ( alpha / 255.0 );
+      blue *= ( alpha / 255.0 );
+      green *= ( alpha / 255.0 );
+    }
+    if ( !hasTransparency )
+    {
+      colors[i] = qRgba( red, green, blue, alpha );
+      continue;
+    }
+    double opacity = renderer.opacity();
+    if ( renderer.rasterTransparency() )
+      opacity = renderer.rasterTransparency()->alphaValue( block->value( i ), renderer.opacity() * 255 ) / 255.0;
+    if ( renderer.alphaBand() > 0 )
+      opacity *= alphaBlock->value( i ) / 255.0;
+    colors[i] = qRgba( opacity * red, opacity * green, opacity * blue, opacity * alpha );
+  }
+  return colors;
+}
+
+QVector<QRgb> TestQgsSingleBandPseudoColorRenderer::renderedColors( QgsSingleBandPseudoColorRenderer &renderer, int width, int height )
+{
+  std::unique_ptr< QgsRasterBlock > block( renderer.block( 1, QgsRectangle( 0, 0, width, height ), width, height ) );
+  QVector<QRgb> colors( width * height );
+  for ( int i = 0; i < colors.size(); ++i )
+    colors[i] = block->color( i );
+  return colors;
+}
+
+void TestQgsSingleBandPseudoColorRenderer::colorTable()
+{
+  std::unique_ptr< QgsColorRampShader > shader( createShader( QgsColorRampShader::Interpolated, -100, 300, false ) );
+  QCOMPARE( shader->colorTable( Qgis::Byte ).size(), 256 );
+  QCOMPARE( shader->colorTable( Qgis::UInt16 ).size(), 65536 );
+  QCOMPARE( shader->colorTable( Qgis::Int16 ).size(), 65536 );
+  QVERIFY( shader->colorTable( Qgis::Float32 ).isEmpty() );
+  QVERIFY( shader->colorTable( Qgis::Int32 ).isEmpty() );
+
+  const QVector<QRgb> table = shader->colorTable( Qgis::Int16 );
+  int red, green, blue, alpha;
+  QVERIFY( shader->shade( 300, &red, &green, &blue, &alpha ) );
+  QCOMPARE( table.at( 32768 + 300 ), qRgb( red, green, blue ) );
+  QVERIFY( shader->shade( -100, &red, &green, &blue, &alpha ) );
+  QCOMPARE( table.at( 32768 - 100 ), qRgb( red, green, blue ) );
+
+  // copies share the computed tables
+  const QgsColorRampShader copy( *shader );
+  QCOMPARE( copy.colorTable( Qgis::Int16 ), table );
+}
+
+void TestQgsSingleBandPseudoColorRenderer::renderMatchesShader_data()
+{
+  QTest::addColumn< int >( "dataType" );
+  QTest::addColumn< int >( "type" );
+  QTest::addColumn< bool >( "clip" );
+  QTest::addColumn< int >( "transparency" );
+  QTest::addColumn< int >( "noData" );
+
+  // transparency: 0 none, 1 opacity, 2 raster transparency, 3 alpha band
+  // no data: 0 none, 1 value, 2 bitmap
+  const QList< QPair< QString, int > > dataTypes = QList< QPair< QString, int > >() << qMakePair( QStringLiteral( "byte" ), static_cast< int >( Qgis::Byte ) )
+      << qMakePair( QStringLiteral( "uint16" ), static_cast< int >( Qgis::UInt16 ) )
+      << qMakePair( QStringLiteral( "int16" ), static_cast< int >( Qgis::Int16 ) )
+      << qMakePair( QStringLiteral( "float32" ), static_cast< int >( Qgis::Float32 ) );
+  for ( const QPair< QString, int > &dataType : dataTypes )
+  {
+    const QString name = dataType.first;
+    QTest::newRow( qPrintable( name + " interpolated" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Interpolated ) << false << 0 << 0;
+    QTest::newRow( qPrintable( name + " interpolated clip" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Interpolated ) << true << 0 << 0;
+    QTest::newRow( qPrintable( name + " discrete" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Discrete ) << false << 0 << 0;
+    QTest::newRow( qPrintable( name + " discrete clip" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Discrete ) << true << 0 << 0;
+    QTest::newRow( qPrintable( name + " exact" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Exact ) << false << 0 << 0;
+    QTest::newRow( qPrintable( name + " opacity" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Interpolated ) << false << 1 << 0;
+    QTest::newRow( qPrintable( name + " raster transparency" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Discrete ) << false << 2 << 0;
+    QTest::newRow( qPrintable( name + " alpha band" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Interpolated ) << false << 3 << 0;
+    QTest::newRow( qPrintable( name + " no data value" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Interpolated ) << false << 0 << 1;
+    QTest::newRow( qPrintable( name + " no data value opacity" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Interpolated ) << false << 1 << 1;
+    QTest::newRow( qPrintable( name + " no data bitmap" ) ) << dataType.second << static_cast< int >( QgsColorRampShader::Exact ) << false << 0 << 2;
+  }
+}
+
+void TestQgsSingleBandPseudoColorRenderer::renderMatchesShader()
+{
+  QFETCH( int, dataType );
+  QFETCH( int, type );
+  QFETCH( bool, clip );
+  QFETCH( int, transparency );
+  QFETCH( int, noData );
+
+  // every value of the 16 bit types appears once
+  TestBlockInput input( static_cast< Qgis::DataType >( dataType ), 256, 256 );
+  if ( noData == 1 )
+  {
+    input.mHasNoDataValue = true;
+    input.mNoDataValue = dataType == Qgis::Int16 ? -32000 : 120;
+  }
+  else if ( noData == 2 )
+  {
+    input.mNoDataBitmapIndex = 130;
+  }
+
+  const double minimum = dataType == Qgis::Int16 ? -30000 : 10;
+  const double maximum = dataType == Qgis::Byte ? 200 : 40000;
+  QgsColorRampShader *rampShader = createShader( static_cast< QgsColorRampShader::Type >( type ), minimum, maximum, clip );
+  if ( type == QgsColorRampShader::Exact )
+  {
+    QList<QgsColorRampShader::ColorRampItem> items = rampShader->colorRampItemList();
+    items << QgsColorRampShader::ColorRampItem( 130, QColor( 255, 0, 0 ) ) << QgsColorRampShader::ColorRampItem( -32000, QColor( 0, 255, 0 ) );
+    std::sort( items.begin(), items.end() );
+    rampShader->setColorRampItemList( items );
+  }
+  const QgsColorRampShader reference( *rampShader );
+
+  QgsRasterShader *shader = new QgsRasterShader( minimum, maximum );
+  shader->setRasterShaderFunction( rampShader );
+  QgsSingleBandPseudoColorRenderer renderer( &input, 1, shader );
+  if ( transparency == 1 )
+  {
+    renderer.setOpacity( 0.6 );
+  }
+  else if ( transparency == 2 )
+  {
+    QgsRasterTransparency *rasterTransparency = new QgsRasterTransparency();
+    QgsRasterTransparency::TransparentSingleValuePixel pixel;
+    pixel.min = 50;
+    pixel.max = 70;
+    pixel.percentTransparent = 70;
+    rasterTransparency->setTransparentSingleValuePixelList( QList<QgsRasterTransparency::TransparentSingleValuePixel>() << pixel );
+    renderer.setRasterTransparency( rasterTransparency );
+  }
+  else if ( transparency == 3 )
+  {
+    renderer.setAlphaBand( 2 );
+  }
+
+  const QVector<QRgb> expected = expectedColors( &input, renderer, reference );
+  const QVector<QRgb> rendered = renderedColors( renderer, 256, 256 );
+  for ( int i = 0; i < expected.size(); ++i )
+  {
+    if ( rendered.at( i ) != expected.at( i ) )
+    {
+      QFAIL( qPrintable( QStringLiteral( "Pixel %1: got %2, expected %3" ).arg( i ).arg( rendered.at( i ), 8, 16 ).arg( expected.at( i ), 8, 16 ) ) );
+    }
+  }
+}
+
+void TestQgsSingleBandPseudoColorRenderer::shaderChanges()
+{
+  TestBlockInput input( Qgis::Byte, 256, 256 );
+  QgsColorRampShader *rampShader = createShader( QgsColorRampShader::Interpolated, 10, 200, false );
+  QgsRasterShader *shader = new QgsRasterShader( 10, 200 );
+  shader->setRasterShaderFunction( rampShader );
+  QgsSingleBandPseudoColorRenderer renderer( &input, 1, shader );
+
+  // the precomputed colors follow the changes of the shader
+  QCOMPARE( renderedColors( renderer, 256, 256 ), expectedColors( &input, renderer, *rampShader ) );
+  rampShader->setColorRampType( QgsColorRampShader::Discrete );
+  QCOMPARE( renderedColors( renderer, 256, 256 ), expectedColors( &input, renderer, *rampShader ) );
+  rampShader->setClip( true );
+  QCOMPARE( renderedColors( renderer, 256, 256 ), expectedColors( &input, renderer, *rampShader ) );
+  rampShader->setColorRampItemList( QList<QgsColorRampShader::ColorRampItem>() << QgsColorRampShader::ColorRampItem( 100, QColor( 0, 0, 255 ) ) );
+  QCOMPARE( renderedColors( renderer, 256, 256 ), expectedColors( &input, renderer, *rampShader ) );
+  rampShader->setColorRampType( QStringLiteral( "INTERPOLATED" ) );
+  QCOMPARE( renderedColors( renderer, 256, 256 ), expectedColors( &input, renderer, *rampShader ) );
+}
+
+void TestQgsSingleBandPseudoColorRenderer::benchmarkRender_data()
+{
+  QTest::addColumn< int >( "dataType" );
+  QTest::newRow( "byte" ) << static_cast< int >( Qgis::Byte );
+  QTest::newRow( "uint16" ) << static_cast< int >( Qgis::UInt16 );
+  QTest::newRow( "float32" ) << static_cast< int >( Qgis::Float32 );
+}
+
+void TestQgsSingleBandPseudoColorRenderer::benchmarkRender()
+{
+  QFETCH( int, dataType );
+
+  TestBlockInput input( static_cast< Qgis::DataType >( dataType ), 4096, 4096 );
+  QgsRasterShader *shader = new QgsRasterShader( 10, 40000 );
+  shader->setRasterShaderFunction( createShader( QgsColorRampShader::Interpolated, 10, 40000, false ) );
+  QgsSingleBandPseudoColorRenderer renderer( &input, 1, shader );
+
+  QBENCHMARK
+  {
+    std::unique_ptr< QgsRasterBlock > block( renderer.block( 1, input.extent(), 4096, 4096 ) );
+    QVERIFY( !block->isEmpty() );
+  }
+}
+
+QGSTEST_MAIN( TestQgsSingleBandPseudoColorRenderer )
+#include "testqgssinglebandpseudocolorrenderer.moc"
@@ -16,6 +16,9 @@
 #include "qgstest.h"
 #include <QObject>
 #include <QString>
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
 
 #include <qgsapplication.h>
 #include "qgsfeatureiterator.h"
@@ -143,6 +146,95 @@ class TestQgsSpatialIndex : public QObject
       QVERIFY( fids[0] == 1 );
     }
 
+    void testPersistence()
+    {
+      QgsSpatialIndex index;
+      Q_FOREACH ( const QgsFeature &f, _pointFeatures() )
+        index.insertFeature( f );
+
+      QTemporaryDir dir;
+      const QString path = dir.filePath( QStringLiteral( "index.qgsidx" ) );
+      const QDateTime timestamp( QDate( 2018, 10, 1 ), QTime( 12, 0 ) );
+      QVERIFY( index.writeToFile( path, timestamp ) );
+
+      bool ok = false;
+      QgsSpatialIndex loaded = QgsSpatialIndex::fromFile( path, timestamp, &ok );
+      QVERIFY( ok );
+      QList<QgsFeatureId> fids = loaded.intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 2 << 3 );
+      QCOMPARE( loaded.nearestNeighbor( QgsPointXY( 2, -2 ), 1 ), QList<QgsFeatureId>() << 4 );
+
+      // any timestamp is accepted if none is given
+      QgsSpatialIndex::fromFile( path, QDateTime(), &ok );
+      QVERIFY( ok );
+
+      // outdated or invalid files are rejected
+      QgsSpatialIndex outdated = QgsSpatialIndex::fromFile( path, timestamp.addSecs( 1 ), &ok );
+      QVERIFY( !ok );
+      QVERIFY( outdated.intersects( QgsRectangle( -10, -10, 10, 10 ) ).isEmpty() );
+      QgsSpatialIndex::fromFile( dir.filePath( QStringLiteral( "missing.qgsidx" ) ), timestamp, &ok );
+      QVERIFY( !ok );
+      QFile garbage( dir.filePath( QStringLiteral( "garbage.qgsidx" ) ) );
+      QVERIFY( garbage.open( QIODevice::WriteOnly ) );
+      garbage.write( QByteArray( 200, 'x' ) );
+      garbage.close();
+      QgsSpatialIndex::fromFile( garbage.fileName(), timestamp, &ok );
+      QVERIFY( !ok );
+
+      // changes to a loaded index are not written back to the file
+      QVERIFY( loaded.insertFeature( 5, QgsRectangle( -5, 5, -5, 5 ) ) );
+      QVERIFY( loaded.deleteFeature( _pointFeatures().at( 2 ) ) );
+      fids = loaded.intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 2 << 5 );
+      fids = QgsSpatialIndex::fromFile( path, timestamp ).intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 2 << 3 );
+
+      // but a loaded index can be written again
+      const QString path2 = dir.filePath( QStringLiteral( "index2.qgsidx" ) );
+      QVERIFY( loaded.writeToFile( path2, timestamp ) );
+      fids = QgsSpatialIndex::fromFile( path2, timestamp ).intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 2 << 5 );
+    }
+
+    void testCache()
+    {
+      QgsVectorLayer vl( QStringLiteral( "Point" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsFeatureList features;
+      for ( int i = 0; i < 1000; ++i )
+        features << _pointFeature( i + 1, i % 100, i / 100 );
+      vl.dataProvider()->addFeatures( features );
+
+      const QString key = QStringLiteral( "testqgsspatialindex:%1" ).arg( QDateTime::currentMSecsSinceEpoch() );
+      const QString path = QgsSpatialIndex::cacheFilePath( key );
+      QVERIFY( !QFile::exists( path ) );
+
+      // no timestamp, no cache
+      QgsSpatialIndex uncached = QgsSpatialIndex::fromCache( *vl.dataProvider(), key, QDateTime() );
+      QCOMPARE( uncached.intersects( QgsRectangle( 9.5, 0.5, 10.5, 1.5 ) ), QList<QgsFeatureId>() << 111 );
+      QVERIFY( !QFile::exists( path ) );
+
+      const QDateTime timestamp = QDateTime::currentDateTime();
+      QgsSpatialIndex built = QgsSpatialIndex::fromCache( *vl.dataProvider(), key, timestamp );
+      QVERIFY( QFile::exists( path ) );
+      QCOMPARE( built.intersects( QgsRectangle( 9.5, 0.5, 10.5, 1.5 ) ), QList<QgsFeatureId>() << 111 );
+
+      // the second call opens the cached index, without reading the features
+      QgsVectorLayer empty( QStringLiteral( "Point" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
+      QgsSpatialIndex cached = QgsSpatialIndex::fromCache( *empty.dataProvider(), key, timestamp );
+      QCOMPARE( cached.intersects( QgsRectangle( 9.5, 0.5, 10.5, 1.5 ) ), QList<QgsFeatureId>() << 111 );
+      QCOMPARE( cached.intersects( QgsRectangle( -1, -1, 100, 100 ) ).count(), 1000 );
+
+      // a newer source is indexed again
+      QgsSpatialIndex rebuilt = QgsSpatialIndex::fromCache( *empty.dataProvider(), key, timestamp.addSecs( 10 ) );
+      QVERIFY( rebuilt.intersects( QgsRectangle( -1, -1, 100, 100 ) ).isEmpty() );
+
+      QVERIFY( QFile::remove( path ) );
+    }
+
     void benchmarkIntersect()
     {
       // add 50K features to the index
@@ -227,6 +319,23 @@ class TestQgsSpatialIndex : public QObject
       delete indexInsert;
     }
 
+    void benchmarkOpenFromFile()
+    {
+      QgsSpatialIndex index;
+      for ( int i = 0; i < 100000; ++i )
+        index.insertFeature( i, QgsRectangle( i % 1000, i / 1000, i % 1000 + 1, i / 1000 + 1 ) );
+
+      QTemporaryDir dir;
+      const QString path = dir.filePath( QStringLiteral( "index.qgsidx" ) );
+      QVERIFY( index.writeToFile( path, QDateTime() ) );
+
+      QBENCHMARK
+      {
+        QgsSpatialIndex loaded = QgsSpatialIndex::fromFile( path, QDateTime() );
+        loaded.intersects( QgsRectangle( 500, 50, 501, 51 ) );
+      }
+    }
+
 };
 
 QGSTEST_MAIN( TestQgsSpatialIndex )
@@ -0,0 +1,358 @@
+/***************************************************************************
+     testqgswkbview.cpp
+     --------------------------------------
+    Date                 : October 2018
+    Copyright            : (C) 2018 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QDataStream>
+
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgsgeometrycollection.h"
+#include "qgsgeometryfactory.h"
+#include "qgslinestring.h"
+#include "qgswkbptr.h"
+#include "qgsmaptopixelgeometrysimplifier.h"
+#include "qgswkbview_p.h"
+
+class TestQgsWkbView : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void view_data();
+    void view();
+    void unsupported_data();
+    void unsupported();
+    void bigEndian();
+    void lazyGeometry_data();
+    void lazyGeometry();
+    void lazyGeometryCopies();
+    void simplify_data();
+    void simplify();
+
+    void benchmarkBoundingBox_data();
+    void benchmarkBoundingBox();
+    void benchmarkSimplify_data();
+    void benchmarkSimplify();
+
+  private:
+    static QByteArray largeMultiPolygonWkb();
+};
+
+void TestQgsWkbView::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsWkbView::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsWkbView::view_data()
+{
+  QTest::addColumn< QString >( "wkt" );
+
+  QTest::newRow( "point" ) << QStringLiteral( "Point (1 2)" );
+  QTest::newRow( "point zm" ) << QStringLiteral( "PointZM (1 2 3 4)" );
+  QTest::newRow( "empty line" ) << QStringLiteral( "LineString EMPTY" );
+  QTest::newRow( "line" ) << QStringLiteral( "LineString (1 2, 3 -4, -5 6)" );
+  QTest::newRow( "line m" ) << QStringLiteral( "LineStringM (1 2 3, 3 -4 5, -5 6 7)" );
+  QTest::newRow( "empty polygon" ) << QStringLiteral( "Polygon EMPTY" );
+  QTest::newRow( "polygon" ) << QStringLiteral( "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(1 1, 2 1, 2 2, 1 1))" );
+  QTest::newRow( "polygon z" ) << QStringLiteral( "PolygonZ ((0 0 1, 10 0 2, 10 10 3, 0 0 1))" );
+  QTest::newRow( "multipoint" ) << QStringLiteral( "MultiPoint ((1 2),(-3 4))" );
+  QTest::newRow( "multilinestring" ) << QStringLiteral( "MultiLineString ((1 2, 3 4),(-5 -6, 7 8, 9 10))" );
+  QTest::newRow( "multipolygon" ) << QStringLiteral( "MultiPolygon (((0 0, 1 0, 1 1, 0 0)),((5 5, 6 5, 6 6, 5 5),(5.1 5.1, 5.2 5.1, 5.2 5.2, 5.1 5.1)))" );
+  QTest::newRow( "multipolygon zm" ) << QStringLiteral( "MultiPolygonZM (((0 0 1 2, 1 0 1 2, 1 1 1 2, 0 0 1 2)))" );
+  QTest::newRow( "empty multipolygon" ) << QStringLiteral( "MultiPolygon EMPTY" );
+  QTest::newRow( "collection" ) << QStringLiteral( "GeometryCollection (Point (1 2),LineString (3 4, 5 6),Polygon ((0 0, 1 0, 1 1, 0 0)))" );
+}
+
+void TestQgsWkbView::view()
+{
+  QFETCH( QString, wkt );
+
+  const QgsGeometry parsed = QgsGeometry::fromWkt( wkt );
+  QVERIFY( !parsed.isNull() );
+  const QByteArray wkb = parsed.asWkb();
+
+  const QgsWkbView view( wkb );
+  QVERIFY( view.isValid() );
+  QVERIFY( view.isNativeEndian() );
+  QCOMPARE( view.wkbType(), parsed.constGet()->wkbType() );
+  QCOMPARE( view.isEmpty(), parsed.constGet()->isEmpty() );
+  QCOMPARE( view.nCoordinates(), parsed.constGet()->nCoordinates() );
+  QCOMPARE( view.boundingBox(), parsed.constGet()->boundingBox() );
+  QCOMPARE( view.asWkb(), wkb );
+  QCOMPARE( view.materialize()->asWkt(), parsed.asWkt() );
+
+  const QVector< QgsWkbView > parts = view.parts();
+  if ( QgsWkbTypes::isMultiType( view.wkbType() ) )
+  {
+    QCOMPARE( parts.count(), parsed.constGet()->partCount() );
+    for ( int i = 0; i < parts.count(); ++i )
+    {
+      const QgsAbstractGeometry *part = qgsgeometry_cast< const QgsGeometryCollection * >( parsed.constGet() )->geometryN( i );
+      QCOMPARE( parts.at( i ).wkbType(), part->wkbType() );
+      QCOMPARE( parts.at( i ).boundingBox(), part->boundingBox() );
+    }
+    QVERIFY( view.sequences().isEmpty() );
+  }
+  else
+  {
+    QCOMPARE( parts.count(), 1 );
+    int coordinates = 0;
+    for ( const QgsWkbView::CoordinateSequence &sequence : view.sequences() )
+    {
+      std::unique_ptr< QgsLineString > line = sequence.toLineString();
+      QCOMPARE( line->numPoints(), sequence.count() );
+      for ( int i = 0; i < sequence.count(); ++i )
+      {
+        QCOMPARE( line->xAt( i ), sequence.x( i ) );
+        QCOMPARE( line->yAt( i ), sequence.y( i ) );
+      }
+      coordinates += sequence.count();
+    }
+    QCOMPARE( coordinates, view.nCoordinates() );
+  }
+}
+
+void TestQgsWkbView::unsupported_data()
+{
+  QTest::addColumn< QByteArray >( "wkb" );
+
+  QTest::newRow( "empty" ) << QByteArray();
+  QTest::newRow( "curve" ) << QgsGeometry::fromWkt( QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) ).asWkb();
+  QTest::newRow( "curve polygon" ) << QgsGeometry::fromWkt( QStringLiteral( "CurvePolygon (CircularString (0 0, 1 1, 2 0, 1 -1, 0 0))" ) ).asWkb();
+  QTest::newRow( "triangle" ) << QgsGeometry::fromWkt( QStringLiteral( "Triangle ((0 0, 1 0, 1 1, 0 0))" ) ).asWkb();
+  QTest::newRow( "truncated" ) << QgsGeometry::fromWkt( QStringLiteral( "LineString (0 0, 1 1, 2 2)" ) ).asWkb().left( 40 );
+  QTest::newRow( "nested collection" ) << QgsGeometry::fromWkt( QStringLiteral( "GeometryCollection (MultiPoint ((1 2)))" ) ).asWkb();
+
+  // a multi point whose second part has a z value, the factory would drop it
+  QByteArray mixed;
+  QDataStream stream( &mixed, QIODevice::WriteOnly );
+  stream.setByteOrder( QDataStream::LittleEndian );
+  stream << static_cast< quint8 >( 1 ) << static_cast< quint32 >( QgsWkbTypes::MultiPoint ) << static_cast< quint32 >( 2 );
+  stream << static_cast< quint8 >( 1 ) << static_cast< quint32 >( QgsWkbTypes::Point ) << 1.0 << 2.0;
+  stream << static_cast< quint8 >( 1 ) << static_cast< quint32 >( QgsWkbTypes::PointZ ) << 1.0 << 2.0 << 3.0;
+  QTest::newRow( "mixed dimensions" ) << mixed;
+}
+
+void TestQgsWkbView::unsupported()
+{
+  QFETCH( QByteArray, wkb );
+
+  const QgsWkbView view( wkb );
+  QVERIFY( !view.isValid() );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::Unknown );
+  QVERIFY( !view.materialize() );
+
+  // unsupported WKB is still parsed straight away by QgsGeometry
+  QgsGeometry geometry;
+  geometry.fromWkb( wkb );
+  QgsConstWkbPtr ptr( wkb );
+  std::unique_ptr< QgsAbstractGeometry > expected = wkb.isEmpty() ? nullptr : QgsGeometryFactory::geomFromWkb( ptr );
+  QCOMPARE( geometry.isNull(), !expected );
+  if ( expected )
+    QCOMPARE( geometry.asWkt(), expected->asWkt() );
+}
+
+void TestQgsWkbView::bigEndian()
+{
+  QByteArray wkb;
+  QDataStream stream( &wkb, QIODevice::WriteOnly );
+  stream.setByteOrder( QDataStream::BigEndian );
+  stream << static_cast< quint8 >( 0 ) << static_cast< quint32 >( QgsWkbTypes::LineString ) << static_cast< quint32 >( 3 );
+  stream << 1.0 << 2.0 << -3.0 << 4.0 << 5.0 << -6.0;
+
+  const QgsWkbView view( wkb );
+  QVERIFY( view.isValid() );
+  QVERIFY( !view.isNativeEndian() || QgsApplication::endian() == QgsApplication::XDR );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::LineString );
+  QCOMPARE( view.boundingBox(), QgsRectangle( -3, -6, 5, 4 ) );
+  QCOMPARE( view.sequences().at( 0 ).y( 2 ), -6.0 );
+
+  QgsGeometry geometry;
+  geometry.fromWkb( wkb );
+  QCOMPARE( geometry.asWkt(), QStringLiteral( "LineString (1 2, -3 4, 5 -6)" ) );
+  // non native WKB is always written back in the native byte order
+  QCOMPARE( geometry.asWkb(), QgsGeometry::fromWkt( QStringLiteral( "LineString (1 2, -3 4, 5 -6)" ) ).asWkb() );
+}
+
+void TestQgsWkbView::lazyGeometry_data()
+{
+  view_data();
+}
+
+void TestQgsWkbView::lazyGeometry()
+{
+  QFETCH( QString, wkt );
+
+  const QgsGeometry parsed = QgsGeometry::fromWkt( wkt );
+  QgsGeometry lazy;
+  lazy.fromWkb( parsed.asWkb() );
+
+  QCOMPARE( lazy.isNull(), false );
+  QCOMPARE( lazy.wkbType(), parsed.wkbType() );
+  QCOMPARE( lazy.type(), parsed.type() );
+  QCOMPARE( lazy.isMultipart(), parsed.isMultipart() );
+  QCOMPARE( lazy.isEmpty(), parsed.isEmpty() );
+  QCOMPARE( lazy.boundingBox(), parsed.boundingBox() );
+  QCOMPARE( lazy.boundingBoxIntersects( QgsRectangle( 0, 0, 1, 1 ) ), parsed.boundingBoxIntersects( QgsRectangle( 0, 0, 1, 1 ) ) );
+  QCOMPARE( lazy.asWkb(), parsed.asWkb() );
+
+  // anything else parses the WKB
+  QCOMPARE( lazy.asWkt(), parsed.asWkt() );
+  QCOMPARE( lazy.boundingBox(), parsed.boundingBox() );
+  QVERIFY( lazy.equals( parsed ) || parsed.isEmpty() );
+}
+
+void TestQgsWkbView::lazyGeometryCopies()
+{
+  QgsGeometry lazy;
+  lazy.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "LineString (0 0, 10 10)" ) ).asWkb() );
+  QgsGeometry copy( lazy );
+
+  // modifying a copy must not affect the WKB shared with the original
+  copy.translate( 5, 5 );
+  QCOMPARE( copy.boundingBox(), QgsRectangle( 5, 5, 15, 15 ) );
+  QCOMPARE( copy.asWkt(), QStringLiteral( "LineString (5 5, 15 15)" ) );
+  QCOMPARE( lazy.boundingBox(), QgsRectangle( 0, 0, 10, 10 ) );
+  QCOMPARE( lazy.asWkt(), QStringLiteral( "LineString (0 0, 10 10)" ) );
+
+  // and the WKB of a modified geometry is written from the modified geometry
+  lazy.get()->transform( QTransform::fromScale( 2, 2 ) );
+  QCOMPARE( lazy.boundingBox(), QgsRectangle( 0, 0, 20, 20 ) );
+  QCOMPARE( lazy.asWkb(), QgsGeometry::fromWkt( QStringLiteral( "LineString (0 0, 20 20)" ) ).asWkb() );
+
+  QgsGeometry other;
+  other.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "Point (1 1)" ) ).asWkb() );
+  other.set( new QgsLineString( QgsPoint( 1, 2 ), QgsPoint( 3, 4 ) ) );
+  QCOMPARE( other.boundingBox(), QgsRectangle( 1, 2, 3, 4 ) );
+}
+
+void TestQgsWkbView::simplify_data()
+{
+  QTest::addColumn< QString >( "wkt" );
+  QTest::addColumn< int >( "algorithm" );
+  QTest::addColumn< double >( "tolerance" );
+
+  const QStringList wkts = QStringList()
+                           << QStringLiteral( "LineString (0 0, 0.1 0, 0.2 0.05, 5 5, 5.1 5.1, 5.2 5, 10 10, 10.05 10, 20 0)" )
+                           << QStringLiteral( "LineStringZ (0 0 1, 0.1 0 1, 0.2 0.05 1, 5 5 1, 5.1 5.1 1, 5.2 5 1, 10 10 1, 10.05 10 1, 20 0 1)" )
+                           << QStringLiteral( "Polygon ((0 0, 0.1 0, 10 0, 10.1 0.1, 10 10, 9.9 10, 0 10, 0 5, 0 0),(1 1, 1.01 1, 1.02 1.01, 1 1))" )
+                           << QStringLiteral( "MultiPolygon (((0 0, 0.1 0, 10 0, 10.1 0.1, 10 10, 9.9 10, 0 10, 0 5, 0 0)),((20 20, 20.01 20, 20.02 20.02, 20 20.01, 20 20)))" )
+                           << QStringLiteral( "MultiLineString ((0 0, 0.1 0, 0.2 0.05, 5 5, 5.1 5.1, 10 10),(0 0, 0.01 0.01, 0.02 0))" )
+                           << QStringLiteral( "MultiPoint ((0 0),(1 1),(2 2),(3 3),(4 4))" );
+  for ( const QString &wkt : wkts )
+  {
+    for ( int algorithm : QList< int >() << QgsMapToPixelSimplifier::Distance << QgsMapToPixelSimplifier::SnapToGrid )
+    {
+      for ( double tolerance : QList< double >() << 0.05 << 0.5 << 1 << 50 )
+      {
+        QTest::newRow( QStringLiteral( "%1 %2 %3" ).arg( wkt.left( 20 ) ).arg( algorithm ).arg( tolerance ).toLatin1() ) << wkt << algorithm << tolerance;
+      }
+    }
+  }
+}
+
+void TestQgsWkbView::simplify()
+{
+  QFETCH( QString, wkt );
+  QFETCH( int, algorithm );
+  QFETCH( double, tolerance );
+
+  const QByteArray wkb = QgsGeometry::fromWkt( wkt ).asWkb();
+  const QgsMapToPixelSimplifier simplifier( QgsMapToPixelSimplifier::SimplifyGeometry | QgsMapToPixelSimplifier::SimplifyEnvelope,
+      tolerance, static_cast< QgsMapToPixelSimplifier::SimplifyAlgorithm >( algorithm ) );
+
+  QgsGeometry lazy;
+  lazy.fromWkb( wkb );
+  QgsGeometry parsed;
+  parsed.fromWkb( wkb );
+  QVERIFY( parsed.constGet() );
+
+  const QgsGeometry lazyResult = simplifier.simplify( lazy );
+  const QgsGeometry parsedResult = simplifier.simplify( parsed );
+  QCOMPARE( lazyResult.asWkt(), parsedResult.asWkt() );
+  QCOMPARE( lazyResult.wkbType(), parsedResult.wkbType() );
+}
+
+QByteArray TestQgsWkbView::largeMultiPolygonWkb()
+{
+  QgsMultiPolygonXY multiPolygon;
+  for ( int part = 0; part < 50; ++part )
+  {
+    QgsPolylineXY ring;
+    for ( int i = 0; i < 2000; ++i )
+    {
+      const double angle = 2 * M_PI * i / 2000;
+      ring << QgsPointXY( part * 100 + 10 * std::cos( angle ), 10 * std::sin( angle ) );
+    }
+    ring << ring.at( 0 );
+    multiPolygon << ( QgsPolygonXY() << ring );
+  }
+  return QgsGeometry::fromMultiPolygonXY( multiPolygon ).asWkb();
+}
+
+void TestQgsWkbView::benchmarkBoundingBox_data()
+{
+  QTest::addColumn< bool >( "lazy" );
+  QTest::newRow( "parsed" ) << false;
+  QTest::newRow( "lazy" ) << true;
+}
+
+void TestQgsWkbView::benchmarkBoundingBox()
+{
+  QFETCH( bool, lazy );
+
+  const QByteArray wkb = largeMultiPolygonWkb();
+  QBENCHMARK
+  {
+    QgsGeometry geometry;
+    geometry.fromWkb( wkb );
+    if ( !lazy )
+      geometry.constGet();
+    geometry.boundingBox();
+  }
+}
+
+void TestQgsWkbView::benchmarkSimplify_data()
+{
+  benchmarkBoundingBox_data();
+}
+
+void TestQgsWkbView::benchmarkSimplify()
+{
+  QFETCH( bool, lazy );
+
+  const QByteArray wkb = largeMultiPolygonWkb();
+  const QgsMapToPixelSimplifier simplifier( QgsMapToPixelSimplifier::SimplifyGeometry | QgsMapToPixelSimplifier::SimplifyEnvelope, 0.5 );
+  QBENCHMARK
+  {
+    QgsGeometry geometry;
+    geometry.fromWkb( wkb );
+    if ( !lazy )
+      geometry.constGet();
+    simplifier.simplify( geometry );
+  }
+}
+
+QGSTEST_MAIN( TestQgsWkbView )
+#include "testqgswkbview.moc"
@@ -14,8 +14,37 @@
  ***************************************************************************/
 #include "qgstest.h"
 #include <QObject>
+#include <QDataStream>
+#include <functional>
 
 #include <qgspostgresprovider.h>
+#include <qgspostgresbinarydecoder.h>
+
+// binary send format of a numeric with base 10000 \a digits
+static QByteArray numeric( qint16 weight, bool negative, qint16 scale, const QList<qint16> &digits )
+{
+  QByteArray data;
+  QDataStream stream( &data, QIODevice::WriteOnly );
+  stream << static_cast<qint16>( digits.count() ) << weight << static_cast<quint16>( negative ? 0x4000 : 0 ) << scale;
+  for ( qint16 digit : digits )
+    stream << digit;
+  return data;
+}
+
+// binary send format of a value written by \a write
+static QByteArray encode( const std::function<void( QDataStream & )> &write )
+{
+  QByteArray data;
+  QDataStream stream( &data, QIODevice::WriteOnly );
+  write( stream );
+  return data;
+}
+
+static qint64 postgresMicroseconds( const QDateTime &dateTime )
+{
+  const qint64 days = dateTime.date().toJulianDay() - QDate( 2000, 1, 1 ).toJulianDay();
+  return days * 86400LL * 1000000 + dateTime.time().msecsSinceStartOfDay() * 1000LL;
+}
 
 class TestQgsPostgresProvider: public QObject
 {
@@ -78,6 +107,147 @@ class TestQgsPostgresProvider: public QObject
       qDebug() << "actual: " << decoded;
       QCOMPARE( decoded.toList(), expected );
     }
+
+    void decodeBinary_data()
+    {
+      QTest::addColumn<QString>( "typeName" );
+      QTest::addColumn<int>( "type" );
+      QTest::addColumn<QByteArray>( "binary" );
+      QTest::addColumn<QString>( "text" );
+
+      QTest::newRow( "bool" ) << QStringLiteral( "bool" ) << static_cast<int>( QVariant::Bool ) << QByteArray( 1, 1 ) << QStringLiteral( "t" );
+      QTest::newRow( "bool false" ) << QStringLiteral( "bool" ) << static_cast<int>( QVariant::Bool ) << QByteArray( 1, 0 ) << QStringLiteral( "f" );
+      QTest::newRow( "int2" ) << QStringLiteral( "int2" ) << static_cast<int>( QVariant::Int ) << encode( []( QDataStream & s ) { s << static_cast<qint16>( -5 ); } ) << QStringLiteral( "-5" );
+      QTest::newRow( "int4" ) << QStringLiteral( "int4" ) << static_cast<int>( QVariant::Int ) << encode( []( QDataStream & s ) { s << static_cast<qint32>( 123456 ); } ) << QStringLiteral( "123456" );
+      QTest::newRow( "int8" ) << QStringLiteral( "int8" ) << static_cast<int>( QVariant::LongLong ) << encode( []( QDataStream & s ) { s << static_cast<qint64>( 9876543210LL ); } ) << QStringLiteral( "9876543210" );
+      QTest::newRow( "float4" ) << QStringLiteral( "float4" ) << static_cast<int>( QVariant::Double ) << encode( []( QDataStream & s ) { s.setFloatingPointPrecision( QDataStream::SinglePrecision ); s << 1.1f; } ) << QStringLiteral( "1.1" );
+      QTest::newRow( "float8" ) << QStringLiteral( "float8" ) << static_cast<int>( QVariant::Double ) << encode( []( QDataStream & s ) { s << -3.25; } ) << QStringLiteral( "-3.25" );
+      QTest::newRow( "numeric" ) << QStringLiteral( "numeric" ) << static_cast<int>( QVariant::Double ) << numeric( 1, false, 3, QList<qint16>() << 1 << 2345 << 6780 ) << QStringLiteral( "12345.678" );
+      QTest::newRow( "numeric small" ) << QStringLiteral( "numeric" ) << static_cast<int>( QVariant::Double ) << numeric( -1, true, 4, QList<qint16>() << 12 ) << QStringLiteral( "-0.0012" );
+      QTest::newRow( "numeric zero" ) << QStringLiteral( "numeric" ) << static_cast<int>( QVariant::Double ) << numeric( 0, false, 0, QList<qint16>() ) << QStringLiteral( "0" );
+      QTest::newRow( "date" ) << QStringLiteral( "date" ) << static_cast<int>( QVariant::Date ) << encode( []( QDataStream & s ) { s << static_cast<qint32>( QDate( 2018, 10, 1 ).toJulianDay() - QDate( 2000, 1, 1 ).toJulianDay() ); } ) << QStringLiteral( "2018-10-01" );
+      QTest::newRow( "time" ) << QStringLiteral( "time" ) << static_cast<int>( QVariant::Time ) << encode( []( QDataStream & s ) { s << static_cast<qint64>( QTime( 12, 34, 56, 789 ).msecsSinceStartOfDay() * 1000LL ); } ) << QStringLiteral( "12:34:56.789" );
+      QTest::newRow( "timestamp" ) << QStringLiteral( "timestamp" ) << static_cast<int>( QVariant::DateTime ) << encode( []( QDataStream & s ) { s << postgresMicroseconds( QDateTime( QDate( 2018, 10, 1 ), QTime( 12, 34, 56, 789 ) ) ); } ) << QStringLiteral( "2018-10-01T12:34:56.789" );
+      QTest::newRow( "timestamp before 2000" ) << QStringLiteral( "timestamp" ) << static_cast<int>( QVariant::DateTime ) << encode( []( QDataStream & s ) { s << postgresMicroseconds( QDateTime( QDate( 1999, 12, 31 ), QTime( 23, 0, 0 ) ) ); } ) << QStringLiteral( "1999-12-31T23:00:00" );
+      QTest::newRow( "text" ) << QStringLiteral( "text" ) << static_cast<int>( QVariant::String ) << QStringLiteral( "h\u00e9llo" ).toUtf8() << QStringLiteral( "h\u00e9llo" );
+      QTest::newRow( "varchar" ) << QStringLiteral( "varchar" ) << static_cast<int>( QVariant::String ) << QByteArray( "abc" ) << QStringLiteral( "abc" );
+    }
+
+    void decodeBinary()
+    {
+      QFETCH( QString, typeName );
+      QFETCH( int, type );
+      QFETCH( QByteArray, binary );
+      QFETCH( QString, text );
+
+      const QgsField field( QStringLiteral( "f" ), static_cast<QVariant::Type>( type ), typeName );
+      const QgsPostgresBinaryDecoder::Format format = QgsPostgresBinaryDecoder::format( field );
+      QVERIFY( format != QgsPostgresBinaryDecoder::Unsupported );
+
+      const QVariant decoded = QgsPostgresBinaryDecoder::decode( format, field, binary.constData(), binary.size() );
+      const QVariant expected = QgsPostgresProvider::convertValue( field.type(), field.subType(), text );
+      QCOMPARE( decoded.type(), expected.type() );
+      QCOMPARE( decoded, expected );
+
+      // truncated values are null
+      if ( format != QgsPostgresBinaryDecoder::Text && format != QgsPostgresBinaryDecoder::Numeric )
+        QVERIFY( QgsPostgresBinaryDecoder::decode( format, field, binary.constData(), binary.size() - 1 ).isNull() );
+    }
+
+    void decodeBinaryArray()
+    {
+      QByteArray ints;
+      QDataStream intStream( &ints, QIODevice::WriteOnly );
+      // dimensions, has nulls, element oid (int4), size and lower bound of the dimension
+      intStream << static_cast<qint32>( 1 ) << static_cast<qint32>( 1 ) << static_cast<quint32>( 23 ) << static_cast<qint32>( 3 ) << static_cast<qint32>( 1 );
+      intStream << static_cast<qint32>( 4 ) << static_cast<qint32>( 1 ) << static_cast<qint32>( -1 ) << static_cast<qint32>( 4 ) << static_cast<qint32>( -3 );
+
+      const QgsField intField( QStringLiteral( "f" ), QVariant::List, QStringLiteral( "_int4" ), -1, 0, QString(), QVariant::Int );
+      QCOMPARE( QgsPostgresBinaryDecoder::format( intField ), QgsPostgresBinaryDecoder::Array );
+      const QVariant decoded = QgsPostgresBinaryDecoder::decode( QgsPostgresBinaryDecoder::Array, intField, ints.constData(), ints.size() );
+      QCOMPARE( decoded, QgsPostgresProvider::convertValue( QVariant::List, QVariant::Int, QStringLiteral( "{1,NULL,-3}" ) ) );
+      QVERIFY( decoded.toList().at( 1 ).isNull() );
+
+      QByteArray strings;
+      QDataStream stringStream( &strings, QIODevice::WriteOnly );
+      stringStream << static_cast<qint32>( 1 ) << static_cast<qint32>( 0 ) << static_cast<quint32>( 25 ) << static_cast<qint32>( 2 ) << static_cast<qint32>( 1 );
+      stringStream << static_cast<qint32>( 1 );
+      stringStream.writeRawData( "a", 1 );
+      stringStream << static_cast<qint32>( 4 );
+      stringStream.writeRawData( "b, c", 4 );
+
+      const QgsField stringField( QStringLiteral( "f" ), QVariant::StringList, QStringLiteral( "_text" ), -1, 0, QString(), QVariant::String );
+      QCOMPARE( QgsPostgresBinaryDecoder::decode( QgsPostgresBinaryDecoder::Array, stringField, strings.constData(), strings.size() ),
+                QgsPostgresProvider::convertValue( QVariant::StringList, QVariant::String, QStringLiteral( "{a,\"b, c\"}" ) ) );
+
+      // empty array
+      QByteArray empty;
+      QDataStream emptyStream( &empty, QIODevice::WriteOnly );
+      emptyStream << static_cast<qint32>( 0 ) << static_cast<qint32>( 0 ) << static_cast<quint32>( 23 );
+      QCOMPARE( QgsPostgresBinaryDecoder::decode( QgsPostgresBinaryDecoder::Array, intField, empty.constData(), empty.size() ), QVariant( QVariantList() ) );
+
+      // truncated
+      QVERIFY( QgsPostgresBinaryDecoder::decode( QgsPostgresBinaryDecoder::Array, intField, ints.constData(), ints.size() - 2 ).isNull() );
+    }
+
+    void decodeBinaryUnsupported()
+    {
+      // fetched as text
+      QCOMPARE( QgsPostgresBinaryDecoder::format( QgsField( QStringLiteral( "f" ), QVariant::String, QStringLiteral( "character" ) ) ), QgsPostgresBinaryDecoder::Unsupported );
+      QCOMPARE( QgsPostgresBinaryDecoder::format( QgsField( QStringLiteral( "f" ), QVariant::String, QStringLiteral( "timestamptz" ) ) ), QgsPostgresBinaryDecoder::Unsupported );
+      QCOMPARE( QgsPostgresBinaryDecoder::format( QgsField( QStringLiteral( "f" ), QVariant::Map, QStringLiteral( "hstore" ) ) ), QgsPostgresBinaryDecoder::Unsupported );
+      QCOMPARE( QgsPostgresBinaryDecoder::format( QgsField( QStringLiteral( "f" ), QVariant::String, QStringLiteral( "geometry" ) ) ), QgsPostgresBinaryDecoder::Unsupported );
+      // field type which does not match the type name
+      QCOMPARE( QgsPostgresBinaryDecoder::format( QgsField( QStringLiteral( "f" ), QVariant::String, QStringLiteral( "int4" ) ) ), QgsPostgresBinaryDecoder::Unsupported );
+      QCOMPARE( QgsPostgresBinaryDecoder::format( QgsField( QStringLiteral( "f" ), QVariant::List, QStringLiteral( "_hstore" ), -1, 0, QString(), QVariant::Map ) ), QgsPostgresBinaryDecoder::Unsupported );
+    }
+
+    void benchmarkDecode_data()
+    {
+      QTest::addColumn<bool>( "binary" );
+      QTest::newRow( "text" ) << false;
+      QTest::newRow( "binary" ) << true;
+    }
+
+    void benchmarkDecode()
+    {
+      QFETCH( bool, binary );
+
+      // a wide row, as the server sends it in both formats
+      const QList<QgsField> fields = QList<QgsField>()
+                                     << QgsField( QStringLiteral( "i" ), QVariant::Int, QStringLiteral( "int4" ) )
+                                     << QgsField( QStringLiteral( "l" ), QVariant::LongLong, QStringLiteral( "int8" ) )
+                                     << QgsField( QStringLiteral( "d" ), QVariant::Double, QStringLiteral( "float8" ) )
+                                     << QgsField( QStringLiteral( "n" ), QVariant::Double, QStringLiteral( "numeric" ) )
+                                     << QgsField( QStringLiteral( "t" ), QVariant::DateTime, QStringLiteral( "timestamp" ) )
+                                     << QgsField( QStringLiteral( "b" ), QVariant::Bool, QStringLiteral( "bool" ) );
+      QList<QByteArray> binaryValues;
+      binaryValues << encode( []( QDataStream & s ) { s << static_cast<qint32>( 123456 ); } )
+                   << encode( []( QDataStream & s ) { s << static_cast<qint64>( 9876543210LL ); } )
+                   << encode( []( QDataStream & s ) { s << 12345.6789; } )
+                   << numeric( 1, false, 3, QList<qint16>() << 1 << 2345 << 6780 )
+                   << encode( []( QDataStream & s ) { s << postgresMicroseconds( QDateTime( QDate( 2018, 10, 1 ), QTime( 12, 34, 56 ) ) ); } )
+                   << QByteArray( 1, 1 );
+      const QList<QByteArray> textValues = QList<QByteArray>() << "123456" << "9876543210" << "12345.6789" << "12345.678" << "2018-10-01T12:34:56" << "t";
+
+      QList<QgsPostgresBinaryDecoder::Format> formats;
+      for ( const QgsField &field : fields )
+        formats << QgsPostgresBinaryDecoder::format( field );
+
+      QBENCHMARK
+      {
+        for ( int row = 0; row < 10000; ++row )
+        {
+          for ( int i = 0; i < fields.count(); ++i )
+          {
+            if ( binary )
+              QgsPostgresBinaryDecoder::decode( formats.at( i ), fields.at( i ), binaryValues.at( i ).constData(), binaryValues.at( i ).size() );
+            else
+              QgsPostgresProvider::convertValue( fields.at( i ).type(), fields.at( i ).subType(), QString::fromUtf8( textValues.at( i ).constData() ) );
+          }
+        }
+      }
+    }
 };
 
 QGSTEST_MAIN( TestQgsPostgresProvider )
@@ -20,7 +20,8 @@ import tempfile
 from osgeo import gdal, ogr  # NOQA
 from qgis.PyQt.QtCore import QVariant
 from qgis.core import (QgsFeature, QgsFeatureRequest, QgsField, QgsSettings, QgsDataProvider,
-                       QgsVectorDataProvider, QgsVectorLayer, QgsWkbTypes, QgsNetworkAccessManager)
+                       QgsVectorDataProvider, QgsVectorLayer, QgsWkbTypes, QgsNetworkAccessManager,
+                       QgsFeatureBatch, QgsRectangle, NULL)
 from qgis.testing import start_app, unittest
 
 from utilities import unitTestDataPath
@@ -404,6 +405,92 @@ class PyQgsOGRProvider(unittest.TestCase):
         vl = QgsVectorLayer(datasource, 'test', 'ogr')
         self.assertEqual(len(vl.fields()), 2)
 
+    def testBatch(self):
+        """ Test that features read in batches are the same as the ones read one by one """
+
+        tmpfile = os.path.join(self.basetestpath, 'testBatch.gpkg')
+        ds = ogr.GetDriverByName('GPKG').CreateDataSource(tmpfile)
+        lyr = ds.CreateLayer('test', geom_type=ogr.wkbMultiPolygon)
+        lyr.CreateField(ogr.FieldDefn('int', ogr.OFTInteger))
+        lyr.CreateField(ogr.FieldDefn('int64', ogr.OFTInteger64))
+        lyr.CreateField(ogr.FieldDefn('real', ogr.OFTReal))
+        lyr.CreateField(ogr.FieldDefn('str', ogr.OFTString))
+        lyr.CreateField(ogr.FieldDefn('date', ogr.OFTDate))
+        for i in range(25):
+            f = ogr.Feature(lyr.GetLayerDefn())
+            if i % 4:
+                f['int'] = i
+                f['int64'] = i * 10000000000
+                f['real'] = i / 3.0
+                f['str'] = 'feature {}'.format(i)
+                f['date'] = '2018/10/{:02d}'.format(i + 1)
+            if i % 5:
+                # single polygons must be returned as multipolygons
+                f.SetGeometry(ogr.CreateGeometryFromWkt('POLYGON (({0} 0,{0} 1,{1} 1,{0} 0))'.format(i, i + 1)))
+            lyr.CreateFeature(f)
+        ds = None
+
+        vl = QgsVectorLayer('{}|layerid=0'.format(tmpfile), 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+        provider = vl.dataProvider()
+
+        def summary(features):
+            return [(f.id(), f.attributes(), f.geometry().asWkt()) for f in features]
+
+        def batched(request, size, source=provider):
+            features = []
+            batch = QgsFeatureBatch()
+            it = source.getFeatures(request)
+            while it.nextBatch(batch, size):
+                self.assertLessEqual(batch.size(), size)
+                for column in range(batch.columnCount()):
+                    for row in range(batch.size()):
+                        value = batch.value(column, row)
+                        self.assertEqual(batch.isNull(column, row), value == NULL)
+                        if batch.isNull(column, row):
+                            continue
+                        if batch.columnType(column) == QgsFeatureBatch.Int64Column:
+                            self.assertEqual(batch.int64Value(column, row), value)
+                        elif batch.columnType(column) == QgsFeatureBatch.DoubleColumn:
+                            self.assertEqual(batch.doubleValue(column, row), value)
+                        elif batch.columnType(column) == QgsFeatureBatch.StringColumn:
+                            self.assertEqual(batch.stringValue(column, row), value)
+                features.extend(batch.feature(row) for row in range(batch.size()))
+            self.assertFalse(it.nextBatch(batch, size))
+            self.assertTrue(batch.isEmpty())
+            return features
+
+        requests = [QgsFeatureRequest(),
+                    QgsFeatureRequest().setSubsetOfAttributes([0, 3]),
+                    QgsFeatureRequest().setFlags(QgsFeatureRequest.NoGeometry),
+                    QgsFeatureRequest().setFilterRect(QgsRectangle(3.5, 0, 10.5, 1)),
+                    QgsFeatureRequest().setFilterRect(QgsRectangle(3.5, 0, 10.5, 1)).setFlags(QgsFeatureRequest.ExactIntersect),
+                    QgsFeatureRequest().setLimit(7),
+                    QgsFeatureRequest().setFilterExpression('"int" > 10'),
+                    QgsFeatureRequest().setFilterExpression('"int" > 10 AND $area > 0'),
+                    QgsFeatureRequest().setFilterFids([2, 5, 9]),
+                    QgsFeatureRequest().addOrderBy('real', False)]
+        for request in requests:
+            expected = summary(provider.getFeatures(request))
+            self.assertTrue(expected)
+            for size in (1, 4, 1000):
+                self.assertEqual(summary(batched(request, size)), expected)
+
+        # the vector layer iterator fills batches from its features
+        self.assertEqual(summary(batched(QgsFeatureRequest(), 10, vl)), summary(vl.getFeatures()))
+
+        batch = QgsFeatureBatch()
+        self.assertTrue(provider.getFeatures().nextBatch(batch))
+        self.assertEqual(batch.size(), 25)
+        self.assertEqual([batch.columnType(c) for c in range(batch.columnCount())],
+                         [QgsFeatureBatch.Int64Column, QgsFeatureBatch.Int64Column, QgsFeatureBatch.Int64Column,
+                          QgsFeatureBatch.DoubleColumn, QgsFeatureBatch.StringColumn, QgsFeatureBatch.VariantColumn])
+        self.assertEqual(batch.columnIndex(4), 4)
+        self.assertEqual(batch.int64Value(2, 1), 10000000000)
+        self.assertTrue(batch.hasGeometry(1))
+        self.assertFalse(batch.hasGeometry(5))
+        self.assertEqual(batch.geometry(1).asWkt(), 'MultiPolygon (((1 0, 1 1, 2 1, 1 0)))')
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -44,7 +44,8 @@ from qgis.core import (
     QgsCoordinateReferenceSystem,
     QgsProject,
     QgsWkbTypes,
-    QgsGeometry
+    QgsGeometry,
+    QgsFeatureSink
 )
 from qgis.gui import QgsGui, QgsAttributeForm
 from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant, QDir, QObject
@@ -372,6 +373,98 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         for i in range(100):
             iterators.append(self.vl.getFeatures(request))
 
+    def testPrefetch(self):
+        """
+        Asserts that fetching the next batch of features in the background
+        gives the same features, in any batch size
+        """
+        expected = [(f.id(), f.attributes(), f.geometry().asWkt()) for f in self.vl.getFeatures()]
+        self.assertEqual(len(expected), 5)
+
+        try:
+            for prefetch in (True, False):
+                for queue_size in (1, 2, 5, 6):
+                    QgsSettings().setValue('PostgreSQL/prefetchFeatures', prefetch, QgsSettings.Providers)
+                    QgsSettings().setValue('PostgreSQL/featureQueueSize', queue_size, QgsSettings.Providers)
+                    features = [(f.id(), f.attributes(), f.geometry().asWkt()) for f in self.vl.getFeatures()]
+                    self.assertEqual(features, expected)
+
+                    # closing the iterator while a fetch is in flight
+                    it = self.vl.getFeatures()
+                    self.assertTrue(it.nextFeature(QgsFeature()))
+                    self.assertTrue(it.rewind())
+                    self.assertEqual([f.id() for f in it], [f[0] for f in expected])
+                    it = self.vl.getFeatures()
+                    self.assertTrue(it.nextFeature(QgsFeature()))
+                    it.close()
+                    self.assertEqual(len([f for f in self.vl.getFeatures(QgsFeatureRequest().setLimit(2))]), 2)
+        finally:
+            QgsSettings().remove('PostgreSQL/prefetchFeatures', QgsSettings.Providers)
+            QgsSettings().remove('PostgreSQL/featureQueueSize', QgsSettings.Providers)
+
+    def testBinaryAttributes(self):
+        """
+        Asserts that attributes decoded from their binary format are the same as
+        the ones parsed from their text representation
+        """
+        def features(layer):
+            return [(f.id(), f.attributes()) for f in layer.getFeatures()]
+
+        for vl in (self.vl, self.poly_vl):
+            try:
+                QgsSettings().setValue('PostgreSQL/binaryAttributes', False, QgsSettings.Providers)
+                expected = features(vl)
+                QgsSettings().setValue('PostgreSQL/binaryAttributes', True, QgsSettings.Providers)
+                self.assertEqual(features(vl), expected)
+            finally:
+                QgsSettings().remove('PostgreSQL/binaryAttributes', QgsSettings.Providers)
+
+    def testCopyFeatures(self):
+        """
+        Asserts that features loaded with COPY are the same as the ones inserted
+        one by one
+        """
+        for geometry_type in ('geometry', 'geography'):
+            self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.copy_data')
+            self.execSQLCommand('CREATE TABLE qgis_test.copy_data (pk SERIAL NOT NULL PRIMARY KEY, batch integer, name text, num integer, flag boolean DEFAULT true, geom public.{}(MultiPoint, 4326))'.format(geometry_type))
+
+            vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=MULTIPOINT table="qgis_test"."copy_data" (geom) sql=', 'test', 'postgres')
+            self.assertTrue(vl.isValid())
+
+            def features(batch):
+                result = []
+                for i in range(30):
+                    f = QgsFeature(vl.fields())
+                    f['batch'] = batch
+                    f['name'] = NULL if i % 7 == 0 else 'tab\tnew\nline\r back\\slash \\N é {}'.format(i)
+                    f['num'] = NULL if i % 5 == 0 else i
+                    if i % 3:
+                        f.setGeometry(QgsGeometry.fromWkt('Point({} {})'.format(i, -i)))
+                    result.append(f)
+                return result
+
+            def batch(batch):
+                request = QgsFeatureRequest().setFilterExpression('"batch" = {}'.format(batch))
+                return sorted([(f['name'], f['num'], f['flag'], f.geometry().asWkt()) for f in vl.getFeatures(request)], key=str)
+
+            try:
+                QgsSettings().setValue('PostgreSQL/copyThreshold', 10, QgsSettings.Providers)
+                self.assertTrue(vl.dataProvider().addFeatures(features(0), QgsFeatureSink.FastInsert)[0], geometry_type)
+                QgsSettings().setValue('PostgreSQL/copyThreshold', 0, QgsSettings.Providers)
+                self.assertTrue(vl.dataProvider().addFeatures(features(1), QgsFeatureSink.FastInsert)[0], geometry_type)
+            finally:
+                QgsSettings().remove('PostgreSQL/copyThreshold', QgsSettings.Providers)
+
+            self.assertEqual(vl.featureCount(), 60, geometry_type)
+            copied = batch(0)
+            self.assertEqual(len(copied), 30, geometry_type)
+            self.assertEqual(copied, batch(1), geometry_type)
+            self.assertIn(('tab\tnew\nline\r back\\slash \\N é 1', 1, True, 'MultiPoint ((1 -1))'), copied)
+            self.assertEqual(len(set(f['pk'] for f in vl.getFeatures())), 60, geometry_type)
+
+            del vl
+            self.execSQLCommand('DROP TABLE qgis_test.copy_data')
+
     def testTransactionDirtyName(self):
         # create a vector ayer based on postgres
         vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POLYGON table="qgis_test"."some_poly_data" (geom) sql=', 'test', 'postgres')
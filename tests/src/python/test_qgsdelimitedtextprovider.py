@@ -35,7 +35,7 @@ import collections
 
 rebuildTests = 'REBUILD_DELIMITED_TEXT_TESTS' in os.environ
 
-from qgis.PyQt.QtCore import QCoreApplication, QUrl, QObject
+from qgis.PyQt.QtCore import QCoreApplication, QUrl, QObject, QVariant
 
 from qgis.core import (
     QgsProviderRegistry,
@@ -43,7 +43,9 @@ from qgis.core import (
     QgsFeatureRequest,
     QgsRectangle,
     QgsApplication,
-    QgsFeature)
+    QgsFeature,
+    QgsSettings,
+    QgsWkbTypes)
 
 from qgis.testing import start_app, unittest
 from utilities import unitTestDataPath, compareWkt
@@ -828,6 +830,111 @@ class TestQgsDelimitedTextProviderOther(unittest.TestCase):
         components = registry.decodeUri('delimitedtext', uri)
         self.assertEqual(components['path'], filename)
 
+    def test_044_parallel_scan(self):
+        # Scanning a file in concurrent chunks gives the same layer as a sequential scan
+        tmpdir = tempfile.mkdtemp()
+        filename = os.path.join(tmpdir, 'parallel.csv')
+        with open(filename, 'w', newline='') as f:
+            f.write('id,name,value,wkt\r\n')
+            for i in range(200):
+                if i % 17 == 3:
+                    f.write('{0},"multi\nline ""{0}""",{0},"MULTIPOINT(({0} {1}))"\r\n'.format(i, i * 2))
+                elif i % 23 == 5:
+                    f.write('{0},bad"quote,{0},POINT({0} 1)\n'.format(i))
+                elif i % 31 == 7:
+                    f.write('\n')
+                else:
+                    f.write('{0},"name, {0}",{1},POINT({0} {2})\n'.format(i, i if i < 150 else i + 0.5, -i))
+
+        def layerContents(watchFile=False):
+            url = MyUrl.fromLocalFile(filename)
+            url.addQueryItem('type', 'csv')
+            url.addQueryItem('wktField', 'wkt')
+            url.addQueryItem('spatialIndex', 'yes')
+            if watchFile:
+                url.addQueryItem('watchFile', 'yes')
+            layer = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+            self.assertTrue(layer.isValid())
+            fields = [(field.name(), field.type()) for field in layer.fields()]
+            features = [(f.id(), f.attributes(), f.geometry().asWkt()) for f in layer.getFeatures()]
+            inRect = [f.id() for f in layer.getFeatures(QgsFeatureRequest().setFilterRect(QgsRectangle(10, -100, 50, 100)))]
+            return fields, layer.featureCount(), layer.extent().toString(), layer.wkbType(), features, inRect
+
+        settings = QgsSettings()
+        try:
+            settings.setValue('DelimitedText/scanChunkSize', 0, QgsSettings.Providers)
+            sequential = layerContents()
+            settings.setValue('DelimitedText/scanChunkSize', 64, QgsSettings.Providers)
+            parallel = layerContents()
+            # a watched file is never memory mapped, so it is scanned sequentially
+            watched = layerContents(watchFile=True)
+        finally:
+            settings.remove('DelimitedText/scanChunkSize', QgsSettings.Providers)
+
+        self.assertEqual(parallel, sequential)
+        self.assertEqual(watched, sequential)
+        fields, count, extent, wkbType, features, inRect = sequential
+        self.assertEqual(fields, [('id', QVariant.Int), ('name', QVariant.String), ('value', QVariant.Double)])
+        self.assertEqual(wkbType, QgsWkbTypes.MultiPoint)
+        # the record of row 88 starts on line 95, after the header and 5 records on two lines
+        self.assertIn((95, [88, 'multi\nline "88"', 88], 'MultiPoint ((88 176))'), features)
+        self.assertTrue(inRect)
+
+    def test_045_index_file(self):
+        # Scan results are stored in an index file and read back while the file is unchanged
+        tmpdir = tempfile.mkdtemp()
+        filename = os.path.join(tmpdir, 'indexed.csv')
+
+        def writeFile(count):
+            with open(filename, 'w') as f:
+                f.write('id,name,x,y\n')
+                for i in range(count):
+                    if i % 50 == 7:
+                        f.write('{0},"two\nlines",{0},bad\n'.format(i))
+                    else:
+                        f.write('{0},name {0},{0},{1}\n'.format(i, i % 20))
+
+        url = MyUrl.fromLocalFile(filename)
+        url.addQueryItem('type', 'csv')
+        url.addQueryItem('xField', 'x')
+        url.addQueryItem('yField', 'y')
+        url.addQueryItem('spatialIndex', 'yes')
+        url.addQueryItem('indexFile', 'yes')
+
+        def layerContents():
+            layer = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+            self.assertTrue(layer.isValid())
+            fields = [(field.name(), field.type()) for field in layer.fields()]
+            features = [(f.id(), f.attributes()) for f in layer.getFeatures()]
+            inRect = [f.id() for f in layer.getFeatures(QgsFeatureRequest().setFilterRect(QgsRectangle(100, 2, 200, 5)))]
+            byFid = [f.attributes() for f in layer.getFeatures(QgsFeatureRequest().setFilterFids([1000, 3, 502]))]
+            return fields, layer.featureCount(), layer.extent().toString(), features, inRect, byFid
+
+        writeFile(1000)
+        scanned = layerContents()
+        self.assertTrue(os.path.exists(filename + '.qdti'))
+        self.assertTrue(os.path.exists(filename + '.qdti.rtree'))
+        self.assertEqual(scanned[1], 980)
+        self.assertEqual(scanned[2], '0.0000000000000000,0.0000000000000000 : 999.0000000000000000,19.0000000000000000')
+
+        def lineNumber(i):
+            # after the header and the records on two lines
+            return i + 2 + len([j for j in range(i) if j % 50 == 7])
+
+        self.assertEqual(sorted(scanned[4]), [lineNumber(i) for i in range(100, 201) if i % 20 in range(2, 6) and i % 50 != 7])
+        self.assertEqual([lineNumber(i) for i in (1, 490, 978)], [3, 502, 1000])
+        self.assertEqual(sorted(a[0] for a in scanned[5]), [1, 490, 978])
+
+        # reopening uses the index file
+        self.assertEqual(layerContents(), scanned)
+
+        # a changed file is scanned again
+        time.sleep(1)
+        writeFile(1100)
+        rescanned = layerContents()
+        self.assertEqual(rescanned[1], 1078)
+        self.assertEqual(layerContents(), rescanned)
+
 
 if __name__ == '__main__':
     unittest.main()
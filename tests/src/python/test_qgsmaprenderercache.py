@@ -14,13 +14,26 @@ __revision__ = '$Format:%H$'
 
 import qgis  # NOQA
 
+import math
+
 from qgis.core import (QgsMapRendererCache,
+                       QgsMapRendererSequentialJob,
+                       QgsMapSettings,
+                       QgsLabelPosition,
+                       QgsPalLayerSettings,
+                       QgsTextFormat,
+                       QgsVectorLayerSimpleLabeling,
+                       QgsCoordinateReferenceSystem,
+                       QgsFeature,
+                       QgsGeometry,
+                       QgsFontUtils,
+                       QgsPointXY,
                        QgsRectangle,
                        QgsVectorLayer,
                        QgsProject)
 from qgis.testing import start_app, unittest
-from qgis.PyQt.QtCore import QCoreApplication
-from qgis.PyQt.QtGui import QImage
+from qgis.PyQt.QtCore import QCoreApplication, QSize
+from qgis.PyQt.QtGui import QImage, QFont
 from time import sleep
 start_app()
 
@@ -97,6 +110,120 @@ class TestQgsMapRendererCache(unittest.TestCase):
         self.assertTrue(cache.cacheImage('layer').isNull())
         self.assertFalse(cache.hasCacheImage('layer'))
 
+    def testLabelPlacements(self):
+        layer = QgsVectorLayer("Point?field=fldtxt:string",
+                               "layer", "memory")
+        cache = QgsMapRendererCache()
+        self.assertFalse(cache.init(QgsRectangle(1, 2, 3, 4), 1000))
+        self.assertEqual(cache.labelPlacements(), [])
+
+        position = QgsLabelPosition(1, 0, [QgsPointXY(1, 2), QgsPointXY(2, 2), QgsPointXY(2, 3), QgsPointXY(1, 3)],
+                                    QgsRectangle(1, 2, 2, 3), 1, 1, layer.id(), 'label', QFont(), False)
+        cache.setLabelPlacements([position], [layer])
+        self.assertEqual(len(cache.labelPlacements()), 1)
+
+        # placements are kept when panning at the same scale
+        self.assertFalse(cache.init(QgsRectangle(11, 12, 13, 14), 1000))
+        self.assertEqual(len(cache.labelPlacements()), 1)
+        self.assertEqual(cache.labelPlacements()[0].labelText, 'label')
+
+        # but not when zooming
+        self.assertFalse(cache.init(QgsRectangle(11, 12, 13, 14), 2000))
+        self.assertEqual(cache.labelPlacements(), [])
+
+        # and not when the layer is repainted
+        cache.setLabelPlacements([position], [layer])
+        self.assertEqual(len(cache.labelPlacements()), 1)
+        layer.triggerRepaint()
+        self.assertEqual(cache.labelPlacements(), [])
+
+    def labeledLayer(self, name, x, y, placement, quadOffset=QgsPalLayerSettings.QuadrantOver):
+        layer = QgsVectorLayer("Point?crs=epsg:3857&field=fldtxt:string", name, "memory")
+        f = QgsFeature(layer.fields(), 1)
+        f.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(x, y)))
+        self.assertTrue(layer.dataProvider().addFeatures([f])[0])
+
+        settings = QgsPalLayerSettings()
+        settings.fieldName = "'label'"
+        settings.isExpression = True
+        settings.placement = placement
+        settings.quadOffset = quadOffset
+        text_format = QgsTextFormat()
+        text_format.setFont(QgsFontUtils.getStandardTestFont('Bold'))
+        text_format.setSize(12)
+        settings.setFormat(text_format)
+        layer.setLabeling(QgsVectorLayerSimpleLabeling(settings))
+        layer.setLabelsEnabled(True)
+        return layer
+
+    def renderLabels(self, layers, extent, cache=None):
+        """Renders the layers and returns the label positions by layer id"""
+        settings = QgsMapSettings()
+        settings.setDestinationCrs(QgsCoordinateReferenceSystem('EPSG:3857'))
+        settings.setOutputSize(QSize(400, 400))
+        settings.setOutputDpi(96)
+        settings.setExtent(extent)
+        settings.setLayers(layers)
+
+        job = QgsMapRendererSequentialJob(settings)
+        if cache is not None:
+            job.setCache(cache)
+        job.start()
+        job.waitForFinished()
+        results = job.takeLabelingResults()
+        return {p.layerID: p for p in results.labelsWithinRect(settings.visibleExtent())}
+
+    def assertSamePosition(self, position, expected):
+        self.assertEqual(len(position.cornerPoints), len(expected.cornerPoints))
+        for point, expected_point in zip(position.cornerPoints, expected.cornerPoints):
+            self.assertAlmostEqual(point.x(), expected_point.x(), 6)
+            self.assertAlmostEqual(point.y(), expected_point.y(), 6)
+        self.assertAlmostEqual(position.rotation, expected.rotation, 6)
+
+    def testLabelPlacementsRender(self):
+        """Labels keep their position when the map is panned at the same scale"""
+        extent = QgsRectangle(-10, -10, 10, 10)
+        layer = self.labeledLayer('a', 0, 0, QgsPalLayerSettings.AroundPoint)
+
+        # best position of the label without any conflict
+        best = self.renderLabels([layer], extent)[layer.id()]
+        width = best.labelRect.width()
+        height = best.labelRect.height()
+
+        # a label which only fits below left of its point hides this best position
+        blocker = self.labeledLayer('b', best.labelRect.xMaximum() + 0.3 * width, best.labelRect.yMaximum() + 0.3 * height,
+                                    QgsPalLayerSettings.OverPoint, QgsPalLayerSettings.QuadrantBelowLeft)
+        layers = [blocker, layer]
+        cache = QgsMapRendererCache()
+        labels = self.renderLabels(layers, extent, cache)
+        self.assertIn(blocker.id(), labels)
+        moved = labels[layer.id()]
+        self.assertFalse(moved.labelRect.intersects(labels[blocker.id()].labelRect))
+        self.assertNotEqual(moved.labelRect, best.labelRect)
+
+        # pan at the same scale, so that the blocking point is out of view
+        right = math.ceil((best.labelRect.xMaximum() + 0.1 * width) * 64) / 64
+        panned = QgsRectangle(right - 20, -10, right, 10)
+        self.assertTrue(panned.contains(best.labelRect))
+        self.assertTrue(panned.contains(moved.labelRect))
+
+        # without previous placements the label moves back to its best position
+        labels = self.renderLabels(layers, panned)
+        self.assertNotIn(blocker.id(), labels)
+        self.assertSamePosition(labels[layer.id()], best)
+
+        # but the placement of the previous render is kept
+        labels = self.renderLabels(layers, panned, cache)
+        self.assertNotIn(blocker.id(), labels)
+        self.assertSamePosition(labels[layer.id()], moved)
+
+        # labels are placed again when the scale changes
+        zoomed = QgsRectangle(right - 10, -5, right, 5)
+        expected = self.renderLabels(layers, zoomed)[layer.id()]
+        labels = self.renderLabels(layers, zoomed, cache)
+        self.assertSamePosition(labels[layer.id()], expected)
+        self.assertNotEqual(labels[layer.id()].labelRect, moved.labelRect)
+
     def testRequestRepaintSimple(self):
         """ test requesting repaint with a single dependent layer """
         layer = QgsVectorLayer("Point?field=fldtxt:string",
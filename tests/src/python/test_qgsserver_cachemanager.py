@@ -415,6 +415,73 @@ class TestQgsServerCacheManager(unittest.TestCase):
         filelist = [f for f in os.listdir(self._servercache._tile_cache_dir) if f.endswith(".png")]
         self.assertEqual(len(filelist), 0, 'Exception has been cached ')
 
+    def test_gettile_metatile(self):
+        project = self._project_path
+        assert os.path.exists(project), "Project file not found: " + project
+
+        def tile_query(row, col):
+            return "?" + "&".join(["%s=%s" % i for i in list({
+                "MAP": urllib.parse.quote(project),
+                "SERVICE": "WMTS",
+                "VERSION": "1.0.0",
+                "REQUEST": "GetTile",
+                "LAYER": "Country",
+                "STYLE": "",
+                "TILEMATRIXSET": "EPSG:3857",
+                "TILEMATRIX": "1",
+                "TILEROW": str(row),
+                "TILECOL": str(col),
+                "FORMAT": "image/png"
+            }.items())])
+
+        def cached_tiles():
+            return [f for f in os.listdir(self._servercache._tile_cache_dir) if f.endswith(".png")]
+
+        cacheManager = self._server_iface.cacheManager()
+        self.assertTrue(cacheManager.deleteCachedImages(None))
+
+        # tile rendered alone
+        r, h = self._result(self._execute_request(tile_query(1, 1)))
+        self.assertEqual(h.get("Content-Type"), "image/png", r)
+        single = QImage.fromData(r, "PNG")
+        self.assertFalse(single.isNull())
+        self.assertTrue(cacheManager.deleteCachedImages(None))
+
+        # same tile rendered in the block of the 2x2 tiles of the matrix
+        try:
+            self._server.putenv('QGIS_SERVER_WMTS_METATILE_COLUMNS', '2')
+            self._server.putenv('QGIS_SERVER_WMTS_METATILE_ROWS', '2')
+            r, h = self._result(self._execute_request(tile_query(1, 1)))
+        finally:
+            self._server.putenv('QGIS_SERVER_WMTS_METATILE_COLUMNS', '1')
+            self._server.putenv('QGIS_SERVER_WMTS_METATILE_ROWS', '1')
+        self.assertEqual(h.get("Content-Type"), "image/png", r)
+        metatiled = QImage.fromData(r, "PNG")
+        self.assertEqual(metatiled.size(), single.size())
+
+        different = 0
+        for y in range(single.height()):
+            for x in range(single.width()):
+                if single.pixel(x, y) != metatiled.pixel(x, y):
+                    different += 1
+        self.assertLessEqual(different, single.width() * single.height() // 100)
+
+        # the siblings have been cached with the requested tile
+        self.assertEqual(len(cached_tiles()), 4, 'Siblings are not cached')
+
+        # replace the cached tiles, so that a sibling served from the cache is recognized
+        red = QImage(256, 256, QImage.Format_ARGB32)
+        red.fill(0xffff0000)
+        for f in cached_tiles():
+            red.save(os.path.join(self._servercache._tile_cache_dir, f), 'PNG')
+
+        r, h = self._result(self._execute_request(tile_query(0, 0)))
+        self.assertEqual(h.get("Content-Type"), "image/png", r)
+        sibling = QImage.fromData(r, "PNG")
+        self.assertEqual(sibling.pixel(128, 128), 0xffff0000)
+
+        self.assertTrue(cacheManager.deleteCachedImages(None))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,137 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the built-in cache of QgsServer.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Project'
+__date__ = '16/10/2018'
+__copyright__ = 'Copyright 2018, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+print('CTEST_FULL_OUTPUT')
+
+import qgis  # NOQA
+
+import os
+import urllib.parse
+import tempfile
+import hashlib
+import shutil
+
+# The settings are read when the server is initialized. The memory tier is
+# disabled, so that the responses are read from the files of the disk tier.
+_cache_dir = tempfile.mkdtemp()
+os.environ['QGIS_SERVER_CACHE_DIRECTORY'] = _cache_dir
+os.environ['QGIS_SERVER_NATIVE_CACHE_MEMORY_SIZE'] = '0'
+os.environ['QGIS_SERVER_NATIVE_CACHE_DISK_SIZE'] = str(10 * 1024 * 1024)
+
+from qgis.testing import unittest
+from utilities import unitTestDataPath
+from qgis.server import QgsServer, QgsServerRequest, QgsBufferServerRequest, QgsBufferServerResponse
+from qgis.core import QgsApplication
+
+
+class TestQgsServerNativeCache(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        """Run before all tests"""
+        cls._app = QgsApplication([], False)
+        cls._server = QgsServer()
+        cls._server_iface = cls._server.serverInterface()
+
+    @classmethod
+    def tearDownClass(cls):
+        """Run after all tests"""
+        del cls._server
+        shutil.rmtree(_cache_dir, True)
+        cls._app.exitQgis()
+
+    def _execute_request(self, qs, requestMethod=QgsServerRequest.GetMethod, data=None):
+        request = QgsBufferServerRequest(qs, requestMethod, {}, data)
+        response = QgsBufferServerResponse()
+        self._server.handleRequest(request, response)
+        return bytes(response.body())
+
+    def _cached_files(self, project):
+        project_dir = os.path.join(_cache_dir, 'server', hashlib.sha1(project.encode('utf8')).hexdigest())
+        files = []
+        for root, dirs, names in os.walk(project_dir):
+            files += [os.path.join(root, name) for name in names]
+        return files
+
+    def setUp(self):
+        d = unitTestDataPath('qgis_server_accesscontrol') + '/'
+        self._project_path = os.path.join(d, "project.qgs")
+
+    def test_getcapabilities(self):
+        project = self._project_path
+        assert os.path.exists(project), "Project file not found: " + project
+
+        bodies = {}
+        for service, version in (('WMS', '1.3.0'), ('WFS', '1.1.0'), ('WCS', '1.0.0'), ('WMTS', '1.0.0')):
+            query_string = '?MAP=%s&SERVICE=%s&VERSION=%s&REQUEST=GetCapabilities' % (urllib.parse.quote(project), service, version)
+            # without cache
+            bodies[service] = self._execute_request(query_string)
+            # with cache, parameters are normalized
+            query_string = '?request=GetCapabilities&version=%s&service=%s&map=%s' % (version, service, urllib.parse.quote(project))
+            self.assertEqual(self._execute_request(query_string), bodies[service])
+
+        self.assertEqual(len(self._cached_files(project)), 4, 'Not enough files in cache')
+
+        # removing the project from the server cache removes its documents
+        self._server_iface.removeConfigCacheEntry(project)
+        self.assertEqual(len(self._cached_files(project)), 0, 'All files in cache are not deleted')
+
+        query_string = '?MAP=%s&SERVICE=WMS&VERSION=1.3.0&REQUEST=GetCapabilities' % urllib.parse.quote(project)
+        self.assertEqual(self._execute_request(query_string), bodies['WMS'])
+        self.assertEqual(len(self._cached_files(project)), 1)
+
+    def test_url(self):
+        project = self._project_path
+        assert os.path.exists(project), "Project file not found: " + project
+        self._server_iface.removeConfigCacheEntry(project)
+
+        # the capabilities embed the URL of the service, they are cached for each URL
+        query_string = '?MAP=%s&SERVICE=WMS&VERSION=1.3.0&REQUEST=GetCapabilities' % urllib.parse.quote(project)
+        first = self._execute_request('http://first.example.com/qgis' + query_string)
+        second = self._execute_request('https://second.example.com:8443/ows' + query_string)
+        self.assertIn(b'first.example.com/qgis', first)
+        self.assertNotIn(b'second.example.com', first)
+        self.assertIn(b'second.example.com:8443/ows', second)
+        self.assertNotIn(b'first.example.com', second)
+
+        self.assertEqual(self._execute_request('http://first.example.com/qgis' + query_string), first)
+        self.assertEqual(len(self._cached_files(project)), 2)
+
+        self._server_iface.removeConfigCacheEntry(project)
+
+    def test_getlegendgraphic(self):
+        project = self._project_path
+        assert os.path.exists(project), "Project file not found: " + project
+        self._server_iface.removeConfigCacheEntry(project)
+
+        query_string = '?MAP=%s&SERVICE=WMS&VERSION=1.3.0&REQUEST=GetLegendGraphic&LAYER=Country&FORMAT=image/png' % urllib.parse.quote(project)
+        # without cache
+        body = self._execute_request(query_string)
+        self.assertTrue(body.startswith(b'\x89PNG'))
+        self.assertEqual(len(self._cached_files(project)), 1)
+        # with cache
+        self.assertEqual(self._execute_request(query_string), body)
+        self.assertEqual(len(self._cached_files(project)), 1)
+
+        # replace the cached image, so that a response served from the cache is recognized
+        overwritten = b'\x89PNG overwritten'
+        with open(self._cached_files(project)[0], 'wb') as f:
+            f.write(overwritten)
+        self.assertEqual(self._execute_request(query_string), overwritten)
+
+        self._server_iface.removeConfigCacheEntry(project)
+
+
+if __name__ == '__main__':
+    unittest.main()
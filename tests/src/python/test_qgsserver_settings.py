@@ -133,6 +133,46 @@ class TestQgsServerSettings(unittest.TestCase):
         self.assertEqual(self.settings.cacheDirectory(), "/tmp/fake")
         os.environ.pop(env)
 
+    def test_env_worker_threads(self):
+        env = "QGIS_SERVER_WORKER_THREADS"
+
+        self.assertEqual(self.settings.workerThreads(), 1)
+
+        os.environ[env] = "4"
+        self.settings.load()
+        self.assertEqual(self.settings.workerThreads(), 4)
+        os.environ.pop(env)
+
+    def test_env_wmts_metatile(self):
+        env_columns = "QGIS_SERVER_WMTS_METATILE_COLUMNS"
+        env_rows = "QGIS_SERVER_WMTS_METATILE_ROWS"
+
+        self.assertEqual(self.settings.wmtsMetatileColumns(), 1)
+        self.assertEqual(self.settings.wmtsMetatileRows(), 1)
+
+        os.environ[env_columns] = "4"
+        os.environ[env_rows] = "2"
+        self.settings.load()
+        self.assertEqual(self.settings.wmtsMetatileColumns(), 4)
+        self.assertEqual(self.settings.wmtsMetatileRows(), 2)
+        os.environ.pop(env_columns)
+        os.environ.pop(env_rows)
+
+    def test_env_native_cache_size(self):
+        env_memory = "QGIS_SERVER_NATIVE_CACHE_MEMORY_SIZE"
+        env_disk = "QGIS_SERVER_NATIVE_CACHE_DISK_SIZE"
+
+        self.assertEqual(self.settings.nativeCacheMemorySize(), 0)
+        self.assertEqual(self.settings.nativeCacheDiskSize(), 0)
+
+        os.environ[env_memory] = "1024"
+        os.environ[env_disk] = "2048"
+        self.settings.load()
+        self.assertEqual(self.settings.nativeCacheMemorySize(), 1024)
+        self.assertEqual(self.settings.nativeCacheDiskSize(), 2048)
+        os.environ.pop(env_memory)
+        os.environ.pop(env_disk)
+
     def test_priority(self):
         env = "QGIS_OPTIONS_PATH"
         dpath = "conf0"
@@ -0,0 +1,203 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsServer requests handled concurrently by several threads.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Project'
+__date__ = '16/10/2018'
+__copyright__ = 'Copyright 2018, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+print('CTEST_FULL_OUTPUT')
+
+import qgis  # NOQA
+
+import os
+
+# Deterministic XML
+os.environ['QT_HASH_SEED'] = '1'
+
+import glob
+import shutil
+import tempfile
+import threading
+import time
+import urllib.parse
+
+from qgis.testing import unittest
+from utilities import unitTestDataPath
+from qgis.server import QgsServer, QgsConfigCache, QgsBufferServerRequest, QgsBufferServerResponse
+from qgis.core import QgsApplication, QgsProject
+from qgis.PyQt import sip
+from qgis.PyQt.QtCore import QCoreApplication, QThread
+
+THREAD_COUNT = 4
+
+
+class RequestThread(QThread):
+
+    """Handles batches of requests, and records the project instance of the thread after each one"""
+
+    def __init__(self, server, batches):
+        super().__init__()
+        self.server = server
+        self.batches = batches
+        self.started_batch = [threading.Event() for batch in batches]
+        self.finished_batch = [threading.Event() for batch in batches]
+        self.responses = []
+        self.instances = []
+
+    def run(self):
+        for batch, started, finished in zip(self.batches, self.started_batch, self.finished_batch):
+            started.wait()
+            for path, qs in batch:
+                request = QgsBufferServerRequest(qs)
+                response = QgsBufferServerResponse()
+                self.server.handleRequest(request, response)
+                self.responses.append(bytes(response.body()))
+
+                # the instance set for the request must be the project cached for this thread
+                instance = QgsProject.instance()
+                cached = QgsConfigCache.instance().project(path)
+                self.instances.append((instance.fileName(), sip.unwrapinstance(instance), sip.unwrapinstance(cached)))
+            finished.set()
+
+
+class TestQgsServerThreads(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        """Run before all tests"""
+        cls._app = QgsApplication([], False)
+        cls._server = QgsServer()
+
+        # projects are copied, so that they can be modified
+        cls._project_dir = tempfile.mkdtemp()
+        data_dir = unitTestDataPath('qgis_server')
+        for f in glob.glob(os.path.join(data_dir, 'testlayer.*')):
+            shutil.copy(f, cls._project_dir)
+        cls._projects = []
+        for name in ('test_project.qgs', 'test_project_wfs.qgs'):
+            shutil.copy(os.path.join(data_dir, name), cls._project_dir)
+            cls._projects.append(os.path.join(cls._project_dir, name))
+
+    @classmethod
+    def tearDownClass(cls):
+        """Run after all tests"""
+        del cls._server
+        shutil.rmtree(cls._project_dir, True)
+        cls._app.exitQgis()
+
+    def _requests(self):
+        requests = []
+        for path in self._projects:
+            for params in ({'SERVICE': 'WMS', 'VERSION': '1.3.0', 'REQUEST': 'GetCapabilities'},
+                           {'SERVICE': 'WFS', 'VERSION': '1.1.0', 'REQUEST': 'GetFeature', 'TYPENAME': 'testlayer',
+                            'OUTPUTFORMAT': 'GeoJSON'}):
+                params['MAP'] = path
+                requests.append((path, '?' + urllib.parse.urlencode(params)))
+        return requests
+
+    def _serial_responses(self, requests):
+        responses = []
+        for path, qs in requests:
+            request = QgsBufferServerRequest(qs)
+            response = QgsBufferServerResponse()
+            self._server.handleRequest(request, response)
+            responses.append(bytes(response.body()))
+        return responses
+
+    def _start_threads(self, requests, batch_count):
+        """Starts threads running the requests in each batch, in a different order in each thread"""
+        threads = []
+        for i in range(THREAD_COUNT):
+            thread_requests = (requests[i:] + requests[:i]) * 2
+            threads.append(RequestThread(self._server, [thread_requests] * batch_count))
+        for thread in threads:
+            thread.start()
+        return threads
+
+    def _run_batch(self, threads, batch, requests):
+        """Runs a batch in all the threads, checks their project instances and returns their responses by request"""
+        for thread in threads:
+            thread.started_batch[batch].set()
+        for thread in threads:
+            self.assertTrue(thread.finished_batch[batch].wait(60))
+
+        # watchers of the projects read by the threads are set in the main thread
+        QCoreApplication.processEvents()
+
+        main_instance = sip.unwrapinstance(QgsProject.instance())
+        responses = {}
+        for thread in threads:
+            batch_size = len(thread.batches[batch])
+            offset = batch * batch_size
+            self.assertEqual(len(thread.responses), offset + batch_size)
+            for (path, qs), response, (file_name, instance, cached) in zip(thread.batches[batch], thread.responses[offset:], thread.instances[offset:]):
+                self.assertEqual(file_name, path)
+                self.assertEqual(instance, cached)
+                self.assertNotEqual(instance, main_instance)
+                responses.setdefault(qs, []).append(response)
+        return responses
+
+    def test_concurrent_requests(self):
+        requests = self._requests()
+        serial = self._serial_responses(requests)
+        for (path, qs), response in zip(requests, serial):
+            self.assertTrue(response, qs)
+
+        threads = self._start_threads(requests, 1)
+        parallel = self._run_batch(threads, 0, requests)
+        for thread in threads:
+            self.assertTrue(thread.wait(60000))
+
+        for (path, qs), response in zip(requests, serial):
+            self.assertEqual(len(parallel[qs]), THREAD_COUNT * 2)
+            for parallel_response in parallel[qs]:
+                self.assertEqual(parallel_response, response, qs)
+
+    def test_project_reload(self):
+        requests = self._requests()
+        self._serial_responses(requests)
+
+        # the threads keep their projects between the batches
+        threads = self._start_threads(requests, 2)
+        self._run_batch(threads, 0, requests)
+
+        removed = []
+        QgsConfigCache.instance().projectRemovedFromCache.connect(removed.append)
+
+        # touch the first project, the file watcher bumps its version
+        path = self._projects[0]
+        with open(path, 'r', encoding='utf-8') as f:
+            content = f.read()
+        self.assertIn('QGIS TestProject', content)
+        with open(path, 'w', encoding='utf-8') as f:
+            f.write(content.replace('QGIS TestProject', 'QGIS Reloaded Project'))
+
+        start = time.time()
+        while path not in removed and time.time() - start < 10:
+            QCoreApplication.processEvents()
+            time.sleep(0.01)
+        self.assertIn(path, removed)
+
+        # the threads reload their stale project, and give the same responses as the main thread
+        serial = self._serial_responses(requests)
+        parallel = self._run_batch(threads, 1, requests)
+        for thread in threads:
+            self.assertTrue(thread.wait(60000))
+
+        for (request_path, qs), response in zip(requests, serial):
+            for parallel_response in parallel[qs]:
+                self.assertEqual(parallel_response, response, qs)
+            if request_path == path and 'GetCapabilities' in qs:
+                self.assertIn(b'QGIS Reloaded Project', response)
+                self.assertNotIn(b'QGIS TestProject', response)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -22,14 +22,17 @@ import os
 os.environ['QT_HASH_SEED'] = '1'
 
 import re
+import json
 import urllib.request
 import urllib.parse
 import urllib.error
 
 from qgis.server import QgsServerRequest
+from qgis.core import QgsProject, QgsVectorLayer, QgsFeature, QgsGeometry, QgsPointXY, QgsJsonExporter
 
 from qgis.testing import unittest
 from qgis.PyQt.QtCore import QSize
+from qgis.PyQt.QtXml import QDomDocument
 
 import osgeo.gdal  # NOQA
 
@@ -367,6 +370,71 @@ class TestQgsServerWFS(QgsServerTestBase):
         """Test GetFeature with featureid"""
         self.wfs_request_compare("GetFeature", '1.0.0', "SRSNAME=EPSG:4326&TYPENAME=testlayer&FEATUREID=testlayer.0", 'wfs_getFeature_1_0_0_featureid_0')
 
+    def test_getfeature_escaped_values(self):
+        """Test GetFeature with values containing characters escaped in XML"""
+        values = ['a < b & c > d', '"quoted" ]]> end', 'line\nbreak\r\nand\ttab', ']]]]>>']
+
+        layer = QgsVectorLayer('Point?crs=epsg:4326&field=id:integer&field=name:string', 'special', 'memory')
+        features = []
+        for i, value in enumerate(values):
+            f = QgsFeature(layer.fields())
+            f.setAttributes([i, value])
+            f.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(i, i)))
+            features.append(f)
+        self.assertTrue(layer.dataProvider().addFeatures(features)[0])
+
+        project = QgsProject()
+        project.addMapLayer(layer)
+        project.writeEntry('WFSLayers', '/', [layer.id()])
+
+        query_string = 'https://www.qgis.org/?SERVICE=WFS&REQUEST=GetFeature&TYPENAME=special'
+        for version, outputformat in (('1.0.0', 'GML2'), ('1.1.0', 'GML3')):
+            header, body = self._execute_request_project(query_string + '&VERSION=%s&OUTPUTFORMAT=%s' % (version, outputformat), project)
+            body = body.decode('utf-8')
+            self.assertIn('&lt;', body)
+            self.assertIn('&amp;', body)
+            self.assertIn(']]&gt;', body)
+            self.assertIn('&#xd;', body)
+            for value in values:
+                # streamed values are escaped the same way as by QDom
+                doc = QDomDocument()
+                element = doc.createElement('qgs:name')
+                element.appendChild(doc.createTextNode(value))
+                doc.appendChild(element)
+                self.assertIn(doc.toString(-1).strip(), body, outputformat)
+
+        header, body = self._execute_request_project(query_string + '&OUTPUTFORMAT=GeoJSON', project)
+        result = json.loads(body.decode('utf-8'))
+        self.assertEqual([f['properties']['name'] for f in result['features']], values)
+
+    def test_getfeature_geojson(self):
+        """Test GetFeature GeoJSON features are written as by QgsJsonExporter"""
+        values = ['"quoted" back\\slash and/slash', 'line\nbreak\r\nand\ttab\b', 'unicode é漢字', None]
+
+        layer = QgsVectorLayer('LineString?crs=epsg:3857&field=id:integer&field=name:string&field=value:double', 'special', 'memory')
+        features = []
+        for i, value in enumerate(values):
+            f = QgsFeature(layer.fields())
+            f.setAttributes([i, value, i + 0.25])
+            f.setGeometry(QgsGeometry.fromWkt('LineString(%d 0, %d 100000)' % (i * 100000, (i + 1) * 100000)))
+            features.append(f)
+        self.assertTrue(layer.dataProvider().addFeatures(features)[0])
+
+        project = QgsProject()
+        project.addMapLayer(layer)
+        project.writeEntry('WFSLayers', '/', [layer.id()])
+
+        query_string = 'https://www.qgis.org/?SERVICE=WFS&VERSION=1.1.0&REQUEST=GetFeature&TYPENAME=special&OUTPUTFORMAT=GeoJSON'
+        for propertyname, attributes in (('', [0, 1, 2]), ('&PROPERTYNAME=name', [1])):
+            header, body = self._execute_request_project(query_string + propertyname, project)
+
+            exporter = QgsJsonExporter()
+            exporter.setSourceCrs(layer.crs())
+            exporter.setAttributes(attributes)
+            for f in layer.getFeatures():
+                expected = exporter.exportFeature(f, {}, 'special.%d' % f.id())
+                self.assertIn(expected.encode('utf-8'), body)
+
 
 if __name__ == '__main__':
     unittest.main()
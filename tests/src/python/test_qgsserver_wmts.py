@@ -190,6 +190,39 @@ class TestQgsServerWMTS(QgsServerTestBase):
         r, h = self._result(self._execute_request(qs))
         self._img_diff_error(r, h, "WMTS_GetTile_Hello_4326_0", 20000)
 
+    def test_wmts_gettile_metatile_without_cache(self):
+        qs = "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectGroupsPath),
+            "SERVICE": "WMTS",
+            "VERSION": "1.0.0",
+            "REQUEST": "GetTile",
+            "LAYER": "CountryGroup",
+            "STYLE": "",
+            "TILEMATRIXSET": "EPSG:3857",
+            "TILEMATRIX": "1",
+            "TILEROW": "1",
+            "TILECOL": "1",
+            "FORMAT": "image/png"
+        }.items())])
+
+        # no cache filter is registered to store the sibling tiles in
+        self.assertFalse(self.server.serverInterface().cacheManager().hasCaches())
+
+        r, h = self._result(self._execute_request(qs))
+        self.assertEqual(h.get("Content-Type"), "image/png", r)
+        single = r
+
+        # the metatile setting is ignored, the tile is rendered alone
+        try:
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_COLUMNS', '2')
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_ROWS', '2')
+            r, h = self._result(self._execute_request(qs))
+        finally:
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_COLUMNS', '1')
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_ROWS', '1')
+        self.assertEqual(h.get("Content-Type"), "image/png", r)
+        self.assertEqual(r, single)
+
     def test_wmts_gettile_invalid_parameters(self):
         qs = "?" + "&".join(["%s=%s" % i for i in list({
             "MAP": urllib.parse.quote(self.projectGroupsPath),